@@ -0,0 +1,290 @@
+// ktrie_bench.cpp — unified benchmark driver for kntrie / kstrie
+//
+// Build: g++ -std=c++23 -O2 -march=x86-64-v3 -I../KNTRIE -I../KSTRIE ktrie_bench.cpp -pthread
+// Run:   ./ktrie_bench [--n N] [--ops N] [--suite a,b] [--threads 1,2,4]
+//                      [--zipf THETA] [--group N] [--seed S] [--label TAG]
+//                      [--json FILE|-] [--no-perf] [--list]
+//
+// JSON goes to --json (default stdout); a one-line-per-result table goes
+// to stderr.  Each suite below is independent; add new ones with
+// KTRIE_BENCH_SUITE.
+
+#include "ktrie_bench.hpp"
+#include "kntrie.hpp"
+#include "concurrent_kntrie.hpp"
+#include "sharded_kntrie.hpp"
+#include "kstrie.hpp"
+
+using namespace gteitelbaum;
+using namespace ktrie_bench;
+
+static constexpr std::size_t FIND_BATCH = 64;   // keys per find_batch call
+
+// ==========================================================================
+// String keys
+// ==========================================================================
+
+// SEQUENTIAL: fixed-width "user:%012zu" (long shared prefix, dense tail).
+// UNIFORM: random 8..32 byte alphanumerics, in random order.
+static std::vector<std::string> make_string_keys(std::size_t n, key_pattern p,
+                                                 std::uint64_t seed) {
+    std::vector<std::string> keys;
+    keys.reserve(n);
+    if (p == key_pattern::SEQUENTIAL) {
+        char buf[32];
+        for (std::size_t i = 0; i < n; ++i) {
+            std::snprintf(buf, sizeof(buf), "user:%012zu", i);
+            keys.emplace_back(buf);
+        }
+        return keys;
+    }
+    static constexpr char ALNUM[] = "abcdefghijklmnopqrstuvwxyz0123456789";
+    std::mt19937_64 rng(seed);
+    std::uniform_int_distribution<int> len(8, 32), ch(0, 35);
+    while (keys.size() < n) {
+        for (std::size_t i = keys.size(); i < n; ++i) {
+            std::string s(static_cast<std::size_t>(len(rng)), ' ');
+            for (auto& c : s) c = ALNUM[ch(rng)];
+            keys.push_back(std::move(s));
+        }
+        std::sort(keys.begin(), keys.end());
+        keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    }
+    std::shuffle(keys.begin(), keys.end(), rng);
+    return keys;
+}
+
+// Per-thread access stream: same distribution, different seed.
+static std::vector<std::size_t> thread_access(const context_t& ctx, std::size_t n,
+                                              std::size_t ops, access_t a, unsigned t) {
+    options_t o = ctx.opts;
+    o.seed += t * 7919;
+    return make_access(n, ops, a, o);
+}
+
+// A batch op covers FIND_BATCH keys: rescale the run to per-key figures.
+static void per_key(run_t& r, std::size_t batch) {
+    r.ops *= batch;
+    for (auto& s : r.samples_ns) s /= static_cast<double>(batch);
+}
+
+static constexpr key_pattern KEY_PATTERNS[] = {key_pattern::SEQUENTIAL, key_pattern::UNIFORM};
+static constexpr access_t    LOOKUPS[]      = {access_t::UNIFORM, access_t::ZIPFIAN};
+
+// ==========================================================================
+// kntrie_u64 — single-threaded insert / find / miss / erase
+// ==========================================================================
+
+KTRIE_BENCH_SUITE(kntrie_u64) {
+    const options_t& o = ctx.opts;
+    for (key_pattern kp : KEY_PATTERNS) {
+        auto keys = make_keys(o.n, kp, o.seed);
+        kntrie<std::uint64_t, std::uint64_t> t;
+
+        auto ins = time_ops(o, keys.size(), [&](std::size_t i) { t.insert(keys[i], i); });
+        ctx.add("kntrie_u64", "insert", name_of(kp), "sequential", o.n, 1, ins, t.memory_usage());
+
+        for (access_t a : LOOKUPS) {
+            auto idx = make_access(keys.size(), o.timed_ops(), a, o);
+            auto r = time_ops(o, idx.size(), [&](std::size_t i) {
+                auto it = t.find(keys[idx[i]]);
+                do_not_optimize(it);
+            });
+            ctx.add("kntrie_u64", "find", name_of(kp), name_of(a), o.n, 1, r, t.memory_usage());
+        }
+
+        // Misses: past the end for sequential keys, fresh random otherwise.
+        std::mt19937_64 rng(o.seed + 1);
+        std::vector<std::uint64_t> miss(o.timed_ops());
+        for (std::size_t i = 0; i < miss.size(); ++i)
+            miss[i] = kp == key_pattern::SEQUENTIAL ? o.n + i : rng();
+        auto rm = time_ops(o, miss.size(), [&](std::size_t i) {
+            bool b = t.contains(miss[i]);
+            do_not_optimize(b);
+        });
+        ctx.add("kntrie_u64", "find_miss", name_of(kp), "uniform", o.n, 1, rm, t.memory_usage());
+
+        auto er = time_ops(o, keys.size(), [&](std::size_t i) { t.erase(keys[i]); });
+        ctx.add("kntrie_u64", "erase", name_of(kp), "sequential", o.n, 1, er);
+    }
+}
+
+// ==========================================================================
+// kntrie_read_sweep — concurrent readers on one const kntrie: find vs find_batch
+// ==========================================================================
+
+KTRIE_BENCH_SUITE(kntrie_read_sweep) {
+    const options_t& o = ctx.opts;
+    auto keys = make_keys(o.n, key_pattern::UNIFORM, o.seed);
+    kntrie<std::uint64_t, std::uint64_t> t;
+    for (std::size_t i = 0; i < keys.size(); ++i) t.insert(keys[i], i);
+    const auto& ct = t;
+
+    for (unsigned th : ctx.thread_sweep()) {
+        auto rf = time_threads(o, th, o.timed_ops(), [&](unsigned tid) {
+            auto idx = thread_access(ctx, keys.size(), o.timed_ops(), access_t::ZIPFIAN, tid);
+            return [&ct, &keys, idx = std::move(idx)](std::size_t i) {
+                auto it = ct.find(keys[idx[i]]);
+                do_not_optimize(it);
+            };
+        });
+        ctx.add("kntrie_read_sweep", "find", "uniform", "zipfian", o.n, th, rf, t.memory_usage());
+
+        std::size_t batches = o.timed_ops() / FIND_BATCH;
+        auto rb = time_threads(o, th, batches, [&](unsigned tid) {
+            auto idx = thread_access(ctx, keys.size(), batches * FIND_BATCH,
+                                     access_t::ZIPFIAN, tid);
+            std::vector<std::uint64_t> q(idx.size());
+            for (std::size_t i = 0; i < idx.size(); ++i) q[i] = keys[idx[i]];
+            return [&ct, q = std::move(q),
+                    out = std::vector<const std::uint64_t*>(FIND_BATCH)](std::size_t b) mutable {
+                ct.find_batch(std::span<const std::uint64_t>(q.data() + b * FIND_BATCH, FIND_BATCH),
+                              std::span<const std::uint64_t*>(out));
+                do_not_optimize(out[0]);
+            };
+        });
+        per_key(rb, FIND_BATCH);
+        ctx.add("kntrie_read_sweep", "find_batch", "uniform", "zipfian", o.n, th, rb, t.memory_usage());
+    }
+}
+
+// ==========================================================================
+// concurrent_reads — concurrent_kntrie left-right readers
+// ==========================================================================
+
+KTRIE_BENCH_SUITE(concurrent_reads) {
+    const options_t& o = ctx.opts;
+    auto keys = make_keys(o.n, key_pattern::UNIFORM, o.seed);
+    concurrent_kntrie<std::uint64_t, std::uint64_t> c;
+    c.write([&](auto& t) {
+        for (std::size_t i = 0; i < keys.size(); ++i) t.insert(keys[i], i);
+    });
+
+    for (unsigned th : ctx.thread_sweep()) {
+        auto r = time_threads(o, th, o.timed_ops(), [&](unsigned tid) {
+            auto idx = thread_access(ctx, keys.size(), o.timed_ops(), access_t::ZIPFIAN, tid);
+            return [&c, &keys, idx = std::move(idx)](std::size_t i) {
+                bool b = c.contains(keys[idx[i]]);
+                do_not_optimize(b);
+            };
+        });
+        ctx.add("concurrent_reads", "contains", "uniform", "zipfian", o.n, th, r);
+    }
+}
+
+// ==========================================================================
+// sharded_rw — sharded_kntrie per-shard mutex: reads and overwrites
+// ==========================================================================
+
+KTRIE_BENCH_SUITE(sharded_rw) {
+    const options_t& o = ctx.opts;
+    auto keys = make_keys(o.n, key_pattern::UNIFORM, o.seed);
+    sharded_kntrie<std::uint64_t, std::uint64_t> s;
+    for (std::size_t i = 0; i < keys.size(); ++i) s.insert(keys[i], i);
+
+    for (unsigned th : ctx.thread_sweep()) {
+        auto rf = time_threads(o, th, o.timed_ops(), [&](unsigned tid) {
+            auto idx = thread_access(ctx, keys.size(), o.timed_ops(), access_t::ZIPFIAN, tid);
+            return [&s, &keys, idx = std::move(idx)](std::size_t i) {
+                bool b = s.contains(keys[idx[i]]);
+                do_not_optimize(b);
+            };
+        });
+        ctx.add("sharded_rw", "contains", "uniform", "zipfian", o.n, th, rf);
+
+        auto rw = time_threads(o, th, o.timed_ops(), [&](unsigned tid) {
+            auto idx = thread_access(ctx, keys.size(), o.timed_ops(), access_t::ZIPFIAN, tid);
+            return [&s, &keys, idx = std::move(idx)](std::size_t i) {
+                s.insert_or_assign(keys[idx[i]], i);
+            };
+        });
+        ctx.add("sharded_rw", "insert_or_assign", "uniform", "zipfian", o.n, th, rw);
+    }
+}
+
+// ==========================================================================
+// kstrie_str — single-threaded insert / find / miss / erase
+// ==========================================================================
+
+KTRIE_BENCH_SUITE(kstrie_str) {
+    const options_t& o = ctx.opts;
+    for (key_pattern kp : KEY_PATTERNS) {
+        auto keys = make_string_keys(o.n, kp, o.seed);
+        kstrie<std::uint64_t> t;
+
+        auto ins = time_ops(o, keys.size(), [&](std::size_t i) { t.insert(keys[i], i); });
+        ctx.add("kstrie_str", "insert", name_of(kp), "sequential", o.n, 1, ins, t.memory_usage());
+
+        for (access_t a : LOOKUPS) {
+            auto idx = make_access(keys.size(), o.timed_ops(), a, o);
+            auto r = time_ops(o, idx.size(), [&](std::size_t i) {
+                auto it = t.find(keys[idx[i]]);
+                do_not_optimize(it);
+            });
+            ctx.add("kstrie_str", "find", name_of(kp), name_of(a), o.n, 1, r, t.memory_usage());
+        }
+
+        // Misses: every present key with one byte appended.
+        auto idx = make_access(keys.size(), o.timed_ops(), access_t::UNIFORM, o);
+        std::vector<std::string> miss(idx.size());
+        for (std::size_t i = 0; i < idx.size(); ++i) miss[i] = keys[idx[i]] + "~";
+        auto rm = time_ops(o, miss.size(), [&](std::size_t i) {
+            bool b = t.contains(miss[i]);
+            do_not_optimize(b);
+        });
+        ctx.add("kstrie_str", "find_miss", name_of(kp), "uniform", o.n, 1, rm, t.memory_usage());
+
+        auto er = time_ops(o, keys.size(), [&](std::size_t i) { t.erase(keys[i]); });
+        ctx.add("kstrie_str", "erase", name_of(kp), "sequential", o.n, 1, er);
+    }
+}
+
+// ==========================================================================
+// kstrie_read_sweep — concurrent readers on one const kstrie: find vs find_batch
+// ==========================================================================
+
+KTRIE_BENCH_SUITE(kstrie_read_sweep) {
+    const options_t& o = ctx.opts;
+    auto keys = make_string_keys(o.n, key_pattern::UNIFORM, o.seed);
+    kstrie<std::uint64_t> t;
+    for (std::size_t i = 0; i < keys.size(); ++i) t.insert(keys[i], i);
+    const auto& ct = t;
+
+    for (unsigned th : ctx.thread_sweep()) {
+        auto rf = time_threads(o, th, o.timed_ops(), [&](unsigned tid) {
+            auto idx = thread_access(ctx, keys.size(), o.timed_ops(), access_t::ZIPFIAN, tid);
+            return [&ct, &keys, idx = std::move(idx)](std::size_t i) {
+                auto it = ct.find(keys[idx[i]]);
+                do_not_optimize(it);
+            };
+        });
+        ctx.add("kstrie_read_sweep", "find", "uniform", "zipfian", o.n, th, rf, t.memory_usage());
+
+        std::size_t batches = o.timed_ops() / FIND_BATCH;
+        auto rb = time_threads(o, th, batches, [&](unsigned tid) {
+            auto idx = thread_access(ctx, keys.size(), batches * FIND_BATCH,
+                                     access_t::ZIPFIAN, tid);
+            std::vector<std::string_view> q(idx.size());
+            for (std::size_t i = 0; i < idx.size(); ++i) q[i] = keys[idx[i]];
+            return [&ct, q = std::move(q),
+                    out = std::vector<const std::uint64_t*>(FIND_BATCH)](std::size_t b) mutable {
+                ct.find_batch(std::span<const std::string_view>(q.data() + b * FIND_BATCH, FIND_BATCH),
+                              std::span<const std::uint64_t*>(out));
+                do_not_optimize(out[0]);
+            };
+        });
+        per_key(rb, FIND_BATCH);
+        ctx.add("kstrie_read_sweep", "find_batch", "uniform", "zipfian", o.n, th, rb, t.memory_usage());
+    }
+}
+
+// ==========================================================================
+// Driver
+// ==========================================================================
+
+int main(int argc, char* argv[]) {
+    return run_main(argc, argv, {
+        {"kntrie_simd_search_bits", std::to_string(KNTRIE_SIMD_SEARCH_BITS)},
+        {"kstrie_simd_search_bits", std::to_string(KSTRIE_SIMD_SEARCH_BITS)},
+    });
+}
@@ -0,0 +1,632 @@
+#ifndef KTRIE_BENCH_HPP
+#define KTRIE_BENCH_HPP
+
+// ==========================================================================
+// ktrie_bench.hpp — shared benchmark harness
+//
+// One place for what the per-library benches each hand-roll: timing,
+// do_not_optimize, latency percentiles, hardware counters, key and
+// access generators, and machine-readable output.
+//
+// Suites register with KTRIE_BENCH_SUITE(name) and record result_t rows
+// through the context; a binary's main() hands over to run_main(), which
+// parses options, runs the suites and writes JSON.
+//
+// Latency: ops run in groups of opts.group (default 16) between two
+// clock reads, and each group contributes one sample of
+// group_ns / group_ops.  Timing single ops would mostly measure the clock.
+// p50/p99/p999 are taken over those samples.
+//
+// Hardware counters: Linux perf_event (cycles, instructions, cache
+// misses, branch misses), opened per measuring thread.  Where perf is
+// unavailable (other OS, perf_event_paranoid, containers) the counters
+// are reported as absent rather than failing the run.
+// ==========================================================================
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace ktrie_bench {
+
+// ==========================================================================
+// Helpers
+// ==========================================================================
+
+using bench_clock = std::chrono::steady_clock;
+
+inline double elapsed_ns(bench_clock::time_point a, bench_clock::time_point b) {
+    return std::chrono::duration<double, std::nano>(b - a).count();
+}
+
+#ifdef _MSC_VER
+template<typename T>
+inline void do_not_optimize(T const& val) {
+    static volatile char const* sink;
+    sink = reinterpret_cast<char const volatile*>(&val);
+}
+#else
+template<typename T>
+inline void do_not_optimize(T const& val) {
+    asm volatile("" : : "r,m"(val) : "memory");
+}
+#endif
+
+// ==========================================================================
+// Options
+// ==========================================================================
+
+struct options_t {
+    std::size_t n        = 1'000'000;  // keys per container
+    std::size_t ops      = 0;          // timed ops per measurement (0 = n)
+    std::size_t group    = 16;         // ops per latency sample
+    double      zipf     = 0.99;       // Zipfian skew (theta)
+    std::uint64_t seed   = 42;
+    bool        perf     = true;       // try perf_event counters
+    std::vector<unsigned> threads;     // thread sweep (empty = 1,2,4..hw)
+    std::vector<std::string> mixes;    // YCSB workloads A..F (empty = all)
+    std::size_t scan_max = 100;        // YCSB scan length is uniform in [1, scan_max]
+    std::string label;                 // free-form run tag (e.g. commit)
+
+    std::size_t timed_ops() const noexcept { return ops ? ops : n; }
+};
+
+// ==========================================================================
+// Hardware counters
+// ==========================================================================
+
+struct hw_counters_t {
+    bool          valid         = false;
+    std::uint64_t cycles        = 0;
+    std::uint64_t instructions  = 0;
+    std::uint64_t cache_misses  = 0;
+    std::uint64_t branch_misses = 0;
+
+    hw_counters_t& operator+=(const hw_counters_t& o) noexcept {
+        if (!o.valid) return *this;
+        valid          = true;
+        cycles        += o.cycles;
+        instructions  += o.instructions;
+        cache_misses  += o.cache_misses;
+        branch_misses += o.branch_misses;
+        return *this;
+    }
+};
+
+// Counter group for the calling thread.  start()/stop() bracket a region;
+// stop() returns an invalid sample if the group could not be opened.
+class perf_group {
+    static constexpr int NUM_EVENTS = 4;
+    int fds_v[NUM_EVENTS] = {-1, -1, -1, -1};
+
+#if defined(__linux__)
+    static int open_event(std::uint64_t config, int group_fd) {
+        perf_event_attr pe;
+        std::memset(&pe, 0, sizeof(pe));
+        pe.type           = PERF_TYPE_HARDWARE;
+        pe.size           = sizeof(pe);
+        pe.config         = config;
+        pe.disabled       = group_fd == -1;
+        pe.exclude_kernel = 1;
+        pe.exclude_hv     = 1;
+        pe.read_format    = PERF_FORMAT_GROUP;
+        return static_cast<int>(syscall(SYS_perf_event_open, &pe, 0, -1, group_fd, 0));
+    }
+#endif
+
+public:
+    explicit perf_group(bool enable) {
+#if defined(__linux__)
+        if (!enable) return;
+        static constexpr std::uint64_t EVENTS[NUM_EVENTS] = {
+            PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+        for (int i = 0; i < NUM_EVENTS; ++i) {
+            fds_v[i] = open_event(EVENTS[i], i ? fds_v[0] : -1);
+            if (fds_v[i] < 0) { close_all(); return; }
+        }
+#else
+        (void)enable;
+#endif
+    }
+
+    perf_group(const perf_group&) = delete;
+    perf_group& operator=(const perf_group&) = delete;
+    ~perf_group() { close_all(); }
+
+    bool is_open() const noexcept { return fds_v[0] >= 0; }
+
+    void start() noexcept {
+#if defined(__linux__)
+        if (!is_open()) return;
+        ioctl(fds_v[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(fds_v[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+    }
+
+    hw_counters_t stop() noexcept {
+        hw_counters_t r;
+#if defined(__linux__)
+        if (!is_open()) return r;
+        ioctl(fds_v[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+        std::uint64_t buf[1 + NUM_EVENTS] = {};
+        if (read(fds_v[0], buf, sizeof(buf)) != static_cast<ssize_t>(sizeof(buf)))
+            return r;
+        r.valid         = true;
+        r.cycles        = buf[1];
+        r.instructions  = buf[2];
+        r.cache_misses  = buf[3];
+        r.branch_misses = buf[4];
+#endif
+        return r;
+    }
+
+private:
+    void close_all() noexcept {
+#if defined(__linux__)
+        for (int& fd : fds_v) {
+            if (fd >= 0) close(fd);
+            fd = -1;
+        }
+#endif
+    }
+};
+
+// ==========================================================================
+// Measurement
+// ==========================================================================
+
+struct run_t {
+    std::vector<double> samples_ns;  // per-op latency of each timed group
+    std::uint64_t       ops     = 0;
+    double              wall_ns = 0;
+    hw_counters_t       hw;
+};
+
+// Time ops calls of op(i), i in [0, ops).
+template<typename F>
+run_t time_ops(const options_t& opts, std::size_t ops, F&& op) {
+    run_t r;
+    std::size_t group = std::max<std::size_t>(opts.group, 1);
+    r.samples_ns.reserve(ops / group + 1);
+    perf_group pg(opts.perf);
+
+    pg.start();
+    auto t0 = bench_clock::now();
+    for (std::size_t i = 0; i < ops; i += group) {
+        std::size_t e = std::min(i + group, ops);
+        auto a = bench_clock::now();
+        for (std::size_t j = i; j < e; ++j) op(j);
+        auto b = bench_clock::now();
+        r.samples_ns.push_back(elapsed_ns(a, b) / static_cast<double>(e - i));
+    }
+    r.wall_ns = elapsed_ns(t0, bench_clock::now());
+    r.hw = pg.stop();
+    r.ops = ops;
+    return r;
+}
+
+// Run time_ops on `threads` threads released together; make_op(t) returns
+// thread t's op(i) callable.  Samples and counters are merged; wall time
+// is the slowest thread's.
+template<typename MakeOp>
+run_t time_threads(const options_t& opts, unsigned threads,
+                   std::size_t ops_per_thread, MakeOp&& make_op) {
+    if (threads <= 1) return time_ops(opts, ops_per_thread, make_op(0u));
+
+    std::vector<run_t> runs(threads);
+    std::atomic<unsigned> ready{0};
+    std::atomic<bool> go{false};
+    std::vector<std::thread> pool;
+    pool.reserve(threads);
+    for (unsigned t = 0; t < threads; ++t) {
+        pool.emplace_back([&, t] {
+            auto op = make_op(t);
+            ready.fetch_add(1);
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            runs[t] = time_ops(opts, ops_per_thread, op);
+        });
+    }
+    while (ready.load() < threads) std::this_thread::yield();
+    go.store(true, std::memory_order_release);
+    for (auto& th : pool) th.join();
+
+    run_t r;
+    for (auto& x : runs) {
+        r.samples_ns.insert(r.samples_ns.end(), x.samples_ns.begin(), x.samples_ns.end());
+        r.ops += x.ops;
+        r.wall_ns = std::max(r.wall_ns, x.wall_ns);
+        r.hw += x.hw;
+    }
+    return r;
+}
+
+inline double percentile(std::vector<double>& v, double q) {
+    if (v.empty()) return 0;
+    std::size_t k = std::min(v.size() - 1,
+                             static_cast<std::size_t>(q * static_cast<double>(v.size())));
+    std::nth_element(v.begin(), v.begin() + static_cast<std::ptrdiff_t>(k), v.end());
+    return v[k];
+}
+
+// ==========================================================================
+// Results
+// ==========================================================================
+
+struct result_t {
+    std::string   suite;
+    std::string   op;
+    std::string   keys;      // key set pattern: sequential / uniform / ...
+    std::string   access;    // access order: sequential / uniform / zipfian
+    std::size_t   n        = 0;
+    unsigned      threads  = 1;
+    std::uint64_t ops      = 0;
+    double        ns_per_op = 0;  // wall time per op per thread
+    double        mops     = 0;   // aggregate throughput
+    double        p50_ns   = 0;
+    double        p99_ns   = 0;
+    double        p999_ns  = 0;
+    std::size_t   bytes    = 0;   // container memory_usage(), 0 if n/a
+    hw_counters_t hw;             // totals over all threads
+};
+
+inline result_t summarize(run_t& r, unsigned threads) {
+    result_t o;
+    o.threads = threads;
+    o.ops     = r.ops;
+    if (r.ops) {
+        double per_thread = static_cast<double>(r.ops) / threads;
+        o.ns_per_op = r.wall_ns / per_thread;
+        o.mops      = r.wall_ns > 0 ? static_cast<double>(r.ops) * 1e3 / r.wall_ns : 0;
+    }
+    o.p50_ns  = percentile(r.samples_ns, 0.50);
+    o.p99_ns  = percentile(r.samples_ns, 0.99);
+    o.p999_ns = percentile(r.samples_ns, 0.999);
+    o.hw      = r.hw;
+    return o;
+}
+
+// ==========================================================================
+// Workload generators
+// ==========================================================================
+
+// n distinct 64-bit keys.  SEQUENTIAL: 0..n-1.  UNIFORM: random, in random order.
+enum class key_pattern { SEQUENTIAL, UNIFORM };
+
+inline const char* name_of(key_pattern p) {
+    return p == key_pattern::SEQUENTIAL ? "sequential" : "uniform";
+}
+
+inline std::vector<std::uint64_t> make_keys(std::size_t n, key_pattern p,
+                                            std::uint64_t seed) {
+    std::vector<std::uint64_t> keys;
+    keys.reserve(n);
+    if (p == key_pattern::SEQUENTIAL) {
+        for (std::size_t i = 0; i < n; ++i) keys.push_back(i);
+        return keys;
+    }
+    std::mt19937_64 rng(seed);
+    while (keys.size() < n) {
+        std::size_t have = keys.size();
+        for (std::size_t i = have; i < n; ++i) keys.push_back(rng());
+        std::sort(keys.begin(), keys.end());
+        keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    }
+    std::shuffle(keys.begin(), keys.end(), rng);
+    return keys;
+}
+
+// Zipfian ranks over [0, n) — Gray et al., "Quickly Generating
+// Billion-Record Synthetic Databases" (the YCSB generator).  Rank 0 is
+// the hottest.
+class zipf_gen {
+    std::size_t n_v;
+    double theta_v, alpha_v, zetan_v, eta_v;
+    std::uniform_real_distribution<double> u_v{0.0, 1.0};
+
+    static double zeta(std::size_t n, double theta) {
+        double s = 0;
+        for (std::size_t i = 1; i <= n; ++i) s += 1.0 / std::pow(static_cast<double>(i), theta);
+        return s;
+    }
+
+public:
+    zipf_gen(std::size_t n, double theta)
+        : n_v(n), theta_v(theta), alpha_v(1.0 / (1.0 - theta)), zetan_v(zeta(n, theta)) {
+        double zeta2 = zeta(2, theta);
+        eta_v = (1.0 - std::pow(2.0 / static_cast<double>(n), 1.0 - theta))
+              / (1.0 - zeta2 / zetan_v);
+    }
+
+    template<typename RNG>
+    std::size_t operator()(RNG& rng) {
+        double u  = u_v(rng);
+        double uz = u * zetan_v;
+        if (uz < 1.0) return 0;
+        if (uz < 1.0 + std::pow(0.5, theta_v)) return std::min<std::size_t>(1, n_v - 1);
+        auto r = static_cast<std::size_t>(
+            static_cast<double>(n_v) * std::pow(eta_v * u - eta_v + 1.0, alpha_v));
+        return std::min(r, n_v - 1);
+    }
+};
+
+enum class access_t { SEQUENTIAL, UNIFORM, ZIPFIAN };
+
+inline const char* name_of(access_t a) {
+    switch (a) {
+    case access_t::SEQUENTIAL: return "sequential";
+    case access_t::UNIFORM:    return "uniform";
+    default:                   return "zipfian";
+    }
+}
+
+// ops indices into a key array of size n.  Zipfian ranks go through a
+// fixed random permutation so the hot keys are scattered across the key
+// space instead of being the first few inserted.
+inline std::vector<std::size_t> make_access(std::size_t n, std::size_t ops, access_t a,
+                                            const options_t& opts) {
+    std::vector<std::size_t> idx(ops);
+    std::mt19937_64 rng(opts.seed ^ 0x9E3779B97F4A7C15ull);
+    switch (a) {
+    case access_t::SEQUENTIAL:
+        for (std::size_t i = 0; i < ops; ++i) idx[i] = i % n;
+        break;
+    case access_t::UNIFORM: {
+        std::uniform_int_distribution<std::size_t> d(0, n - 1);
+        for (auto& x : idx) x = d(rng);
+        break;
+    }
+    case access_t::ZIPFIAN: {
+        std::vector<std::size_t> perm(n);
+        for (std::size_t i = 0; i < n; ++i) perm[i] = i;
+        std::shuffle(perm.begin(), perm.end(), rng);
+        zipf_gen z(n, opts.zipf);
+        for (auto& x : idx) x = perm[z(rng)];
+        break;
+    }
+    }
+    return idx;
+}
+
+// ==========================================================================
+// Suite registry
+// ==========================================================================
+
+struct context_t {
+    options_t             opts;
+    std::vector<result_t> results;
+
+    std::vector<unsigned> thread_sweep() const {
+        if (!opts.threads.empty()) return opts.threads;
+        unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+        std::vector<unsigned> v;
+        for (unsigned t = 1; t < hw; t *= 2) v.push_back(t);
+        v.push_back(hw);
+        return v;
+    }
+
+    // Record one measurement and echo it to stderr.
+    void add(std::string suite, std::string op, std::string keys, std::string access,
+             std::size_t n, unsigned threads, run_t& run, std::size_t bytes = 0) {
+        result_t r = summarize(run, threads);
+        r.suite  = std::move(suite);
+        r.op     = std::move(op);
+        r.keys   = std::move(keys);
+        r.access = std::move(access);
+        r.n      = n;
+        r.bytes  = bytes;
+        std::fprintf(stderr, "%-18s %-20s %-10s %-10s n=%-9zu t=%-3u %8.1f ns/op"
+                             "  p50 %7.1f  p99 %7.1f  p999 %8.1f  %8.2f Mops/s\n",
+                     r.suite.c_str(), r.op.c_str(), r.keys.c_str(), r.access.c_str(),
+                     r.n, r.threads, r.ns_per_op, r.p50_ns, r.p99_ns, r.p999_ns, r.mops);
+        results.push_back(std::move(r));
+    }
+};
+
+using suite_fn = void (*)(context_t&);
+
+struct suite_entry_t {
+    const char* name;
+    suite_fn    fn;
+};
+
+inline std::vector<suite_entry_t>& suites() {
+    static std::vector<suite_entry_t> v;
+    return v;
+}
+
+struct suite_registrar {
+    suite_registrar(const char* name, suite_fn fn) { suites().push_back({name, fn}); }
+};
+
+#define KTRIE_BENCH_SUITE(name)                                              \
+    static void name(::ktrie_bench::context_t&);                             \
+    static ::ktrie_bench::suite_registrar name##_registrar{#name, name};     \
+    static void name(::ktrie_bench::context_t& ctx)
+
+// ==========================================================================
+// JSON output
+// ==========================================================================
+
+inline void json_string(std::FILE* f, const std::string& s) {
+    std::fputc('"', f);
+    for (unsigned char c : s) {
+        if (c == '"' || c == '\\') std::fprintf(f, "\\%c", c);
+        else if (c < 0x20)         std::fprintf(f, "\\u%04x", c);
+        else                       std::fputc(c, f);
+    }
+    std::fputc('"', f);
+}
+
+inline void write_json(std::FILE* f, const context_t& ctx,
+                       const std::vector<std::pair<std::string, std::string>>& meta) {
+    std::fprintf(f, "{\n  \"schema\": \"ktrie_bench/1\",\n  \"meta\": {");
+    for (std::size_t i = 0; i < meta.size(); ++i) {
+        std::fprintf(f, "%s\n    ", i ? "," : "");
+        json_string(f, meta[i].first);
+        std::fprintf(f, ": ");
+        json_string(f, meta[i].second);
+    }
+    std::fprintf(f, "\n  },\n  \"results\": [");
+    for (std::size_t i = 0; i < ctx.results.size(); ++i) {
+        const result_t& r = ctx.results[i];
+        std::fprintf(f, "%s\n    {\"suite\": ", i ? "," : "");
+        json_string(f, r.suite);
+        std::fprintf(f, ", \"op\": ");
+        json_string(f, r.op);
+        std::fprintf(f, ", \"keys\": ");
+        json_string(f, r.keys);
+        std::fprintf(f, ", \"access\": ");
+        json_string(f, r.access);
+        std::fprintf(f, ", \"n\": %zu, \"threads\": %u, \"ops\": %llu, "
+                        "\"ns_per_op\": %.3f, \"mops\": %.4f, "
+                        "\"p50_ns\": %.3f, \"p99_ns\": %.3f, \"p999_ns\": %.3f, "
+                        "\"bytes\": %zu, \"hw\": ",
+                     r.n, r.threads, static_cast<unsigned long long>(r.ops),
+                     r.ns_per_op, r.mops, r.p50_ns, r.p99_ns, r.p999_ns, r.bytes);
+        if (r.hw.valid && r.ops) {
+            double ops = static_cast<double>(r.ops);
+            std::fprintf(f, "{\"cycles_per_op\": %.3f, \"instructions_per_op\": %.3f, "
+                            "\"cache_misses_per_op\": %.4f, \"branch_misses_per_op\": %.4f}}",
+                         r.hw.cycles / ops, r.hw.instructions / ops,
+                         r.hw.cache_misses / ops, r.hw.branch_misses / ops);
+        } else {
+            std::fprintf(f, "null}");
+        }
+    }
+    std::fprintf(f, "\n  ]\n}\n");
+}
+
+// ==========================================================================
+// Driver — parse options, run the registered suites, write JSON.
+// extra_meta carries build facts only the caller knows (SIMD width, ...).
+// ==========================================================================
+
+inline std::vector<std::string> split_list(const char* s) {
+    std::vector<std::string> v;
+    std::string cur;
+    for (const char* p = s; ; ++p) {
+        if (*p == ',' || *p == '\0') {
+            if (!cur.empty()) v.push_back(cur);
+            cur.clear();
+            if (*p == '\0') break;
+        } else {
+            cur += *p;
+        }
+    }
+    return v;
+}
+
+inline int run_main(int argc, char* argv[],
+                    std::vector<std::pair<std::string, std::string>> extra_meta = {}) {
+    const char* prog = argc > 0 ? argv[0] : "ktrie_bench";
+    auto usage = [&] {
+        std::fprintf(stderr,
+            "usage: %s [--n N] [--ops N] [--suite a,b] [--threads 1,2,4]\n"
+            "       [--zipf THETA] [--group N] [--seed S] [--label TAG]\n"
+            "       [--mix A,B,..] [--scan-max N] [--json FILE|-] [--no-perf] [--list]\n",
+            prog);
+    };
+
+    context_t ctx;
+    std::vector<std::string> only;
+    std::string json_path = "-";
+
+    for (int i = 1; i < argc; ++i) {
+        std::string_view a = argv[i];
+        auto next = [&]() -> const char* {
+            if (i + 1 >= argc) { usage(); std::exit(2); }
+            return argv[++i];
+        };
+        if      (a == "--n")        ctx.opts.n        = std::strtoull(next(), nullptr, 10);
+        else if (a == "--ops")      ctx.opts.ops      = std::strtoull(next(), nullptr, 10);
+        else if (a == "--group")    ctx.opts.group    = std::strtoull(next(), nullptr, 10);
+        else if (a == "--seed")     ctx.opts.seed     = std::strtoull(next(), nullptr, 10);
+        else if (a == "--scan-max") ctx.opts.scan_max = std::strtoull(next(), nullptr, 10);
+        else if (a == "--zipf")     ctx.opts.zipf     = std::strtod(next(), nullptr);
+        else if (a == "--label")    ctx.opts.label    = next();
+        else if (a == "--json")     json_path         = next();
+        else if (a == "--suite")    only              = split_list(next());
+        else if (a == "--mix")      ctx.opts.mixes    = split_list(next());
+        else if (a == "--no-perf")  ctx.opts.perf     = false;
+        else if (a == "--threads") {
+            for (auto& s : split_list(next()))
+                ctx.opts.threads.push_back(static_cast<unsigned>(std::strtoul(s.c_str(), nullptr, 10)));
+        } else if (a == "--list") {
+            for (auto& s : suites()) std::printf("%s\n", s.name);
+            return 0;
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (ctx.opts.n == 0 || ctx.opts.scan_max == 0 ||
+        !(ctx.opts.zipf > 0 && ctx.opts.zipf < 1)) {
+        std::fprintf(stderr, "%s: need --n > 0, --scan-max > 0 and 0 < --zipf < 1\n", prog);
+        return 2;
+    }
+
+    for (auto& s : suites()) {
+        if (!only.empty() && std::find(only.begin(), only.end(), s.name) == only.end())
+            continue;
+        s.fn(ctx);
+    }
+
+    char when[32];
+    std::time_t now = std::time(nullptr);
+    std::strftime(when, sizeof(when), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+    perf_group probe(ctx.opts.perf);
+
+    std::vector<std::pair<std::string, std::string>> meta = {
+        {"label",      ctx.opts.label},
+        {"time_utc",   when},
+#if defined(__clang__)
+        {"compiler",   "clang " __clang_version__},
+#elif defined(__GNUC__)
+        {"compiler",   "gcc " __VERSION__},
+#elif defined(_MSC_VER)
+        {"compiler",   "msvc " + std::to_string(_MSC_VER)},
+#endif
+        {"hw_threads", std::to_string(std::thread::hardware_concurrency())},
+        {"perf",       probe.is_open() ? "perf_event" : "unavailable"},
+        {"n",          std::to_string(ctx.opts.n)},
+        {"ops",        std::to_string(ctx.opts.timed_ops())},
+        {"group",      std::to_string(ctx.opts.group)},
+        {"zipf",       std::to_string(ctx.opts.zipf)},
+        {"seed",       std::to_string(ctx.opts.seed)},
+        {"scan_max",   std::to_string(ctx.opts.scan_max)},
+    };
+    for (auto& m : extra_meta) meta.push_back(std::move(m));
+
+    std::FILE* f = json_path == "-" ? stdout : std::fopen(json_path.c_str(), "w");
+    if (!f) {
+        std::fprintf(stderr, "%s: cannot open %s\n", prog, json_path.c_str());
+        return 1;
+    }
+    write_json(f, ctx, meta);
+    if (f != stdout) std::fclose(f);
+    return 0;
+}
+
+} // namespace ktrie_bench
+
+#endif // KTRIE_BENCH_HPP
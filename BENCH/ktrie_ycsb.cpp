@@ -0,0 +1,388 @@
+// ktrie_ycsb.cpp — YCSB-style mixed read/write stress across threads
+//
+// Build: g++ -std=c++23 -O2 -march=x86-64-v3 -I../KNTRIE -I../KSTRIE ktrie_ycsb.cpp -pthread
+// Run:   ./ktrie_ycsb [--n N] [--ops N] [--mix A,B,..] [--threads 1,2,4]
+//                     [--scan-max N] [--zipf THETA] [--suite ycsb_u64,ycsb_string]
+//                     [--json FILE|-] [--no-perf] [--label TAG]
+//
+// Each (workload, store, thread count) row loads n records untimed, then
+// every thread runs --ops operations drawn from the workload mix.  Rows
+// land in the ktrie_bench JSON as suite "ycsb_<W>", op = store name, so
+// throughput-vs-threads curves and p99/p999 come straight out of it.
+//
+// Workloads (Cooper et al., "Benchmarking Cloud Serving Systems with YCSB"):
+//   A  50% read  50% update              zipfian
+//   B  95% read   5% update              zipfian
+//   C 100% read                          zipfian
+//   D  95% read   5% insert              latest
+//   E  95% scan   5% insert              zipfian start, length 1..scan_max
+//   F  50% read  50% read-modify-write   zipfian
+//
+// Stores: sharded_kntrie and concurrent_kntrie as shipped; kntrie, kstrie,
+// std::map and std::unordered_map behind one std::shared_mutex (readers
+// shared, writers exclusive); absl::btree_map likewise when available.
+// Unordered stores skip E.
+
+#include "ktrie_bench.hpp"
+#include "kntrie.hpp"
+#include "concurrent_kntrie.hpp"
+#include "sharded_kntrie.hpp"
+#include "kstrie.hpp"
+
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+#if !defined(KTRIE_YCSB_ABSL)
+#  if __has_include(<absl/container/btree_map.h>)
+#    define KTRIE_YCSB_ABSL 1
+#  else
+#    define KTRIE_YCSB_ABSL 0
+#  endif
+#endif
+#if KTRIE_YCSB_ABSL
+#include <absl/container/btree_map.h>
+#endif
+
+using namespace gteitelbaum;
+using namespace ktrie_bench;
+
+// ==========================================================================
+// Workloads
+// ==========================================================================
+
+enum class op_t : std::uint8_t { READ, UPDATE, INSERT, SCAN, RMW };
+
+struct mix_t {
+    const char* name;
+    unsigned    read, update, insert, scan, rmw;   // percent
+    bool        latest;                            // D: skew toward newest records
+};
+
+static constexpr mix_t MIXES[] = {
+    {"A", 50, 50, 0,  0,  0, false},
+    {"B", 95,  5, 0,  0,  0, false},
+    {"C", 100, 0, 0,  0,  0, false},
+    {"D", 95,  0, 5,  0,  0, true},
+    {"E",  0,  0, 5, 95,  0, false},
+    {"F", 50,  0, 0,  0, 50, false},
+};
+
+// One pre-generated operation.  rec is a record number for zipfian
+// workloads, a recency rank for "latest"; unused by INSERT.
+struct step_t {
+    op_t          op;
+    std::uint32_t len;
+    std::uint64_t rec;
+};
+
+// Record numbers in use.  Inserts claim next; reads under "latest" look
+// back from done, which only counts inserts that have completed.
+struct records_t {
+    std::atomic<std::uint64_t> next;
+    std::atomic<std::uint64_t> done;
+    explicit records_t(std::uint64_t n) : next(n), done(n) {}
+};
+
+// Bijective 64-bit mix (splitmix64 finalizer): record number -> key, so
+// consecutive records scatter over the key space.
+static std::uint64_t mix64(std::uint64_t x) {
+    x ^= x >> 30; x *= 0xBF58476D1CE4E5B9ull;
+    x ^= x >> 27; x *= 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+// Shared per-workload generator state: zipf_gen's zeta sum is O(n), so
+// build it once and hand each thread a copy.
+struct stream_gen_t {
+    const mix_t*             mix;
+    zipf_gen                 zipf;
+    std::vector<std::size_t> perm;   // rank -> record, hot records scattered
+
+    stream_gen_t(const mix_t& m, const options_t& o)
+        : mix(&m), zipf(o.n, o.zipf), perm(o.n) {
+        for (std::size_t i = 0; i < o.n; ++i) perm[i] = i;
+        std::mt19937_64 rng(o.seed ^ 0x9E3779B97F4A7C15ull);
+        std::shuffle(perm.begin(), perm.end(), rng);
+    }
+
+    std::vector<step_t> make(const options_t& o, unsigned tid) const {
+        std::vector<step_t> v(o.timed_ops());
+        std::mt19937_64 rng(o.seed + tid * 7919);
+        std::uniform_int_distribution<unsigned> pct(0, 99);
+        std::uniform_int_distribution<std::uint32_t> len(1, static_cast<std::uint32_t>(o.scan_max));
+        zipf_gen z = zipf;
+        for (auto& s : v) {
+            unsigned p = pct(rng);
+            const mix_t& m = *mix;
+            if      (p < m.read)                              s.op = op_t::READ;
+            else if ((p -= m.read) < m.update)                s.op = op_t::UPDATE;
+            else if ((p -= m.update) < m.insert)              s.op = op_t::INSERT;
+            else if ((p -= m.insert) < m.scan)                s.op = op_t::SCAN;
+            else                                              s.op = op_t::RMW;
+            std::size_t rank = z(rng);
+            s.rec = m.latest ? rank : perm[rank];
+            s.len = s.op == op_t::SCAN ? len(rng) : 1;
+        }
+        return v;
+    }
+};
+
+// ==========================================================================
+// Stores — read / update / insert / scan over one key type
+// ==========================================================================
+
+template<typename MAP>
+concept ordered_map = requires(const MAP& m, const typename MAP::key_type& k) {
+    m.lower_bound(k);
+};
+
+// Any map behind a single reader/writer lock.
+template<typename MAP>
+class locked_store {
+    MAP                       m_v;
+    mutable std::shared_mutex mu_v;
+
+    template<typename K>
+    void put(const K& k, std::uint64_t v) {
+        if constexpr (requires { m_v.insert_or_assign(k, v); })
+            m_v.insert_or_assign(k, v);
+        else
+            m_v.insert_or_assign(typename MAP::key_type(k), v);
+    }
+
+public:
+    static constexpr bool ORDERED = ordered_map<MAP>;
+
+    template<typename K>
+    bool read(const K& k, std::uint64_t& out) const {
+        std::shared_lock lk(mu_v);
+        auto it = m_v.find(k);
+        if (it == m_v.end()) return false;
+        out = (*it).second;
+        return true;
+    }
+
+    template<typename K>
+    void update(const K& k, std::uint64_t v) { std::unique_lock lk(mu_v); put(k, v); }
+
+    template<typename K>
+    void insert(const K& k, std::uint64_t v) { std::unique_lock lk(mu_v); put(k, v); }
+
+    template<typename K>
+    std::uint64_t scan(const K& k, std::size_t len) const requires ORDERED {
+        std::shared_lock lk(mu_v);
+        std::uint64_t sum = 0;
+        auto it = m_v.lower_bound(k);
+        for (std::size_t i = 0; i < len && it != m_v.end(); ++i, ++it) sum += (*it).second;
+        return sum;
+    }
+
+    std::size_t bytes() const {
+        if constexpr (requires { m_v.memory_usage(); }) return m_v.memory_usage();
+        else return 0;
+    }
+};
+
+class sharded_store {
+    sharded_kntrie<std::uint64_t, std::uint64_t> s_v;
+
+public:
+    static constexpr bool ORDERED = true;
+
+    bool read(std::uint64_t k, std::uint64_t& out) const {
+        auto v = s_v.find(k);
+        if (!v) return false;
+        out = *v;
+        return true;
+    }
+    void update(std::uint64_t k, std::uint64_t v) { s_v.insert_or_assign(k, v); }
+    void insert(std::uint64_t k, std::uint64_t v) { s_v.insert_or_assign(k, v); }
+
+    std::uint64_t scan(std::uint64_t k, std::size_t len) const {
+        std::uint64_t sum = 0;
+        s_v.for_each_from(k, len, [&](std::uint64_t, std::uint64_t v) { sum += v; });
+        return sum;
+    }
+
+    std::size_t bytes() const { return 0; }
+};
+
+class concurrent_store {
+    using trie_type = kntrie<std::uint64_t, std::uint64_t>;
+    concurrent_kntrie<std::uint64_t, std::uint64_t> c_v;
+
+public:
+    static constexpr bool ORDERED = true;
+
+    bool read(std::uint64_t k, std::uint64_t& out) const {
+        auto v = c_v.find(k);
+        if (!v) return false;
+        out = *v;
+        return true;
+    }
+    void update(std::uint64_t k, std::uint64_t v) { c_v.insert_or_assign(k, v); }
+    void insert(std::uint64_t k, std::uint64_t v) { c_v.insert_or_assign(k, v); }
+
+    std::uint64_t scan(std::uint64_t k, std::size_t len) const {
+        return c_v.read([&](const trie_type& t) {
+            std::uint64_t sum = 0;
+            auto it = t.lower_bound(k);
+            for (std::size_t i = 0; i < len && it != t.end(); ++i, ++it) sum += (*it).second;
+            return sum;
+        });
+    }
+
+    std::size_t bytes() const {
+        return c_v.read([](const trie_type& t) { return t.memory_usage(); });
+    }
+};
+
+// Transparent hash so unordered_map<std::string> looks up by string_view.
+struct string_hash {
+    using is_transparent = void;
+    std::size_t operator()(std::string_view s) const noexcept {
+        return std::hash<std::string_view>{}(s);
+    }
+};
+
+// ==========================================================================
+// Keys — record number -> store key
+// ==========================================================================
+
+struct u64_keys {
+    static constexpr const char* NAME = "u64";
+    std::uint64_t operator()(std::uint64_t rec) { return mix64(rec); }
+};
+
+// "user" + hashed record number, as YCSB's own key builder.
+struct string_keys {
+    static constexpr const char* NAME = "string";
+    char buf[32];
+    std::string_view operator()(std::uint64_t rec) {
+        int len = std::snprintf(buf, sizeof(buf), "user%llu",
+                                static_cast<unsigned long long>(mix64(rec)));
+        return {buf, static_cast<std::size_t>(len)};
+    }
+};
+
+// ==========================================================================
+// Runner
+// ==========================================================================
+
+template<typename STORE, typename KEYS>
+static void run_store(context_t& ctx, const stream_gen_t& gen, const char* store_name) {
+    const options_t& o = ctx.opts;
+    const mix_t& m = *gen.mix;
+    if constexpr (!STORE::ORDERED) {
+        if (m.scan) return;
+    }
+    std::string suite = std::string("ycsb_") + m.name;
+    const char* access = m.latest ? "latest" : "zipfian";
+
+    for (unsigned th : ctx.thread_sweep()) {
+        STORE store;
+        KEYS load_keys;
+        for (std::uint64_t r = 0; r < o.n; ++r) store.insert(load_keys(r), r);
+        records_t recs(o.n);
+
+        auto run = time_threads(o, th, o.timed_ops(), [&](unsigned tid) {
+            return [&store, &recs, steps = gen.make(o, tid), &m, keys = KEYS{}]
+                   (std::size_t i) mutable {
+                const step_t& s = steps[i];
+                std::uint64_t rec = s.rec;
+                if (m.latest) {
+                    std::uint64_t n = recs.done.load(std::memory_order_relaxed);
+                    rec = n - 1 - std::min<std::uint64_t>(rec, n - 1);
+                }
+                std::uint64_t v = 0;
+                switch (s.op) {
+                case op_t::READ:
+                    store.read(keys(rec), v);
+                    do_not_optimize(v);
+                    break;
+                case op_t::UPDATE:
+                    store.update(keys(rec), i);
+                    break;
+                case op_t::INSERT: {
+                    std::uint64_t r = recs.next.fetch_add(1, std::memory_order_relaxed);
+                    store.insert(keys(r), r);
+                    recs.done.fetch_add(1, std::memory_order_release);
+                    break;
+                }
+                case op_t::SCAN:
+                    if constexpr (STORE::ORDERED) v = store.scan(keys(rec), s.len);
+                    do_not_optimize(v);
+                    break;
+                case op_t::RMW:
+                    store.read(keys(rec), v);
+                    store.update(keys(rec), v + 1);
+                    break;
+                }
+            };
+        });
+        ctx.add(suite, store_name, KEYS::NAME, access, o.n, th, run, store.bytes());
+    }
+}
+
+template<typename F>
+static void for_each_mix(const context_t& ctx, F&& fn) {
+    for (const mix_t& m : MIXES) {
+        const auto& want = ctx.opts.mixes;
+        if (!want.empty() && std::find(want.begin(), want.end(), m.name) == want.end())
+            continue;
+        fn(m);
+    }
+}
+
+// ==========================================================================
+// ycsb_u64 — 64-bit keys
+// ==========================================================================
+
+KTRIE_BENCH_SUITE(ycsb_u64) {
+    using U = std::uint64_t;
+    for_each_mix(ctx, [&](const mix_t& m) {
+        stream_gen_t gen(m, ctx.opts);
+        run_store<sharded_store,                            u64_keys>(ctx, gen, "sharded_kntrie");
+        run_store<concurrent_store,                         u64_keys>(ctx, gen, "concurrent_kntrie");
+        run_store<locked_store<kntrie<U, U>>,               u64_keys>(ctx, gen, "locked_kntrie");
+        run_store<locked_store<std::map<U, U>>,             u64_keys>(ctx, gen, "locked_map");
+        run_store<locked_store<std::unordered_map<U, U>>,   u64_keys>(ctx, gen, "locked_unordered_map");
+#if KTRIE_YCSB_ABSL
+        run_store<locked_store<absl::btree_map<U, U>>,      u64_keys>(ctx, gen, "locked_btree_map");
+#endif
+    });
+}
+
+// ==========================================================================
+// ycsb_string — "user<hash>" keys
+// ==========================================================================
+
+KTRIE_BENCH_SUITE(ycsb_string) {
+    using U = std::uint64_t;
+    using smap  = std::map<std::string, U, std::less<>>;
+    using shash = std::unordered_map<std::string, U, string_hash, std::equal_to<>>;
+    for_each_mix(ctx, [&](const mix_t& m) {
+        stream_gen_t gen(m, ctx.opts);
+        run_store<locked_store<kstrie<U>>, string_keys>(ctx, gen, "locked_kstrie");
+        run_store<locked_store<smap>,      string_keys>(ctx, gen, "locked_map");
+        run_store<locked_store<shash>,     string_keys>(ctx, gen, "locked_unordered_map");
+#if KTRIE_YCSB_ABSL
+        using sbtree = absl::btree_map<std::string, U, std::less<>>;
+        run_store<locked_store<sbtree>,    string_keys>(ctx, gen, "locked_btree_map");
+#endif
+    });
+}
+
+// ==========================================================================
+// Driver
+// ==========================================================================
+
+int main(int argc, char* argv[]) {
+    return run_main(argc, argv, {
+        {"kntrie_simd_search_bits", std::to_string(KNTRIE_SIMD_SEARCH_BITS)},
+        {"kstrie_simd_search_bits", std::to_string(KSTRIE_SIMD_SEARCH_BITS)},
+        {"absl_btree",              KTRIE_YCSB_ABSL ? "yes" : "no"},
+    });
+}
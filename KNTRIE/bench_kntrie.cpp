@@ -715,6 +715,57 @@ static void run_bench(size_t max_n, bool verbose,
     std::fflush(stdout);  // Forces immediate output to the console
 }
 
+// ==========================================================================
+// bench_search — compact-leaf search kernel, scalar vs dispatching
+//
+// Sorted unique leaves of the sizes compact nodes actually hold; probes
+// are present keys in random order.  "simd" is adaptive_search as the
+// trie calls it (scalar when the target has no AVX2/AVX-512 or the
+// leaf is narrower than one vector).
+// ==========================================================================
+
+template<typename K>
+static void bench_search_rows(const char* key_name) {
+    using namespace gteitelbaum::kntrie_detail;
+    constexpr size_t PROBES = 1 << 20;
+    std::mt19937_64 rng(42);
+    for (unsigned n : {8u, 16u, 32u, 64u, 128u, 256u, 512u, 1024u}) {
+        std::set<K> s;
+        while (s.size() < n) s.insert(static_cast<K>(rng()));
+        std::vector<K> ks(s.begin(), s.end());
+        std::vector<K> probes(PROBES);
+        for (auto& p : probes) p = ks[rng() % n];
+
+        double best_scalar = 1e18, best_simd = 1e18;
+        for (int t = 0; t < TRIALS; ++t) {
+            uint64_t cs = 0;
+            double t0 = now_ms();
+            for (K p : probes)
+                cs += adaptive_search_scalar(ks.data(), n, p, std::less_equal<K>{}) - ks.data();
+            best_scalar = std::min(best_scalar, now_ms() - t0);
+            do_not_optimize(cs);
+
+            cs = 0;
+            t0 = now_ms();
+            for (K p : probes)
+                cs += adaptive_search_last(ks.data(), n, p) - ks.data();
+            best_simd = std::min(best_simd, now_ms() - t0);
+            do_not_optimize(cs);
+        }
+        double ns = 1e6 / PROBES;
+        std::printf("%-4s %5u %10.2f %10.2f %8.2fx\n", key_name, n,
+                    best_scalar * ns, best_simd * ns, best_scalar / best_simd);
+    }
+}
+
+static void bench_search() {
+    std::printf("leaf search ns/lookup (SIMD width %d bits)\n",
+                KNTRIE_SIMD_SEARCH_BITS);
+    std::printf("%-4s %5s %10s %10s %9s\n", "key", "N", "scalar", "simd", "speedup");
+    bench_search_rows<uint16_t>("u16");
+    bench_search_rows<uint32_t>("u32");
+}
+
 // ==========================================================================
 // Dispatch — nested switch on key type x value type
 // ==========================================================================
@@ -741,13 +792,18 @@ static type_id parse_type(const char* s) {
 
 
 int main(int argc, char* argv[]) {
+    if (argc == 2 && !std::strcmp(argv[1], "search")) {
+        bench_search();
+        return 0;
+    }
     if (argc < 5 || argc > 6) {
         std::fprintf(stderr,
             "Usage: %s <key_type> <val_type> <max_entries> <verbose:y/n> [output.html]\n"
+            "       %s search      (leaf search kernel: scalar vs SIMD)\n"
             "  Key types:   u16 i16 u32 i32 u64 i64\n"
             "  Value types: bool i8 i16 i32 i64 string big256\n"
             "  Example: %s u64 i32 6000000 y chart64.html\n",
-            argv[0], argv[0]);
+            argv[0], argv[0], argv[0]);
         return 1;
     }
 
@@ -0,0 +1,201 @@
+#ifndef CONCURRENT_KNTRIE_HPP
+#define CONCURRENT_KNTRIE_HPP
+
+#include "kntrie.hpp"
+#include <atomic>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+namespace gteitelbaum {
+
+namespace kntrie_detail {
+
+// ==========================================================================
+// Read indicator: striped reader counts, one cache line per stripe.
+//
+// Each thread sticks to one stripe (assigned round-robin on first use),
+// so readers on different cores never write the same line.
+// ==========================================================================
+
+inline constexpr std::size_t READ_STRIPES = 32;
+
+inline std::size_t read_stripe() noexcept {
+    static std::atomic<std::size_t> next_v{0};
+    thread_local std::size_t mine_v =
+        next_v.fetch_add(1, std::memory_order_relaxed) % READ_STRIPES;
+    return mine_v;
+}
+
+struct read_indicator_t {
+    struct alignas(CACHE_LINE_BYTES) stripe_t {
+        std::atomic<std::int64_t> n_v{0};
+    };
+    stripe_t stripes_v[READ_STRIPES];
+
+    void arrive(std::size_t s) noexcept { stripes_v[s].n_v.fetch_add(1); }
+    void depart(std::size_t s) noexcept { stripes_v[s].n_v.fetch_sub(1); }
+
+    bool is_empty() const noexcept {
+        for (const auto& s : stripes_v)
+            if (s.n_v.load() != 0) return false;
+        return true;
+    }
+
+    void wait_empty() const noexcept {
+        while (!is_empty()) std::this_thread::yield();
+    }
+};
+
+} // namespace kntrie_detail
+
+// ==========================================================================
+// concurrent_kntrie<KEY, VALUE, ALLOC>
+//
+// Read-mostly concurrent map: lock-free readers, mutexed writers.
+//
+// Left-right scheme.  Two full kntrie instances; readers always run the
+// ordinary find loop on the published one with no lock and no shared
+// write (only their own indicator stripe).  A writer applies its
+// mutation to the hidden instance, publishes it with one atomic store,
+// flips the epoch and waits for readers of the previous epoch to drain
+// — the retired instance is then private to the writer, which replays
+// the same mutation on it so both copies agree again.
+//
+// Cost: 2x memory, each write runs twice, writers serialize.  Readers
+// never block and never see a half-built node.  Mutations passed to
+// write() must be deterministic (they run once per instance).
+// ==========================================================================
+
+template<typename KEY, typename VALUE, typename ALLOC = std::allocator<std::uint64_t>>
+class concurrent_kntrie {
+public:
+    using trie_type   = kntrie<KEY, VALUE, ALLOC>;
+    using key_type    = KEY;
+    using mapped_type = VALUE;
+    using size_type   = std::size_t;
+
+private:
+    trie_type                                inst_v[2];
+    std::atomic<unsigned>                    active_v{0};
+    std::atomic<unsigned>                    epoch_v{0};
+    mutable kntrie_detail::read_indicator_t  readers_v[2];
+    std::mutex                               write_mu_v;
+
+    // Copy one instance over the other after fn left it out of step.  If
+    // the copy itself throws there is no consistent state left to keep.
+    void resync(unsigned from) noexcept { inst_v[from ^ 1] = inst_v[from]; }
+
+    // Wait until no reader can still be looking at the retired instance.
+    void drain_readers() noexcept {
+        unsigned e = epoch_v.load();
+        readers_v[e ^ 1].wait_empty();
+        epoch_v.store(e ^ 1);
+        readers_v[e].wait_empty();
+    }
+
+public:
+    concurrent_kntrie() = default;
+    explicit concurrent_kntrie(const ALLOC& a) : inst_v{trie_type(a), trie_type(a)} {}
+
+    concurrent_kntrie(const concurrent_kntrie&) = delete;
+    concurrent_kntrie& operator=(const concurrent_kntrie&) = delete;
+
+    // ------------------------------------------------------------------
+    // Readers — fn(const trie_type&) runs against a stable snapshot.
+    // References into the trie must not escape fn.
+    // ------------------------------------------------------------------
+
+    template<typename Fn>
+    decltype(auto) read(Fn&& fn) const {
+        std::size_t s = kntrie_detail::read_stripe();
+        unsigned e = epoch_v.load();
+        readers_v[e].arrive(s);
+        struct depart_t {
+            kntrie_detail::read_indicator_t& r; std::size_t s;
+            ~depart_t() { r.depart(s); }
+        } guard{readers_v[e], s};
+        return fn(std::as_const(inst_v[active_v.load()]));
+    }
+
+    std::optional<VALUE> find(const KEY& key) const {
+        return read([&](const trie_type& t) -> std::optional<VALUE> {
+            auto it = t.find(key);
+            if (it == t.end()) return std::nullopt;
+            return VALUE((*it).second);
+        });
+    }
+
+    bool contains(const KEY& key) const {
+        return read([&](const trie_type& t) { return t.contains(key); });
+    }
+
+    size_type size() const {
+        return read([](const trie_type& t) { return t.size(); });
+    }
+
+    bool empty() const { return size() == 0; }
+
+    // ------------------------------------------------------------------
+    // Writers — fn(trie_type&) is applied to both instances in turn.
+    // Returns fn's result from the first application.
+    //
+    // If fn throws on the first application nothing is published: the
+    // hidden instance is restored from the published one and the
+    // exception propagates.  If it throws on the replay the write has
+    // already been published, so it stands: the retired instance is
+    // restored from the published one and the exception is dropped.
+    // Either restore is a full copy; std::terminate if that throws.
+    // ------------------------------------------------------------------
+
+    template<typename Fn>
+    decltype(auto) write(Fn&& fn) {
+        std::lock_guard<std::mutex> lk(write_mu_v);
+        unsigned cur = active_v.load(std::memory_order_relaxed);
+        auto apply = [&] {
+            try {
+                return fn(inst_v[cur ^ 1]);
+            } catch (...) {
+                resync(cur);
+                throw;
+            }
+        };
+        auto replay = [&] {
+            active_v.store(cur ^ 1);
+            drain_readers();
+            try {
+                fn(inst_v[cur]);
+            } catch (...) {
+                resync(cur ^ 1);
+            }
+        };
+        if constexpr (std::is_void_v<std::invoke_result_t<Fn&, trie_type&>>) {
+            apply();
+            replay();
+        } else {
+            auto r = apply();
+            replay();
+            return r;
+        }
+    }
+
+    bool insert(const KEY& key, const VALUE& value) {
+        return write([&](trie_type& t) { return t.insert(key, value).second; });
+    }
+
+    bool insert_or_assign(const KEY& key, const VALUE& value) {
+        return write([&](trie_type& t) { return t.insert_or_assign(key, value).second; });
+    }
+
+    size_type erase(const KEY& key) {
+        return write([&](trie_type& t) { return t.erase(key); });
+    }
+
+    void clear() {
+        write([](trie_type& t) { t.clear(); });
+    }
+};
+
+} // namespace gteitelbaum
+
+#endif // CONCURRENT_KNTRIE_HPP
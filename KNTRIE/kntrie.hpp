@@ -1,13 +1,22 @@
 #ifndef KNTRIE_HPP
 #define KNTRIE_HPP
 
+#include "kntrie_coro.hpp"
 #include "kntrie_impl.hpp"
+#include "kntrie_pool_allocator.hpp"
 #include <stdexcept>
 #include <iterator>
 #include <initializer_list>
+#include <span>
 
 namespace gteitelbaum {
 
+// Process-wide hot-path counters, shared by every kntrie instantiation.
+// All zero unless built with KNTRIE_INSTRUMENT=1.
+using kntrie_instrument_t = kntrie_detail::instrument_t;
+inline kntrie_instrument_t kntrie_instrument() noexcept { return kntrie_detail::instrument_snapshot(); }
+inline void kntrie_instrument_reset() noexcept { kntrie_detail::instrument_reset(); }
+
 template<typename KEY, typename VALUE, typename ALLOC = std::allocator<std::uint64_t>>
 class kntrie {
     static_assert(std::is_integral_v<KEY> && sizeof(KEY) >= 2,
@@ -198,11 +207,103 @@ public:
     using reverse_iterator       = std::reverse_iterator<iterator>;
     using const_reverse_iterator = reverse_iterator;
 
+    // ==================================================================
+    // scan_cursor — range scan one leaf at a time.
+    //
+    // Each next() exposes one leaf's run of keys and values as spans.
+    // Compact-leaf values (and unsigned keys) are the leaf's own
+    // arrays; bitmap-leaf and signed keys are decoded into a cursor
+    // buffer.  The following leaf is located and prefetched before
+    // next() returns, so its lines arrive while the caller works on the
+    // current block.  Values must be stored inline (trivially copyable,
+    // at most 8 bytes, not bool).  Spans are valid until the next call
+    // or any modification of the trie.
+    // ==================================================================
+
+    class scan_cursor {
+        friend class kntrie;
+        static constexpr std::size_t BUF = KO::IS_SIGNED
+            ? kntrie_detail::COMPACT_MAX : kntrie_detail::BYTE_VALUES;
+        static constexpr unsigned LEAF_START = ~0u;
+
+        std::uint64_t* leaf_v = nullptr;   // leaf the next block comes from
+        unsigned       from_v = 0;         // compact pos / bitmap bit, or LEAF_START
+        UK             hi_v   = 0;         // stored exclusive end
+        const KEY*     keys_v = nullptr;
+        const VALUE*   vals_v = nullptr;
+        std::size_t    n_v    = 0;
+        KEY            buf_v[BUF];
+
+        scan_cursor(const impl_t& impl, UK lo, UK hi) noexcept : hi_v(hi) {
+            if (lo >= hi) return;
+            auto e = impl.lower_bound_entry(lo);
+            if (!e.found) return;
+            leaf_v = e.leaf;
+            from_v = kntrie_detail::get_header(e.leaf)->is_bitmap() ? e.bit : e.pos;
+        }
+
+    public:
+        scan_cursor(const scan_cursor&) = delete;
+        scan_cursor& operator=(const scan_cursor&) = delete;
+
+        // Advance to the next non-empty block; false once past hi
+        bool next() noexcept {
+            using namespace kntrie_detail;
+            n_v = 0;
+            if (!leaf_v) return false;
+            std::uint64_t* leaf = leaf_v;
+            auto* hdr = get_header(leaf);
+            bool done;
+
+            if (!hdr->is_bitmap()) [[likely]] {
+                const UK* kd = CO::keys(leaf, COMPACT_HEADER_U64);
+                unsigned from = from_v == LEAF_START ? 0 : from_v;
+                unsigned to = hdr->entries();
+                done = kd[to - 1] >= hi_v;
+                if (done)
+                    to = static_cast<unsigned>(std::lower_bound(kd + from, kd + to, hi_v) - kd);
+                n_v = to - from;
+                vals_v = reinterpret_cast<const VALUE*>(CO::vals(leaf) + from);
+                if constexpr (KO::IS_SIGNED) {
+                    for (std::size_t i = 0; i < n_v; ++i) buf_v[i] = KO::to_user(kd[from + i]);
+                    keys_v = buf_v;
+                } else {
+                    keys_v = reinterpret_cast<const KEY*>(kd + from);
+                }
+            } else {
+                const bitmap_256_t& bmp = BO::bm(leaf, BITMAP_LEAF_HEADER_U64);
+                UK base = BO::read_base_key(leaf);
+                unsigned b = from_v == LEAF_START ? bmp.first_set_bit() : from_v;
+                vals_v = static_cast<const VALUE*>(BO::bm_val_ptr(leaf, BITMAP_LEAF_HEADER_U64,
+                    bmp.find_slot<slot_mode::UNFILTERED>(static_cast<std::uint8_t>(b))));
+                done = false;
+                for (;;) {
+                    UK k = base | UK(b);
+                    if (k >= hi_v) { done = true; break; }
+                    buf_v[n_v++] = KO::to_user(k);
+                    auto r = bmp.next_bit_after(static_cast<std::uint8_t>(b));
+                    if (!r.found) break;
+                    b = r.idx;
+                }
+                keys_v = buf_v;
+            }
+
+            leaf_v = done ? nullptr : impl_t::next_leaf(leaf);
+            from_v = LEAF_START;
+            if (leaf_v) prefetch_leaf(leaf_v);
+            return n_v != 0;
+        }
+
+        std::span<const KEY>   keys()   const noexcept { return {keys_v, n_v}; }
+        std::span<const VALUE> values() const noexcept { return {vals_v, n_v}; }
+    };
+
     // ==================================================================
     // Construction / Destruction
     // ==================================================================
 
     kntrie() = default;
+    explicit kntrie(const ALLOC& a) : impl_(a) {}
     ~kntrie() = default;
 
     kntrie(kntrie&& o) noexcept : impl_(std::move(o.impl_)) {}
@@ -212,20 +313,148 @@ public:
         return *this;
     }
 
+    // Copy: structural node-by-node clone, O(n) with no re-insertion.
     kntrie(const kntrie& o) {
-        for (auto [k, v] : o)
-            impl_.insert(KO::to_stored(k), v);
+        impl_.clone_from(o.impl_);
     }
 
     kntrie& operator=(const kntrie& o) {
-        if (this != &o) {
-            impl_.clear();
-            for (auto [k, v] : o)
-                impl_.insert(KO::to_stored(k), v);
-        }
+        if (this != &o)
+            impl_.clone_from(o.impl_);
         return *this;
     }
 
+    // ------------------------------------------------------------------
+    // Bulk load from a range of (key, value) pairs in ascending key order
+    // (key_comp order).  Builds every node once at final size instead of
+    // inserting key by key.  Repeated keys keep the first occurrence;
+    // unsorted input throws std::invalid_argument.
+    // ------------------------------------------------------------------
+
+    template<typename InputIt>
+    requires (!std::is_integral_v<InputIt>)
+    static kntrie from_sorted(InputIt first, InputIt last) {
+        kntrie t;
+        t.assign_sorted(first, last);
+        return t;
+    }
+
+    template<typename InputIt>
+    requires (!std::is_integral_v<InputIt>)
+    void assign_sorted(InputIt first, InputIt last) {
+        impl_.assign_sorted(first, last,
+            [](const KEY& k) noexcept { return KO::to_stored(k); });
+    }
+
+    // Parallel variant: subtrees under the first branching byte are
+    // built on up to `threads` threads, then stitched under one root.
+    // Falls back to the serial build for stateful allocators.
+    template<typename InputIt>
+    requires (!std::is_integral_v<InputIt>)
+    static kntrie from_sorted(InputIt first, InputIt last, unsigned threads) {
+        kntrie t;
+        t.assign_sorted(first, last, threads);
+        return t;
+    }
+
+    template<typename InputIt>
+    requires (!std::is_integral_v<InputIt>)
+    void assign_sorted(InputIt first, InputIt last, unsigned threads) {
+        impl_.assign_sorted(first, last,
+            [](const KEY& k) noexcept { return KO::to_stored(k); }, threads);
+    }
+
+    // ------------------------------------------------------------------
+    // Set algebra — both trees are descended in lockstep: bitmask nodes
+    // dispatch over the AND / OR of their child bitmaps, so subtrees on
+    // one side only are skipped or copied whole, and leaves are merged
+    // linearly.  The result is bulk built in one pass.  A key in both
+    // takes this trie's value; merge_with takes
+    // combine(const VALUE& mine, const VALUE& theirs) instead.
+    // ------------------------------------------------------------------
+
+    kntrie intersect(const kntrie& o) const {
+        return join<true, false, false>(o, keep_mine);
+    }
+
+    kntrie set_union(const kntrie& o) const {
+        return join<true, true, true>(o, keep_mine);
+    }
+
+    kntrie set_difference(const kntrie& o) const {
+        return join<false, true, false>(o, keep_mine);
+    }
+
+    template<typename F>
+    kntrie merge_with(const kntrie& o, F&& combine) const {
+        return join<true, true, true>(o, combine);
+    }
+
+    // ------------------------------------------------------------------
+    // Bool tries as integer sets — the set is the keys mapped to true
+    // (a key mapped to false is not a member).  bitset_* join two tries
+    // 64 keys at a time: bitmap leaves over the same 256 keys combine
+    // their value bitmaps in one vector op, compact leaves are gathered
+    // into words.  Results map every member to true.
+    // ------------------------------------------------------------------
+
+    kntrie bitset_or(const kntrie& o) const requires IS_BOOL {
+        return bitset<kntrie_detail::bitset_op::OR>(o);
+    }
+
+    kntrie bitset_and(const kntrie& o) const requires IS_BOOL {
+        return bitset<kntrie_detail::bitset_op::AND>(o);
+    }
+
+    kntrie bitset_andnot(const kntrie& o) const requires IS_BOOL {
+        return bitset<kntrie_detail::bitset_op::ANDNOT>(o);
+    }
+
+    // Number of members (keys mapped to true), by popcount of the
+    // leaves' value bits.
+    size_type count() const noexcept requires IS_BOOL {
+        return impl_.count_true();
+    }
+
+    // fn(KEY base, std::uint64_t word) for each nonzero word of members
+    // in key order: bit i of word is key base + i; base is a multiple
+    // of 64 (of the sign-flipped key for signed KEY).
+    template<typename F>
+    void for_each_word(F&& fn) const requires IS_BOOL {
+        impl_.for_each_word([&](UK base, std::uint64_t w) { fn(KO::to_user(base), w); });
+    }
+
+    // ==================================================================
+    // On-disk image
+    //
+    // save() writes a frozen copy with offsets in place of pointers;
+    // map() maps it read-only and serves find / lower_bound / iteration
+    // straight from the file.  map(path, policy) loads a private copy
+    // into huge-page / NUMA-placed memory instead; map_replicated()
+    // loads one copy per NUMA node and serves each thread from the copy
+    // local to its socket.  VALUE must be stored inline.
+    // ==================================================================
+
+    void save(const std::string& path) const {
+        impl_.save_image(path.c_str(),
+            KO::IS_SIGNED ? kntrie_detail::IMAGE_FLAG_SIGNED : std::uint8_t(0));
+    }
+
+    static kntrie_view<KEY, VALUE> map(const std::string& path) {
+        return kntrie_view<KEY, VALUE>(path);
+    }
+
+    static kntrie_view<KEY, VALUE> map(const std::string& path,
+                                       const kntrie_page_policy& pol) {
+        return kntrie_view<KEY, VALUE>(path, pol);
+    }
+
+    static kntrie_numa_view<KEY, VALUE> map_replicated(
+            const std::string& path,
+            kntrie_huge_pages huge = kntrie_huge_pages::TRANSPARENT) {
+        return kntrie_numa_view<KEY, VALUE>(path, huge);
+    }
+
     void swap(kntrie& o) noexcept { impl_.swap(o.impl_); }
     friend void swap(kntrie& a, kntrie& b) noexcept { a.swap(b); }
 
@@ -346,8 +575,29 @@ public:
     }
 
     iterator erase(iterator first, iterator last) {
-        while (first != last) first = erase(first);
-        return last;
+        if (first == last) return last;
+        bool to_end = !last.leaf_v;
+        UK hi = last.key_v;
+        impl_.erase_range(first.key_v, to_end ? ~UK(0) : UK(hi - 1));
+        if (to_end) return end();
+        return iterator(impl_.find_entry(hi));
+    }
+
+    // Keys in [lo, hi).  Subtrees wholly inside the range are dropped
+    // without visiting their entries; only the two boundary paths are
+    // rewritten.
+    size_type erase_range(const KEY& lo, const KEY& hi) {
+        if (!key_compare{}(lo, hi)) return 0;
+        return impl_.erase_range(KO::to_stored(lo), UK(KO::to_stored(hi) - 1));
+    }
+
+    // Moves the keys in [lo, hi) into a new kntrie sharing this
+    // allocator; whole subtrees are moved, not copied.
+    kntrie extract_range(const KEY& lo, const KEY& hi) {
+        kntrie out(get_allocator());
+        if (key_compare{}(lo, hi))
+            impl_.extract_range(KO::to_stored(lo), UK(KO::to_stored(hi) - 1), out.impl_);
+        return out;
     }
 
     void clear() noexcept { impl_.clear(); }
@@ -374,22 +624,139 @@ public:
         return const_iterator(r);
     }
 
+    // ------------------------------------------------------------------
+    // Batched lookup — descents for independent keys run in lockstep with
+    // software prefetch, overlapping their cache misses.  out[i] receives
+    // the result for keys[i]; out must be at least keys.size() long.
+    // ------------------------------------------------------------------
+
+    void find_batch(std::span<const KEY> keys, std::span<iterator> out) const {
+        if (out.size() < keys.size()) [[unlikely]]
+            throw std::invalid_argument("kntrie::find_batch: output too small");
+        iterator e = end();
+        batch_lookup(keys, [&](std::size_t i, const kntrie_detail::iter_entry_t<UK>& r) {
+            out[i] = r.found ? iterator(r) : e;
+        });
+    }
+
+    void find_batch(std::span<const KEY> keys, std::span<const VALUE*> out) const
+    requires (!IS_BOOL) {
+        if (out.size() < keys.size()) [[unlikely]]
+            throw std::invalid_argument("kntrie::find_batch: output too small");
+        batch_lookup(keys, [&](std::size_t i, const kntrie_detail::iter_entry_t<UK>& r) {
+            out[i] = r.found ? &deref_val_const(r.val) : nullptr;
+        });
+    }
+
+    // Bit i of words[i / 64] is set iff keys[i] is present.
+    void contains_batch(std::span<const KEY> keys, std::span<std::uint64_t> words) const {
+        std::size_t nw = (keys.size() + kntrie_detail::U64_BITS - 1) / kntrie_detail::U64_BITS;
+        if (words.size() < nw) [[unlikely]]
+            throw std::invalid_argument("kntrie::contains_batch: output too small");
+        std::fill(words.begin(), words.begin() + nw, std::uint64_t(0));
+        batch_lookup(keys, [&](std::size_t i, const kntrie_detail::iter_entry_t<UK>& r) {
+            words[i / kntrie_detail::U64_BITS] |=
+                std::uint64_t(r.found) << (i % kntrie_detail::U64_BITS);
+        });
+    }
+
+    // ------------------------------------------------------------------
+    // Coroutine lookup — see kntrie_coro.hpp.  Each bitmask hop prefetches
+    // the child and co_awaits hop(), letting a scheduler run other
+    // lookups while the miss resolves.  co_lower_bound warms the key's
+    // path the same way, then resolves with lower_bound on hot lines.
+    // ------------------------------------------------------------------
+
+    template<typename HOP = kntrie_hop>
+    kntrie_lookup<const_iterator, HOP> co_find(KEY key, HOP hop = {}) const {
+        UK stored = KO::to_stored(key);
+        auto d = impl_.descend_start(stored);
+        while (impl_t::descend_step(d, stored)) co_await hop();
+        auto r = impl_t::descend_finish(d, stored);
+        co_return r.found ? const_iterator(r) : end();
+    }
+
+    template<typename HOP = kntrie_hop>
+    kntrie_lookup<const_iterator, HOP> co_lower_bound(KEY key, HOP hop = {}) const {
+        UK stored = KO::to_stored(key);
+        auto d = impl_.descend_start(stored);
+        while (impl_t::descend_step(d, stored)) co_await hop();
+        co_return lower_bound(key);
+    }
+
     iterator lower_bound(const KEY& key) {
         auto r = impl_.lower_bound_entry(KO::to_stored(key));
         if (!r.found) [[unlikely]] return end();
         return iterator(r);
     }
+    const_iterator lower_bound(const KEY& key) const {
+        auto r = impl_.lower_bound_entry(KO::to_stored(key));
+        if (!r.found) [[unlikely]] return end();
+        return const_iterator(r);
+    }
 
     iterator upper_bound(const KEY& key) {
         auto r = impl_.upper_bound_entry(KO::to_stored(key));
         if (!r.found) [[unlikely]] return end();
         return iterator(r);
     }
+    const_iterator upper_bound(const KEY& key) const {
+        auto r = impl_.upper_bound_entry(KO::to_stored(key));
+        if (!r.found) [[unlikely]] return end();
+        return const_iterator(r);
+    }
 
     std::pair<iterator, iterator> equal_range(const KEY& key) {
         return {lower_bound(key), upper_bound(key)};
     }
 
+    // Cursor over [lo, hi); see scan_cursor
+    scan_cursor scan(const KEY& lo, const KEY& hi) const
+    requires (VT::IS_INLINE && !IS_BOOL) {
+        return scan_cursor(impl_, KO::to_stored(lo), KO::to_stored(hi));
+    }
+
+    // fn(std::span<const KEY> keys, std::span<const VALUE> values) once
+    // per leaf-sized block of [lo, hi), in key order
+    template<typename FN>
+    void scan(const KEY& lo, const KEY& hi, FN&& fn) const
+    requires (VT::IS_INLINE && !IS_BOOL) {
+        auto c = scan(lo, hi);
+        while (c.next()) fn(c.keys(), c.values());
+    }
+
+    // ==================================================================
+    // Order statistics — per-node subtree counts; each level reads up
+    // to half its children's counts: O(depth × fanout / 2), not O(depth)
+    // ==================================================================
+
+    // Number of keys < key
+    size_type rank(const KEY& key) const noexcept {
+        return impl_.rank_entry(KO::to_stored(key));
+    }
+
+    // The i-th smallest key (0-based); end() when i >= size()
+    iterator select(size_type i) {
+        auto r = impl_.select_entry(i);
+        if (!r.found) [[unlikely]] return end();
+        return iterator(r);
+    }
+    const_iterator select(size_type i) const {
+        return const_cast<kntrie*>(this)->select(i);
+    }
+
+    // Number of keys in [lo, hi)
+    size_type count_range(const KEY& lo, const KEY& hi) const noexcept {
+        if (!key_compare{}(lo, hi)) return 0;
+        return rank(hi) - rank(lo);
+    }
+
+    // std::distance(first, last) without stepping through the range
+    difference_type distance(const_iterator first, const_iterator last) const noexcept {
+        return static_cast<difference_type>(position(last))
+             - static_cast<difference_type>(position(first));
+    }
+
     // ==================================================================
     // Observers
     // ==================================================================
@@ -436,6 +803,26 @@ public:
     const_reverse_iterator crbegin() const noexcept { return const_reverse_iterator(end()); }
     const_reverse_iterator crend()   const noexcept { return const_reverse_iterator(begin()); }
 
+    // ==================================================================
+    // Memory compaction
+    //
+    // After insert/erase churn, nodes sit at the capacity they once grew
+    // to and are scattered over the heap.  compact(budget) moves up to
+    // budget nodes into fresh allocations sized for their contents, in
+    // key order, and returns true once a whole pass has finished; the
+    // next call starts a new pass.  Calls may interleave with any other
+    // modification, so a pass can run a slice at a time between
+    // requests.  shrink_to_fit() runs one complete pass.  Both
+    // invalidate iterators.
+    // ==================================================================
+
+    bool compact(std::size_t budget) { return impl_.compact(budget); }
+
+    void shrink_to_fit() {
+        impl_.compact_restart();
+        impl_.compact(SIZE_MAX);
+    }
+
     // ==================================================================
     // Debug / Stats
     // ==================================================================
@@ -448,6 +835,46 @@ public:
 
 private:
     impl_t impl_;
+
+    size_type position(const const_iterator& it) const noexcept {
+        return it.leaf_v ? impl_.rank_entry(it.key_v) : size();
+    }
+
+    static constexpr auto keep_mine = [](const VALUE& a, const VALUE&) -> const VALUE& {
+        return a;
+    };
+
+    template<bool KEEP_AB, bool KEEP_A, bool KEEP_B, typename F>
+    kntrie join(const kntrie& o, F& combine) const {
+        kntrie r;
+        r.impl_.template assign_join<KEEP_AB, KEEP_A, KEEP_B>(impl_, o.impl_, combine);
+        return r;
+    }
+
+    template<kntrie_detail::bitset_op OP>
+    kntrie bitset(const kntrie& o) const {
+        kntrie r;
+        r.impl_.template assign_bitset<OP>(impl_, o.impl_);
+        return r;
+    }
+
+    // Convert user keys to stored form in stack-sized chunks, then hand
+    // each chunk to impl_t::find_batch.  fn(i, entry) with i into keys.
+    static constexpr std::size_t BATCH_CHUNK = 256;
+
+    template<typename FN>
+    void batch_lookup(std::span<const KEY> keys, FN&& fn) const noexcept {
+        UK stored[BATCH_CHUNK];
+        for (std::size_t base = 0; base < keys.size(); base += BATCH_CHUNK) {
+            std::size_t n = std::min(BATCH_CHUNK, keys.size() - base);
+            for (std::size_t i = 0; i < n; ++i)
+                stored[i] = KO::to_stored(keys[base + i]);
+            impl_.find_batch(stored, n,
+                [&](std::size_t i, const kntrie_detail::iter_entry_t<UK>& r) {
+                    fn(base + i, r);
+                });
+        }
+    }
 };
 
 } // namespace gteitelbaum
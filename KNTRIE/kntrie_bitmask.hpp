@@ -661,6 +661,7 @@ struct bitmask_ops {
                         node, static_cast<uint16_t>(suffix)};
             }
 
+            stat_add(stat_t::REALLOC);
             size_t au64 = get_bitmask_leaf(static_cast<std::uint16_t>(nc));
             uint64_t* nn = bld.alloc_node(au64);
             auto* nh = get_header(nn);
@@ -702,6 +703,7 @@ struct bitmask_ops {
                         node, static_cast<uint16_t>(suffix)};
             }
 
+            stat_add(stat_t::REALLOC);
             size_t au64 = get_bitmask_leaf(static_cast<std::uint16_t>(nc));
             uint64_t* nn = bld.alloc_node(au64);
             auto* nh = get_header(nn);
@@ -940,6 +942,83 @@ struct bitmask_ops {
         bld.dealloc_node(node, get_header(node)->alloc_u64());
     }
 
+    // ==================================================================
+    // Structural clone helpers (copy construction)
+    // ==================================================================
+
+    // Bitmap leaf: memcpy body, copy-construct out-of-line values.
+    static uint64_t* bitmap_clone(const uint64_t* node, BLD& bld) {
+        auto* h = get_header(node);
+        size_t au64 = h->alloc_u64();
+        uint64_t* nn = bld.alloc_node(au64);
+        std::memcpy(nn, node, au64 * U64_BYTES);
+        if constexpr (VT::HAS_DESTRUCTOR) {
+            uint16_t count = h->entries();
+            const VST* sv = bl_vals(node, BHS);
+            VST* dv = bl_vals_mut(nn, BHS);
+            uint16_t i = 0;
+            try {
+                for (; i < count; ++i)
+                    dv[i] = bld.store_value(*sv[i]);
+            } catch (...) {
+                while (i-- > 0) bld.destroy_value(dv[i]);
+                bld.dealloc_node(nn, au64);
+                throw;
+            }
+        }
+        return nn;
+    }
+
+    // Bitmask / skip chain: memcpy body and repair embed self-pointers.
+    // Children still reference the source subtree — caller replaces
+    // them via chain_children_mut, then calls relink_chain.
+    static uint64_t* clone_shell(const uint64_t* node, BLD& bld) {
+        auto* h = get_header(node);
+        size_t au64 = h->alloc_u64();
+        uint64_t* nn = bld.alloc_node(au64);
+        std::memcpy(nn, node, au64 * U64_BYTES);
+        fix_embeds(nn, h->skip());
+        return nn;
+    }
+
+    // Point every final-level child's parent link at node.
+    static void relink_chain(uint64_t* node) noexcept {
+        relink_all_children(node, chain_hs(get_header(node)->skip()));
+    }
+
+    // ==================================================================
+    // Compaction: move to a fresh allocation at the size class of the
+    // current contents and free the old node.
+    // ==================================================================
+
+    static uint64_t* bitmap_relocate(uint64_t* node, BLD& bld) {
+        auto* h = get_header(node);
+        uint16_t count = static_cast<uint16_t>(h->entries());
+        size_t old_u64 = h->alloc_u64();
+        size_t au64 = get_bitmask_leaf(count);
+        uint64_t* nn = bld.alloc_node(au64);
+        std::memcpy(nn, node, bitmap_leaf_size_u64(count) * U64_BYTES);
+        get_header(nn)->set_alloc_u64(au64);
+        bld.dealloc_node(node, old_u64);
+        return nn;
+    }
+
+    // Bitmask / skip chain.  Children still point back at the old node —
+    // caller calls relink_chain once it has updated them.
+    static uint64_t* relocate_chain(uint64_t* node, BLD& bld) {
+        auto* h = get_header(node);
+        uint8_t sc = h->skip();
+        unsigned nc = h->entries();
+        size_t old_u64 = h->alloc_u64();
+        size_t au64 = get_internal_u64(static_cast<std::uint16_t>(nc), sc);
+        uint64_t* nn = bld.alloc_node(au64);
+        std::memcpy(nn, node, bitmask_size_u64(nc, chain_hs(sc)) * U64_BYTES);
+        get_header(nn)->set_alloc_u64(au64);
+        fix_embeds(nn, sc);
+        bld.dealloc_node(node, old_u64);
+        return nn;
+    }
+
     // --- Chain header size: 1 (base header) + sc * 6 (embed slots) ---
     static constexpr size_t chain_hs(uint8_t sc) noexcept {
         return HEADER_U64 + static_cast<size_t>(sc) * EMBED_U64;
@@ -988,6 +1067,7 @@ private:
         }
 
         // Realloc
+        stat_add(stat_t::REALLOC);
         uint64_t saved = *descendants_ptr(node, hs, oc);
         size_t au64 = get_internal_u64(static_cast<std::uint16_t>(nc), h->skip());
         uint64_t* nn = bld.alloc_node(au64);
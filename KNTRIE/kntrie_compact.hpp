@@ -131,10 +131,52 @@ struct compact_ops {
         bld.dealloc_node(node, alloc_total_u64(h->alloc_u64()));
     }
 
+    // Structural clone: memcpy body, copy-construct out-of-line values.
+    static std::uint64_t* clone_leaf(const std::uint64_t* node, BLD& bld) {
+        auto* h = get_header(node);
+        std::size_t total = alloc_total_u64(h->alloc_u64());
+        std::uint64_t* nn = bld.alloc_node(total);
+        std::memcpy(nn, node, total * U64_BYTES);
+        if constexpr (VT::HAS_DESTRUCTOR) {
+            const VST* sv = vals(node);
+            VST* dv = vals_mut(nn);
+            unsigned entries = h->entries();
+            unsigned i = 0;
+            try {
+                for (; i < entries; ++i)
+                    dv[i] = bld.store_value(*sv[i]);
+            } catch (...) {
+                while (i-- > 0) bld.destroy_value(dv[i]);
+                bld.dealloc_node(nn, total);
+                throw;
+            }
+        }
+        return nn;
+    }
+
     static void dealloc_node_only(std::uint64_t* node, BLD& bld) {
         bld.dealloc_node(node, alloc_total_u64(get_header(node)->alloc_u64()));
     }
 
+    // Compaction: move to a fresh allocation at the entry class of the
+    // current count.  Values move bitwise; the old node is freed.
+    static std::uint64_t* relocate_leaf(std::uint64_t* node, BLD& bld) {
+        auto* h = get_header(node);
+        unsigned entries = h->entries();
+        std::size_t old_total = alloc_total_u64(h->alloc_u64());
+        std::uint64_t* nn = bld.alloc_node(get_compact_u64(static_cast<std::uint16_t>(entries)));
+        copy_leaf_header(node, nn, HU);
+        set_capacity(nn, static_cast<std::uint16_t>(entries));
+        std::memcpy(keys(nn, HU), keys(node, HU), entries * sizeof(K));
+        if constexpr (VT::IS_BOOL)
+            std::memcpy(bool_vals_mut(nn).data, bool_vals(node).data,
+                        bool_slots::u64_for(entries) * U64_BYTES);
+        else
+            std::memcpy(static_cast<void*>(vals_mut(nn)), vals(node), entries * sizeof(VST));
+        bld.dealloc_node(node, old_total);
+        return nn;
+    }
+
     // ==================================================================
     // Insert
     // ==================================================================
@@ -172,6 +214,7 @@ struct compact_ops {
 
         // Grow if no room
         if (!has_room(entries, h)) [[unlikely]] {
+            stat_add(stat_t::REALLOC);
             unsigned new_entries = entries + 1;
             std::size_t total = get_compact_u64(static_cast<std::uint16_t>(new_entries));
             std::uint64_t* nn = bld.alloc_node(total);
@@ -0,0 +1 @@
+#include "kntrie_coro.hpp"
@@ -0,0 +1,142 @@
+#ifndef KNTRIE_CORO_HPP
+#define KNTRIE_CORO_HPP
+
+#include <coroutine>
+#include <exception>
+#include <iterator>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace gteitelbaum {
+
+// ==========================================================================
+// Coroutine lookups (kntrie::co_find / co_lower_bound)
+//
+// A lookup is a lazy coroutine that prefetches the next node at every
+// bitmask hop and then co_awaits hop().  While one lookup waits on its
+// prefetch, the scheduler runs others, so many in-flight descents share
+// a core the way find_batch's lockstep groups do, without batching.
+//
+// HOP picks who resumes a suspended lookup:
+//
+//   kntrie_hop (default)  suspend_always.  kntrie_interleave() resumes
+//                         a set of lookups round-robin; co_await on a
+//                         single lookup runs it to completion inline.
+//   runtime yield         any callable returning the runtime's own
+//                         reschedule awaitable (e.g. a task-queue
+//                         yield).  co_await hands the lookup to the
+//                         runtime and resumes the awaiter when done.
+//
+// The trie must outlive the lookup and must not be modified while a
+// lookup is in flight.
+// ==========================================================================
+
+struct kntrie_hop {
+    std::suspend_always operator()() const noexcept { return {}; }
+};
+
+template<typename R, typename HOP = kntrie_hop>
+class kntrie_lookup {
+public:
+    struct promise_type {
+        std::optional<R>        value_v;
+        std::exception_ptr      error_v;
+        std::coroutine_handle<> cont_v;
+
+        kntrie_lookup get_return_object() noexcept {
+            return kntrie_lookup(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+
+        struct final_awaiter {
+            bool await_ready() const noexcept { return false; }
+            std::coroutine_handle<> await_suspend(
+                    std::coroutine_handle<promise_type> h) const noexcept {
+                auto c = h.promise().cont_v;
+                return c ? c : std::noop_coroutine();
+            }
+            void await_resume() const noexcept {}
+        };
+        final_awaiter final_suspend() const noexcept { return {}; }
+
+        void return_value(R v) { value_v.emplace(std::move(v)); }
+        void unhandled_exception() noexcept { error_v = std::current_exception(); }
+    };
+
+private:
+    using handle_t = std::coroutine_handle<promise_type>;
+    handle_t h_v;
+
+    explicit kntrie_lookup(handle_t h) noexcept : h_v(h) {}
+
+public:
+    kntrie_lookup(kntrie_lookup&& o) noexcept : h_v(std::exchange(o.h_v, {})) {}
+    kntrie_lookup& operator=(kntrie_lookup&& o) noexcept {
+        if (this != &o) {
+            if (h_v) h_v.destroy();
+            h_v = std::exchange(o.h_v, {});
+        }
+        return *this;
+    }
+    kntrie_lookup(const kntrie_lookup&) = delete;
+    kntrie_lookup& operator=(const kntrie_lookup&) = delete;
+    ~kntrie_lookup() { if (h_v) h_v.destroy(); }
+
+    // Manual driving: resume() advances one hop.
+    [[nodiscard]] bool done() const noexcept { return !h_v || h_v.done(); }
+    void resume() { if (!done()) h_v.resume(); }
+
+    // Result once done(); rethrows anything the hop awaitable threw.
+    R result() {
+        auto& p = h_v.promise();
+        if (p.error_v) std::rethrow_exception(p.error_v);
+        return std::move(*p.value_v);
+    }
+
+    auto operator co_await() && noexcept {
+        struct awaiter {
+            handle_t h;
+            bool await_ready() const noexcept { return h.done(); }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> cont) {
+                if constexpr (std::is_same_v<HOP, kntrie_hop>) {
+                    while (!h.done()) h.resume();
+                    return cont;
+                } else {
+                    h.promise().cont_v = cont;
+                    return h;
+                }
+            }
+            R await_resume() {
+                auto& p = h.promise();
+                if (p.error_v) std::rethrow_exception(p.error_v);
+                return std::move(*p.value_v);
+            }
+        };
+        return awaiter{h_v};
+    }
+};
+
+// Resume every lookup in [first, last) round-robin, one hop each per
+// round, until all are done.  Results are then read with result().
+template<typename It>
+void kntrie_interleave(It first, It last) {
+    bool is_live = true;
+    while (is_live) {
+        is_live = false;
+        for (It it = first; it != last; ++it) {
+            if (it->done()) continue;
+            it->resume();
+            is_live |= !it->done();
+        }
+    }
+}
+
+template<typename Range>
+void kntrie_interleave(Range& lookups) {
+    kntrie_interleave(std::begin(lookups), std::end(lookups));
+}
+
+} // namespace gteitelbaum
+
+#endif // KNTRIE_CORO_HPP
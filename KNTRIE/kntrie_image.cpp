@@ -0,0 +1 @@
+#include "kntrie_image.hpp"
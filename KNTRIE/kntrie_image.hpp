@@ -0,0 +1,656 @@
+#ifndef KNTRIE_IMAGE_HPP
+#define KNTRIE_IMAGE_HPP
+
+#include "kntrie_ops.hpp"
+#include "kntrie_pool_allocator.hpp"
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define KNTRIE_IMAGE_MMAP 1
+#else
+#define KNTRIE_IMAGE_MMAP 0
+#endif
+
+namespace gteitelbaum::kntrie_detail {
+
+// ==========================================================================
+// On-disk image
+//
+// [image_header_t (64 bytes)][node words ...]
+//
+// Nodes are copied word-for-word from the live tree.  Every child
+// pointer (bitmask children and embed links) is rewritten as a byte
+// offset from the start of the image, keeping LEAF_BIT on leaf children;
+// parent pointers are zeroed.  Sentinels carry no address and stay as
+// they are.  Native endian — a byte-swapped image fails the magic check.
+//
+// Only inline values (trivially copyable, <= 8 bytes, or bool) can be
+// saved: out-of-line values live outside the node words.
+// ==========================================================================
+
+inline constexpr std::uint64_t IMAGE_MAGIC   = 0x31474D49'45495254ull;  // "TRIEIMG1"
+inline constexpr std::uint32_t IMAGE_VERSION = 1;
+
+inline constexpr std::uint8_t IMAGE_FLAG_SIGNED = 1u << 0;
+inline constexpr std::uint8_t IMAGE_FLAG_BOOL   = 1u << 1;
+
+struct image_header_t {
+    std::uint64_t magic;
+    std::uint32_t version;
+    std::uint8_t  key_bytes;
+    std::uint8_t  value_bytes;
+    std::uint8_t  flags;
+    std::uint8_t  root_skip;
+    std::uint64_t size;
+    std::uint64_t root;          // offset-tagged, or SENTINEL_TAGGED when empty
+    std::uint64_t root_prefix;
+    std::uint64_t total_bytes;
+    std::uint64_t reserved[2];
+};
+
+inline constexpr std::size_t IMAGE_HEADER_U64 = sizeof(image_header_t) / U64_BYTES;
+static_assert(sizeof(image_header_t) == 64);
+
+// ==========================================================================
+// image_ops<K, VALUE> — writer + offset-based readers.
+//
+// Readers take the image base and mirror find_loop / tracked_descent_fwd
+// with base + offset in place of raw pointers.  The leaf-local helpers
+// (compact_find, bitmap_advance, leaf_find_ge, ...) never follow a
+// pointer out of the leaf, so they run on mapped leaves unchanged.
+// ==========================================================================
+
+template<typename K, typename VALUE>
+struct image_ops {
+    using ALLOC = std::allocator<std::uint64_t>;
+    using BO    = bitmask_ops<K, VALUE, ALLOC>;
+    using CO    = compact_ops<K, VALUE, ALLOC>;
+    using OPS   = kntrie_ops<K, VALUE, ALLOC>;
+    using VT    = value_traits<VALUE, ALLOC>;
+
+    static_assert(VT::IS_INLINE, "kntrie image: VALUE must be stored inline");
+
+    static constexpr unsigned TOP_SHIFT = (sizeof(K) - 1) * CHAR_BIT;
+    static constexpr std::size_t MAX_DEPTH = sizeof(K);
+
+    // ==================================================================
+    // Writer
+    // ==================================================================
+
+    // Append the subtree at tagged to out; returns its offset-tagged form.
+    // Works on indices: out may reallocate during the recursion.
+    static std::uint64_t emit(std::uint64_t tagged, std::vector<std::uint64_t>& out) {
+        if (tagged & LEAF_BIT) {
+            if (tagged & NOT_FOUND_BIT) return tagged;
+            const std::uint64_t* node = untag_leaf(tagged);
+            auto* hdr = get_header(node);
+            std::size_t n = hdr->is_bitmap() ? hdr->alloc_u64()
+                                             : CO::alloc_total_u64(hdr->alloc_u64());
+            std::size_t at = out.size();
+            out.insert(out.end(), node, node + n);
+            out[at + (hdr->is_bitmap() ? BITMAP_LEAF_PARENT_IDX : COMPACT_PARENT_IDX)] = 0;
+            return (at * U64_BYTES) | LEAF_BIT;
+        }
+
+        const std::uint64_t* node = bm_to_node_const(tagged);
+        auto* hdr = get_header(node);
+        std::uint8_t sc = hdr->skip();
+        std::size_t at = out.size();
+        out.insert(out.end(), node, node + hdr->alloc_u64());
+        out[at + BM_PARENT_IDX] = 0;
+
+        for (std::uint8_t e = 0; e < sc; ++e)
+            out[at + HEADER_U64 + e * EMBED_U64 + EMBED_CHILD_PTR] =
+                (at + HEADER_U64 + (e + 1) * EMBED_U64) * U64_BYTES;
+
+        const std::uint64_t* ch = BO::chain_children(node, sc);
+        std::size_t ch_at = at + static_cast<std::size_t>(ch - node);
+        unsigned nc = BO::chain_child_count(node, sc);
+        for (unsigned i = 0; i < nc; ++i) {
+            std::uint64_t c = emit(ch[i], out);
+            out[ch_at + i] = c;
+        }
+        return (at + HEADER_U64) * U64_BYTES;
+    }
+
+    static void save(const char* path, std::uint64_t root, K prefix,
+                     unsigned root_skip, std::size_t size, std::uint8_t flags) {
+        std::vector<std::uint64_t> out(IMAGE_HEADER_U64, 0);
+        std::uint64_t img_root = (root == BO::SENTINEL_TAGGED)
+            ? BO::SENTINEL_TAGGED : emit(root, out);
+
+        image_header_t h{};
+        h.magic       = IMAGE_MAGIC;
+        h.version     = IMAGE_VERSION;
+        h.key_bytes   = static_cast<std::uint8_t>(sizeof(K));
+        h.value_bytes = static_cast<std::uint8_t>(sizeof(VALUE));
+        h.flags       = static_cast<std::uint8_t>(flags | (VT::IS_BOOL ? IMAGE_FLAG_BOOL : 0));
+        h.root_skip   = static_cast<std::uint8_t>(root_skip);
+        h.size        = size;
+        h.root        = img_root;
+        h.root_prefix = static_cast<std::uint64_t>(prefix);
+        h.total_bytes = out.size() * U64_BYTES;
+        std::memcpy(out.data(), &h, sizeof(h));
+
+        std::FILE* f = std::fopen(path, "wb");
+        if (!f) throw std::runtime_error(std::string("kntrie::save: cannot open ") + path);
+        bool ok = std::fwrite(out.data(), U64_BYTES, out.size(), f) == out.size();
+        ok = (std::fclose(f) == 0) && ok;
+        if (!ok) throw std::runtime_error(std::string("kntrie::save: write failed ") + path);
+    }
+
+    // ==================================================================
+    // Readers
+    // ==================================================================
+
+    static std::uint64_t* at(const std::uint64_t* base, std::uint64_t off) noexcept {
+        return const_cast<std::uint64_t*>(base) + (off / U64_BYTES);
+    }
+    static std::uint64_t* leaf_at(const std::uint64_t* base, std::uint64_t tagged) noexcept {
+        return at(base, tagged & ~LEAF_BIT);
+    }
+
+    static iter_entry_t<K> leaf_edge(std::uint64_t* leaf) noexcept {
+        if (get_header(leaf)->is_bitmap()) return BO::bitmap_edge(leaf, dir_t::FWD);
+        return CO::compact_edge(leaf, dir_t::FWD);
+    }
+
+    static iter_entry_t<K> find(const std::uint64_t* base, std::uint64_t ptr,
+                                K stored, unsigned shift) noexcept {
+        while (!(ptr & LEAF_BIT)) {
+            ptr = BO::bm_child(reinterpret_cast<std::uintptr_t>(at(base, ptr)),
+                               static_cast<std::uint8_t>((stored >> shift) & 0xFF));
+            shift -= CHAR_BIT;
+        }
+        if (ptr & NOT_FOUND_BIT) return {};
+        std::uint64_t* leaf = leaf_at(base, ptr);
+        auto* hdr = get_header(leaf);
+        if (hdr->is_bitmap())
+            return BO::bitmap_find_byte(leaf, stored,
+                static_cast<std::uint8_t>((stored >> shift) & 0xFF));
+        return CO::compact_find(leaf, hdr, stored);
+    }
+
+    // Path from the root to the current leaf: each frame is one bitmap
+    // level (embeds included) and the byte taken there.
+    struct cursor_t {
+        const std::uint64_t* bms[MAX_DEPTH];
+        std::uint8_t         bytes[MAX_DEPTH];
+        unsigned             depth = 0;
+        iter_entry_t<K>      e{};
+    };
+
+    static const bitmap_256_t& bitmap_of(const std::uint64_t* bm) noexcept {
+        return *reinterpret_cast<const bitmap_256_t*>(bm);
+    }
+
+    static void descend_first(const std::uint64_t* base, std::uint64_t ptr,
+                              cursor_t& c) noexcept {
+        while (!(ptr & LEAF_BIT)) {
+            const std::uint64_t* bm = at(base, ptr);
+            c.bms[c.depth]   = bm;
+            c.bytes[c.depth] = bitmap_of(bm).first_set_bit();
+            ++c.depth;
+            ptr = bm[BM_CHILDREN_START];
+        }
+        c.e = leaf_edge(leaf_at(base, ptr));
+    }
+
+    // Leaf exhausted: climb to the nearest level with a later sibling.
+    static void climb_next(const std::uint64_t* base, cursor_t& c) noexcept {
+        while (c.depth > 0) {
+            unsigned top = c.depth - 1;
+            auto adj = bitmap_of(c.bms[top]).next_set_after(c.bytes[top]);
+            if (adj.found) {
+                c.bytes[top] = adj.idx;
+                descend_first(base, c.bms[top][BM_CHILDREN_START + adj.slot], c);
+                return;
+            }
+            c.depth = top;
+        }
+        c.e = {};
+    }
+
+    static void advance(const std::uint64_t* base, cursor_t& c) noexcept {
+        iter_entry_t<K> next;
+        if (get_header(c.e.leaf)->is_bitmap())
+            next = BO::bitmap_advance(c.e.leaf, c.e.pos, c.e.bit, c.e.key, c.e.val, dir_t::FWD);
+        else
+            next = CO::compact_advance(c.e.leaf, c.e.pos, c.e.val, dir_t::FWD);
+        if (next.found) c.e = next;
+        else            climb_next(base, c);
+    }
+
+    static void first(const std::uint64_t* base, std::uint64_t root, cursor_t& c) noexcept {
+        c.depth = 0;
+        if (root == BO::SENTINEL_TAGGED) { c.e = {}; return; }
+        descend_first(base, root, c);
+    }
+
+    static void lower_bound(const std::uint64_t* base, std::uint64_t root,
+                            K prefix, unsigned root_skip, K stored,
+                            cursor_t& c) noexcept {
+        c.depth = 0;
+        c.e = {};
+        if (root == BO::SENTINEL_TAGGED) return;
+
+        unsigned shift = TOP_SHIFT;
+        for (unsigned i = 0; i < root_skip; ++i, shift -= CHAR_BIT) {
+            std::uint8_t sb = static_cast<std::uint8_t>((stored >> shift) & 0xFF);
+            std::uint8_t rb = static_cast<std::uint8_t>((prefix >> shift) & 0xFF);
+            if (sb != rb) {
+                if (sb < rb) descend_first(base, root, c);
+                return;
+            }
+        }
+
+        std::uint64_t ptr = root;
+        while (!(ptr & LEAF_BIT)) {
+            const std::uint64_t* bm = at(base, ptr);
+            const bitmap_256_t& b = bitmap_of(bm);
+            std::uint8_t ti = static_cast<std::uint8_t>((stored >> shift) & 0xFF);
+            if (b.has_bit(ti)) {
+                c.bms[c.depth] = bm;
+                c.bytes[c.depth] = ti;
+                ++c.depth;
+                ptr = bm[BM_CHILDREN_START + b.find_slot<slot_mode::UNFILTERED>(ti)];
+                shift -= CHAR_BIT;
+                continue;
+            }
+            auto adj = b.next_set_after(ti);
+            if (adj.found) {
+                c.bms[c.depth] = bm;
+                c.bytes[c.depth] = adj.idx;
+                ++c.depth;
+                descend_first(base, bm[BM_CHILDREN_START + adj.slot], c);
+            } else {
+                climb_next(base, c);
+            }
+            return;
+        }
+
+        auto r = OPS::leaf_find_ge(leaf_at(base, ptr), stored);
+        if (r.found) c.e = r;
+        else         climb_next(base, c);
+    }
+};
+
+// ==========================================================================
+// image_file — read-only mapping of a whole file (mmap where available,
+// otherwise an owned heap copy).  The page-policy constructor instead
+// reads the file into anonymous memory placed by that policy, so a copy
+// can be pinned to one NUMA node and backed by huge pages.
+// ==========================================================================
+
+class image_file {
+    const std::uint64_t*             data_v  = nullptr;
+    std::size_t                      bytes_v = 0;
+    std::size_t                      span_v  = 0;     // mapped length
+    std::unique_ptr<std::uint64_t[]> owned_v;
+
+    void unmap() noexcept {
+#if KNTRIE_IMAGE_MMAP
+        if (data_v && !owned_v)
+            ::munmap(const_cast<std::uint64_t*>(data_v), span_v);
+#endif
+        owned_v.reset();
+        data_v  = nullptr;
+        bytes_v = 0;
+        span_v  = 0;
+    }
+
+    void read_owned(const char* path) {
+        std::FILE* f = std::fopen(path, "rb");
+        if (!f) throw std::runtime_error(std::string("kntrie::map: cannot open ") + path);
+        std::fseek(f, 0, SEEK_END);
+        long n = std::ftell(f);
+        std::fseek(f, 0, SEEK_SET);
+        if (n <= 0) { std::fclose(f); throw std::runtime_error(std::string("kntrie::map: empty ") + path); }
+        bytes_v = static_cast<std::size_t>(n);
+        owned_v.reset(new std::uint64_t[(bytes_v + U64_BYTES - 1) / U64_BYTES]);
+        bool ok = std::fread(owned_v.get(), 1, bytes_v, f) == bytes_v;
+        std::fclose(f);
+        if (!ok) throw std::runtime_error(std::string("kntrie::map: read failed ") + path);
+        data_v = owned_v.get();
+    }
+
+public:
+    explicit image_file(const char* path) {
+#if KNTRIE_IMAGE_MMAP
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0) throw std::runtime_error(std::string("kntrie::map: cannot open ") + path);
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || st.st_size <= 0) {
+            ::close(fd);
+            throw std::runtime_error(std::string("kntrie::map: cannot stat ") + path);
+        }
+        bytes_v = static_cast<std::size_t>(st.st_size);
+        span_v  = bytes_v;
+        void* p = ::mmap(nullptr, bytes_v, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) throw std::runtime_error(std::string("kntrie::map: mmap failed ") + path);
+        data_v = static_cast<const std::uint64_t*>(p);
+#else
+        read_owned(path);
+#endif
+    }
+
+    image_file(const char* path, const kntrie_page_policy& pol) {
+#if KNTRIE_IMAGE_MMAP && KNTRIE_PAGE_MMAP
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0) throw std::runtime_error(std::string("kntrie::map: cannot open ") + path);
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || st.st_size <= 0) {
+            ::close(fd);
+            throw std::runtime_error(std::string("kntrie::map: cannot stat ") + path);
+        }
+        bytes_v = static_cast<std::size_t>(st.st_size);
+        std::size_t hb = huge_page_bytes(pol.huge);
+        span_v = round_up_bytes(bytes_v, bytes_v >= hb ? hb : PAGE_BYTES);
+        kntrie_pool_stats_t ignored;
+        void* p = page_map(span_v, pol, ignored);
+        if (!p) {
+            ::close(fd);
+            span_v = 0;
+            throw std::runtime_error(std::string("kntrie::map: mmap failed ") + path);
+        }
+        // First touch happens here, after the NUMA policy is in place
+        auto* dst = static_cast<char*>(p);
+        std::size_t done = 0;
+        while (done < bytes_v) {
+            ssize_t r = ::pread(fd, dst + done, bytes_v - done, static_cast<off_t>(done));
+            if (r <= 0) break;
+            done += static_cast<std::size_t>(r);
+        }
+        ::close(fd);
+        data_v = static_cast<const std::uint64_t*>(p);
+        if (done != bytes_v) {
+            unmap();
+            throw std::runtime_error(std::string("kntrie::map: read failed ") + path);
+        }
+        ::mprotect(p, span_v, PROT_READ);
+#else
+        (void)pol;
+        read_owned(path);
+#endif
+    }
+
+    ~image_file() { unmap(); }
+
+    image_file(const image_file&) = delete;
+    image_file& operator=(const image_file&) = delete;
+
+    image_file(image_file&& o) noexcept
+        : data_v(std::exchange(o.data_v, nullptr)),
+          bytes_v(std::exchange(o.bytes_v, 0)),
+          span_v(std::exchange(o.span_v, 0)),
+          owned_v(std::move(o.owned_v)) {}
+
+    image_file& operator=(image_file&& o) noexcept {
+        if (this != &o) {
+            unmap();
+            data_v  = std::exchange(o.data_v, nullptr);
+            bytes_v = std::exchange(o.bytes_v, 0);
+            span_v  = std::exchange(o.span_v, 0);
+            owned_v = std::move(o.owned_v);
+        }
+        return *this;
+    }
+
+    const std::uint64_t* data()  const noexcept { return data_v; }
+    std::size_t          bytes() const noexcept { return bytes_v; }
+};
+
+} // namespace gteitelbaum::kntrie_detail
+
+namespace gteitelbaum {
+
+// ==========================================================================
+// kntrie_view<KEY, VALUE>
+//
+// Read-only map over an image written by kntrie::save().  find,
+// lower_bound and iteration run directly on the mapped words — nothing
+// is copied or rebuilt, and processes mapping the same file share its
+// page cache.  Move-only; iterators are valid while the view lives.
+// ==========================================================================
+
+template<typename KEY, typename VALUE>
+class kntrie_view {
+    using KO     = kntrie_detail::key_ops<KEY>;
+    using UK     = typename KO::UK;
+    using NORM_V = kntrie_detail::normalized_ops_value_t<VALUE>;
+    using IO     = kntrie_detail::image_ops<UK, NORM_V>;
+
+    static constexpr bool IS_BOOL = std::is_same_v<VALUE, bool>;
+
+    kntrie_detail::image_file file_v;
+    const std::uint64_t*      base_v = nullptr;
+    std::uint64_t             root_v = 0;
+    UK                        prefix_v{};
+    unsigned                  skip_v = 0;
+    std::size_t               size_v = 0;
+
+    void validate() {
+        using namespace kntrie_detail;
+        if (file_v.bytes() < sizeof(image_header_t))
+            throw std::runtime_error("kntrie::map: file too small");
+        image_header_t h;
+        std::memcpy(&h, file_v.data(), sizeof(h));
+        std::uint8_t want_flags = static_cast<std::uint8_t>(
+            (KO::IS_SIGNED ? IMAGE_FLAG_SIGNED : 0) | (IS_BOOL ? IMAGE_FLAG_BOOL : 0));
+        if (h.magic != IMAGE_MAGIC || h.version != IMAGE_VERSION)
+            throw std::runtime_error("kntrie::map: not a kntrie image");
+        if (h.key_bytes != sizeof(KEY) || h.value_bytes != sizeof(VALUE) || h.flags != want_flags)
+            throw std::runtime_error("kntrie::map: key/value type mismatch");
+        std::uint64_t root_off = h.root & ~LEAF_BIT;
+        if (h.total_bytes != file_v.bytes() || h.root_skip >= sizeof(KEY) ||
+            (h.root != IO::BO::SENTINEL_TAGGED &&
+             (root_off >= h.total_bytes || root_off % U64_BYTES != 0)))
+            throw std::runtime_error("kntrie::map: corrupt header");
+        base_v   = file_v.data();
+        root_v   = h.root;
+        prefix_v = static_cast<UK>(h.root_prefix);
+        skip_v   = h.root_skip;
+        size_v   = static_cast<std::size_t>(h.size);
+    }
+
+    UK prefix_mask() const noexcept {
+        return skip_v ? static_cast<UK>(~UK(0) << ((sizeof(UK) - skip_v) * CHAR_BIT)) : UK(0);
+    }
+
+    static VALUE read_value(const kntrie_detail::iter_entry_t<UK>& e) noexcept {
+        if constexpr (IS_BOOL) {
+            auto* words = static_cast<const std::uint64_t*>(e.val);
+            return (words[e.pos / kntrie_detail::U64_BITS] >> (e.pos % kntrie_detail::U64_BITS)) & 1;
+        } else {
+            VALUE v;
+            std::memcpy(&v, e.val, sizeof(VALUE));
+            return v;
+        }
+    }
+
+public:
+    using key_type    = KEY;
+    using mapped_type = VALUE;
+    using value_type  = std::pair<const KEY, VALUE>;
+    using size_type   = std::size_t;
+
+    explicit kntrie_view(const std::string& path) : file_v(path.c_str()) { validate(); }
+
+    // Private copy of the image in memory placed by pol (huge pages,
+    // NUMA node binding) instead of a shared file mapping.
+    kntrie_view(const std::string& path, const kntrie_page_policy& pol)
+        : file_v(path.c_str(), pol) { validate(); }
+
+    kntrie_view(kntrie_view&&) noexcept = default;
+    kntrie_view& operator=(kntrie_view&&) noexcept = default;
+
+    // ==================================================================
+    // Iterator — forward, read-only, yields pairs by value
+    // ==================================================================
+
+    class iterator {
+        friend class kntrie_view;
+        const std::uint64_t*   base_v = nullptr;
+        typename IO::cursor_t  cur_v{};
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = std::pair<const KEY, VALUE>;
+        using difference_type   = std::ptrdiff_t;
+        using reference         = std::pair<const KEY, VALUE>;
+
+        iterator() = default;
+
+        reference operator*() const noexcept {
+            return {KO::to_user(cur_v.e.key), read_value(cur_v.e)};
+        }
+
+        iterator& operator++() noexcept {
+            IO::advance(base_v, cur_v);
+            return *this;
+        }
+        iterator operator++(int) noexcept { auto t = *this; ++*this; return t; }
+
+        bool operator==(const iterator& o) const noexcept {
+            if (!cur_v.e.found || !o.cur_v.e.found) return cur_v.e.found == o.cur_v.e.found;
+            return cur_v.e.key == o.cur_v.e.key;
+        }
+        bool operator!=(const iterator& o) const noexcept { return !(*this == o); }
+    };
+    using const_iterator = iterator;
+
+    [[nodiscard]] bool      empty() const noexcept { return size_v == 0; }
+    [[nodiscard]] size_type size()  const noexcept { return size_v; }
+    [[nodiscard]] size_type image_bytes() const noexcept { return file_v.bytes(); }
+
+    iterator begin() const noexcept {
+        iterator it;
+        it.base_v = base_v;
+        IO::first(base_v, root_v, it.cur_v);
+        return it;
+    }
+    iterator end() const noexcept { return iterator(); }
+
+    bool contains(const KEY& key) const noexcept { return find_value(key).has_value(); }
+    size_type count(const KEY& key) const noexcept { return contains(key) ? 1 : 0; }
+
+    std::optional<VALUE> find_value(const KEY& key) const noexcept {
+        UK stored = KO::to_stored(key);
+        if ((stored ^ prefix_v) & prefix_mask()) return std::nullopt;
+        auto r = IO::find(base_v, root_v, stored, IO::TOP_SHIFT - skip_v * CHAR_BIT);
+        if (!r.found) return std::nullopt;
+        return read_value(r);
+    }
+
+    VALUE at(const KEY& key) const {
+        auto v = find_value(key);
+        if (!v) [[unlikely]] throw std::out_of_range("kntrie_view::at");
+        return *v;
+    }
+
+    iterator find(const KEY& key) const noexcept {
+        iterator it = lower_bound(key);
+        if (it.cur_v.e.found && it.cur_v.e.key != KO::to_stored(key)) return end();
+        return it;
+    }
+
+    iterator lower_bound(const KEY& key) const noexcept {
+        iterator it;
+        it.base_v = base_v;
+        IO::lower_bound(base_v, root_v, prefix_v, skip_v, KO::to_stored(key), it.cur_v);
+        return it;
+    }
+
+    iterator upper_bound(const KEY& key) const noexcept {
+        iterator it = lower_bound(key);
+        if (it.cur_v.e.found && it.cur_v.e.key == KO::to_stored(key)) ++it;
+        return it;
+    }
+};
+
+// ==========================================================================
+// kntrie_numa_view<KEY, VALUE>
+//
+// One kntrie_view per NUMA node, each loaded into memory bound to its
+// node, so a descent never leaves the socket.  Lookups go to the replica
+// of the calling thread's current node; the node is looked up again
+// every NUMA_RECHECK calls to follow thread migration.  Iterators come
+// from that replica and stay valid while the view lives.
+// ==========================================================================
+
+template<typename KEY, typename VALUE>
+class kntrie_numa_view {
+    using view_t = kntrie_view<KEY, VALUE>;
+
+    static constexpr unsigned NUMA_RECHECK = 256;
+
+    std::vector<view_t>        replicas_v;
+    std::vector<std::uint16_t> slot_v;        // node id -> replica index
+
+public:
+    using key_type       = KEY;
+    using mapped_type    = VALUE;
+    using value_type     = std::pair<const KEY, VALUE>;
+    using size_type      = std::size_t;
+    using iterator       = typename view_t::iterator;
+    using const_iterator = iterator;
+
+    explicit kntrie_numa_view(const std::string& path,
+                              kntrie_huge_pages huge = kntrie_huge_pages::TRANSPARENT,
+                              const std::vector<unsigned>& nodes = kntrie_numa_nodes()) {
+        for (unsigned n : nodes) {
+            if (n >= kntrie_detail::NUMA_MAX_NODES) continue;
+            kntrie_page_policy pol;
+            pol.huge  = huge;
+            pol.numa  = nodes.size() > 1 ? kntrie_numa::BIND : kntrie_numa::DEFAULT;
+            pol.nodes = std::uint64_t(1) << n;
+            if (slot_v.size() <= n) slot_v.resize(n + 1, 0);
+            slot_v[n] = static_cast<std::uint16_t>(replicas_v.size());
+            replicas_v.emplace_back(path, pol);
+        }
+        if (replicas_v.empty()) throw std::invalid_argument("kntrie::map_replicated: no NUMA nodes");
+    }
+
+    kntrie_numa_view(kntrie_numa_view&&) noexcept = default;
+    kntrie_numa_view& operator=(kntrie_numa_view&&) noexcept = default;
+
+    // Replica for the calling thread's node (the first one for unknown nodes)
+    const view_t& local() const noexcept {
+        thread_local unsigned node = 0, calls = 0;
+        if (calls++ % NUMA_RECHECK == 0) node = kntrie_detail::current_numa_node();
+        return replicas_v[node < slot_v.size() ? slot_v[node] : 0];
+    }
+
+    [[nodiscard]] size_type replicas() const noexcept { return replicas_v.size(); }
+    const view_t& replica(size_type i) const noexcept { return replicas_v[i]; }
+
+    [[nodiscard]] bool      empty() const noexcept { return replicas_v[0].empty(); }
+    [[nodiscard]] size_type size()  const noexcept { return replicas_v[0].size(); }
+
+    iterator begin() const noexcept { return local().begin(); }
+    iterator end()   const noexcept { return iterator(); }
+
+    bool contains(const KEY& key) const noexcept { return local().contains(key); }
+    size_type count(const KEY& key) const noexcept { return local().count(key); }
+    std::optional<VALUE> find_value(const KEY& key) const noexcept { return local().find_value(key); }
+    VALUE at(const KEY& key) const { return local().at(key); }
+    iterator find(const KEY& key) const noexcept { return local().find(key); }
+    iterator lower_bound(const KEY& key) const noexcept { return local().lower_bound(key); }
+    iterator upper_bound(const KEY& key) const noexcept { return local().upper_bound(key); }
+};
+
+} // namespace gteitelbaum
+
+#endif // KNTRIE_IMAGE_HPP
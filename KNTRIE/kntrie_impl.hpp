@@ -2,9 +2,16 @@
 #define KNTRIE_IMPL_HPP
 
 #include "kntrie_ops.hpp"
+#include "kntrie_image.hpp"
 #include <memory>
 #include <cstring>
 #include <algorithm>
+#include <atomic>
+#include <exception>
+#include <iterator>
+#include <stdexcept>
+#include <thread>
+#include <vector>
 
 namespace gteitelbaum::kntrie_detail {
 
@@ -15,6 +22,10 @@ struct kntrie_stats_t {
     std::size_t compact_leaves = 0;
     std::size_t bitmask_nodes  = 0;
     std::size_t bm_children    = 0;
+    // Allocator-level figures; zero unless ALLOC reports stats()
+    // (kntrie_pool_allocator).
+    std::size_t reserved_bytes = 0;
+    std::size_t live_bytes     = 0;
 };
 
 // ======================================================================
@@ -56,6 +67,7 @@ private:
     std::size_t   size_v;
     unsigned      root_skip_bytes_v;
     BLD           bld_v;
+    compact_walk_t<K> compact_v;     // resume point of an unfinished compact()
 
     K root_prefix_mask() const noexcept {
         unsigned shift = (sizeof(K) - root_skip_bytes_v) * CHAR_BIT;
@@ -90,7 +102,7 @@ public:
     kntrie_impl(kntrie_impl&& o) noexcept
         : root_ptr_v(o.root_ptr_v), root_prefix_v(o.root_prefix_v),
           size_v(o.size_v), root_skip_bytes_v(o.root_skip_bytes_v),
-          bld_v(std::move(o.bld_v)) {
+          bld_v(std::move(o.bld_v)), compact_v(o.compact_v) {
         o.root_ptr_v = BO::SENTINEL_TAGGED;
         o.root_prefix_v = K{};
         o.size_v = 0;
@@ -106,6 +118,7 @@ public:
             size_v = o.size_v;
             root_skip_bytes_v = o.root_skip_bytes_v;
             bld_v = std::move(o.bld_v);
+            compact_v = o.compact_v;
             o.root_ptr_v = BO::SENTINEL_TAGGED;
             o.root_prefix_v = K{};
             o.size_v = 0;
@@ -120,6 +133,7 @@ public:
         std::swap(size_v, o.size_v);
         std::swap(root_skip_bytes_v, o.root_skip_bytes_v);
         bld_v.swap(o.bld_v);
+        std::swap(compact_v, o.compact_v);
     }
 
     [[nodiscard]] bool      empty() const noexcept { return size_v == 0; }
@@ -138,8 +152,13 @@ public:
 
     iter_entry_t<K> find_entry(K stored) const noexcept {
         if (root_skip_bytes_v != 0) [[unlikely]] {
-            if ((stored ^ root_prefix_v) & root_prefix_mask()) [[unlikely]]
+            if ((stored ^ root_prefix_v) & root_prefix_mask()) [[unlikely]] {
+                if constexpr (INSTRUMENT) {
+                    stat_add(stat_t::SKIP_MISMATCH);
+                    stat_find_depth(0);
+                }
                 return {};
+            }
         }
         return OPS::find_loop(root_ptr_v, stored, root_dispatch_shift());
     }
@@ -148,6 +167,45 @@ public:
         return find_entry(stored).found;
     }
 
+    // Batched find: fn(i, iter_entry_t<K>) for each stored[i], in order.
+    template<typename FN>
+    void find_batch(const K* stored, std::size_t n, FN&& fn) const noexcept {
+        K mask = root_skip_bytes_v ? root_prefix_mask() : K(0);
+        OPS::find_batch_loop(root_ptr_v, stored, n, root_dispatch_shift(),
+                             root_prefix_v, mask, std::forward<FN>(fn));
+    }
+
+    // ==================================================================
+    // Stepwise descent (kntrie::co_find / co_lower_bound)
+    //
+    // descend_start places the cursor on the root, or on the sentinel
+    // when the root prefix rules the key out.  descend_step takes one
+    // bitmask hop and prefetches the child; false once on a leaf.
+    // ==================================================================
+
+    struct descent_t {
+        std::uint64_t ptr;
+        unsigned      shift;
+    };
+
+    descent_t descend_start(K stored) const noexcept {
+        if (root_skip_bytes_v != 0 && ((stored ^ root_prefix_v) & root_prefix_mask()))
+            return {BO::SENTINEL_TAGGED, 0};
+        return {root_ptr_v, root_dispatch_shift()};
+    }
+
+    static bool descend_step(descent_t& d, K stored) noexcept {
+        if (d.ptr & LEAF_BIT) return false;
+        d.ptr = BO::bm_child(d.ptr, static_cast<std::uint8_t>((stored >> d.shift) & 0xFF));
+        d.shift -= CHAR_BIT;
+        prefetch_tagged(d.ptr);
+        return true;
+    }
+
+    static iter_entry_t<K> descend_finish(const descent_t& d, K stored) noexcept {
+        return OPS::find_in_leaf(d.ptr, stored, d.shift);
+    }
+
     // ==================================================================
     // Edge entry
     // ==================================================================
@@ -198,6 +256,32 @@ public:
         return walk_bm_chain(grandparent, phdr->parent_byte(), dir);
     }
 
+    // Leaf after leaf in key order, or nullptr.  Reads bitmask nodes
+    // only — never the returned leaf — so a scan can prefetch it.
+    static std::uint64_t* next_leaf(std::uint64_t* leaf) noexcept {
+        auto* hdr = get_header(leaf);
+        std::uint64_t* parent = leaf_parent(leaf);
+        if (!parent || hdr->is_root()) [[unlikely]] return nullptr;
+        std::uint16_t byte = hdr->parent_byte();
+        for (;;) {
+            auto* phdr = get_header(parent);
+            auto adj = bitmap_ref(BO::node_bm_ptr(parent))
+                .next_set_after(static_cast<std::uint8_t>(byte));
+            if (adj.found) {
+                std::uint64_t child = BO::chain_child(parent, phdr->skip(), adj.slot);
+                while (!(child & LEAF_BIT)) {
+                    const std::uint64_t* node = bm_to_node_const(child);
+                    child = BO::chain_children(node, get_header(node)->skip())[0];
+                }
+                return untag_leaf_mut(child);
+            }
+            if (phdr->is_root()) [[unlikely]] return nullptr;
+            byte = phdr->parent_byte();
+            parent = bm_parent(parent);
+            if (!parent) [[unlikely]] return nullptr;
+        }
+    }
+
     static iter_entry_t<K> advance_pos(iter_entry_t<K> cur, dir_t dir) noexcept {
         if (!cur.found) return {};
         auto* hdr = get_header(cur.leaf);
@@ -240,6 +324,105 @@ public:
         });
     }
 
+    // ==================================================================
+    // Order statistics — every bitmask node keeps its exact subtree
+    // count, so a level adds up the counts of the children on one side
+    // of the descent (whichever side is shorter) instead of visiting
+    // their entries.  Each count lives in its child node, so a level
+    // costs up to nc / 2 independent loads into separate nodes (128 at
+    // full fanout): O(depth × fanout), bounded by the key width.
+    // ==================================================================
+
+    // Number of keys < stored
+    size_type rank_entry(K stored) const noexcept {
+        if (size_v == 0) return 0;
+        if (root_skip_bytes_v != 0) [[unlikely]] {
+            K mask = root_prefix_mask();
+            K sp = stored & mask, rp = root_prefix_v & mask;
+            if (sp != rp) return sp < rp ? 0 : size_v;
+        }
+
+        size_type acc = 0;
+        std::uint64_t ptr = root_ptr_v;
+        unsigned shift = root_dispatch_shift();
+
+        while (!(ptr & LEAF_BIT)) {
+            const std::uint64_t* node = bm_to_node_const(ptr);
+            auto* hdr = get_header(node);
+            std::uint8_t sc = hdr->skip();
+            unsigned nc = hdr->entries();
+            std::uint64_t total = BO::chain_descendants(node, sc, nc);
+
+            for (std::uint8_t si = 0; si < sc; ++si) {
+                std::uint8_t expected = static_cast<std::uint8_t>((stored >> shift) & 0xFF);
+                std::uint8_t actual = BO::skip_byte(node, si);
+                if (expected != actual)
+                    return expected < actual ? acc : acc + total;
+                shift -= CHAR_BIT;
+            }
+
+            std::uint8_t ti = static_cast<std::uint8_t>((stored >> shift) & 0xFF);
+            const bitmap_256_t& bmp = BO::chain_bitmap(node, sc);
+            const std::uint64_t* ch = BO::chain_children(node, sc);
+            unsigned below = static_cast<unsigned>(
+                bmp.find_slot<slot_mode::UNFILTERED>(ti));
+            acc += count_children_before(ch, below, nc, total);
+            if (!bmp.has_bit(ti)) return acc;
+            ptr = ch[below];
+            shift -= CHAR_BIT;
+        }
+
+        if (ptr & NOT_FOUND_BIT) return acc;
+        return acc + OPS::leaf_count_lt(untag_leaf(ptr), stored);
+    }
+
+    // The i-th smallest entry (0-based); not found when i >= size
+    iter_entry_t<K> select_entry(size_type i) const noexcept {
+        if (i >= size_v) return {};
+        std::uint64_t ptr = root_ptr_v;
+
+        while (!(ptr & LEAF_BIT)) {
+            const std::uint64_t* node = bm_to_node_const(ptr);
+            auto* hdr = get_header(node);
+            std::uint8_t sc = hdr->skip();
+            unsigned nc = hdr->entries();
+            std::uint64_t total = BO::chain_descendants(node, sc, nc);
+            const std::uint64_t* ch = BO::chain_children(node, sc);
+
+            unsigned s;
+            if (i < total / 2) {
+                for (s = 0; ; ++s) {
+                    std::uint64_t c = BO::exact_subtree_count(ch[s]);
+                    if (i < c) break;
+                    i -= c;
+                }
+            } else {
+                // Count back from the end: r entries follow entry i
+                size_type r = total - 1 - i;
+                for (s = nc - 1; ; --s) {
+                    std::uint64_t c = BO::exact_subtree_count(ch[s]);
+                    if (r < c) { i = c - 1 - r; break; }
+                    r -= c;
+                }
+            }
+            ptr = ch[s];
+        }
+
+        return OPS::leaf_entry_at(untag_leaf_mut(ptr), i);
+    }
+
+    // Entries under ch[0..k) of a node with nc children and total entries
+    static size_type count_children_before(const std::uint64_t* ch, unsigned k,
+                                           unsigned nc, std::uint64_t total) noexcept {
+        size_type n = 0;
+        if (k <= nc - k) {
+            for (unsigned s = 0; s < k; ++s) n += BO::exact_subtree_count(ch[s]);
+            return n;
+        }
+        for (unsigned s = k; s < nc; ++s) n += BO::exact_subtree_count(ch[s]);
+        return total - n;
+    }
+
     // ==================================================================
     // Insert — takes stored K directly
     // ==================================================================
@@ -266,6 +449,364 @@ public:
         return insert_dispatch<true, true>(stored, value);
     }
 
+    // ==================================================================
+    // Compaction — see OPS::compact_subtree.
+    //
+    // Moves up to budget nodes (at least one) and keeps the resume point
+    // in compact_v, so a pass can be spread over many calls.  The resume
+    // point is a key, not a node: mutations between calls are safe, and
+    // at worst move a rebuilt node twice or leave it for the next pass.
+    // Returns true when the pass is complete.
+    // ==================================================================
+
+    bool compact(std::size_t budget) {
+        compact_walk_t<K> w = compact_v;
+        w.budget  = std::max<std::size_t>(budget, 1);
+        w.moved   = 0;
+        w.stopped = false;
+        compact_v = {};
+        if (size_v == 0) return true;
+
+        bool has_lo = w.has_lo;
+        K prefix{};
+        if (root_skip_bytes_v != 0) {
+            K mask = root_prefix_mask();
+            prefix = root_prefix_v & mask;
+            if (has_lo && (w.lo & mask) > prefix) return true;
+            has_lo = has_lo && (w.lo & mask) == prefix;
+        }
+        root_ptr_v = OPS::compact_subtree(root_ptr_v, root_dispatch_shift(), prefix,
+                                          has_lo, w, bld_v);
+        mark_root();
+        if (!w.stopped) return true;
+        w.has_lo = true;
+        compact_v = w;
+        return false;
+    }
+
+    void compact_restart() noexcept { compact_v = {}; }
+
+    // ==================================================================
+    // Structural copy — replace contents with a node-by-node clone of o.
+    // Cloned aside and swapped in, so a throw leaves *this unchanged.
+    // ==================================================================
+
+    void clone_from(const kntrie_impl& o) {
+        if (this == &o) return;
+        kntrie_impl t(bld_v.get_allocator());
+        if (o.size_v != 0) {
+            t.root_ptr_v = OPS::clone_subtree(o.root_ptr_v, o.root_dispatch_shift(), t.bld_v);
+            t.root_prefix_v = o.root_prefix_v;
+            t.size_v = o.size_v;
+            t.set_root(o.root_skip_bytes_v);
+            t.mark_root();
+        }
+        swap(t);
+    }
+
+    // ==================================================================
+    // Bulk load — replace contents from an ascending sequence.
+    //
+    // *it is pair-like: it->first converted by to_stored, it->second the
+    // value.  Repeated keys keep the first occurrence.  Nodes are built
+    // once at final size by build_node_from_arrays_tagged; the root is
+    // normalized once at the end.  Throws std::invalid_argument (and
+    // leaves *this unchanged) if the input is not sorted.
+    //
+    // threads > 1: subtrees under the first branching level are built
+    // concurrently (see build_parallel).  Same tree as the serial build.
+    // ==================================================================
+
+    template<typename IT, typename TO_STORED>
+    void assign_sorted(IT first, IT last, TO_STORED&& to_stored, unsigned threads = 1) {
+        std::vector<K> keys;
+        slot_vec       vals;
+        if constexpr (std::is_base_of_v<std::forward_iterator_tag,
+                          typename std::iterator_traits<IT>::iterator_category>) {
+            auto n = static_cast<std::size_t>(std::distance(first, last));
+            keys.reserve(n);
+            vals.reserve(n);
+        }
+
+        try {
+            for (; first != last; ++first) {
+                K k = to_stored(first->first);
+                if (!keys.empty() && k <= keys.back()) [[unlikely]] {
+                    if (k == keys.back()) continue;
+                    throw std::invalid_argument("kntrie::assign_sorted: input not sorted");
+                }
+                keys.push_back(k);
+                push_slot(vals, make_slot(first->second));
+            }
+        } catch (...) {
+            destroy_slots(vals);
+            throw;
+        }
+
+        assign_built(keys, vals, threads);
+    }
+
+    // ==================================================================
+    // Set algebra — replace contents with the join of a and b (either may
+    // be *this): keys in both (KEEP_AB), a's (KEEP_A) and b's (KEEP_B)
+    // unmatched keys.  A matched key takes combine(a_value, b_value).
+    //
+    // Roots with different skips are aligned first: the shallower root is
+    // descended along the deeper root's prefix (join_descend), then
+    // OPS::join_walk runs both trees in lockstep.  Output arrives in key
+    // order and is bulk built like assign_sorted.
+    // ==================================================================
+
+    template<bool KEEP_AB, bool KEEP_A, bool KEEP_B, typename C>
+    void assign_join(const kntrie_impl& a, const kntrie_impl& b, C& combine) {
+        std::vector<K> keys;
+        slot_vec       vals;
+        auto out = [&](K k, const NVST* va, const NVST* vb) {
+            NVST sv = va && vb ? make_slot(combine(slot_value(*va), slot_value(*vb)))
+                               : make_slot(slot_value(va ? *va : *vb));
+            keys.push_back(k);
+            push_slot(vals, sv);
+        };
+        try {
+            join_roots<KEEP_AB, KEEP_A, KEEP_B>(a, b, out);
+        } catch (...) {
+            destroy_slots(vals);
+            throw;
+        }
+        assign_built(keys, vals, 1);
+    }
+
+    // ==================================================================
+    // Bool tries as integer sets — the keys mapped to true.  Roots are
+    // aligned as in assign_join, then OPS::join_words combines 64-key
+    // words.  The result's keys are expanded from its words and bulk
+    // built with value true.
+    // ==================================================================
+
+    template<bitset_op OP>
+    void assign_bitset(const kntrie_impl& a, const kntrie_impl& b) {
+        std::vector<K> keys;
+        auto out = [&](K base, std::uint64_t w) {
+            for (; w; w &= w - 1)
+                keys.push_back(base | K(std::countr_zero(w)));
+        };
+        word_roots<OP>(a, b, out);
+        slot_vec vals(keys.size(), staged_slot{true});
+        assign_built(keys, vals, 1);
+    }
+
+    std::size_t count_true() const noexcept {
+        return size_v ? OPS::count_true(root_ptr_v) : 0;
+    }
+
+    // cb(K base, std::uint64_t word) for every nonzero word in key order.
+    template<typename Fn>
+    void for_each_word(Fn&& cb) const {
+        if (size_v) OPS::walk_words(root_ptr_v, cb);
+    }
+
+private:
+    // Staged value slots for bulk builds.  Wrapped so bool slots stay a
+    // plain bool array (std::vector<bool> is packed and has no data()).
+    struct staged_slot { NVST v; };
+    static_assert(sizeof(staged_slot) == sizeof(NVST));
+    using slot_vec = std::vector<staged_slot>;
+
+    void destroy_slots(slot_vec& vals) noexcept {
+        for (auto& s : vals) bld_v.destroy_value(s.v);
+    }
+
+    // Append a staged slot; it is destroyed if the append throws.
+    void push_slot(slot_vec& vals, NVST sv) {
+        try {
+            vals.push_back({sv});
+        } catch (...) {
+            bld_v.destroy_value(sv);
+            throw;
+        }
+    }
+
+    // Replace contents with sorted, distinct keys[i] carrying vals[i].
+    // The vals are consumed either way.  Built aside and swapped in, so
+    // a throw leaves *this unchanged.
+    void assign_built(std::vector<K>& keys, slot_vec& vals, unsigned threads) {
+        kntrie_impl t(bld_v.get_allocator());
+        if (!keys.empty()) {
+            try {
+                if (threads > 1 && keys.size() > COMPACT_MAX
+                    && std::allocator_traits<ALLOC>::is_always_equal::value)
+                    t.root_ptr_v = t.build_parallel(keys.data(), &vals.data()->v,
+                                                    keys.size(), threads);
+                else
+                    t.root_ptr_v = OPS::build_node_from_arrays_tagged(
+                        keys.data(), &vals.data()->v, keys.size(), TOP_SHIFT, keys[0],
+                        t.bld_v);
+            } catch (...) {
+                destroy_slots(vals);   // the builders free their partial nodes
+                throw;
+            }
+            t.size_v = keys.size();
+            t.root_prefix_v = keys[0];
+            t.set_root(0);
+            t.mark_root();
+            t.normalize_root();
+        }
+        swap(t);
+    }
+
+    // Normalized slot → VALUE (reference for non-inline values).
+    static decltype(auto) slot_value(const NVST& s) noexcept {
+        if constexpr (NVT::IS_INLINE) return *reinterpret_cast<const VALUE*>(&s);
+        else                          return static_cast<const VALUE&>(*s);
+    }
+
+    K prefix_mask_for(unsigned skip) const noexcept {
+        return skip ? ~K(0) << ((sizeof(K) - skip) * CHAR_BIT) : K(0);
+    }
+
+    template<bool KEEP_AB, bool KEEP_A, bool KEEP_B, typename OUT>
+    static void join_roots(const kntrie_impl& a, const kntrie_impl& b, OUT& out) {
+        unsigned s = std::min(a.root_skip_bytes_v, b.root_skip_bytes_v);
+        if (a.size_v && b.size_v
+            && ((a.root_prefix_v ^ b.root_prefix_v) & a.prefix_mask_for(s))) {
+            join_disjoint<KEEP_A, KEEP_B>(a, b, out);
+            return;
+        }
+        if (a.size_v == 0 || b.size_v == 0 || a.root_skip_bytes_v == b.root_skip_bytes_v)
+            OPS::template join_walk<KEEP_AB, KEEP_A, KEEP_B>(
+                a.root_ptr_v, b.root_ptr_v, a.root_dispatch_shift(), out);
+        else if (a.root_skip_bytes_v > b.root_skip_bytes_v)
+            join_descend<KEEP_AB, KEEP_B, KEEP_A, false>(
+                b.root_ptr_v, b.root_dispatch_shift(), a, out);
+        else
+            join_descend<KEEP_AB, KEEP_A, KEEP_B, true>(
+                a.root_ptr_v, a.root_dispatch_shift(), b, out);
+    }
+
+    // Root prefixes differ: all of one tree sorts before the other.
+    template<bool KEEP_A, bool KEEP_B, typename OUT>
+    static void join_disjoint(const kntrie_impl& a, const kntrie_impl& b, OUT& out) {
+        auto a_only = [&](K k, const NVST& v) { out(k, &v, nullptr); };
+        auto b_only = [&](K k, const NVST& v) { out(k, nullptr, &v); };
+        bool a_first = a.root_prefix_v < b.root_prefix_v;
+        if (KEEP_A && a_first)  OPS::join_walk_all(a.root_ptr_v, a_only);
+        if constexpr (KEEP_B)   OPS::join_walk_all(b.root_ptr_v, b_only);
+        if (KEEP_A && !a_first) OPS::join_walk_all(a.root_ptr_v, a_only);
+    }
+
+    // x (a subtree of the shallower tree, at shift) has matched deep's
+    // root prefix above shift.  Walk x down the rest of that prefix; x's children
+    // off the path hold keys that deep lacks.  X_IS_A maps x / deep
+    // back onto out's (a, b) order.
+    template<bool KEEP_AB, bool KEEP_X, bool KEEP_D, bool X_IS_A, typename OUT>
+    static void join_descend(std::uint64_t x, unsigned shift, const kntrie_impl& deep,
+                             OUT& out) {
+        auto emit = [&](K k, const NVST* vx, const NVST* vd) {
+            if constexpr (X_IS_A) out(k, vx, vd);
+            else                  out(k, vd, vx);
+        };
+        auto x_only = [&](K k, const NVST& v) { emit(k, &v, nullptr); };
+        auto d_only = [&](K k, const NVST& v) { emit(k, nullptr, &v); };
+        if (shift == deep.root_dispatch_shift()) {
+            if constexpr (X_IS_A)
+                OPS::template join_walk<KEEP_AB, KEEP_X, KEEP_D>(x, deep.root_ptr_v, shift, out);
+            else
+                OPS::template join_walk<KEEP_AB, KEEP_D, KEEP_X>(deep.root_ptr_v, x, shift, out);
+            return;
+        }
+        if (OPS::is_empty(x)) {
+            if constexpr (KEEP_D) OPS::join_walk_all(deep.root_ptr_v, d_only);
+            return;
+        }
+        if (x & LEAF_BIT) {
+            OPS::template join_leaf<KEEP_AB, KEEP_X, KEEP_D, true>(x, deep.root_ptr_v,
+                [&](K k) { return deep.find_entry(k); }, emit);
+            return;
+        }
+        std::uint8_t byte = static_cast<std::uint8_t>((deep.root_prefix_v >> shift) & 0xFF);
+        bool is_placed = false;
+        BO::bitmap_ref(x).for_each_set([&](std::uint8_t idx, int slot) {
+            std::uint64_t child = BO::child_at(x, slot);
+            if (idx == byte) {
+                join_descend<KEEP_AB, KEEP_X, KEEP_D, X_IS_A>(
+                    child, shift - CHAR_BIT, deep, out);
+                is_placed = true;
+                return;
+            }
+            if (idx > byte && !is_placed) {
+                if constexpr (KEEP_D) OPS::join_walk_all(deep.root_ptr_v, d_only);
+                is_placed = true;
+            }
+            if constexpr (KEEP_X) OPS::join_walk_all(child, x_only);
+        });
+        if (!is_placed)
+            if constexpr (KEEP_D) OPS::join_walk_all(deep.root_ptr_v, d_only);
+    }
+
+    // join_roots / join_disjoint / join_descend at word grain.
+    template<bitset_op OP, typename OUT>
+    static void word_roots(const kntrie_impl& a, const kntrie_impl& b, OUT& out) {
+        constexpr bool KEEP_A = OP != bitset_op::AND;
+        constexpr bool KEEP_B = OP == bitset_op::OR;
+        unsigned s = std::min(a.root_skip_bytes_v, b.root_skip_bytes_v);
+        if (a.size_v && b.size_v
+            && ((a.root_prefix_v ^ b.root_prefix_v) & a.prefix_mask_for(s))) {
+            bool a_first = a.root_prefix_v < b.root_prefix_v;
+            if (KEEP_A && a_first)  OPS::walk_words(a.root_ptr_v, out);
+            if constexpr (KEEP_B)   OPS::walk_words(b.root_ptr_v, out);
+            if (KEEP_A && !a_first) OPS::walk_words(a.root_ptr_v, out);
+            return;
+        }
+        if (a.size_v == 0 || b.size_v == 0 || a.root_skip_bytes_v == b.root_skip_bytes_v)
+            OPS::template join_words<OP>(a.root_ptr_v, b.root_ptr_v, a.root_dispatch_shift(), out);
+        else if (a.root_skip_bytes_v > b.root_skip_bytes_v)
+            word_descend<OP, false>(b.root_ptr_v, b.root_dispatch_shift(), a, out);
+        else
+            word_descend<OP, true>(a.root_ptr_v, a.root_dispatch_shift(), b, out);
+    }
+
+    template<bitset_op OP, bool X_IS_A, typename OUT>
+    static void word_descend(std::uint64_t x, unsigned shift, const kntrie_impl& deep,
+                             OUT& out) {
+        constexpr bool KEEP_X = OP == bitset_op::OR || (OP == bitset_op::ANDNOT && X_IS_A);
+        constexpr bool KEEP_D = OP == bitset_op::OR || (OP == bitset_op::ANDNOT && !X_IS_A);
+        if (shift == deep.root_dispatch_shift()) {
+            if constexpr (X_IS_A)
+                OPS::template join_words<OP>(x, deep.root_ptr_v, shift, out);
+            else
+                OPS::template join_words<OP>(deep.root_ptr_v, x, shift, out);
+            return;
+        }
+        if (OPS::is_empty(x)) {
+            if constexpr (KEEP_D) OPS::walk_words(deep.root_ptr_v, out);
+            return;
+        }
+        if (x & LEAF_BIT) {
+            OPS::template join_words_leaf<OP, X_IS_A>(x, deep.root_ptr_v,
+                [&](K k) { return deep.find_entry(k); }, out);
+            return;
+        }
+        std::uint8_t byte = static_cast<std::uint8_t>((deep.root_prefix_v >> shift) & 0xFF);
+        bool is_placed = false;
+        BO::bitmap_ref(x).for_each_set([&](std::uint8_t idx, int slot) {
+            std::uint64_t child = BO::child_at(x, slot);
+            if (idx == byte) {
+                word_descend<OP, X_IS_A>(child, shift - CHAR_BIT, deep, out);
+                is_placed = true;
+                return;
+            }
+            if (idx > byte && !is_placed) {
+                if constexpr (KEEP_D) OPS::walk_words(deep.root_ptr_v, out);
+                is_placed = true;
+            }
+            if constexpr (KEEP_X) OPS::walk_words(child, out);
+        });
+        if (!is_placed)
+            if constexpr (KEEP_D) OPS::walk_words(deep.root_ptr_v, out);
+    }
+
+public:
+
     // ==================================================================
     // Erase — takes stored K directly
     // ==================================================================
@@ -295,7 +836,67 @@ public:
         return find_ge_entry(stored);
     }
 
+    // ==================================================================
+    // Range erase / extract — stored keys in [lo, last].
+    //
+    // OPS::split_range frees (or moves) fully covered subtrees whole and
+    // rewrites only the nodes on the two boundary paths; the root is
+    // settled once at the end.  extract_range moves the keys into dst,
+    // which must be empty and share this allocator.  Both return the
+    // number of keys removed.
+    // ==================================================================
+
+    size_type erase_range(K lo, K last) {
+        return split_range<false>(lo, last, nullptr);
+    }
+
+    size_type extract_range(K lo, K last, kntrie_impl& dst) {
+        return split_range<true>(lo, last, &dst);
+    }
+
 private:
+    template<bool TAKE>
+    size_type split_range(K lo, K last, kntrie_impl* dst) {
+        if (size_v == 0) [[unlikely]] return 0;
+        bool has_lo = true, has_hi = true;
+        if (root_skip_bytes_v != 0) {
+            K mask = root_prefix_mask();
+            K p = root_prefix_v & mask;
+            if ((lo & mask) > p || (last & mask) < p) return 0;
+            has_lo = (lo & mask) == p;
+            has_hi = (last & mask) == p;
+        }
+
+        auto r = OPS::template split_range<TAKE>(root_ptr_v, root_dispatch_shift(),
+                                                  lo, last, has_lo, has_hi, bld_v);
+        if (r.count == 0) return 0;
+        if constexpr (TAKE) {
+            dst->root_ptr_v = r.taken;
+            dst->root_prefix_v = root_prefix_v;
+            dst->size_v = r.count;
+            dst->set_root(root_skip_bytes_v);
+            dst->settle_root();
+        }
+        root_ptr_v = r.kept ? r.kept : BO::SENTINEL_TAGGED;
+        size_v -= r.count;
+        settle_root();
+        return r.count;
+    }
+
+    // Restore the root invariants after the tree below was rewritten
+    void settle_root() {
+        if (size_v == 0) {
+            root_ptr_v = BO::SENTINEL_TAGGED;
+            root_prefix_v = K{};
+            set_root(0);
+            return;
+        }
+        mark_root();
+        normalize_root();
+        if (size_v <= COMPACT_MAX && !(root_ptr_v & LEAF_BIT))
+            coalesce_bm_to_leaf();
+    }
+
     erase_result_t<K> erase_stored(K stored) {
         if (root_skip_bytes_v != 0) [[unlikely]] {
             if ((stored ^ root_prefix_v) & root_prefix_mask()) [[unlikely]]
@@ -334,12 +935,27 @@ public:
     kntrie_stats_t debug_stats() const noexcept {
         kntrie_stats_t s{};
         s.total_bytes = sizeof(*this);
-        // TODO: walk tree and collect stats
+        if (root_ptr_v != BO::SENTINEL_TAGGED)
+            collect_stats(root_ptr_v, s);
+        if constexpr (requires(const ALLOC& a) { a.stats(); }) {
+            auto ps = get_allocator().stats();
+            s.reserved_bytes = ps.reserved_bytes;
+            s.live_bytes     = ps.live_bytes;
+        }
         return s;
     }
 
     std::size_t memory_usage() const noexcept { return debug_stats().total_bytes; }
 
+    // ==================================================================
+    // Image — frozen, offset-addressed copy (kntrie_image.hpp)
+    // ==================================================================
+
+    void save_image(const char* path, std::uint8_t flags) const {
+        image_ops<K, NORM_V>::save(path, root_ptr_v, root_prefix_v,
+                                   root_skip_bytes_v, size_v, flags);
+    }
+
     const std::uint64_t* debug_root() const noexcept {
         if (root_ptr_v == BO::SENTINEL_TAGGED) return nullptr;
         if (root_ptr_v & LEAF_BIT) return untag_leaf(root_ptr_v);
@@ -347,8 +963,131 @@ public:
     }
 
 private:
-    template<bool INSERT, bool ASSIGN>
-    insert_pos_result_t insert_dispatch(K stored, const VALUE& value) {
+    // ==================================================================
+    // build_parallel — sorted arrays, count > COMPACT_MAX
+    //
+    // Sorted input shares the common prefix of its first and last key,
+    // so the first branching level is known up front.  Each byte group
+    // there is an independent subtree: workers claim groups largest-
+    // first from a shared counter and build them with their own
+    // builder.  The groups are stitched under one bitmask (parent links
+    // and descendant count set by make_bitmask) and the common prefix
+    // wrapped back on exactly as the serial build does.
+    //
+    // Only taken for stateless allocators (is_always_equal): nodes built
+    // by a worker's builder are later freed through bld_v.
+    // ==================================================================
+
+    std::uint64_t build_parallel(K* keys, NVST* vals, std::size_t count,
+                                 unsigned threads) {
+        unsigned common = static_cast<unsigned>(
+            std::countl_zero(static_cast<K>(keys[0] ^ keys[count - 1]))) / CHAR_BIT;
+        unsigned shift = TOP_SHIFT - common * CHAR_BIT;
+
+        struct group_t { std::size_t start, n; std::uint8_t idx; };
+        group_t groups[BYTE_VALUES];
+        unsigned n_groups = 0;
+        for (std::size_t i = 0; i < count; ) {
+            std::uint8_t b = static_cast<std::uint8_t>(keys[i] >> shift);
+            K bound = static_cast<K>(keys[i] | ((K(1) << shift) - 1));
+            std::size_t j = static_cast<std::size_t>(
+                std::upper_bound(keys + i, keys + count, bound) - keys);
+            groups[n_groups++] = {i, j - i, b};
+            i = j;
+        }
+
+        unsigned order[BYTE_VALUES];
+        for (unsigned g = 0; g < n_groups; ++g) order[g] = g;
+        std::sort(order, order + n_groups,
+                  [&](unsigned a, unsigned b) { return groups[a].n > groups[b].n; });
+
+        std::uint64_t child_ptrs[BYTE_VALUES] = {};
+        std::atomic<unsigned> next{0};
+        std::exception_ptr err;
+        std::atomic<bool> failed{false};
+        auto work = [&] {
+            BLD local(bld_v.get_allocator());
+            for (unsigned t; (t = next.fetch_add(1)) < n_groups; ) {
+                if (failed.load(std::memory_order_relaxed)) return;
+                const group_t& g = groups[order[t]];
+                try {
+                    child_ptrs[order[t]] = OPS::build_node_from_arrays_tagged(
+                        keys + g.start, vals + g.start, g.n,
+                        shift - CHAR_BIT, keys[g.start], local);
+                } catch (...) {
+                    if (!failed.exchange(true)) err = std::current_exception();
+                    return;
+                }
+            }
+        };
+
+        unsigned n_workers = std::min(threads, n_groups);
+        std::vector<std::thread> pool;
+        pool.reserve(n_workers - 1);
+        for (unsigned w = 1; w < n_workers; ++w) pool.emplace_back(work);
+        work();
+        for (auto& th : pool) th.join();
+
+        // On failure only nodes are freed: the values stay with the caller
+        if (err) {
+            for (unsigned g = 0; g < n_groups; ++g)
+                if (child_ptrs[g])
+                    OPS::dealloc_subtree_nodes_only(child_ptrs[g], shift - CHAR_BIT, bld_v);
+            std::rethrow_exception(err);
+        }
+
+        std::uint8_t indices[BYTE_VALUES];
+        for (unsigned g = 0; g < n_groups; ++g) indices[g] = groups[g].idx;
+        std::uint64_t tagged;
+        try {
+            tagged = tag_bitmask(BO::make_bitmask(
+                indices, child_ptrs, static_cast<int>(n_groups), bld_v, count));
+        } catch (...) {
+            for (unsigned g = 0; g < n_groups; ++g)
+                OPS::dealloc_subtree_nodes_only(child_ptrs[g], shift - CHAR_BIT, bld_v);
+            throw;
+        }
+        for (unsigned c = common; c-- > 0; ) {
+            std::uint8_t b = static_cast<std::uint8_t>(keys[0] >> (TOP_SHIFT - c * CHAR_BIT));
+            try {
+                tagged = OPS::wrap_single_child(b, tagged, count, bld_v);
+            } catch (...) {
+                OPS::dealloc_subtree_nodes_only(tagged, TOP_SHIFT - (c + 1) * CHAR_BIT, bld_v);
+                throw;
+            }
+        }
+        return tagged;
+    }
+
+    static void collect_stats(std::uint64_t tagged, kntrie_stats_t& s) noexcept {
+        if (tagged & LEAF_BIT) {
+            if (tagged & NOT_FOUND_BIT) return;
+            const std::uint64_t* node = untag_leaf(tagged);
+            auto* hdr = get_header(node);
+            s.total_entries += hdr->entries();
+            if (hdr->is_bitmap()) {
+                ++s.bitmap_leaves;
+                s.total_bytes += hdr->alloc_u64() * U64_BYTES;
+            } else {
+                ++s.compact_leaves;
+                s.total_bytes += CO::alloc_total_u64(hdr->alloc_u64()) * U64_BYTES;
+            }
+            return;
+        }
+
+        const std::uint64_t* node = bm_to_node_const(tagged);
+        auto* hdr = get_header(node);
+        std::uint8_t sc = hdr->skip();
+        ++s.bitmask_nodes;
+        s.bm_children += BO::chain_child_count(node, sc);
+        s.total_bytes += hdr->alloc_u64() * U64_BYTES;
+        BO::chain_for_each_child(node, sc, [&](std::uint64_t child) {
+            collect_stats(child, s);
+        });
+    }
+
+    // VALUE → normalized slot (allocates for non-trivial VALUE)
+    NVST make_slot(const VALUE& value) {
         NVST sv;
         if constexpr (std::is_same_v<VALUE, NORM_V>) {
             sv = bld_v.store_value(value);
@@ -357,6 +1096,12 @@ private:
             sv = NVST{};
             std::memcpy(&sv, &value, sizeof(VALUE));
         }
+        return sv;
+    }
+
+    template<bool INSERT, bool ASSIGN>
+    insert_pos_result_t insert_dispatch(K stored, const VALUE& value) {
+        NVST sv = make_slot(value);
 
         if (size_v == 0) [[unlikely]] {
             if constexpr (!INSERT) { bld_v.destroy_value(sv); return {}; }
@@ -367,6 +1112,8 @@ private:
             K diff = (stored ^ root_prefix_v) & root_prefix_mask();
             if (diff) [[unlikely]] {
                 if constexpr (!INSERT) { bld_v.destroy_value(sv); return {}; }
+                stat_add(stat_t::SKIP_MISMATCH);
+                stat_add(stat_t::SPLIT);
                 unsigned shift_pos = TOP_SHIFT;
                 unsigned div_pos = 0;
                 while (div_pos < root_skip_bytes_v) {
@@ -535,6 +1282,7 @@ private:
     // ==================================================================
 
     void coalesce_bm_to_leaf() {
+        stat_add(stat_t::COALESCE);
         constexpr std::size_t hu = COMPACT_HEADER_U64;
         std::size_t total_u64 = CO::get_compact_u64(static_cast<std::uint16_t>(size_v));
         std::uint64_t* leaf = bld_v.alloc_node(total_u64);
@@ -617,7 +1365,9 @@ private:
 
     void remove_all() noexcept {
         if (root_ptr_v == BO::SENTINEL_TAGGED) return;
-        OPS::dealloc_subtree(root_ptr_v, root_dispatch_shift(), bld_v);
+        // Pool fast path: nothing to destroy, so drop every block at once.
+        if (!std::is_trivially_destructible_v<NORM_V> || !bld_v.release_all())
+            OPS::dealloc_subtree(root_ptr_v, root_dispatch_shift(), bld_v);
         root_ptr_v = BO::SENTINEL_TAGGED;
         root_prefix_v = K{};
         set_root(0);
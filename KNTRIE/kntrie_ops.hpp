@@ -47,20 +47,81 @@ struct kntrie_ops {
 
     static iter_entry_t<K> find_loop(std::uint64_t ptr, K stored,
                                      unsigned shift) noexcept {
+        [[maybe_unused]] unsigned start = shift;
         while (!(ptr & LEAF_BIT)) [[likely]] {
             ptr = BO::bm_child(ptr, static_cast<std::uint8_t>((stored >> shift) & 0xFF));
             shift -= CHAR_BIT;
         }
+        if constexpr (INSTRUMENT) stat_find_depth((start - shift) / CHAR_BIT);
+        return find_in_leaf(ptr, stored, shift);
+    }
+
+    // Leaf half of find_loop: ptr is a tagged leaf (or the sentinel).
+    static iter_entry_t<K> find_in_leaf(std::uint64_t ptr, K stored,
+                                        unsigned shift) noexcept {
         if (ptr & NOT_FOUND_BIT) [[unlikely]] return {};
         auto* node = untag_leaf_mut(ptr);
         auto* hdr = get_header(node);  // prefetches cache line for compact_find
         if (hdr->is_bitmap()) [[unlikely]] {
+            if constexpr (INSTRUMENT) stat_bitmap_hit();
             std::uint8_t byte = static_cast<std::uint8_t>((stored >> shift) & 0xFF);
             return BO::bitmap_find_byte(node, stored, byte);
         }
+        if constexpr (INSTRUMENT) stat_compact_hit(hdr->entries());
         return CO::compact_find(node, hdr, stored);
     }
 
+    // ==================================================================
+    // find_batch_loop — FIND_BATCH_GROUP find_loop descents in lockstep.
+    //
+    // Each round advances every unfinished key one bitmask level and
+    // prefetches the child it landed on, so the misses of independent
+    // keys overlap instead of serializing.  Keys whose root prefix does
+    // not match (stored ^ prefix) & prefix_mask start at the sentinel.
+    // fn(index, iter_entry_t<K>) is called in input order.
+    // ==================================================================
+
+    static constexpr std::size_t FIND_BATCH_GROUP = 16;
+
+    template<typename FN>
+    static void find_batch_loop(std::uint64_t root, const K* stored, std::size_t n,
+                                unsigned shift, K prefix, K prefix_mask,
+                                FN&& fn) noexcept {
+        std::uint64_t ptrs[FIND_BATCH_GROUP];
+        unsigned      shifts[FIND_BATCH_GROUP];
+
+        for (std::size_t base = 0; base < n; base += FIND_BATCH_GROUP) {
+            std::size_t g = std::min(FIND_BATCH_GROUP, n - base);
+            const K* ks = stored + base;
+            for (std::size_t i = 0; i < g; ++i) {
+                ptrs[i]   = ((ks[i] ^ prefix) & prefix_mask) ? BO::SENTINEL_TAGGED : root;
+                shifts[i] = shift;
+            }
+
+            bool is_live = !(root & LEAF_BIT);
+            while (is_live) {
+                is_live = false;
+                for (std::size_t i = 0; i < g; ++i) {
+                    std::uint64_t p = ptrs[i];
+                    if (p & LEAF_BIT) continue;
+                    p = BO::bm_child(p, static_cast<std::uint8_t>((ks[i] >> shifts[i]) & 0xFF));
+                    shifts[i] -= CHAR_BIT;
+                    prefetch_tagged(p);
+                    ptrs[i] = p;
+                    is_live |= !(p & LEAF_BIT);
+                }
+            }
+
+            for (std::size_t i = 0; i < g; ++i) {
+                if constexpr (INSTRUMENT) {
+                    if ((ks[i] ^ prefix) & prefix_mask) stat_add(stat_t::SKIP_MISMATCH);
+                    stat_find_depth((shift - shifts[i]) / CHAR_BIT);
+                }
+                fn(base + i, find_in_leaf(ptrs[i], ks[i], shifts[i]));
+            }
+        }
+    }
+
     // ==================================================================
     // descend_edge_loop — walk to min/max leaf + dispatch in one call.
     // ==================================================================
@@ -109,7 +170,8 @@ struct kntrie_ops {
     // build_node_from_arrays — recursive subtree builder.
     //
     // Builds from sorted full-K arrays.  At bitmap depth (shift==0),
-    // creates bitmap leaf.  Otherwise, compact leaf or recursive bitmask.
+    // creates bitmap leaf.  Otherwise, compact leaf or recursive bitmask;
+    // a level with a single child goes through wrap_single_child.
     // Returns tagged pointer.
     // ==================================================================
 
@@ -132,26 +194,57 @@ struct kntrie_ops {
                 static_cast<unsigned>(count), bld));
         }
 
-        // Many entries: partition by byte at shift, build bitmask
+        // Many entries: partition by byte at shift, build bitmask.  If an
+        // allocation throws, the children built so far are freed (nodes
+        // only: the values still belong to the caller's arrays).
         std::uint8_t indices[BYTE_VALUES];
         std::uint64_t child_ptrs[BYTE_VALUES];
         int n_children = 0;
 
-        std::size_t i = 0;
-        while (i < count) {
-            std::uint8_t ti = static_cast<std::uint8_t>((keys[i] >> shift) & 0xFF);
-            std::size_t start = i;
-            while (i < count &&
-                   static_cast<std::uint8_t>((keys[i] >> shift) & 0xFF) == ti) ++i;
-            indices[n_children] = ti;
-            child_ptrs[n_children] = build_node_from_arrays_tagged(
-                keys + start, vals + start, i - start,
-                shift - CHAR_BIT, keys[start], bld);
-            n_children++;
+        try {
+            std::size_t i = 0;
+            while (i < count) {
+                std::uint8_t ti = static_cast<std::uint8_t>((keys[i] >> shift) & 0xFF);
+                std::size_t start = i;
+                while (i < count &&
+                       static_cast<std::uint8_t>((keys[i] >> shift) & 0xFF) == ti) ++i;
+                indices[n_children] = ti;
+                child_ptrs[n_children] = build_node_from_arrays_tagged(
+                    keys + start, vals + start, i - start,
+                    shift - CHAR_BIT, keys[start], bld);
+                n_children++;
+            }
+
+            if (n_children == 1) [[unlikely]]
+                return wrap_single_child(indices[0], child_ptrs[0], count, bld);
+            return tag_bitmask(
+                BO::make_bitmask(indices, child_ptrs, n_children, bld, count));
+        } catch (...) {
+            for (int c = 0; c < n_children; ++c)
+                dealloc_subtree_nodes_only(child_ptrs[c], shift - CHAR_BIT, bld);
+            throw;
         }
+    }
 
-        return tag_bitmask(
-            BO::make_bitmask(indices, child_ptrs, n_children, bld, count));
+    // ==================================================================
+    // wrap_single_child — a freshly partitioned level with one child.
+    //
+    // Compact child: returned directly (stores full K).
+    // Bitmap leaf:   needs its dispatch path — one-child bitmask.
+    // Bitmask child: dispatch byte absorbed into its skip chain.
+    // ==================================================================
+
+    static std::uint64_t wrap_single_child(std::uint8_t idx, std::uint64_t child_tagged,
+                                           std::size_t total, BLD& bld) {
+        if (child_tagged & LEAF_BIT) {
+            if (!get_header(untag_leaf(child_tagged))->is_bitmap())
+                return child_tagged;
+            std::uint8_t indices[1] = {idx};
+            std::uint64_t children[1] = {child_tagged};
+            return tag_bitmask(BO::make_bitmask(indices, children, 1, bld, total));
+        }
+        std::uint8_t pfx_bytes[1] = {idx};
+        return BO::wrap_in_chain(bm_to_node(child_tagged), pfx_bytes, 1, bld);
     }
 
     // ==================================================================
@@ -199,6 +292,7 @@ struct kntrie_ops {
     static insert_result_t convert_to_bitmask_tagged(
             const std::uint64_t* node, const node_header_t* hdr,
             K stored, unsigned shift, VST value, BLD& bld) {
+        stat_add(stat_t::SPLIT);
 
         std::uint16_t old_count = hdr->entries();
         constexpr std::size_t hs = COMPACT_HEADER_U64;
@@ -302,22 +396,7 @@ struct kntrie_ops {
         std::uint64_t child_tagged;
 
         if (n_children == 1) [[unlikely]] {
-            child_tagged = child_ptrs[0];
-
-            if (child_tagged & LEAF_BIT) {
-                std::uint64_t* leaf = untag_leaf_mut(child_tagged);
-                if (get_header(leaf)->is_bitmap()) {
-                    // Bitmap child: needs dispatch path — wrap in one-child bitmask
-                    child_tagged = tag_bitmask(
-                        BO::make_bitmask(indices, child_ptrs, 1, bld, total));
-                }
-                // Compact child: return directly (full K stored)
-            } else {
-                // Bitmask child: wrap dispatch byte in chain
-                std::uint8_t pfx_bytes[1] = {indices[0]};
-                std::uint64_t* bm_node = bm_to_node(child_tagged);
-                child_tagged = BO::wrap_in_chain(bm_node, pfx_bytes, 1, bld);
-            }
+            child_tagged = wrap_single_child(indices[0], child_ptrs[0], total, bld);
         } else {
             child_tagged = tag_bitmask(
                 BO::make_bitmask(indices, child_ptrs, n_children, bld, total));
@@ -341,6 +420,9 @@ struct kntrie_ops {
                                          std::uint8_t sc, std::uint8_t mismatch_pos,
                                          K stored, unsigned shift,
                                          VST value, BLD& bld) {
+        stat_add(stat_t::SKIP_MISMATCH);
+        stat_add(stat_t::SPLIT);
+
         // Divergence byte
         std::uint8_t expected_byte = static_cast<std::uint8_t>((stored >> shift) & 0xFF);
         std::uint8_t actual_byte = BO::skip_byte(node, mismatch_pos);
@@ -356,19 +438,9 @@ struct kntrie_ops {
         };
 
         // Build old subtree child pointer: remaining skip chain after mismatch
-        std::uint64_t old_child;
-        std::uint8_t remaining_skip = sc - mismatch_pos - 1;
-        if (remaining_skip > 0) {
-            // Rebuild skip chain with remaining bytes
-            std::uint8_t skip_buf[MAX_SKIP];
-            for (std::uint8_t si = 0; si < remaining_skip; ++si)
-                skip_buf[si] = BO::skip_byte(node, mismatch_pos + 1 + si);
-            old_child = BO::wrap_in_chain(
-                bm_to_node(BO::node_bm_ptr(node)),
-                skip_buf, remaining_skip, bld);
-        } else {
-            old_child = BO::node_bm_ptr(node);
-        }
+        // Build old subtree child pointer: remaining skip chain after mismatch.
+        // Copied out of node, which is deallocated below.
+        std::uint64_t old_child = BO::build_remainder(node, sc, mismatch_pos + 1, bld);
 
         std::uint64_t new_child = tag_leaf(new_leaf);
         std::uint64_t child_ptrs[2];
@@ -705,6 +777,7 @@ struct kntrie_ops {
     static erase_result_t<K> do_coalesce(std::uint64_t* node, node_header_t* hdr,
                                          K stored, std::uint64_t total_entries,
                                          unsigned shift, BLD& bld) {
+        stat_add(stat_t::COALESCE);
         std::uint8_t sc = hdr->skip();
 
         // Allocate compact leaf for all entries
@@ -779,6 +852,121 @@ struct kntrie_ops {
         bld.dealloc_node(node, hdr->alloc_u64());
     }
 
+    // ==================================================================
+    // clone_subtree — node-by-node structural copy into bld.
+    //
+    // Leaves are memcpy'd whole (non-inline values copy-constructed);
+    // bitmask nodes are memcpy'd, their children cloned recursively,
+    // then parent links rewired to the copy.  Returns tagged pointer.
+    // If an allocation or value copy throws, the partial copy is freed.
+    // ==================================================================
+
+    static std::uint64_t clone_subtree(std::uint64_t tagged, unsigned shift, BLD& bld) {
+        if (tagged & LEAF_BIT) {
+            if (tagged & NOT_FOUND_BIT) return tagged;
+            const std::uint64_t* node = untag_leaf(tagged);
+            if (get_header(node)->is_bitmap())
+                return tag_leaf(BO::bitmap_clone(node, bld));
+            return tag_leaf(CO::clone_leaf(node, bld));
+        }
+
+        const std::uint64_t* node = bm_to_node_const(tagged);
+        std::uint64_t* nn = BO::clone_shell(node, bld);
+        std::uint8_t sc = get_header(nn)->skip();
+        unsigned child_shift = shift - (sc + 1) * CHAR_BIT;
+        unsigned nc = BO::chain_child_count(nn, sc);
+        std::uint64_t* ch = BO::chain_children_mut(nn, sc);
+        unsigned i = 0;
+        try {
+            for (; i < nc; ++i)
+                ch[i] = clone_subtree(ch[i], child_shift, bld);
+        } catch (...) {
+            while (i-- > 0) dealloc_subtree(ch[i], child_shift, bld);
+            bld.dealloc_node(nn, get_header(nn)->alloc_u64());
+            throw;
+        }
+        BO::relink_chain(nn);
+        return tag_bitmask(nn);
+    }
+
+    // ==================================================================
+    // compact_subtree — move every node to its exact size class.
+    //
+    // Pre-order, children in key order: a full pass allocates the tree
+    // in the order a scan reads it.  Nodes take the size a fresh build
+    // would give them (entry / child count rounded to its class), so
+    // capacity left behind by erases is returned.  has_lo: the prefix
+    // above shift equals w.lo's; nodes before (w.lo, w.lo_shift) were
+    // moved by an earlier call and are passed over.  When the budget
+    // runs out the walk stops and w records the next node due.
+    // ==================================================================
+
+    static std::uint64_t compact_subtree(std::uint64_t tagged, unsigned shift, K prefix,
+                                         bool has_lo, compact_walk_t<K>& w, BLD& bld) {
+        if (w.stopped) return tagged;
+        if (tagged & LEAF_BIT) {
+            if (tagged & NOT_FOUND_BIT) return tagged;
+            if (!compact_due(w, prefix, shift, shift, has_lo)) return tagged;
+            std::uint64_t* node = untag_leaf_mut(tagged);
+            if (get_header(node)->is_bitmap())
+                return tag_leaf(BO::bitmap_relocate(node, bld));
+            return tag_leaf(CO::relocate_leaf(node, bld));
+        }
+
+        std::uint64_t* node = bm_to_node(tagged);
+        std::uint8_t sc = get_header(node)->skip();
+        unsigned node_shift = shift;
+        for (std::uint8_t si = 0; si < sc; ++si) {
+            std::uint8_t b = BO::skip_byte(node, si);
+            if (has_lo) {
+                std::uint8_t lb = static_cast<std::uint8_t>((w.lo >> shift) & 0xFF);
+                if (b < lb) return tagged;
+                has_lo = (b == lb);
+            }
+            prefix |= static_cast<K>(K(b) << shift);
+            shift -= CHAR_BIT;
+        }
+
+        if (compact_due(w, prefix, shift, node_shift, has_lo)) {
+            node = BO::relocate_chain(node, bld);
+            BO::relink_chain(node);
+            tagged = tag_bitmask(node);
+        }
+
+        std::uint8_t lb = has_lo ? static_cast<std::uint8_t>((w.lo >> shift) & 0xFF) : 0;
+        std::uint64_t* ch = BO::chain_children_mut(node, sc);
+        BO::chain_bitmap(node, sc).for_each_set([&](std::uint8_t idx, int slot) {
+            if (w.stopped || idx < lb) return;
+            ch[slot] = compact_subtree(ch[slot], shift - CHAR_BIT,
+                                       static_cast<K>(prefix | static_cast<K>(K(idx) << shift)),
+                                       has_lo && idx == lb, w, bld);
+        });
+        return tagged;
+    }
+
+    // Is the node at (start, shift) due?  low_shift is its lowest
+    // dispatch shift: keys below low_shift + 8 bits are free.  Charges
+    // the budget, or stops the walk at this node once it is spent.
+    static bool compact_due(compact_walk_t<K>& w, K start, unsigned low_shift,
+                            unsigned shift, bool has_lo) noexcept {
+        if (has_lo) {
+            unsigned free_bits = low_shift + CHAR_BIT;
+            K below = free_bits >= KEY_BYTES * CHAR_BIT
+                    ? static_cast<K>(~K(0)) : static_cast<K>((K(1) << free_bits) - 1);
+            if (w.lo & below) return false;        // starts before lo: an ancestor
+            if (shift > w.lo_shift) return false;  // same start, shallower: ancestor
+        }
+        if (w.budget == 0) {
+            w.stopped  = true;
+            w.lo       = start;
+            w.lo_shift = shift;
+            return false;
+        }
+        --w.budget;
+        ++w.moved;
+        return true;
+    }
+
     // Free node structures only — values transferred elsewhere (used by coalesce in impl)
     static void dealloc_subtree_nodes_only(std::uint64_t tagged, unsigned shift, BLD& bld) {
         if (tagged & LEAF_BIT) {
@@ -803,6 +991,241 @@ struct kntrie_ops {
         bld.dealloc_node(node, hdr->alloc_u64());
     }
 
+    // ==================================================================
+    // split_range — detach the keys in [lo, last] from a subtree.
+    //
+    // has_lo / has_hi: the subtree's prefix above shift equals lo's /
+    // last's, so that bound still cuts through it.  With neither, the
+    // whole subtree is in range and is detached without being visited.
+    // Children strictly between the bounds go the same way, so only the
+    // two boundary paths are descended: their bitmask nodes are patched
+    // or rebuilt once, their leaves split entry-wise.  TAKE: detached
+    // parts are assembled into the taken subtree (same shape, same
+    // shift).  Otherwise they are freed.
+    // ==================================================================
+
+    template<bool TAKE>
+    static range_result_t split_range(std::uint64_t ptr, unsigned shift, K lo, K last,
+                                      bool has_lo, bool has_hi, BLD& bld) {
+        if (!has_lo && !has_hi) return detach_whole<TAKE>(ptr, shift, bld);
+        if (ptr & LEAF_BIT) {
+            if (get_header(untag_leaf(ptr))->is_bitmap())
+                return split_bitmap_leaf<TAKE>(ptr, lo, last, has_lo, has_hi, bld);
+            return split_compact_leaf<TAKE>(ptr, lo, last, has_lo, has_hi, bld);
+        }
+
+        std::uint64_t* node = bm_to_node(ptr);
+        auto* hdr = get_header(node);
+        std::uint8_t sc = hdr->skip();
+        unsigned node_shift = shift;
+
+        std::uint8_t chain[MAX_COMBINED_SKIP];
+        for (std::uint8_t si = 0; si < sc; ++si) {
+            std::uint8_t b = BO::skip_byte(node, si);
+            chain[si] = b;
+            if (has_lo) {
+                std::uint8_t lb = static_cast<std::uint8_t>((lo >> shift) & 0xFF);
+                if (b < lb) return {ptr, 0, 0};
+                has_lo = (b == lb);
+            }
+            if (has_hi) {
+                std::uint8_t hb = static_cast<std::uint8_t>((last >> shift) & 0xFF);
+                if (b > hb) return {ptr, 0, 0};
+                has_hi = (b == hb);
+            }
+            shift -= CHAR_BIT;
+        }
+        if (!has_lo && !has_hi) return detach_whole<TAKE>(ptr, node_shift, bld);
+
+        std::uint8_t lb = has_lo ? static_cast<std::uint8_t>((lo >> shift) & 0xFF) : 0;
+        std::uint8_t hb = has_hi ? static_cast<std::uint8_t>((last >> shift) & 0xFF) : 0xFF;
+        unsigned nc = hdr->entries();
+        std::uint64_t desc = BO::chain_descendants(node, sc, nc);
+        std::uint64_t* ch = BO::chain_children_mut(node, sc);
+
+        std::uint8_t  keep_idx[BYTE_VALUES], take_idx[BYTE_VALUES];
+        std::uint64_t keep_ch[BYTE_VALUES],  take_ch[BYTE_VALUES];
+        unsigned nk = 0, nt = 0;
+        std::uint64_t count = 0;
+        BO::chain_bitmap(node, sc).for_each_set([&](std::uint8_t idx, int slot) {
+            if (idx < lb || idx > hb) {
+                keep_idx[nk] = idx;
+                keep_ch[nk++] = ch[slot];
+                return;
+            }
+            auto r = split_range<TAKE>(ch[slot], shift - CHAR_BIT, lo, last,
+                                       has_lo && idx == lb, has_hi && idx == hb, bld);
+            count += r.count;
+            if (r.kept)  { keep_idx[nk] = idx; keep_ch[nk++] = r.kept; }
+            if (r.taken) { take_idx[nt] = idx; take_ch[nt++] = r.taken; }
+        });
+        if (count == 0) return {ptr, 0, 0};
+
+        std::uint64_t kept;
+        if (nk == nc && desc - count > COMPACT_MAX) {
+            // Every child survives: patch the boundary children in place.
+            // A rebuilt child may reuse its old address, so relink both.
+            for (unsigned i = 0; i < nk; ++i) {
+                if (keep_idx[i] != lb && keep_idx[i] != hb) continue;
+                ch[i] = keep_ch[i];
+                link_child(node, keep_ch[i], keep_idx[i]);
+            }
+            BO::chain_descendants_mut(node, sc, nc) = desc - count;
+            kept = ptr;
+        } else {
+            bld.dealloc_node(node, hdr->alloc_u64());
+            kept = rebuild_range_node(chain, sc, keep_idx, keep_ch, nk, desc - count, shift, bld);
+        }
+        std::uint64_t taken = 0;
+        if constexpr (TAKE)
+            taken = rebuild_range_node(chain, sc, take_idx, take_ch, nt, count, shift, bld);
+        return {kept, taken, count};
+    }
+
+    template<bool TAKE>
+    static range_result_t detach_whole(std::uint64_t ptr, unsigned shift, BLD& bld) {
+        std::uint64_t n = BO::exact_subtree_count(ptr);
+        if constexpr (TAKE) return {0, ptr, n};
+        dealloc_subtree(ptr, shift, bld);
+        return {0, 0, n};
+    }
+
+    // A bitmask level over n surviving children (final bitmap at shift),
+    // behind the original chain bytes.  Mirrors erase_node: none → 0,
+    // one → collapsed as wrap_single_child, few entries → one compact
+    // leaf.
+    static std::uint64_t rebuild_range_node(const std::uint8_t* chain, std::uint8_t sc,
+                                            const std::uint8_t* indices,
+                                            const std::uint64_t* children, unsigned n,
+                                            std::uint64_t total, unsigned shift, BLD& bld) {
+        if (n == 0) return 0;
+        if (n == 1) {
+            std::uint64_t c = children[0];
+            if (c & LEAF_BIT) {
+                if (!get_header(untag_leaf(c))->is_bitmap()) return c;
+            } else {
+                std::uint8_t bytes[MAX_COMBINED_SKIP];
+                std::memcpy(bytes, chain, sc);
+                bytes[sc] = indices[0];
+                return BO::wrap_in_chain(bm_to_node(c), bytes,
+                                         static_cast<std::uint8_t>(sc + 1), bld);
+            }
+        } else if (total <= COMPACT_MAX) {
+            return coalesce_children(children, n, total, shift - CHAR_BIT, bld);
+        }
+        if (sc == 0)
+            return tag_bitmask(BO::make_bitmask(indices, children, n, bld, total));
+        return tag_bitmask(BO::make_skip_chain(chain, sc, indices, children, n, bld, total));
+    }
+
+    // One compact leaf holding every entry of children[0..n)
+    static std::uint64_t coalesce_children(const std::uint64_t* children, unsigned n,
+                                           std::uint64_t total, unsigned child_shift,
+                                           BLD& bld) {
+        constexpr std::size_t hu = COMPACT_HEADER_U64;
+        std::size_t total_u64 = CO::get_compact_u64(static_cast<std::uint16_t>(total));
+        std::uint64_t* leaf = bld.alloc_node(total_u64);
+        std::memset(leaf, 0, hu * U64_BYTES);  // zero header + parent ptr
+        auto* lh = get_header(leaf);
+        lh->set_entries(static_cast<std::uint16_t>(total));
+        CO::set_capacity(leaf, static_cast<std::uint16_t>(total));
+
+        K* dk = CO::keys(leaf, hu);
+        std::size_t wi = 0;
+        if constexpr (VT::IS_BOOL) {
+            auto bv = CO::bool_vals_mut(leaf);
+            bv.clear_all(total);
+            for (unsigned i = 0; i < n; ++i)
+                walk_collect_and_dealloc(children[i], child_shift,
+                    [&](K key, VST v) {
+                        dk[wi] = key;
+                        bv.set(wi, v);
+                        wi++;
+                    }, bld);
+        } else {
+            VST* dv = CO::vals_mut(leaf);
+            for (unsigned i = 0; i < n; ++i)
+                walk_collect_and_dealloc(children[i], child_shift,
+                    [&](K key, VST v) {
+                        dk[wi] = key;
+                        VT::init_slot(&dv[wi], v);
+                        wi++;
+                    }, bld);
+        }
+        return tag_leaf(leaf);
+    }
+
+    template<bool TAKE>
+    static range_result_t split_compact_leaf(std::uint64_t ptr, K lo, K last,
+                                             bool has_lo, bool has_hi, BLD& bld) {
+        std::uint64_t* node = untag_leaf_mut(ptr);
+        auto* hdr = get_header(node);
+        unsigned entries = hdr->entries();
+        const K* kd = CO::keys(node, COMPACT_HEADER_U64);
+        unsigned a = has_lo ? static_cast<unsigned>(
+            std::lower_bound(kd, kd + entries, lo) - kd) : 0;
+        unsigned b = has_hi ? static_cast<unsigned>(
+            std::upper_bound(kd + a, kd + entries, last) - kd) : entries;
+        if (a == b) return {ptr, 0, 0};
+        unsigned count = b - a;
+        if (count == entries) return detach_whole<TAKE>(ptr, 0, bld);
+
+        // Kept entries first, taken ones after them
+        K   keys[COMPACT_MAX];
+        VST vals[COMPACT_MAX];
+        unsigned nk = entries - count, wk = 0, wt = nk, i = 0;
+        CO::for_each(node, hdr, [&](K k, VST v) {
+            unsigned w = (i < a || i >= b) ? wk++ : wt++;
+            keys[w] = k;
+            vals[w] = v;
+            ++i;
+        });
+
+        std::uint64_t taken = 0;
+        if constexpr (TAKE)
+            taken = tag_leaf(CO::make_leaf(keys + nk, vals + nk, count, bld));
+        else if constexpr (VT::HAS_DESTRUCTOR)
+            for (unsigned j = nk; j < entries; ++j) bld.destroy_value(vals[j]);
+        std::uint64_t kept = tag_leaf(CO::make_leaf(keys, vals, nk, bld));
+        CO::dealloc_node_only(node, bld);
+        return {kept, taken, count};
+    }
+
+    template<bool TAKE>
+    static range_result_t split_bitmap_leaf(std::uint64_t ptr, K lo, K last,
+                                            bool has_lo, bool has_hi, BLD& bld) {
+        std::uint64_t* node = untag_leaf_mut(ptr);
+        unsigned entries = get_header(node)->entries();
+        std::uint8_t ls = has_lo ? static_cast<std::uint8_t>(lo & 0xFF) : 0;
+        std::uint8_t hs = has_hi ? static_cast<std::uint8_t>(last & 0xFF) : 0xFF;
+
+        std::uint8_t sfx[BYTE_VALUES];
+        VST          vals[BYTE_VALUES];
+        unsigned count = 0;
+        BO::for_each_bitmap(node, [&](std::uint8_t s, VST) {
+            count += (s >= ls && s <= hs);
+        });
+        if (count == 0) return {ptr, 0, 0};
+        if (count == entries) return detach_whole<TAKE>(ptr, 0, bld);
+
+        unsigned nk = entries - count, wk = 0, wt = nk;
+        BO::for_each_bitmap(node, [&](std::uint8_t s, VST v) {
+            unsigned w = (s < ls || s > hs) ? wk++ : wt++;
+            sfx[w] = s;
+            vals[w] = v;
+        });
+
+        K base = BO::read_base_key(node);
+        std::uint64_t taken = 0;
+        if constexpr (TAKE)
+            taken = tag_leaf(BO::make_bitmap_leaf(sfx + nk, vals + nk, count, base, bld));
+        else if constexpr (VT::HAS_DESTRUCTOR)
+            for (unsigned j = nk; j < entries; ++j) bld.destroy_value(vals[j]);
+        std::uint64_t kept = tag_leaf(BO::make_bitmap_leaf(sfx, vals, nk, base, bld));
+        BO::bitmap_dealloc_node_only(node, bld);
+        return {kept, taken, count};
+    }
+
     // ==================================================================
     // entry_from_insert_pos — build iter_entry_t from insert result
     // ==================================================================
@@ -859,6 +1282,333 @@ struct kntrie_ops {
             return CO::entry_at_pos(node, pos);
         }
     }
+
+    // ==================================================================
+    // leaf_count_lt / leaf_entry_at — order statistics within one leaf
+    //
+    // A bitmap leaf holds the keys base_key | suffix; stored may lie
+    // wholly below or above that block.
+    // ==================================================================
+
+    static std::size_t leaf_count_lt(const std::uint64_t* node, K stored) noexcept {
+        auto* hdr = get_header(node);
+        if (hdr->is_bitmap()) {
+            K base_key = BO::read_base_key(node);
+            K block = stored & ~K(0xFF);
+            if (block < base_key) return 0;
+            if (block > base_key) return hdr->entries();
+            return static_cast<std::size_t>(BO::bm(node, BITMAP_LEAF_HEADER_U64)
+                .template find_slot<slot_mode::UNFILTERED>(static_cast<std::uint8_t>(stored & 0xFF)));
+        }
+        const K* kd = CO::keys(node, COMPACT_HEADER_U64);
+        unsigned entries = hdr->entries();
+        const K* base = adaptive_search_first(kd, entries, stored);
+        std::size_t pos = static_cast<std::size_t>(base - kd);
+        if (pos < entries && kd[pos] < stored) ++pos;
+        return pos;
+    }
+
+    // i < entries in the leaf
+    static iter_entry_t<K> leaf_entry_at(std::uint64_t* node, std::size_t i) noexcept {
+        auto* hdr = get_header(node);
+        if (hdr->is_bitmap()) {
+            std::uint8_t idx = BO::bm(node, BITMAP_LEAF_HEADER_U64)
+                .select_bit(static_cast<unsigned>(i));
+            return leaf_find_ge(node, BO::read_base_key(node) | K(idx));
+        }
+        return CO::entry_at_pos(node, static_cast<std::uint16_t>(i));
+    }
+
+    // ==================================================================
+    // join_walk — lockstep set-algebra join of two subtrees in key order.
+    //
+    // a and b are tagged pointers reached by the same key prefix, so the
+    // byte at shift is next for both.  A skip-chain embed is itself a
+    // one-child bitmap, so a position inside a chain needs no extra
+    // state.  Two bitmasks dispatch over the AND of their bitmaps (only
+    // matched keys kept: KEEP_AB) or the OR / one side (a side's
+    // unmatched keys kept: KEEP_A / KEEP_B): a child present on one side
+    // only is skipped, or walked whole when kept.  A leaf meeting
+    // anything goes to join_leaf.
+    // out(K stored, const VST* a, const VST* b); null for a missing side.
+    // ==================================================================
+
+    template<bool KEEP_AB, bool KEEP_A, bool KEEP_B, typename OUT>
+    static void join_walk(std::uint64_t a, std::uint64_t b, unsigned shift, OUT& out) {
+        auto a_only = [&](K k, const VST& v) { out(k, &v, nullptr); };
+        auto b_only = [&](K k, const VST& v) { out(k, nullptr, &v); };
+        if (is_empty(a)) {
+            if constexpr (KEEP_B) join_walk_all(b, b_only);
+            return;
+        }
+        if (is_empty(b)) {
+            if constexpr (KEEP_A) join_walk_all(a, a_only);
+            return;
+        }
+        if (a & LEAF_BIT) {
+            join_leaf<KEEP_AB, KEEP_A, KEEP_B, true>(a, b,
+                [&](K k) { return find_loop(b, k, shift); }, out);
+            return;
+        }
+        if (b & LEAF_BIT) {
+            join_leaf<KEEP_AB, KEEP_B, KEEP_A, false>(b, a,
+                [&](K k) { return find_loop(a, k, shift); }, out);
+            return;
+        }
+
+        const bitmap_256_t& ma = BO::bitmap_ref(a);
+        const bitmap_256_t& mb = BO::bitmap_ref(b);
+        bitmap_256_t mm;
+        for (std::size_t w = 0; w < BITMAP_WORDS; ++w) {
+            if constexpr (KEEP_A && KEEP_B) mm.words[w] = ma.words[w] | mb.words[w];
+            else if constexpr (KEEP_A)      mm.words[w] = ma.words[w];
+            else if constexpr (KEEP_B)      mm.words[w] = mb.words[w];
+            else                            mm.words[w] = ma.words[w] & mb.words[w];
+        }
+        mm.for_each_set([&](std::uint8_t idx, int /*slot*/) {
+            join_walk<KEEP_AB, KEEP_A, KEEP_B>(BO::bm_child(a, idx), BO::bm_child(b, idx),
+                                               shift - CHAR_BIT, out);
+        });
+    }
+
+    // Every entry below tagged in order: cb(K stored, const VST&).
+    // tagged may point into a skip chain; leaves hold full keys.
+    template<typename Fn>
+    static void join_walk_all(std::uint64_t tagged, Fn& cb) {
+        if (tagged & LEAF_BIT) {
+            if (!(tagged & NOT_FOUND_BIT))
+                walk_entries_in_order(tagged, 0, [&](K k, const VST& v) { cb(k, v); });
+            return;
+        }
+        BO::bitmap_ref(tagged).for_each_set([&](std::uint8_t /*idx*/, int slot) {
+            join_walk_all(BO::child_at(tagged, slot), cb);
+        });
+    }
+
+    // Leaf l against any subtree x over the same keys.  l's entries are
+    // merged linearly with a walk of x when x is a leaf or its unmatched
+    // keys are kept; otherwise each is looked up with probe(K).
+    template<bool KEEP_AB, bool KEEP_L, bool KEEP_X, bool L_IS_A, typename PROBE, typename OUT>
+    static void join_leaf(std::uint64_t l, std::uint64_t x, PROBE&& probe, OUT& out) {
+        auto emit = [&](K k, const VST* vl, const VST* vx) {
+            if constexpr (L_IS_A) out(k, vl, vx);
+            else                  out(k, vx, vl);
+        };
+        K   lk[COMPACT_MAX];
+        VST lv[COMPACT_MAX];
+        unsigned n = 0;
+        walk_entries_in_order(l, 0, [&](K k, const VST& v) { lk[n] = k; lv[n++] = v; });
+
+        unsigned i = 0;
+        if (KEEP_X || (x & LEAF_BIT)) {
+            auto fn = [&](K k, const VST& vx) {
+                for (; i < n && lk[i] < k; ++i)
+                    if constexpr (KEEP_L) emit(lk[i], &lv[i], nullptr);
+                if (i < n && lk[i] == k) {
+                    if constexpr (KEEP_AB) emit(k, &lv[i], &vx);
+                    ++i;
+                } else if constexpr (KEEP_X) {
+                    emit(k, nullptr, &vx);
+                }
+            };
+            join_walk_all(x, fn);
+            if constexpr (KEEP_L)
+                for (; i < n; ++i) emit(lk[i], &lv[i], nullptr);
+            return;
+        }
+        for (; i < n; ++i) {
+            iter_entry_t<K> e = probe(lk[i]);
+            if (e.found) {
+                if constexpr (KEEP_AB) {
+                    VST vx = entry_value(e);
+                    emit(lk[i], &lv[i], &vx);
+                }
+            } else if constexpr (KEEP_L) {
+                emit(lk[i], &lv[i], nullptr);
+            }
+        }
+    }
+
+    // ==================================================================
+    // Word walks — bool tries as integer sets (the keys mapped to true).
+    //
+    // A word is 64 keys from a multiple of 64.  A bitmap leaf's value
+    // bitmap is four words as stored; a compact leaf's true keys are
+    // gathered into words.  join_words is join_walk at word grain: two
+    // bitmap leaves over the same keys combine with bitmap_combine, a
+    // leaf meeting anything else goes to join_words_leaf.
+    // out(K base, std::uint64_t word), nonzero words in key order.
+    // ==================================================================
+
+    // Words of one leaf into w[] / base[]; returns the count.
+    static unsigned leaf_words(std::uint64_t tagged, K* base, std::uint64_t* w) noexcept {
+        const std::uint64_t* node = untag_leaf(tagged);
+        const auto* hdr = get_header(node);
+        unsigned n = 0;
+        if (hdr->is_bitmap()) {
+            K bk = BO::read_base_key(node);
+            const bitmap_256_t& vbm = BO::val_bm(node, BITMAP_LEAF_HEADER_U64);
+            for (unsigned i = 0; i < BITMAP_WORDS; ++i)
+                if (vbm.words[i]) {
+                    base[n] = bk | K(i * U64_BITS);
+                    w[n++]  = vbm.words[i];
+                }
+            return n;
+        }
+        CO::for_each(node, hdr, [&](K k, bool v) {
+            if (!v) return;
+            K b = k & K(~K(U64_BITS_MASK));
+            if (n == 0 || base[n - 1] != b) {
+                base[n] = b;
+                w[n++]  = 0;
+            }
+            w[n - 1] |= std::uint64_t{1} << (k & U64_BITS_MASK);
+        });
+        return n;
+    }
+
+    static constexpr unsigned LEAF_WORDS_MAX =
+        COMPACT_MAX > BITMAP_WORDS ? COMPACT_MAX : BITMAP_WORDS;
+
+    template<typename OUT>
+    static void walk_words(std::uint64_t tagged, OUT& out) {
+        if (tagged & LEAF_BIT) {
+            if (tagged & NOT_FOUND_BIT) return;
+            K             base[LEAF_WORDS_MAX];
+            std::uint64_t w[LEAF_WORDS_MAX];
+            unsigned n = leaf_words(tagged, base, w);
+            for (unsigned i = 0; i < n; ++i) out(base[i], w[i]);
+            return;
+        }
+        BO::bitmap_ref(tagged).for_each_set([&](std::uint8_t /*idx*/, int slot) {
+            walk_words(BO::child_at(tagged, slot), out);
+        });
+    }
+
+    // Keys mapped to true below tagged.
+    static std::size_t count_true(std::uint64_t tagged) noexcept {
+        if (tagged & LEAF_BIT) {
+            if (tagged & NOT_FOUND_BIT) return 0;
+            const std::uint64_t* node = untag_leaf(tagged);
+            const auto* hdr = get_header(node);
+            if (hdr->is_bitmap())
+                return bitmap_count(BO::val_bm(node, BITMAP_LEAF_HEADER_U64));
+            unsigned entries = hdr->entries();
+            const std::uint64_t* bw = CO::bool_vals(node).data;
+            std::size_t c = 0;
+            unsigned full = entries / U64_BITS;
+            for (unsigned i = 0; i < full; ++i) c += std::popcount(bw[i]);
+            if (entries % U64_BITS)
+                c += std::popcount(bw[full] & ((std::uint64_t{1} << (entries % U64_BITS)) - 1));
+            return c;
+        }
+        std::size_t c = 0;
+        BO::bitmap_ref(tagged).for_each_set([&](std::uint8_t /*idx*/, int slot) {
+            c += count_true(BO::child_at(tagged, slot));
+        });
+        return c;
+    }
+
+    template<bitset_op OP, typename OUT>
+    static void join_words(std::uint64_t a, std::uint64_t b, unsigned shift, OUT& out) {
+        if (is_empty(a)) {
+            if constexpr (OP == bitset_op::OR) walk_words(b, out);
+            return;
+        }
+        if (is_empty(b)) {
+            if constexpr (OP != bitset_op::AND) walk_words(a, out);
+            return;
+        }
+        if ((a & LEAF_BIT) && (b & LEAF_BIT)) {
+            const std::uint64_t* na = untag_leaf(a);
+            const std::uint64_t* nb = untag_leaf(b);
+            if (get_header(na)->is_bitmap() && get_header(nb)->is_bitmap()
+                && BO::read_base_key(na) == BO::read_base_key(nb)) {
+                bitmap_256_t r = bitmap_combine<OP>(
+                    BO::val_bm(na, BITMAP_LEAF_HEADER_U64),
+                    BO::val_bm(nb, BITMAP_LEAF_HEADER_U64));
+                K bk = BO::read_base_key(na);
+                for (unsigned i = 0; i < BITMAP_WORDS; ++i)
+                    if (r.words[i]) out(bk | K(i * U64_BITS), r.words[i]);
+                return;
+            }
+        }
+        if (a & LEAF_BIT) {
+            join_words_leaf<OP, true>(a, b,
+                [&](K k) { return find_loop(b, k, shift); }, out);
+            return;
+        }
+        if (b & LEAF_BIT) {
+            join_words_leaf<OP, false>(b, a,
+                [&](K k) { return find_loop(a, k, shift); }, out);
+            return;
+        }
+
+        const bitmap_256_t& ma = BO::bitmap_ref(a);
+        const bitmap_256_t& mb = BO::bitmap_ref(b);
+        bitmap_256_t mm = OP == bitset_op::ANDNOT ? ma : bitmap_combine<OP>(ma, mb);
+        mm.for_each_set([&](std::uint8_t idx, int /*slot*/) {
+            join_words<OP>(BO::bm_child(a, idx), BO::bm_child(b, idx),
+                           shift - CHAR_BIT, out);
+        });
+    }
+
+    // Leaf l against any subtree x over the same keys.  l's words are
+    // merged with x's word walk, except where only keys of l can survive
+    // (AND, or ANDNOT with l as a) and x is not a leaf: then each true
+    // key of l is looked up with probe(K).
+    template<bitset_op OP, bool L_IS_A, typename PROBE, typename OUT>
+    static void join_words_leaf(std::uint64_t l, std::uint64_t x, PROBE&& probe, OUT& out) {
+        constexpr bool KEEP_L = OP == bitset_op::OR || (OP == bitset_op::ANDNOT && L_IS_A);
+        constexpr bool KEEP_X = OP == bitset_op::OR || (OP == bitset_op::ANDNOT && !L_IS_A);
+        auto combine = [](std::uint64_t wl, std::uint64_t wx) {
+            return L_IS_A ? bitset_word<OP>(wl, wx) : bitset_word<OP>(wx, wl);
+        };
+        K             lb[LEAF_WORDS_MAX];
+        std::uint64_t lw[LEAF_WORDS_MAX];
+        unsigned n = leaf_words(l, lb, lw);
+
+        unsigned i = 0;
+        if (KEEP_X || (x & LEAF_BIT)) {
+            auto fn = [&](K b, std::uint64_t wx) {
+                for (; i < n && lb[i] < b; ++i)
+                    if constexpr (KEEP_L) out(lb[i], lw[i]);
+                if (i < n && lb[i] == b) {
+                    if (std::uint64_t r = combine(lw[i], wx)) out(b, r);
+                    ++i;
+                } else if constexpr (KEEP_X) {
+                    out(b, wx);
+                }
+            };
+            walk_words(x, fn);
+            if constexpr (KEEP_L)
+                for (; i < n; ++i) out(lb[i], lw[i]);
+            return;
+        }
+        for (; i < n; ++i) {
+            std::uint64_t wx = 0;
+            for (std::uint64_t bits = lw[i]; bits; bits &= bits - 1) {
+                unsigned bit = static_cast<unsigned>(std::countr_zero(bits));
+                iter_entry_t<K> e = probe(lb[i] | K(bit));
+                if (e.found && entry_value(e)) wx |= std::uint64_t{1} << bit;
+            }
+            if (std::uint64_t r = combine(lw[i], wx)) out(lb[i], r);
+        }
+    }
+
+    static bool is_empty(std::uint64_t tagged) noexcept {
+        return (tagged & LEAF_BIT) && (tagged & NOT_FOUND_BIT);
+    }
+
+    // Value slot of a found entry (bool: bit pos of the word array).
+    static VST entry_value(const iter_entry_t<K>& e) noexcept {
+        if constexpr (VT::IS_BOOL) {
+            const auto* w = static_cast<const std::uint64_t*>(e.val);
+            return (w[e.pos / U64_BITS] >> (e.pos % U64_BITS)) & 1;
+        } else {
+            return *static_cast<const VST*>(e.val);
+        }
+    }
 };
 
 } // namespace gteitelbaum::kntrie_detail
@@ -0,0 +1 @@
+#include "kntrie_pool_allocator.hpp"
@@ -0,0 +1,513 @@
+#ifndef KNTRIE_POOL_ALLOCATOR_HPP
+#define KNTRIE_POOL_ALLOCATOR_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <algorithm>
+#include <bit>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+#if defined(__linux__)
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define KNTRIE_PAGE_MMAP 1
+#else
+#define KNTRIE_PAGE_MMAP 0
+#endif
+
+namespace gteitelbaum {
+
+// ==========================================================================
+// kntrie_pool_stats_t
+//
+// reserved_bytes: everything obtained from operator new (slabs + large).
+// live_bytes:     bytes currently handed out (requested sizes).
+// ==========================================================================
+
+struct kntrie_pool_stats_t {
+    std::size_t reserved_bytes = 0;
+    std::size_t live_bytes     = 0;
+    std::size_t slab_count     = 0;
+    std::size_t large_blocks   = 0;
+    std::size_t huge_fallbacks = 0;   // MAP_HUGETLB refused; fell back to THP
+    std::size_t numa_failures  = 0;   // mbind refused; pages placed by default
+};
+
+// ==========================================================================
+// kntrie_page_policy
+//
+// Where a pool's slabs come from.  Without a policy slabs are plain
+// operator new blocks.  With one they are anonymous mmaps:
+//
+//   huge   TRANSPARENT  2 MiB-aligned + madvise(MADV_HUGEPAGE)
+//          HUGETLB_2M   MAP_HUGETLB 2 MiB pages (THP if the pool is empty)
+//          HUGETLB_1G   MAP_HUGETLB 1 GiB pages (THP if the pool is empty)
+//   numa   BIND / INTERLEAVE / PREFERRED over the node mask `nodes`
+//          (bit i = node i), applied with mbind before first touch.
+//
+// slab_bytes = 0 picks one huge page per slab; smaller non-zero values
+// are raised to the least that holds one block of the biggest size
+// class.  Large blocks (over the
+// biggest size class) are mapped at 4 KiB granularity under the same
+// NUMA policy.  Non-Linux builds ignore the policy.
+// ==========================================================================
+
+enum class kntrie_huge_pages : std::uint8_t { NONE, TRANSPARENT, HUGETLB_2M, HUGETLB_1G };
+enum class kntrie_numa       : std::uint8_t { DEFAULT, BIND, INTERLEAVE, PREFERRED };
+
+struct kntrie_page_policy {
+    kntrie_huge_pages huge       = kntrie_huge_pages::TRANSPARENT;
+    kntrie_numa       numa       = kntrie_numa::DEFAULT;
+    std::uint64_t     nodes      = 0;
+    std::size_t       slab_bytes = 0;
+};
+
+namespace kntrie_detail {
+
+// ==========================================================================
+// Page mapping
+// ==========================================================================
+
+inline constexpr std::size_t PAGE_BYTES      = std::size_t(1) << 12;   // 4 KiB
+inline constexpr std::size_t HUGE_2M_BYTES   = std::size_t(1) << 21;
+inline constexpr std::size_t HUGE_1G_BYTES   = std::size_t(1) << 30;
+inline constexpr unsigned    NUMA_MAX_NODES  = 64;                     // width of policy.nodes
+
+// linux/mempolicy.h modes
+inline constexpr int MPOL_MODE_PREFERRED  = 1;
+inline constexpr int MPOL_MODE_BIND       = 2;
+inline constexpr int MPOL_MODE_INTERLEAVE = 3;
+
+inline constexpr std::size_t round_up_bytes(std::size_t n, std::size_t grain) noexcept {
+    return (n + grain - 1) & ~(grain - 1);
+}
+
+inline constexpr std::size_t huge_page_bytes(kntrie_huge_pages h) noexcept {
+    switch (h) {
+    case kntrie_huge_pages::NONE:       return PAGE_BYTES;
+    case kntrie_huge_pages::HUGETLB_1G: return HUGE_1G_BYTES;
+    default:                            return HUGE_2M_BYTES;
+    }
+}
+
+#if KNTRIE_PAGE_MMAP
+
+inline void* map_anon(std::size_t bytes, int extra_flags) noexcept {
+    void* p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | extra_flags, -1, 0);
+    return p == MAP_FAILED ? nullptr : p;
+}
+
+// Over-map by one huge page and trim, so THP can back every 2 MiB span.
+inline void* map_thp(std::size_t bytes) noexcept {
+    auto* raw = static_cast<std::byte*>(map_anon(bytes + HUGE_2M_BYTES, 0));
+    if (!raw) return nullptr;
+    std::byte* p = reinterpret_cast<std::byte*>(
+        round_up_bytes(reinterpret_cast<std::uintptr_t>(raw), HUGE_2M_BYTES));
+    if (p != raw) ::munmap(raw, static_cast<std::size_t>(p - raw));
+    std::size_t tail = static_cast<std::size_t>(raw + bytes + HUGE_2M_BYTES - (p + bytes));
+    if (tail) ::munmap(p + bytes, tail);
+#ifdef MADV_HUGEPAGE
+    ::madvise(p, bytes, MADV_HUGEPAGE);
+#endif
+    return p;
+}
+
+inline bool numa_bind(void* p, std::size_t bytes, const kntrie_page_policy& pol) noexcept {
+    int mode = pol.numa == kntrie_numa::BIND       ? MPOL_MODE_BIND
+             : pol.numa == kntrie_numa::INTERLEAVE ? MPOL_MODE_INTERLEAVE
+             :                                       MPOL_MODE_PREFERRED;
+    unsigned long mask = static_cast<unsigned long>(pol.nodes);
+    // maxnode counts one past the last bit the kernel reads
+    return ::syscall(SYS_mbind, p, bytes, mode, &mask,
+                     static_cast<unsigned long>(NUMA_MAX_NODES + 1), 0u) == 0;
+}
+
+// bytes must be a multiple of PAGE_BYTES.  Huge pages are only used when
+// bytes is a whole number of them.  Returns nullptr when mmap fails.
+inline void* page_map(std::size_t bytes, const kntrie_page_policy& pol,
+                      kntrie_pool_stats_t& st) noexcept {
+    void* p = nullptr;
+    std::size_t hb = huge_page_bytes(pol.huge);
+    bool huge = pol.huge != kntrie_huge_pages::NONE && bytes % hb == 0;
+    if (huge && (pol.huge == kntrie_huge_pages::HUGETLB_2M ||
+                 pol.huge == kntrie_huge_pages::HUGETLB_1G)) {
+#ifdef MAP_HUGETLB
+        int size_log2 = pol.huge == kntrie_huge_pages::HUGETLB_1G ? 30 : 21;
+        p = map_anon(bytes, MAP_HUGETLB | (size_log2 << MAP_HUGE_SHIFT));
+#endif
+        if (!p) ++st.huge_fallbacks;
+    }
+    if (!p) p = (huge || bytes % HUGE_2M_BYTES == 0) ? map_thp(bytes) : map_anon(bytes, 0);
+    if (p && pol.numa != kntrie_numa::DEFAULT && !numa_bind(p, bytes, pol))
+        ++st.numa_failures;
+    return p;
+}
+
+inline void page_unmap(void* p, std::size_t bytes) noexcept { ::munmap(p, bytes); }
+
+// NUMA node of the calling thread's current CPU (0 if unknown).
+inline unsigned current_numa_node() noexcept {
+    unsigned cpu = 0, node = 0;
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 29))
+    if (::getcpu(&cpu, &node) != 0) return 0;                 // vDSO
+#else
+    if (::syscall(SYS_getcpu, &cpu, &node, nullptr) != 0) return 0;
+#endif
+    return node;
+}
+
+#else
+
+inline void* page_map(std::size_t bytes, const kntrie_page_policy&,
+                      kntrie_pool_stats_t&) noexcept {
+    return ::operator new(bytes, std::align_val_t(PAGE_BYTES), std::nothrow);
+}
+
+inline void page_unmap(void* p, std::size_t) noexcept {
+    ::operator delete(p, std::align_val_t(PAGE_BYTES));
+}
+
+inline unsigned current_numa_node() noexcept { return 0; }
+
+#endif
+
+} // namespace kntrie_detail
+
+// Online NUMA node ids (from /sys/devices/system/node/online); {0} when
+// the system reports none or is not Linux.
+inline std::vector<unsigned> kntrie_numa_nodes() {
+    std::vector<unsigned> nodes;
+#if KNTRIE_PAGE_MMAP
+    if (std::FILE* f = std::fopen("/sys/devices/system/node/online", "r")) {
+        unsigned lo = 0, hi = 0;
+        int c = 0;
+        while (std::fscanf(f, "%u", &lo) == 1) {
+            hi = lo;
+            c = std::fgetc(f);
+            if (c == '-') {
+                if (std::fscanf(f, "%u", &hi) != 1) break;
+                c = std::fgetc(f);
+            }
+            for (unsigned n = lo; n <= hi && n < kntrie_detail::NUMA_MAX_NODES; ++n)
+                nodes.push_back(n);
+            if (c != ',') break;
+        }
+        std::fclose(f);
+    }
+#endif
+    if (nodes.empty()) nodes.push_back(0);
+    return nodes;
+}
+
+namespace kntrie_detail {
+
+// ==========================================================================
+// pool_resource
+//
+// Size-classed free lists carved from large slabs.  Classes are exact
+// 8-byte steps up to 128 bytes, then 4 steps per power of two up to
+// POOL_MAX_CLASS_BYTES — the same ~1.25x spacing ENTRY_CLASSES gives
+// node allocations, so a node's rounded size lands close to a class.
+// Anything bigger (or over-aligned) goes to operator new on a tracked
+// list so release_all can still drop it.  With a kntrie_page_policy,
+// slabs and large blocks are page mappings instead (see page_map).
+//
+// Not thread-safe: one pool per container (or per thread).
+// ==========================================================================
+
+inline constexpr std::size_t POOL_GRAIN_BYTES     = 8;
+inline constexpr std::size_t POOL_EXACT_BYTES     = 128;
+inline constexpr std::size_t POOL_EXACT_CLASSES   = POOL_EXACT_BYTES / POOL_GRAIN_BYTES;  // 16
+inline constexpr unsigned    POOL_EXACT_LOG2      = std::countr_zero(POOL_EXACT_BYTES);   // 7
+inline constexpr unsigned    POOL_STEPS_LOG2      = 2;                                    // 4 per octave
+inline constexpr std::size_t POOL_MAX_CLASS_BYTES = std::size_t(1) << 15;                 // 32 KiB
+inline constexpr std::size_t POOL_SLAB_BYTES      = std::size_t(1) << 18;                 // 256 KiB
+inline constexpr std::size_t POOL_ALIGN           = 64;
+inline constexpr std::size_t POOL_SMALL_ALIGN     = POOL_GRAIN_BYTES;
+
+inline constexpr unsigned pool_class_of(std::size_t bytes) noexcept {
+    if (bytes <= POOL_EXACT_BYTES)
+        return static_cast<unsigned>((bytes + POOL_GRAIN_BYTES - 1) / POOL_GRAIN_BYTES) - (bytes != 0);
+    std::size_t b = bytes - 1;
+    unsigned msb = static_cast<unsigned>(std::bit_width(b)) - 1;
+    unsigned sub = static_cast<unsigned>(b >> (msb - POOL_STEPS_LOG2)) & ((1u << POOL_STEPS_LOG2) - 1);
+    return static_cast<unsigned>(POOL_EXACT_CLASSES)
+         + ((msb - POOL_EXACT_LOG2) << POOL_STEPS_LOG2) + sub;
+}
+
+inline constexpr std::size_t pool_class_bytes(unsigned cls) noexcept {
+    if (cls < POOL_EXACT_CLASSES) return (cls + 1) * POOL_GRAIN_BYTES;
+    unsigned rel = cls - static_cast<unsigned>(POOL_EXACT_CLASSES);
+    unsigned msb = POOL_EXACT_LOG2 + (rel >> POOL_STEPS_LOG2);
+    unsigned sub = rel & ((1u << POOL_STEPS_LOG2) - 1);
+    return std::size_t((1u << POOL_STEPS_LOG2) + sub + 1) << (msb - POOL_STEPS_LOG2);
+}
+
+inline constexpr unsigned POOL_NUM_CLASSES = pool_class_of(POOL_MAX_CLASS_BYTES) + 1;
+
+static_assert(pool_class_bytes(pool_class_of(129)) == 160);
+static_assert(pool_class_bytes(pool_class_of(256)) == 256);
+static_assert(pool_class_bytes(POOL_NUM_CLASSES - 1) == POOL_MAX_CLASS_BYTES);
+
+class pool_resource {
+    struct free_block_t { free_block_t* next; };
+    struct slab_t       { slab_t* next; };
+    struct large_t      { large_t* prev; large_t* next; std::size_t bytes; };
+
+    static constexpr std::size_t SLAB_HDR  = POOL_ALIGN;   // keeps carve area aligned
+    static constexpr std::size_t LARGE_HDR = POOL_ALIGN;
+    static_assert(sizeof(slab_t) <= SLAB_HDR && sizeof(large_t) <= LARGE_HDR);
+
+    // Smallest paged slab that carve() can always fit a small block in
+    static constexpr std::size_t MIN_SLAB_BYTES =
+        round_up_bytes(SLAB_HDR + POOL_MAX_CLASS_BYTES, PAGE_BYTES);
+    static_assert(POOL_SLAB_BYTES >= SLAB_HDR + POOL_MAX_CLASS_BYTES);
+
+    free_block_t* free_v[POOL_NUM_CLASSES]{};
+    slab_t*       slabs_v     = nullptr;
+    large_t*      large_v     = nullptr;
+    std::byte*    bump_v      = nullptr;
+    std::byte*    bump_end_v  = nullptr;
+    kntrie_pool_stats_t stats_v{};
+    kntrie_page_policy  policy_v{};
+    bool          paged_v     = false;
+    std::size_t   slab_bytes_v = POOL_SLAB_BYTES;
+
+    void* get_block(std::size_t bytes) {
+        if (!paged_v) return ::operator new(bytes, std::align_val_t(POOL_ALIGN));
+        void* p = page_map(bytes, policy_v, stats_v);
+        if (!p) [[unlikely]] throw std::bad_alloc();
+        return p;
+    }
+
+    void put_block(void* p, std::size_t bytes) noexcept {
+        if (!paged_v) ::operator delete(p, std::align_val_t(POOL_ALIGN));
+        else          page_unmap(p, bytes);
+    }
+
+    // Bytes actually reserved for a large block of `bytes`
+    std::size_t large_span(std::size_t bytes) const noexcept {
+        return paged_v ? round_up_bytes(LARGE_HDR + bytes, PAGE_BYTES) : LARGE_HDR + bytes;
+    }
+
+    void* carve(std::size_t cb) {
+        if (static_cast<std::size_t>(bump_end_v - bump_v) < cb) [[unlikely]] {
+            auto* s = static_cast<slab_t*>(get_block(slab_bytes_v));
+            s->next = slabs_v;
+            slabs_v = s;
+            bump_v     = reinterpret_cast<std::byte*>(s) + SLAB_HDR;
+            bump_end_v = reinterpret_cast<std::byte*>(s) + slab_bytes_v;
+            stats_v.reserved_bytes += slab_bytes_v;
+            ++stats_v.slab_count;
+        }
+        void* p = bump_v;
+        bump_v += cb;
+        return p;
+    }
+
+    void* allocate_large(std::size_t bytes) {
+        auto* l = static_cast<large_t*>(get_block(large_span(bytes)));
+        l->prev  = nullptr;
+        l->next  = large_v;
+        l->bytes = bytes;
+        if (large_v) large_v->prev = l;
+        large_v = l;
+        stats_v.reserved_bytes += large_span(bytes);
+        ++stats_v.large_blocks;
+        return reinterpret_cast<std::byte*>(l) + LARGE_HDR;
+    }
+
+    void deallocate_large(void* p) noexcept {
+        auto* l = reinterpret_cast<large_t*>(static_cast<std::byte*>(p) - LARGE_HDR);
+        if (l->prev) l->prev->next = l->next;
+        else         large_v = l->next;
+        if (l->next) l->next->prev = l->prev;
+        std::size_t span = large_span(l->bytes);
+        stats_v.reserved_bytes -= span;
+        --stats_v.large_blocks;
+        put_block(l, span);
+    }
+
+    void free_large_all() noexcept {
+        while (large_v) {
+            large_t* n = large_v->next;
+            std::size_t span = large_span(large_v->bytes);
+            stats_v.reserved_bytes -= span;
+            put_block(large_v, span);
+            large_v = n;
+        }
+        stats_v.large_blocks = 0;
+    }
+
+    static bool is_small(std::size_t bytes, std::size_t align) noexcept {
+        return bytes <= POOL_MAX_CLASS_BYTES && align <= POOL_SMALL_ALIGN;
+    }
+
+public:
+    pool_resource() = default;
+
+    explicit pool_resource(const kntrie_page_policy& pol)
+        : policy_v(pol), paged_v(true),
+          slab_bytes_v(std::max(round_up_bytes(pol.slab_bytes ? pol.slab_bytes
+                                                              : huge_page_bytes(pol.huge),
+                                               PAGE_BYTES),
+                                MIN_SLAB_BYTES)) {}
+
+    pool_resource(const pool_resource&) = delete;
+    pool_resource& operator=(const pool_resource&) = delete;
+
+    ~pool_resource() {
+        free_large_all();
+        while (slabs_v) {
+            slab_t* n = slabs_v->next;
+            put_block(slabs_v, slab_bytes_v);
+            slabs_v = n;
+        }
+    }
+
+    void* allocate(std::size_t bytes, std::size_t align) {
+        stats_v.live_bytes += bytes;
+        if (!is_small(bytes, align)) [[unlikely]] return allocate_large(bytes);
+        unsigned cls = pool_class_of(bytes);
+        if (free_block_t* f = free_v[cls]) {
+            free_v[cls] = f->next;
+            return f;
+        }
+        return carve(pool_class_bytes(cls));
+    }
+
+    void deallocate(void* p, std::size_t bytes, std::size_t align) noexcept {
+        stats_v.live_bytes -= bytes;
+        if (!is_small(bytes, align)) [[unlikely]] return deallocate_large(p);
+        unsigned cls = pool_class_of(bytes);
+        auto* f = static_cast<free_block_t*>(p);
+        f->next = free_v[cls];
+        free_v[cls] = f;
+    }
+
+    // Drop every outstanding block at once.  Large blocks and all but
+    // the newest slab are returned; the newest slab is
+    // rewound so refilling after a clear() doesn't start cold.
+    void release_all() noexcept {
+        free_large_all();
+        for (auto& f : free_v) f = nullptr;
+        if (slabs_v) {
+            slab_t* keep = slabs_v;
+            slab_t* s = keep->next;
+            while (s) {
+                slab_t* n = s->next;
+                put_block(s, slab_bytes_v);
+                s = n;
+            }
+            keep->next = nullptr;
+            bump_v     = reinterpret_cast<std::byte*>(keep) + SLAB_HDR;
+            bump_end_v = reinterpret_cast<std::byte*>(keep) + slab_bytes_v;
+            stats_v.slab_count = 1;
+        }
+        stats_v.reserved_bytes = stats_v.slab_count * slab_bytes_v;
+        stats_v.live_bytes = 0;
+    }
+
+    const kntrie_pool_stats_t& stats() const noexcept { return stats_v; }
+};
+
+} // namespace kntrie_detail
+
+// ==========================================================================
+// kntrie_pool_allocator<T>
+//
+// STL allocator over a shared pool_resource.  Copies and rebinds share
+// the pool; a default-constructed allocator owns a fresh one.  Works as
+// the ALLOC of kntrie (nodes and out-of-line values) and of kstrie
+// (through kstrie_memory).  When a kntrie is the pool's only owner and
+// its values need no destructor, remove_all() drops the whole pool via
+// release_all() instead of walking the tree.
+// ==========================================================================
+
+template<typename T>
+class kntrie_pool_allocator {
+    template<typename U> friend class kntrie_pool_allocator;
+
+    std::shared_ptr<kntrie_detail::pool_resource> pool_v;
+
+    static_assert(alignof(T) <= kntrie_detail::POOL_ALIGN,
+                  "kntrie_pool_allocator: over-aligned types not supported");
+
+public:
+    using value_type      = T;
+    using size_type       = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using is_always_equal = std::false_type;
+    using propagate_on_container_swap = std::true_type;
+
+    kntrie_pool_allocator()
+        : pool_v(std::make_shared<kntrie_detail::pool_resource>()) {}
+
+    // Pool whose slabs follow a page policy (huge pages / NUMA placement)
+    explicit kntrie_pool_allocator(const kntrie_page_policy& pol)
+        : pool_v(std::make_shared<kntrie_detail::pool_resource>(pol)) {}
+
+    // No move constructor: a moved-from allocator must stay usable.
+    kntrie_pool_allocator(const kntrie_pool_allocator&) noexcept = default;
+    kntrie_pool_allocator& operator=(const kntrie_pool_allocator&) noexcept = default;
+
+    template<typename U>
+    kntrie_pool_allocator(const kntrie_pool_allocator<U>& o) noexcept
+        : pool_v(o.pool_v) {}
+
+    [[nodiscard]] T* allocate(std::size_t n) {
+        return static_cast<T*>(pool_v->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept {
+        pool_v->deallocate(p, n * sizeof(T), alignof(T));
+    }
+
+    // Frees every block handed out by this pool.  Caller guarantees no
+    // block is still referenced (the kntrie fast path checks
+    // is_sole_owner() first).
+    void release_all() const noexcept { pool_v->release_all(); }
+
+    [[nodiscard]] bool is_sole_owner() const noexcept { return pool_v.use_count() == 1; }
+
+    [[nodiscard]] kntrie_pool_stats_t stats() const noexcept { return pool_v->stats(); }
+
+    template<typename U>
+    bool operator==(const kntrie_pool_allocator<U>& o) const noexcept {
+        return pool_v == o.pool_v;
+    }
+};
+
+// ==========================================================================
+// kntrie_hugepage_allocator<T>
+//
+// kntrie_pool_allocator whose default constructor uses the default
+// kntrie_page_policy (transparent huge pages, default NUMA placement),
+// for containers that default-construct their ALLOC.  Pass a policy to
+// bind or interleave across NUMA nodes or to use MAP_HUGETLB pages.
+// ==========================================================================
+
+template<typename T>
+class kntrie_hugepage_allocator : public kntrie_pool_allocator<T> {
+    using base_t = kntrie_pool_allocator<T>;
+
+public:
+    template<typename U> struct rebind { using other = kntrie_hugepage_allocator<U>; };
+
+    kntrie_hugepage_allocator() : base_t(kntrie_page_policy{}) {}
+    explicit kntrie_hugepage_allocator(const kntrie_page_policy& pol) : base_t(pol) {}
+
+    template<typename U>
+    kntrie_hugepage_allocator(const kntrie_hugepage_allocator<U>& o) noexcept : base_t(o) {}
+};
+
+} // namespace gteitelbaum
+
+#endif // KNTRIE_POOL_ALLOCATOR_HPP
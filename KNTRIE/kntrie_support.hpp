@@ -12,6 +12,32 @@
 #include <algorithm>
 #include <functional>
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// SIMD leaf search: widest vector the target guarantees (MSVC defines the
+// same macros under /arch).  Define KNTRIE_NO_SIMD_SEARCH to force scalar.
+#if !defined(KNTRIE_NO_SIMD_SEARCH) && defined(__AVX512BW__)
+#include <immintrin.h>
+#define KNTRIE_SIMD_SEARCH_BITS 512
+#elif !defined(KNTRIE_NO_SIMD_SEARCH) && defined(__AVX2__)
+#include <immintrin.h>
+#define KNTRIE_SIMD_SEARCH_BITS 256
+#else
+#define KNTRIE_SIMD_SEARCH_BITS 0
+#endif
+
+// Hot-path counters and histograms (see instrument_t).  Off by default;
+// build with KNTRIE_INSTRUMENT=1 to compile them in.  When off every
+// hook is an empty inline function.
+#ifndef KNTRIE_INSTRUMENT
+#define KNTRIE_INSTRUMENT 0
+#endif
+#if KNTRIE_INSTRUMENT
+#include <atomic>
+#endif
+
 namespace gteitelbaum::kntrie_detail {
 
 // ==========================================================================
@@ -45,6 +71,12 @@ inline constexpr std::size_t BYTE_VALUES       = 1u << CHAR_BIT;
 // --- Compact node threshold ---
 inline constexpr std::size_t COMPACT_MAX       = 1024;
 
+// --- Cache line (padding for per-thread / per-shard state) ---
+inline constexpr std::size_t CACHE_LINE_BYTES  = 64;
+
+// --- Range scan: lines of the next leaf prefetched ahead of the caller ---
+inline constexpr std::size_t SCAN_PREFETCH_LINES = 4;
+
 // --- Bitmask node header ---
 inline constexpr std::size_t HEADER_U64        = 2;   // header(1) + parent_ptr(1)
 inline constexpr std::size_t BM_PARENT_IDX     = 1;
@@ -102,7 +134,7 @@ inline bool tst_sign(std::uint64_t v) noexcept {
 // ==========================================================================
 
 template<typename K, typename Compare>
-constexpr const K* adaptive_search(const K* base, unsigned count, K key, Compare cmp) noexcept {
+constexpr const K* adaptive_search_scalar(const K* base, unsigned count, K key, Compare cmp) noexcept {
     int bw = std::bit_width((count - 1) | 1u);
     unsigned count2 = 1u << (bw - 1);
     unsigned diff = count - count2;
@@ -119,6 +151,108 @@ constexpr const K* adaptive_search(const K* base, unsigned count, K key, Compare
     return base;
 }
 
+// ==========================================================================
+// SIMD block search — u16 / u32 keys with less / less_equal
+//
+// Same branchless halving as adaptive_search_scalar, stopped once the
+// window is one vector wide; a single unsigned compare + popcount then
+// counts the window's keys satisfying cmp (a prefix, since keys are
+// sorted) and replaces the last log2(lanes) dependent steps.
+// Windows shorter than two vectors use two overlapping loads.
+// Leaves shorter than one vector stay scalar.
+// ==========================================================================
+
+template<typename K>
+inline constexpr bool SIMD_SEARCH_KEY = KNTRIE_SIMD_SEARCH_BITS != 0 &&
+    (std::is_same_v<K, std::uint16_t> || std::is_same_v<K, std::uint32_t>);
+
+template<typename K>
+inline constexpr unsigned SIMD_SEARCH_LANES =
+    KNTRIE_SIMD_SEARCH_BITS / CHAR_BIT / sizeof(K);
+
+#if KNTRIE_SIMD_SEARCH_BITS
+
+// Lanes of base[0 .. SIMD_SEARCH_LANES<K>) with x < key (STRICT) or x <= key.
+template<typename K, bool STRICT>
+inline unsigned simd_count_block(const K* base, K key) noexcept {
+#if KNTRIE_SIMD_SEARCH_BITS == 512
+    __m512i v = _mm512_loadu_si512(base);
+    if constexpr (sizeof(K) == 2) {
+        __m512i k = _mm512_set1_epi16(static_cast<short>(key));
+        __mmask32 m = STRICT ? _mm512_cmplt_epu16_mask(v, k) : _mm512_cmple_epu16_mask(v, k);
+        return static_cast<unsigned>(std::popcount(static_cast<std::uint32_t>(m)));
+    } else {
+        __m512i k = _mm512_set1_epi32(static_cast<int>(key));
+        __mmask16 m = STRICT ? _mm512_cmplt_epu32_mask(v, k) : _mm512_cmple_epu32_mask(v, k);
+        return static_cast<unsigned>(std::popcount(static_cast<std::uint32_t>(m)));
+    }
+#else
+    // No unsigned compare: x <= k  <=>  max(x, k) == k;  x < k  <=>  max(x, k) != x.
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(base));
+    __m256i k, mx;
+    if constexpr (sizeof(K) == 2) {
+        k  = _mm256_set1_epi16(static_cast<short>(key));
+        mx = _mm256_max_epu16(v, k);
+    } else {
+        k  = _mm256_set1_epi32(static_cast<int>(key));
+        mx = _mm256_max_epu32(v, k);
+    }
+    __m256i eq = (sizeof(K) == 2) ? _mm256_cmpeq_epi16(mx, STRICT ? v : k)
+                                  : _mm256_cmpeq_epi32(mx, STRICT ? v : k);
+    unsigned hits = static_cast<unsigned>(std::popcount(
+        static_cast<std::uint32_t>(_mm256_movemask_epi8(eq)))) / sizeof(K);
+    return STRICT ? SIMD_SEARCH_LANES<K> - hits : hits;
+#endif
+}
+
+// Precondition: count >= SIMD_SEARCH_LANES<K>.
+template<typename K, bool STRICT>
+inline const K* adaptive_search_simd(const K* base, unsigned count, K key) noexcept {
+    constexpr unsigned W = SIMD_SEARCH_LANES<K>;
+    unsigned n;
+    if (count < 2 * W) {
+        n = simd_count_block<K, STRICT>(base, key);
+        if (n == W)
+            n = count - W + simd_count_block<K, STRICT>(base + count - W, key);
+    } else {
+        auto cmp = [key](K x) { return STRICT ? x < key : x <= key; };
+        int bw = std::bit_width((count - 1) | 1u);
+        unsigned count2 = 1u << (bw - 1);
+        unsigned diff = count - count2;
+        const K* diff_val = base + diff;
+        bool is_diff = cmp(*diff_val);
+        base = is_diff ? diff_val : base;
+        count = count2;
+        while (count > W) {
+            count >>= 1;
+            const K* hi_val = base + count;
+            bool is_hi = cmp(*hi_val);
+            base = is_hi ? hi_val : base;
+        }
+        n = simd_count_block<K, STRICT>(base, key);
+    }
+    return base + (n - (n != 0));
+}
+
+#endif // KNTRIE_SIMD_SEARCH_BITS
+
+// Dispatch: SIMD kernel for eligible key/compare pairs at run time,
+// scalar otherwise (including constant evaluation).
+template<typename K, typename Compare>
+constexpr const K* adaptive_search(const K* base, unsigned count, K key, Compare cmp) noexcept {
+#if KNTRIE_SIMD_SEARCH_BITS
+    constexpr bool IS_LT = std::is_same_v<Compare, std::less<K>>;
+    constexpr bool IS_LE = std::is_same_v<Compare, std::less_equal<K>>;
+    if constexpr (SIMD_SEARCH_KEY<K> && (IS_LT || IS_LE)) {
+        if !consteval {
+            if (count >= SIMD_SEARCH_LANES<K>)
+                return adaptive_search_simd<K, IS_LT>(base, count, key);
+        }
+    }
+#endif
+    return adaptive_search_scalar(base, count, key, cmp);
+}
+
 // Last position where *pos <= key.
 template<typename K>
 constexpr const K* adaptive_search_last(const K* base, unsigned count, K key) noexcept {
@@ -315,6 +449,30 @@ inline void set_root_parent(std::uint64_t tagged) noexcept {
     }
 }
 
+// --- Software prefetch ---
+inline void prefetch_read(const void* p) noexcept {
+#if defined(_MSC_VER)
+    _mm_prefetch(static_cast<const char*>(p), _MM_HINT_T0);
+#else
+    __builtin_prefetch(p, 0, 3);
+#endif
+}
+
+// Prefetch the line a tagged pointer touches next: the bitmap for a
+// bitmask child, the header for a leaf.  Sentinel is skipped.
+inline void prefetch_tagged(std::uint64_t tagged) noexcept {
+    if ((tagged & (LEAF_BIT | NOT_FOUND_BIT)) == (LEAF_BIT | NOT_FOUND_BIT)) return;
+    prefetch_read(reinterpret_cast<const void*>(
+        static_cast<std::uintptr_t>(tagged & ~LEAF_BIT)));
+}
+
+// Prefetch the head of a leaf (header and first keys) for a scan.
+inline void prefetch_leaf(const std::uint64_t* leaf) noexcept {
+    const char* p = reinterpret_cast<const char*>(leaf);
+    for (std::size_t i = 0; i < SCAN_PREFETCH_LINES; ++i)
+        prefetch_read(p + i * CACHE_LINE_BYTES);
+}
+
 // Copy leaf header (caller specifies size — compact=2, bitmap=3)
 inline void copy_leaf_header(const std::uint64_t* src, std::uint64_t* dst, std::size_t hu) noexcept {
     std::memcpy(dst, src, hu * U64_BYTES);
@@ -611,6 +769,52 @@ struct bitmap_256_t {
     }
 };
 
+// ==========================================================================
+// Word-level set algebra for bool tries (kntrie::bitset_or / _and /
+// _andnot).  A bitmap leaf's value bitmap is four aligned 64-key words,
+// so two leaves over the same 256 keys combine in one 256-bit op.
+// ==========================================================================
+
+enum class bitset_op : std::uint8_t { OR, AND, ANDNOT };
+
+template<bitset_op OP>
+constexpr std::uint64_t bitset_word(std::uint64_t a, std::uint64_t b) noexcept {
+    if constexpr (OP == bitset_op::OR)       return a | b;
+    else if constexpr (OP == bitset_op::AND) return a & b;
+    else                                     return a & ~b;
+}
+
+template<bitset_op OP>
+inline bitmap_256_t bitmap_combine(const bitmap_256_t& a, const bitmap_256_t& b) noexcept {
+    bitmap_256_t r;
+#if KNTRIE_SIMD_SEARCH_BITS
+    __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a.words));
+    __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b.words));
+    __m256i vr;
+    if constexpr (OP == bitset_op::OR)       vr = _mm256_or_si256(va, vb);
+    else if constexpr (OP == bitset_op::AND) vr = _mm256_and_si256(va, vb);
+    else                                     vr = _mm256_andnot_si256(vb, va);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(r.words), vr);
+#else
+    for (std::size_t w = 0; w < BITMAP_WORDS; ++w)
+        r.words[w] = bitset_word<OP>(a.words[w], b.words[w]);
+#endif
+    return r;
+}
+
+// Set bits in a 256-bit bitmap; one VPOPCNTQ where AVX-512 has it.
+inline std::size_t bitmap_count(const bitmap_256_t& m) noexcept {
+#if KNTRIE_SIMD_SEARCH_BITS && defined(__AVX512VPOPCNTDQ__) && defined(__AVX512VL__)
+    __m256i c = _mm256_popcnt_epi64(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(m.words)));
+    alignas(32) std::uint64_t lanes[BITMAP_WORDS];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), c);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#else
+    return static_cast<std::size_t>(m.popcount());
+#endif
+}
+
 // ==========================================================================
 // Bool slots — packed bit storage (preserved exactly)
 // ==========================================================================
@@ -808,6 +1012,124 @@ struct value_traits {
     }
 };
 
+// ==========================================================================
+// Instrumentation (KNTRIE_INSTRUMENT)
+//
+// Process-wide relaxed counters shared by every kntrie instantiation.
+// Hooks sit on find descent, structural changes and the builder's node
+// allocations; with KNTRIE_INSTRUMENT=0 they compile to nothing.
+// ==========================================================================
+
+inline constexpr bool INSTRUMENT = KNTRIE_INSTRUMENT != 0;
+inline constexpr unsigned INSTRUMENT_BUCKETS = 16;
+
+enum class stat_t : unsigned {
+    FIND,           // find descents (find, contains, find_batch keys)
+    FIND_NODES,     // bitmask levels + leaf visited by those descents
+    SKIP_MISMATCH,  // root prefix / chain skip byte disagreed with the key
+    COMPACT_HIT,    // find reached a compact leaf
+    BITMAP_HIT,     // find reached a bitmap leaf
+    SPLIT,          // leaf overflow -> bitmask, or skip prefix split
+    COALESCE,       // subtree collapsed back into a compact leaf
+    REALLOC,        // node outgrew its ENTRY_CLASSES / alloc size on insert
+    BYTES_ALLOC,
+    BYTES_FREED,
+    COUNT_
+};
+
+// Snapshot returned by kntrie_instrument().
+struct instrument_t {
+    std::uint64_t finds           = 0;
+    std::uint64_t find_nodes      = 0;
+    std::uint64_t skip_mismatches = 0;
+    std::uint64_t compact_hits    = 0;
+    std::uint64_t bitmap_hits     = 0;
+    std::uint64_t splits          = 0;
+    std::uint64_t coalesces       = 0;
+    std::uint64_t reallocs        = 0;
+    std::uint64_t bytes_allocated = 0;
+    std::uint64_t bytes_freed     = 0;
+    // depth[d]: finds that crossed d bitmask levels (last bucket saturates)
+    std::uint64_t depth[INSTRUMENT_BUCKETS] = {};
+    // compact_fill[b]: compact-leaf find hits with entries in the b-th
+    // sixteenth of COMPACT_MAX
+    std::uint64_t compact_fill[INSTRUMENT_BUCKETS] = {};
+};
+
+#if KNTRIE_INSTRUMENT
+struct instrument_counters_t {
+    std::atomic<std::uint64_t> ev[static_cast<unsigned>(stat_t::COUNT_)];
+    std::atomic<std::uint64_t> depth[INSTRUMENT_BUCKETS];
+    std::atomic<std::uint64_t> compact_fill[INSTRUMENT_BUCKETS];
+};
+inline instrument_counters_t instrument_counters{};
+#endif
+
+inline void stat_add([[maybe_unused]] stat_t s,
+                     [[maybe_unused]] std::uint64_t n = 1) noexcept {
+#if KNTRIE_INSTRUMENT
+    instrument_counters.ev[static_cast<unsigned>(s)].fetch_add(n, std::memory_order_relaxed);
+#endif
+}
+
+inline void stat_find_depth([[maybe_unused]] unsigned levels) noexcept {
+#if KNTRIE_INSTRUMENT
+    stat_add(stat_t::FIND);
+    stat_add(stat_t::FIND_NODES, levels);
+    unsigned b = std::min(levels, INSTRUMENT_BUCKETS - 1);
+    instrument_counters.depth[b].fetch_add(1, std::memory_order_relaxed);
+#endif
+}
+
+inline void stat_compact_hit([[maybe_unused]] unsigned entries) noexcept {
+#if KNTRIE_INSTRUMENT
+    stat_add(stat_t::COMPACT_HIT);
+    stat_add(stat_t::FIND_NODES);
+    unsigned b = std::min(static_cast<unsigned>(entries * INSTRUMENT_BUCKETS / COMPACT_MAX),
+                          INSTRUMENT_BUCKETS - 1);
+    instrument_counters.compact_fill[b].fetch_add(1, std::memory_order_relaxed);
+#endif
+}
+
+inline void stat_bitmap_hit() noexcept {
+    stat_add(stat_t::BITMAP_HIT);
+    stat_add(stat_t::FIND_NODES);
+}
+
+inline instrument_t instrument_snapshot() noexcept {
+    instrument_t r;
+#if KNTRIE_INSTRUMENT
+    auto ld = [](stat_t s) {
+        return instrument_counters.ev[static_cast<unsigned>(s)].load(std::memory_order_relaxed);
+    };
+    r.finds           = ld(stat_t::FIND);
+    r.find_nodes      = ld(stat_t::FIND_NODES);
+    r.skip_mismatches = ld(stat_t::SKIP_MISMATCH);
+    r.compact_hits    = ld(stat_t::COMPACT_HIT);
+    r.bitmap_hits     = ld(stat_t::BITMAP_HIT);
+    r.splits          = ld(stat_t::SPLIT);
+    r.coalesces       = ld(stat_t::COALESCE);
+    r.reallocs        = ld(stat_t::REALLOC);
+    r.bytes_allocated = ld(stat_t::BYTES_ALLOC);
+    r.bytes_freed     = ld(stat_t::BYTES_FREED);
+    for (unsigned i = 0; i < INSTRUMENT_BUCKETS; ++i) {
+        r.depth[i]        = instrument_counters.depth[i].load(std::memory_order_relaxed);
+        r.compact_fill[i] = instrument_counters.compact_fill[i].load(std::memory_order_relaxed);
+    }
+#endif
+    return r;
+}
+
+inline void instrument_reset() noexcept {
+#if KNTRIE_INSTRUMENT
+    for (auto& c : instrument_counters.ev) c.store(0, std::memory_order_relaxed);
+    for (unsigned i = 0; i < INSTRUMENT_BUCKETS; ++i) {
+        instrument_counters.depth[i].store(0, std::memory_order_relaxed);
+        instrument_counters.compact_fill[i].store(0, std::memory_order_relaxed);
+    }
+#endif
+}
+
 // ==========================================================================
 // Builder (preserved exactly)
 // ==========================================================================
@@ -840,15 +1162,29 @@ struct builder<VALUE, true, ALLOC> {
 
     std::uint64_t* alloc_node(std::size_t u64_count) {
         std::uint64_t* p = alloc_v.allocate(u64_count);
+        stat_add(stat_t::BYTES_ALLOC, u64_count * U64_BYTES);
         return p;
     }
 
     void dealloc_node(std::uint64_t* p, std::size_t u64_count) noexcept {
+        stat_add(stat_t::BYTES_FREED, u64_count * U64_BYTES);
         alloc_v.deallocate(p, u64_count);
     }
 
     void drain() noexcept {}
 
+    // Whole-pool drop for allocators that support it (kntrie_pool_allocator).
+    // Refuses (returns false) when another container shares the pool.
+    bool release_all() noexcept {
+        if constexpr (requires(const ALLOC& a) { a.is_sole_owner(); a.release_all(); }) {
+            if (alloc_v.is_sole_owner()) {
+                alloc_v.release_all();
+                return true;
+            }
+        }
+        return false;
+    }
+
     using VT = value_traits<VALUE, ALLOC>;
     using slot_type = typename VT::slot_type;
 
@@ -912,6 +1248,7 @@ struct builder<VALUE, false, ALLOC> {
     }
 
     void drain() noexcept { base_v.drain(); }
+    bool release_all() noexcept { return base_v.release_all(); }
 };
 
 // ==========================================================================
@@ -952,6 +1289,28 @@ struct erase_result_t {
     iter_entry_t<UK> next;
 };
 
+// Range split: kept / taken are tagged subtrees (0 when empty),
+// count the entries taken.
+struct range_result_t {
+    std::uint64_t kept;
+    std::uint64_t taken;
+    std::uint64_t count;
+};
+
+// Compaction walk.  A node is named by (start, shift): its smallest
+// possible key and the shift it is entered at.  Pre-order visits nodes
+// in ascending start, deeper-last for equal starts, so (lo, lo_shift)
+// marks the first node not yet moved.  has_lo = false: fresh pass.
+template<typename UK>
+struct compact_walk_t {
+    UK          lo       = 0;
+    unsigned    lo_shift = 0;
+    bool        has_lo   = false;
+    std::size_t budget   = 0;     // nodes still to move this call
+    std::size_t moved    = 0;
+    bool        stopped  = false;
+};
+
 } // namespace gteitelbaum::kntrie_detail
 
 #endif // KNTRIE_SUPPORT_HPP
@@ -1,11 +1,23 @@
 #include "kntrie.hpp"
+#include "concurrent_kntrie.hpp"
+#include "sharded_kntrie.hpp"
 #include <cstdio>
+#include <coroutine>
 #include <cstdlib>
+#include <deque>
 #include <random>
+#include <map>
 #include <set>
+#include <string>
+#include <thread>
+#include <atomic>
 #include <vector>
 #include <algorithm>
 #include <cinttypes>
+#include <limits>
+#include <filesystem>
+#include <fstream>
+#include <cstddef>
 
 using namespace gteitelbaum;
 
@@ -24,6 +36,35 @@ static int g_fail = 0;
 
 #define PASS(name) do { ++g_pass; std::printf("  PASS: %s\n", name); } while(0)
 
+// ======================================================================
+// fail_alloc: throws std::bad_alloc once g_alloc_left allocations have
+// been made (negative = never) and counts live blocks, so an operation
+// that fails part way can be checked for leaks
+// ======================================================================
+
+static std::atomic<long> g_alloc_left{-1};
+static std::atomic<long> g_alloc_live{0};
+
+template<typename T>
+struct fail_alloc {
+    using value_type = T;
+    fail_alloc() = default;
+    template<typename U> fail_alloc(const fail_alloc<U>&) noexcept {}
+
+    T* allocate(std::size_t n) {
+        for (long left = g_alloc_left.load(); left >= 0; )
+            if (left == 0) throw std::bad_alloc();
+            else if (g_alloc_left.compare_exchange_weak(left, left - 1)) break;
+        ++g_alloc_live;
+        return std::allocator<T>{}.allocate(n);
+    }
+    void deallocate(T* p, std::size_t n) noexcept {
+        --g_alloc_live;
+        std::allocator<T>{}.deallocate(p, n);
+    }
+    friend bool operator==(const fail_alloc&, const fail_alloc&) noexcept { return true; }
+};
+
 // ======================================================================
 // test_forward: begin->end, ascending order + correct count
 // ======================================================================
@@ -165,6 +206,763 @@ bool test_erase(kntrie<KEY, int>& t, std::vector<KEY>& unique_keys, const char*
     return true;
 }
 
+// ======================================================================
+// test_find_batch: batched lookup agrees with find() on hits and misses
+// ======================================================================
+
+template<typename KEY>
+bool test_find_batch(kntrie<KEY, int>& t, const std::vector<KEY>& keys, const char* label) {
+    std::printf("    [find_batch] %s ...", label); fflush(stdout);
+
+    // Interleave present keys with probes that may or may not be present.
+    // Probes are computed unsigned, where k * 7 + 3 wraps instead of
+    // overflowing.
+    using UK = std::make_unsigned_t<KEY>;
+    std::vector<KEY> q;
+    q.reserve(keys.size() * 2);
+    for (auto k : keys) {
+        q.push_back(k);
+        q.push_back(static_cast<KEY>(static_cast<UK>(static_cast<UK>(k) * 7u + 3u)));
+    }
+
+    std::vector<typename kntrie<KEY, int>::iterator> its(q.size());
+    std::vector<const int*> vals(q.size());
+    std::vector<uint64_t> bits((q.size() + 63) / 64);
+    t.find_batch(q, its);
+    t.find_batch(q, std::span<const int*>(vals));
+    t.contains_batch(q, bits);
+
+    for (size_t i = 0; i < q.size(); ++i) {
+        auto it = t.find(q[i]);
+        bool in = (bits[i / 64] >> (i % 64)) & 1;
+        CHECK(its[i] == it, "%s: iterator mismatch for %lld", label, (long long)q[i]);
+        CHECK(in == (it != t.end()), "%s: contains bit wrong for %lld", label, (long long)q[i]);
+        if (it == t.end()) {
+            CHECK(vals[i] == nullptr, "%s: value for missing %lld", label, (long long)q[i]);
+        } else {
+            CHECK(vals[i] && *vals[i] == (*it).second, "%s: value mismatch for %lld",
+                  label, (long long)q[i]);
+        }
+    }
+    std::printf(" ok (%zu probes)\n", q.size());
+    PASS(label);
+    return true;
+}
+
+// ======================================================================
+// test_co_find: coroutine lookups agree with find() / lower_bound(),
+// both interleaved round-robin and awaited under a queue-based runtime
+// ======================================================================
+
+// Minimal runtime: a FIFO of ready coroutines and a fire-and-forget task
+struct test_runtime {
+    std::deque<std::coroutine_handle<>> ready;
+    void run() {
+        while (!ready.empty()) {
+            auto h = ready.front();
+            ready.pop_front();
+            h.resume();
+        }
+    }
+};
+
+struct test_yield {
+    test_runtime* rt;
+    auto operator()() const noexcept {
+        struct awaiter {
+            test_runtime* rt;
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> h) const { rt->ready.push_back(h); }
+            void await_resume() const noexcept {}
+        };
+        return awaiter{rt};
+    }
+};
+
+struct test_detached {
+    struct promise_type {
+        test_detached get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() const noexcept { return {}; }
+        std::suspend_never final_suspend() const noexcept { return {}; }
+        void return_void() const noexcept {}
+        void unhandled_exception() const noexcept { std::terminate(); }
+    };
+};
+
+template<typename KEY>
+test_detached co_probe(const kntrie<KEY, int>& t, KEY k, test_runtime& rt,
+                       typename kntrie<KEY, int>::const_iterator& hit,
+                       typename kntrie<KEY, int>::const_iterator& lb,
+                       typename kntrie<KEY, int>::const_iterator& inl) {
+    hit = co_await t.co_find(k, test_yield{&rt});
+    lb  = co_await t.co_lower_bound(k, test_yield{&rt});
+    inl = co_await t.co_find(k);
+}
+
+template<typename KEY>
+bool test_co_find(kntrie<KEY, int>& t, const std::vector<KEY>& keys, const char* label) {
+    std::printf("    [co_find] %s ...", label); fflush(stdout);
+    using UK = std::make_unsigned_t<KEY>;
+    using CI = typename kntrie<KEY, int>::const_iterator;
+    const auto& ct = t;
+
+    std::vector<KEY> q;
+    for (size_t i = 0; i < keys.size() && q.size() < 4000; i += 1 + keys.size() / 2000) {
+        q.push_back(keys[i]);
+        q.push_back(static_cast<KEY>(static_cast<UK>(static_cast<UK>(keys[i]) * 7u + 3u)));
+    }
+
+    std::vector<kntrie_lookup<CI>> finds, lbs;
+    for (auto k : q) {
+        finds.push_back(ct.co_find(k));
+        lbs.push_back(ct.co_lower_bound(k));
+    }
+    kntrie_interleave(finds);
+    kntrie_interleave(lbs.begin(), lbs.end());
+    for (size_t i = 0; i < q.size(); ++i) {
+        CHECK(finds[i].done() && finds[i].result() == ct.find(q[i]),
+              "%s: co_find mismatch for %lld", label, (long long)q[i]);
+        CHECK(lbs[i].result() == ct.lower_bound(q[i]),
+              "%s: co_lower_bound mismatch for %lld", label, (long long)q[i]);
+    }
+
+    test_runtime rt;
+    std::vector<CI> hit(q.size()), lb(q.size()), inl(q.size());
+    for (size_t i = 0; i < q.size(); ++i)
+        co_probe(ct, q[i], rt, hit[i], lb[i], inl[i]);
+    rt.run();
+    for (size_t i = 0; i < q.size(); ++i)
+        CHECK(hit[i] == ct.find(q[i]) && inl[i] == hit[i] && lb[i] == ct.lower_bound(q[i]),
+              "%s: awaited lookup mismatch for %lld", label, (long long)q[i]);
+    std::printf(" ok (%zu probes)\n", q.size());
+    PASS(label);
+    return true;
+}
+
+// ======================================================================
+// test_from_sorted: bulk-built trie matches incremental one, stays mutable
+// ======================================================================
+
+template<typename KEY>
+bool test_from_sorted(kntrie<KEY, int>& t, const std::vector<KEY>& unique_keys,
+                      const char* label) {
+    std::printf("    [from_sorted] %s ...", label); fflush(stdout);
+
+    std::vector<std::pair<KEY, int>> kv;
+    kv.reserve(unique_keys.size());
+    for (auto it = t.begin(); it != t.end(); ++it)
+        kv.emplace_back((*it).first, (*it).second);
+
+    auto b = kntrie<KEY, int>::from_sorted(kv.begin(), kv.end());
+    CHECK(b.size() == t.size(), "%s: size %zu != %zu", label, b.size(), t.size());
+
+    auto ia = t.begin();
+    for (auto ib = b.begin(); ib != b.end(); ++ib, ++ia) {
+        CHECK(ia != t.end(), "%s: bulk trie has extra keys", label);
+        CHECK((*ia).first == (*ib).first && (*ia).second == (*ib).second,
+              "%s: entry mismatch at key %lld", label, (long long)(*ia).first);
+    }
+    CHECK(ia == t.end(), "%s: bulk trie missing keys", label);
+    for (auto k : unique_keys)
+        CHECK(b.contains(k), "%s: key %lld not found after bulk load", label, (long long)k);
+
+    // Parallel build produces the same tree
+    auto p = kntrie<KEY, int>::from_sorted(kv.begin(), kv.end(), 4);
+    auto sp = p.debug_stats(), sb = b.debug_stats();
+    CHECK(sp.total_bytes == sb.total_bytes && sp.bitmask_nodes == sb.bitmask_nodes
+          && sp.compact_leaves == sb.compact_leaves && sp.bitmap_leaves == sb.bitmap_leaves,
+          "%s: parallel build shape differs", label);
+    size_t np = 0;
+    for (auto it = p.rbegin(); it != p.rend(); ++it) ++np;
+    CHECK(np == t.size(), "%s: parallel bwd count %zu != %zu", label, np, t.size());
+    for (auto k : unique_keys)
+        CHECK(p.contains(k), "%s: key %lld missing after parallel load", label, (long long)k);
+
+    // Copy goes through the same path
+    kntrie<KEY, int> c(b);
+    CHECK(c.size() == b.size(), "%s: copy size %zu != %zu", label, c.size(), b.size());
+
+    // Still a valid mutable trie: erase every other key, re-insert them
+    size_t n = 0;
+    for (size_t i = 0; i < unique_keys.size(); i += 2, ++n)
+        CHECK(b.erase(unique_keys[i]) == 1, "%s: erase %lld failed", label,
+              (long long)unique_keys[i]);
+    CHECK(b.size() == unique_keys.size() - n, "%s: size after erase", label);
+    for (size_t i = 0; i < unique_keys.size(); i += 2)
+        b.insert(unique_keys[i], 1);
+    CHECK(b.size() == unique_keys.size(), "%s: size after re-insert", label);
+    for (auto k : unique_keys)
+        CHECK(b.contains(k), "%s: key %lld lost after churn", label, (long long)k);
+
+    // Duplicates collapse; descending input is rejected
+    if (kv.size() >= 2) {
+        std::vector<std::pair<KEY, int>> dup = {kv[0], kv[0], kv[1]};
+        auto d = kntrie<KEY, int>::from_sorted(dup.begin(), dup.end());
+        CHECK(d.size() == 2, "%s: duplicate keys not collapsed", label);
+
+        std::vector<std::pair<KEY, int>> bad = {kv[1], kv[0]};
+        bool threw = false;
+        try { d.assign_sorted(bad.begin(), bad.end()); }
+        catch (const std::invalid_argument&) { threw = true; }
+        CHECK(threw && d.size() == 2, "%s: unsorted input accepted", label);
+    }
+
+    std::printf(" ok\n");
+    PASS(label);
+    return true;
+}
+
+// ======================================================================
+// test_copy: structural clone is equal, independent, and fully linked
+// ======================================================================
+
+template<typename KEY>
+bool test_copy(kntrie<KEY, int>& t, const std::vector<KEY>& unique_keys, const char* label) {
+    std::printf("    [copy] %s ...", label); fflush(stdout);
+
+    kntrie<KEY, int> c(t);
+    CHECK(c.size() == t.size(), "%s: copy size %zu != %zu", label, c.size(), t.size());
+    CHECK(c.memory_usage() == t.memory_usage(), "%s: copy memory differs", label);
+
+    auto ia = t.begin();
+    for (auto ib = c.begin(); ib != c.end(); ++ib, ++ia)
+        CHECK((*ia).first == (*ib).first && (*ia).second == (*ib).second,
+              "%s: copy entry mismatch at key %lld", label, (long long)(*ia).first);
+
+    // Backward walk exercises the rewired parent links
+    size_t n = 0;
+    for (auto it = c.rbegin(); it != c.rend(); ++it) ++n;
+    CHECK(n == t.size(), "%s: copy bwd count %zu != %zu", label, n, t.size());
+
+    // Mutating the copy leaves the source alone
+    for (size_t i = 0; i < unique_keys.size(); i += 3) c.erase(unique_keys[i]);
+    for (auto k : unique_keys)
+        CHECK(t.contains(k), "%s: source lost key %lld", label, (long long)k);
+
+    kntrie<KEY, int> a;
+    a = t;
+    CHECK(a.size() == t.size(), "%s: assigned size %zu != %zu", label, a.size(), t.size());
+
+    std::printf(" ok\n");
+    PASS(label);
+    return true;
+}
+
+// ======================================================================
+// test_rank_select: rank / select / count_range / distance against the
+// sorted key list, probing at, between and outside the keys
+// ======================================================================
+
+template<typename KEY>
+bool test_rank_select(kntrie<KEY, int>& t, const std::vector<KEY>& sorted_keys,
+                      const char* label) {
+    std::printf("    [rank/select] %s ...", label); fflush(stdout);
+    const auto& ct = t;
+    size_t n = sorted_keys.size();
+    CHECK(ct.size() == n, "%s: size %zu != %zu", label, ct.size(), n);
+
+    for (size_t i = 0; i < n; ++i) {
+        KEY k = sorted_keys[i];
+        CHECK(ct.rank(k) == i, "%s: rank(%lld) = %zu, expected %zu",
+              label, (long long)k, ct.rank(k), i);
+        auto it = ct.select(i);
+        CHECK(it != ct.end() && (*it).first == k,
+              "%s: select(%zu) != %lld", label, i, (long long)k);
+        // Just past k: keys <= k
+        if (k != std::numeric_limits<KEY>::max()) {
+            KEY nx = static_cast<KEY>(k + 1);
+            size_t expect = i + 1;
+            CHECK(ct.rank(nx) == expect, "%s: rank(%lld) = %zu, expected %zu",
+                  label, (long long)nx, ct.rank(nx), expect);
+        }
+    }
+    CHECK(ct.select(n) == ct.end(), "%s: select(size) != end", label);
+    CHECK(ct.rank(std::numeric_limits<KEY>::min()) == 0, "%s: rank(min) != 0", label);
+
+    // Random probes and ranges
+    std::mt19937_64 rng(n * 31 + 7);
+    for (int r = 0; r < 500; ++r) {
+        KEY lo = static_cast<KEY>(rng()), hi = static_cast<KEY>(rng());
+        if (n && (r & 1)) {
+            lo = sorted_keys[rng() % n];
+            hi = static_cast<KEY>(lo + static_cast<KEY>(rng() % 300));
+            if (hi < lo) hi = std::numeric_limits<KEY>::max();
+        }
+        size_t rl = static_cast<size_t>(
+            std::lower_bound(sorted_keys.begin(), sorted_keys.end(), lo) - sorted_keys.begin());
+        size_t rh = static_cast<size_t>(
+            std::lower_bound(sorted_keys.begin(), sorted_keys.end(), hi) - sorted_keys.begin());
+        CHECK(ct.rank(lo) == rl, "%s: rank(%lld) = %zu, expected %zu",
+              label, (long long)lo, ct.rank(lo), rl);
+        size_t expect = hi > lo ? rh - rl : 0;
+        CHECK(ct.count_range(lo, hi) == expect, "%s: count_range(%lld, %lld) = %zu, expected %zu",
+              label, (long long)lo, (long long)hi, ct.count_range(lo, hi), expect);
+    }
+
+    // distance agrees with stepping
+    if (n) {
+        size_t a = n / 3, b = n - n / 5;
+        auto ia = ct.select(a), ib = ct.select(b);
+        CHECK(ct.distance(ia, ib) == static_cast<std::ptrdiff_t>(b - a),
+              "%s: distance(%zu, %zu) wrong", label, a, b);
+        CHECK(ct.distance(ib, ia) == -static_cast<std::ptrdiff_t>(b - a),
+              "%s: negative distance wrong", label);
+        CHECK(ct.distance(ct.begin(), ct.end()) == static_cast<std::ptrdiff_t>(n),
+              "%s: distance(begin, end) = %td", label, ct.distance(ct.begin(), ct.end()));
+    }
+
+    std::printf(" ok\n");
+    PASS(label);
+    return true;
+}
+
+// ======================================================================
+// test_erase_range: erase_range / extract_range / erase(first, last) on
+// copies, checked key-by-key and by walking both directions
+// ======================================================================
+
+template<typename KEY>
+bool check_range_result(kntrie<KEY, int>& t, const std::vector<KEY>& want,
+                        const char* what, const char* label) {
+    CHECK(t.size() == want.size(), "%s: %s size %zu != %zu", label, what, t.size(), want.size());
+    size_t i = 0;
+    for (auto it = t.begin(); it != t.end(); ++it, ++i)
+        CHECK(i < want.size() && (*it).first == want[i] && (*it).second == int(want[i] & 0x7FFFFFFF),
+              "%s: %s entry %zu wrong", label, what, i);
+    CHECK(i == want.size(), "%s: %s fwd count %zu != %zu", label, what, i, want.size());
+    for (auto it = t.rbegin(); it != t.rend(); ++it) --i;
+    CHECK(i == 0, "%s: %s bwd count off by %zu", label, what, i);
+    for (auto k : want)
+        CHECK(t.contains(k), "%s: %s lost key %lld", label, what, (long long)k);
+    return true;
+}
+
+template<typename KEY>
+bool test_erase_range(kntrie<KEY, int>& t, const std::vector<KEY>& sorted_keys,
+                      const char* label) {
+    std::printf("    [erase range] %s ...", label); fflush(stdout);
+    size_t n = sorted_keys.size();
+    std::mt19937_64 rng(n * 17 + 3);
+
+    // Index windows [a, b): empty, tiny, boundary-crossing, most, all
+    std::vector<std::pair<size_t, size_t>> wins = {
+        {0, 0}, {0, n}, {0, n / 2}, {n / 2, n}, {n / 3, n / 3 + 1}, {n / 4, n - n / 4}};
+    for (int r = 0; r < 6; ++r) {
+        size_t a = rng() % (n + 1), b = rng() % (n + 1);
+        wins.push_back({std::min(a, b), std::max(a, b)});
+    }
+
+    for (auto [a, b] : wins) {
+        // [lo, hi) in key space: bounds between neighbours hit no key
+        KEY lo = a < n ? sorted_keys[a] : std::numeric_limits<KEY>::max();
+        bool to_max = (b == n);
+        KEY hi = to_max ? std::numeric_limits<KEY>::max() : sorted_keys[b];
+        std::vector<KEY> inside(sorted_keys.begin() + a, sorted_keys.begin() + b);
+        std::vector<KEY> outside(sorted_keys.begin(), sorted_keys.begin() + a);
+        outside.insert(outside.end(), sorted_keys.begin() + b, sorted_keys.end());
+        if (to_max && n && sorted_keys.back() == hi) {
+            // hi is exclusive: max itself stays
+            inside.pop_back();
+            outside.push_back(hi);
+        }
+        if (a >= b) { inside.clear(); outside = sorted_keys; }
+
+        kntrie<KEY, int> e(t);
+        size_t got = e.erase_range(lo, hi);
+        CHECK(got == inside.size(), "%s: erase_range [%zu,%zu) removed %zu, expected %zu",
+              label, a, b, got, inside.size());
+        if (!check_range_result(e, outside, "erase_range", label)) return false;
+
+        kntrie<KEY, int> x(t);
+        auto part = x.extract_range(lo, hi);
+        if (!check_range_result(x, outside, "extract rest", label)) return false;
+        if (!check_range_result(part, inside, "extracted", label)) return false;
+        // Both halves stay independently mutable
+        for (size_t i = 0; i < inside.size(); i += 7) part.erase(inside[i]);
+        for (size_t i = 0; i < outside.size(); i += 5) x.insert(outside[i], 0);
+        CHECK(x.size() == outside.size(), "%s: rest size changed", label);
+
+        kntrie<KEY, int> it_e(t);
+        auto first = a < n ? it_e.find(sorted_keys[a]) : it_e.end();
+        auto last  = b < n ? it_e.find(sorted_keys[b]) : it_e.end();
+        if (a > b) continue;
+        auto ret = it_e.erase(first, last);
+        std::vector<KEY> rest(sorted_keys.begin(), sorted_keys.begin() + a);
+        rest.insert(rest.end(), sorted_keys.begin() + b, sorted_keys.end());
+        if (!check_range_result(it_e, rest, "erase(first, last)", label)) return false;
+        CHECK(b == n ? ret == it_e.end() : (*ret).first == sorted_keys[b],
+              "%s: erase(first, last) returned wrong position", label);
+    }
+
+    std::printf(" ok\n");
+    PASS(label);
+    return true;
+}
+
+// ======================================================================
+// test_scan: scan blocks concatenate to exactly [lo, hi) in order, each
+// block no larger than one leaf
+// ======================================================================
+
+template<typename KEY>
+bool test_scan(kntrie<KEY, int>& t, const std::vector<KEY>& sorted_keys, const char* label) {
+    std::printf("    [scan] %s ...", label); fflush(stdout);
+    const auto& ct = t;
+    size_t n = sorted_keys.size();
+    std::mt19937_64 rng(n * 13 + 5);
+
+    std::vector<std::pair<KEY, KEY>> ranges = {
+        {std::numeric_limits<KEY>::min(), std::numeric_limits<KEY>::max()},
+        {KEY(0), KEY(0)}};
+    for (int r = 0; r < 20; ++r) {
+        KEY a = static_cast<KEY>(rng()), b = static_cast<KEY>(rng());
+        if (n && (r & 1)) {
+            a = sorted_keys[rng() % n];
+            b = sorted_keys[rng() % n];
+        }
+        ranges.push_back({std::min(a, b), std::max(a, b)});
+    }
+
+    for (auto [lo, hi] : ranges) {
+        auto first = std::lower_bound(sorted_keys.begin(), sorted_keys.end(), lo);
+        auto last  = std::lower_bound(sorted_keys.begin(), sorted_keys.end(), hi);
+        std::vector<KEY> got;
+        bool vals_ok = true, sizes_ok = true;
+        ct.scan(lo, hi, [&](std::span<const KEY> ks, std::span<const int> vs) {
+            sizes_ok = sizes_ok && !ks.empty() && ks.size() == vs.size()
+                    && ks.size() <= kntrie_detail::COMPACT_MAX;
+            for (size_t i = 0; i < ks.size(); ++i) {
+                got.push_back(ks[i]);
+                vals_ok = vals_ok && vs[i] == static_cast<int>(ks[i] & 0x7FFFFFFF);
+            }
+        });
+        CHECK(sizes_ok, "%s: bad block size", label);
+        CHECK(vals_ok, "%s: value mismatch", label);
+        CHECK(std::equal(got.begin(), got.end(), first, last) &&
+              got.size() == static_cast<size_t>(last - first),
+              "%s: scan [%lld, %lld) got %zu keys, expected %zu",
+              label, (long long)lo, (long long)hi, got.size(), static_cast<size_t>(last - first));
+    }
+
+    std::printf(" ok\n");
+    PASS(label);
+    return true;
+}
+
+// ======================================================================
+// test_compact: shrink_to_fit and budgeted compact() passes, with edits
+// between slices, keep contents, links and order; memory never grows
+// ======================================================================
+
+template<typename KEY>
+bool test_compact(kntrie<KEY, int>& t, const std::vector<KEY>& sorted_keys, const char* label) {
+    std::printf("    [compact] %s ...", label); fflush(stdout);
+    auto val = [](KEY k) { return static_cast<int>(k & 0x7FFFFFFF); };
+
+    kntrie<KEY, int> s(t);
+    size_t before = s.memory_usage();
+    s.shrink_to_fit();
+    CHECK(s.memory_usage() <= before, "%s: shrink_to_fit grew %zu -> %zu",
+          label, before, s.memory_usage());
+    if (!check_range_result(s, sorted_keys, "shrink_to_fit", label)) return false;
+
+    // Slices of 5 nodes, inserting and erasing between them
+    kntrie<KEY, int> c(t);
+    std::set<KEY> want(sorted_keys.begin(), sorted_keys.end());
+    std::mt19937_64 rng(sorted_keys.size() * 29 + 1);
+    size_t calls = 0, limit = 4 * (c.memory_usage() / 16 + 8);
+    while (!c.compact(5)) {
+        CHECK(++calls < limit, "%s: compact pass did not finish", label);
+        KEY k = static_cast<KEY>(rng());
+        c.insert(k, val(k));
+        want.insert(k);
+        if (!sorted_keys.empty()) {
+            KEY e = sorted_keys[rng() % sorted_keys.size()];
+            c.erase(e);
+            want.erase(e);
+        }
+    }
+    std::vector<KEY> wv(want.begin(), want.end());
+    if (!check_range_result(c, wv, "compact slices", label)) return false;
+
+    // Still fully mutable afterwards
+    for (size_t i = 0; i < wv.size(); i += 3) c.erase(wv[i]);
+    std::vector<KEY> rest;
+    for (size_t i = 0; i < wv.size(); ++i)
+        if (i % 3) rest.push_back(wv[i]);
+    if (!check_range_result(c, rest, "compact then erase", label)) return false;
+
+    std::printf(" ok\n");
+    PASS(label);
+    return true;
+}
+
+// ======================================================================
+// test_instrument: counters stay zero when compiled out; when compiled in,
+// finds, leaf hits and depth buckets agree and every byte is returned
+// ======================================================================
+
+bool test_instrument() {
+    const char* label = "instrument";
+    std::printf("    [instrument] KNTRIE_INSTRUMENT=%d ...", KNTRIE_INSTRUMENT); fflush(stdout);
+    constexpr uint64_t N = 20000;
+    kntrie_instrument_t built, erased, found;
+    uint64_t depth_sum = 0, fill_sum = 0;
+
+    kntrie_instrument_reset();
+    {
+        kntrie<uint64_t, int> t;
+        for (uint64_t i = 0; i < N; ++i) t.insert(i * 3, static_cast<int>(i));
+        built = kntrie_instrument();
+
+        kntrie_instrument_reset();
+        for (uint64_t i = 0; i < N; ++i) (void)t.contains(i * 3);
+        (void)t.contains(~uint64_t(0));
+        found = kntrie_instrument();
+        for (unsigned b = 0; b < kntrie_detail::INSTRUMENT_BUCKETS; ++b) {
+            depth_sum += found.depth[b];
+            fill_sum  += found.compact_fill[b];
+        }
+
+        for (uint64_t i = 500; i < N; ++i) t.erase(i * 3);
+        erased = kntrie_instrument();
+        kntrie_instrument_reset();
+        t.insert(1, 1);  // allocated under the fresh counters, freed below
+    }
+    auto after = kntrie_instrument();
+
+    if constexpr (kntrie_detail::INSTRUMENT) {
+        CHECK(built.splits > 0 && built.reallocs > 0 && built.bytes_allocated > 0,
+              "%s: build recorded no splits/reallocs/bytes", label);
+        CHECK(erased.coalesces > 0, "%s: erase recorded no coalesces", label);
+        CHECK(found.finds == N + 1 && depth_sum == found.finds,
+              "%s: finds %llu depth_sum %llu", label,
+              (unsigned long long)found.finds, (unsigned long long)depth_sum);
+        CHECK(found.compact_hits + found.bitmap_hits <= found.finds &&
+              fill_sum == found.compact_hits,
+              "%s: leaf hits inconsistent", label);
+        CHECK(found.find_nodes > found.compact_hits + found.bitmap_hits,
+              "%s: find_nodes %llu counts no bitmask levels", label,
+              (unsigned long long)found.find_nodes);
+        CHECK(after.bytes_freed > after.bytes_allocated,
+              "%s: destroy freed %llu of %llu bytes", label,
+              (unsigned long long)after.bytes_freed,
+              (unsigned long long)after.bytes_allocated);
+    } else {
+        CHECK(built.bytes_allocated == 0 && erased.coalesces == 0 &&
+              found.finds == 0 && depth_sum == 0 && fill_sum == 0 &&
+              after.bytes_freed == 0,
+              "%s: counters nonzero with instrumentation off", label);
+    }
+
+    std::printf(" ok\n");
+    PASS(label);
+    return true;
+}
+
+// ======================================================================
+// test_set_ops: intersect / set_union / set_difference / merge_with
+// against std::map, with a wide partner (same root skip) and a narrow
+// one (deeper root skip)
+// ======================================================================
+
+template<typename KEY>
+bool test_set_ops(kntrie<KEY, int>& t, const std::vector<KEY>& unique_keys,
+                  const char* label) {
+    std::printf("    [set ops] %s ...", label); fflush(stdout);
+
+    std::map<KEY, int> ma(t.begin(), t.end());
+    std::map<KEY, int> wide, narrow;
+    for (size_t i = 0; i < unique_keys.size(); ++i) {
+        KEY k = unique_keys[i];
+        if (i % 2 == 0) wide.emplace(k, -static_cast<int>(i));
+        if (i % 3 == 0) wide.emplace(static_cast<KEY>(k ^ 1), 7);
+    }
+    KEY mid = unique_keys[unique_keys.size() / 2];
+    for (int j = 0; j < 300; ++j)
+        narrow.emplace(static_cast<KEY>(mid + static_cast<KEY>(j * 3)), j);
+
+    // t's values reach INT_MAX: subtract with wrap-around
+    auto sub = [](int a, int b) {
+        return static_cast<int>(static_cast<unsigned>(a) - static_cast<unsigned>(b));
+    };
+    for (const auto* mb : {&wide, &narrow}) {
+        auto tb = kntrie<KEY, int>::from_sorted(mb->begin(), mb->end());
+        std::map<KEY, int> mi, mu = *mb, md, mm = *mb;
+        for (const auto& [k, v] : ma) {
+            mu[k] = v;
+            auto it = mb->find(k);
+            if (it != mb->end()) { mi.emplace(k, v); mm[k] = sub(v, it->second); }
+            else                 { md.emplace(k, v); mm[k] = v; }
+        }
+        auto same = [&](const kntrie<KEY, int>& got, const std::map<KEY, int>& want,
+                        const char* op) {
+            CHECK(got.size() == want.size(), "%s: %s size %zu != %zu",
+                  label, op, got.size(), want.size());
+            auto it = want.begin();
+            for (auto [k, v] : got) {
+                CHECK(it != want.end() && k == it->first && v == it->second,
+                      "%s: %s entry mismatch at %lld", label, op, (long long)k);
+                ++it;
+            }
+            return true;
+        };
+        if (!same(t.intersect(tb), mi, "intersect")) return false;
+        if (!same(t.set_union(tb), mu, "union")) return false;
+        if (!same(t.set_difference(tb), md, "difference")) return false;
+        if (!same(t.merge_with(tb, sub), mm, "merge"))
+            return false;
+        std::map<KEY, int> mdb;
+        for (const auto& [k, v] : *mb) if (!ma.count(k)) mdb.emplace(k, v);
+        if (!same(tb.set_difference(t), mdb, "reverse difference")) return false;
+    }
+    CHECK(t.intersect(t).size() == t.size(), "%s: self intersect", label);
+    CHECK(t.set_difference(t).empty(), "%s: self difference", label);
+
+    std::printf(" ok\n");
+    PASS(label);
+    return true;
+}
+
+// ======================================================================
+// test_bitset: bool tries as integer sets — bitset_or / _and / _andnot,
+// count() and for_each_word against std::set, with a sparse partner
+// (compact leaves), a dense one (bitmap leaves) and a narrow one
+// (deeper root skip).  Keys mapped to false are not members.
+// ======================================================================
+
+template<typename KEY>
+bool test_bitset(kntrie<KEY, int>& t, const std::vector<KEY>& unique_keys,
+                 const char* label) {
+    std::printf("    [bitset] %s ...", label); fflush(stdout);
+
+    using BT = kntrie<KEY, bool>;
+    BT a;
+    std::set<KEY> sa;
+    for (auto [k, v] : t) {
+        bool m = (v & 3) != 0;
+        a.insert(k, m);
+        if (m) sa.insert(k);
+    }
+
+    std::map<KEY, bool> sparse, dense, narrow;
+    for (size_t i = 0; i < unique_keys.size(); i += 2)
+        sparse.emplace(static_cast<KEY>(unique_keys[i] ^ 1), i % 4 == 0);
+    KEY mid = unique_keys[unique_keys.size() / 2];
+    KEY lo  = static_cast<KEY>(mid & static_cast<KEY>(~KEY(0xFF)));
+    for (int j = 0; j < 1024; ++j)
+        if (j % 5 != 0) dense.emplace(static_cast<KEY>(lo + static_cast<KEY>(j)), j % 7 != 0);
+    for (int j = 0; j < 40; ++j)
+        narrow.emplace(static_cast<KEY>(mid + static_cast<KEY>(j * 3)), true);
+
+    auto words_of = [](const BT& x) {
+        std::set<KEY> out;
+        using UK = std::make_unsigned_t<KEY>;
+        bool ordered = true;
+        bool first = true;
+        KEY prev = 0;
+        x.for_each_word([&](KEY base, std::uint64_t w) {
+            UK ub = static_cast<UK>(base);
+            if ((!first && base <= prev) || w == 0 || (ub & 63) != 0) ordered = false;
+            first = false;
+            prev = base;
+            for (; w; w &= w - 1)
+                out.insert(static_cast<KEY>(ub + UK(std::countr_zero(w))));
+        });
+        return std::pair{out, ordered};
+    };
+    auto same = [&](const BT& got, const std::set<KEY>& want, const char* op) {
+        CHECK(got.count() == want.size(), "%s: %s count %zu != %zu",
+              label, op, got.count(), want.size());
+        CHECK(got.size() == want.size(), "%s: %s size %zu != %zu",
+              label, op, got.size(), want.size());
+        auto [ws, ordered] = words_of(got);
+        CHECK(ordered && ws == want, "%s: %s words mismatch", label, op);
+        auto it = want.begin();
+        for (auto [k, v] : got) {
+            CHECK(it != want.end() && k == *it && v, "%s: %s entry mismatch at %lld",
+                  label, op, (long long)k);
+            ++it;
+        }
+        return true;
+    };
+
+    CHECK(a.count() == sa.size(), "%s: count %zu != %zu", label, a.count(), sa.size());
+    CHECK(words_of(a).first == sa, "%s: for_each_word mismatch", label);
+
+    for (const auto* mb : {&sparse, &dense, &narrow}) {
+        BT b;
+        std::set<KEY> sb;
+        for (auto [k, v] : *mb) {
+            b.insert(k, v);
+            if (v) sb.insert(k);
+        }
+        std::set<KEY> so = sa, sn, sd, sr;
+        so.insert(sb.begin(), sb.end());
+        for (KEY k : sa) (sb.count(k) ? sn : sd).insert(k);
+        for (KEY k : sb) if (!sa.count(k)) sr.insert(k);
+        if (!same(a.bitset_or(b), so, "or")) return false;
+        if (!same(b.bitset_or(a), so, "reverse or")) return false;
+        if (!same(a.bitset_and(b), sn, "and")) return false;
+        if (!same(b.bitset_and(a), sn, "reverse and")) return false;
+        if (!same(a.bitset_andnot(b), sd, "andnot")) return false;
+        if (!same(b.bitset_andnot(a), sr, "reverse andnot")) return false;
+    }
+    CHECK(a.bitset_and(a).count() == sa.size(), "%s: self and", label);
+    CHECK(a.bitset_andnot(a).empty(), "%s: self andnot", label);
+    CHECK(a.bitset_or(BT{}).count() == sa.size(), "%s: or empty", label);
+    CHECK(BT{}.bitset_and(a).empty(), "%s: empty and", label);
+
+    std::printf(" ok\n");
+    PASS(label);
+    return true;
+}
+
+// ======================================================================
+// test_image: save + map gives the same find / order / lower_bound
+// ======================================================================
+
+static std::string image_path(const char* tag) {
+    return (std::filesystem::temp_directory_path() /
+            (std::string("kntrie_test_") + tag + ".img")).string();
+}
+
+template<typename KEY>
+bool test_image(kntrie<KEY, int>& t, const std::vector<KEY>& unique_keys,
+                const char* label) {
+    std::printf("    [image] %s ...", label); fflush(stdout);
+
+    std::string path = image_path("suite");
+    t.save(path);
+    auto v = kntrie<KEY, int>::map(path);
+    CHECK(v.size() == t.size(), "%s: image size %zu != %zu", label, v.size(), t.size());
+
+    auto ia = t.begin();
+    size_t n = 0;
+    for (auto ib = v.begin(); ib != v.end(); ++ib, ++ia, ++n)
+        CHECK(ia != t.end() && (*ia).first == (*ib).first && (*ia).second == (*ib).second,
+              "%s: image entry mismatch at %zu", label, n);
+    CHECK(n == t.size(), "%s: image count %zu != %zu", label, n, t.size());
+
+    for (auto k : unique_keys) {
+        auto got = v.find_value(k);
+        CHECK(got && *got == t.at(k), "%s: image find %lld", label, (long long)k);
+        KEY probe = static_cast<KEY>(k + 1);
+        auto want = t.lower_bound(probe);
+        auto lb = v.lower_bound(probe);
+        CHECK(want == t.end() ? lb == v.end()
+                              : (lb != v.end() && (*lb).first == (*want).first),
+              "%s: image lower_bound %lld", label, (long long)probe);
+        if (t.contains(probe)) continue;
+        CHECK(!v.contains(probe), "%s: image phantom key %lld", label, (long long)probe);
+    }
+
+    std::filesystem::remove(path);
+    std::printf(" ok\n");
+    PASS(label);
+    return true;
+}
+
 // ======================================================================
 // Data generators
 // ======================================================================
@@ -228,6 +1026,16 @@ void run_suite(std::vector<KEY> keys, const char* type_name,
     std::snprintf(buf, sizeof(buf), "%s/%s/n=%zu", type_name, pattern_name, keys.size());
 
     test_find(t, unique_keys, buf);
+    test_find_batch(t, unique_keys, buf);
+    test_co_find(t, unique_keys, buf);
+    test_from_sorted(t, unique_keys, buf);
+    test_copy(t, unique_keys, buf);
+    test_rank_select(t, unique_keys, buf);
+    test_erase_range(t, unique_keys, buf);
+    test_scan(t, unique_keys, buf);
+    test_set_ops(t, unique_keys, buf);
+    test_bitset(t, unique_keys, buf);
+    test_image(t, unique_keys, buf);
     test_forward(t, expected, buf);
     test_backward(t, expected, buf);
     test_fwd_bwd_match(t, buf);
@@ -241,6 +1049,13 @@ void run_suite(std::vector<KEY> keys, const char* type_name,
     test_forward(t, post_erase, buf2);
     test_backward(t, post_erase, buf2);
     test_fwd_bwd_match(t, buf2);
+
+    std::vector<KEY> remaining;
+    for (auto k : unique_keys)
+        if (t.contains(k)) remaining.push_back(k);
+    test_rank_select(t, remaining, buf2);
+    test_scan(t, remaining, buf2);
+    test_compact(t, remaining, buf2);
 }
 
 // ======================================================================
@@ -286,6 +1101,344 @@ void test_edge_cases(const char* type_name) {
         test_fwd_bwd_match(t, buf);
     }
 
+    // Copy with out-of-line values
+    {
+        kntrie<KEY, std::string> t;
+        for (int i = 0; i < 3000; ++i)
+            t.insert(static_cast<KEY>(i * 37), std::string(20, char('a' + i % 26)));
+        kntrie<KEY, std::string> c(t);
+        t.clear();
+        std::printf("    [copy_string] ..."); fflush(stdout);
+        bool ok = (c.size() == 3000);
+        for (int i = 0; ok && i < 3000; ++i) {
+            auto it = c.find(static_cast<KEY>(i * 37));
+            ok = (it != c.end() && (*it).second == std::string(20, char('a' + i % 26)));
+        }
+        std::printf(ok ? " ok\n" : " FAIL\n");
+        if (!ok) ++g_fail; else ++g_pass;
+    }
+
+    // Allocation failure part way through a bulk load or a copy: no
+    // leak, old contents kept (serial and parallel builds, out-of-line
+    // values)
+    {
+        std::printf("    [alloc_fail] ..."); fflush(stdout);
+        using FT = kntrie<KEY, std::string, fail_alloc<std::uint64_t>>;
+        std::vector<std::pair<KEY, std::string>> kv;
+        for (int i = 0; i < 6000; ++i)
+            kv.emplace_back(static_cast<KEY>(i * 7), std::to_string(i));
+        bool ok = true;
+        for (unsigned threads : {1u, 4u}) {
+            FT t;
+            for (int i = 0; i < 300; ++i) t.insert(static_cast<KEY>(i * 5 + 1), "old");
+            long base = g_alloc_live.load();
+            long n = static_cast<long>(kv.size());
+            for (long budget : {0L, 1L, n / 2, n - 1, n, n + 1, n + 2, n + 3, n + 5,
+                                n + 8, n + 13, n + 21, n + 34, n + 55}) {
+                g_alloc_left = budget;
+                bool threw = false;
+                try { t.assign_sorted(kv.begin(), kv.end(), threads); }
+                catch (const std::bad_alloc&) { threw = true; }
+                g_alloc_left = -1;
+                if (!threw) break;
+                ok = ok && g_alloc_live.load() == base && t.size() == 300
+                        && t.contains(static_cast<KEY>(1)) && t.at(static_cast<KEY>(1)) == "old";
+            }
+            t.assign_sorted(kv.begin(), kv.end(), threads);
+            ok = ok && t.size() == kv.size() && !t.contains(static_cast<KEY>(1));
+            for (auto& [k, v] : kv) ok = ok && t.at(k) == v;
+
+            // A failed copy frees its partial clone; assignment keeps the target
+            FT a;
+            a.insert(static_cast<KEY>(1), "old");
+            base = g_alloc_live.load();
+            for (long budget : {0L, 1L, 2L, 3L, 10L, 100L, 1000L, 4000L, n - 1}) {
+                g_alloc_left = budget;
+                int threw = 0;
+                try { FT c(t); }
+                catch (const std::bad_alloc&) { ++threw; }
+                g_alloc_left = budget;
+                try { a = t; }
+                catch (const std::bad_alloc&) { ++threw; }
+                g_alloc_left = -1;
+                ok = ok && threw == 2 && g_alloc_live.load() == base
+                        && a.size() == 1 && a.at(static_cast<KEY>(1)) == "old";
+            }
+        }
+        ok = ok && g_alloc_live.load() == 0;
+        std::printf(ok ? " ok\n" : " FAIL\n");
+        if (!ok) ++g_fail; else ++g_pass;
+    }
+
+    // Pool allocator: churn, stats, release-all fast path, shared pool
+    {
+        using PA = kntrie_pool_allocator<std::uint64_t>;
+        kntrie<KEY, int, PA> t;
+        std::set<KEY> ref;
+        std::mt19937_64 rng(77);
+        for (int i = 0; i < 20000; ++i) {
+            KEY k = static_cast<KEY>(rng());
+            if (rng() & 1) { t.insert(k, (int)k); ref.insert(k); }
+            else           { t.erase(k); ref.erase(k); }
+        }
+        std::printf("    [pool] ..."); fflush(stdout);
+        auto st = t.debug_stats();
+        bool ok = (t.size() == ref.size() && st.total_entries == ref.size()
+                   && st.live_bytes > 0 && st.reserved_bytes >= st.live_bytes);
+        for (auto k : ref) ok = ok && t.contains(k);
+
+        t.clear();
+        st = t.debug_stats();
+        ok = ok && st.live_bytes == 0 && t.begin() == t.end();
+        for (auto k : ref) t.insert(k, 1);
+        ok = ok && t.size() == ref.size();
+
+        PA shared;
+        kntrie<KEY, int, PA> a(shared), b(shared);
+        for (int i = 0; i < 3000; ++i) {
+            a.insert(static_cast<KEY>(i), i);
+            b.insert(static_cast<KEY>(i * 3), i);
+        }
+        a.clear();
+        for (int i = 0; ok && i < 3000; ++i)
+            ok = b.contains(static_cast<KEY>(i * 3));
+        ok = ok && b.debug_stats().live_bytes > 0;
+
+        kntrie<KEY, std::string, kntrie_pool_allocator<std::uint64_t>> ss;
+        for (int i = 0; i < 2000; ++i)
+            ss.insert(static_cast<KEY>(i * 11), std::string(40, 'x'));
+        ss.clear();
+        ok = ok && ss.debug_stats().live_bytes == 0;
+        std::printf(ok ? " ok\n" : " FAIL\n");
+        if (!ok) ++g_fail; else ++g_pass;
+    }
+
+    // Page policy: huge-page / NUMA-placed slabs, replicated image views
+    {
+        std::printf("    [pages] ..."); fflush(stdout);
+        using HA = kntrie_hugepage_allocator<std::uint64_t>;
+        kntrie<KEY, int, HA> t;
+        kntrie_page_policy pol;
+        pol.huge  = kntrie_huge_pages::HUGETLB_2M;
+        pol.numa  = kntrie_numa::BIND;
+        pol.nodes = std::uint64_t(1) << kntrie_numa_nodes().front();
+        kntrie<KEY, int, kntrie_pool_allocator<std::uint64_t>> b{
+            kntrie_pool_allocator<std::uint64_t>(pol)};
+        std::set<KEY> ref;
+        std::mt19937_64 rng(41);
+        for (int i = 0; i < 40000; ++i) {
+            KEY k = static_cast<KEY>(rng());
+            if (rng() % 3) { t.insert(k, (int)k); b.insert(k, (int)k); ref.insert(k); }
+            else           { t.erase(k); b.erase(k); ref.erase(k); }
+        }
+        auto st = t.debug_stats();
+        bool ok = t.size() == ref.size() && b.size() == ref.size()
+               && st.reserved_bytes >= st.live_bytes
+               && st.reserved_bytes % kntrie_detail::HUGE_2M_BYTES == 0;
+        for (auto k : ref) ok = ok && t.at(k) == (int)k && b.at(k) == (int)k;
+
+        std::string path = image_path("numa");
+        t.save(path);
+        auto rv = kntrie<KEY, int, HA>::map_replicated(path);
+        auto pv = kntrie<KEY, int, HA>::map(path, pol);
+        ok = ok && rv.replicas() == kntrie_numa_nodes().size()
+                && rv.size() == ref.size() && pv.size() == ref.size();
+        auto ri = rv.begin();
+        for (auto k : ref) {
+            ok = ok && ri != rv.end() && (*ri).first == k && rv.at(k) == (int)k
+                    && pv.find_value(k) == std::optional<int>((int)k);
+            ++ri;
+        }
+        ok = ok && ri == rv.end();
+        for (std::size_t r = 0; ok && r < rv.replicas(); ++r)
+            ok = rv.replica(r).size() == ref.size();
+        std::filesystem::remove(path);
+
+        t.clear();
+        b.clear();
+        ok = ok && t.debug_stats().live_bytes == 0 && b.debug_stats().live_bytes == 0;
+
+        // Undersized slab_bytes is raised so the biggest class still fits
+        kntrie_page_policy tiny;
+        tiny.huge       = kntrie_huge_pages::NONE;
+        tiny.slab_bytes = 4096;
+        kntrie_pool_allocator<std::uint64_t> ta(tiny);
+        std::vector<std::pair<std::uint64_t*, std::size_t>> blocks;
+        for (std::size_t n : {3000, 4096, 1, 500, 3000, 17, 4000})
+            blocks.emplace_back(ta.allocate(n), n);
+        auto ts = ta.stats();
+        ok = ok && ts.reserved_bytes == ts.slab_count * (std::size_t(36) << 10);
+        for (auto [p, n] : blocks) std::fill_n(p, n, std::uint64_t(n));
+        for (auto [p, n] : blocks)
+            ok = ok && p[0] == n && p[n - 1] == n;
+        for (auto [p, n] : blocks) ta.deallocate(p, n);
+        ok = ok && ta.stats().live_bytes == 0;
+        std::printf(ok ? " ok\n" : " FAIL\n");
+        if (!ok) ++g_fail; else ++g_pass;
+    }
+
+    // Concurrent: lock-free readers see stable keys while a writer churns
+    {
+        concurrent_kntrie<KEY, int> ct;
+        for (int i = 0; i < 2000; ++i) ct.insert(static_cast<KEY>(i * 2), i);
+        std::atomic<bool> stop{false};
+        std::atomic<int>  bad{0};
+        auto reader = [&] {
+            while (!stop.load()) {
+                for (int i = 0; i < 2000; i += 7) {
+                    auto v = ct.find(static_cast<KEY>(i * 2));
+                    if (!v || *v != i) bad.fetch_add(1);
+                }
+            }
+        };
+        std::thread r1(reader), r2(reader);
+        for (int round = 0; round < 20; ++round) {
+            for (int i = 0; i < 500; ++i) ct.insert(static_cast<KEY>(i * 2 + 1), i);
+            for (int i = 0; i < 500; ++i) ct.erase(static_cast<KEY>(i * 2 + 1));
+        }
+        stop.store(true);
+        r1.join(); r2.join();
+        std::printf("    [concurrent] ..."); fflush(stdout);
+        bool ok = (bad.load() == 0 && ct.size() == 2000);
+        ok = ok && ct.write([](auto& t) { return t.size(); }) == 2000;
+
+        // A throw on either application leaves both instances in step
+        auto both_sizes = [&] {
+            auto a = ct.write([](auto& t) { return t.size(); });
+            auto b = ct.write([](auto& t) { return t.size(); });
+            return a == b ? a : size_t(-1);
+        };
+        for (int fail_on : {1, 2}) {
+            int calls = 0;
+            bool threw = false;
+            try {
+                ct.write([&](auto& t) {
+                    t.insert(static_cast<KEY>(4001), 1);
+                    if (++calls == fail_on) throw std::runtime_error("write");
+                });
+            } catch (const std::runtime_error&) { threw = true; }
+            ok = ok && threw == (fail_on == 1)
+                    && ct.contains(static_cast<KEY>(4001)) == (fail_on == 2)
+                    && both_sizes() == (fail_on == 1 ? 2000u : 2001u);
+        }
+        std::printf(ok ? " ok\n" : " FAIL\n");
+        if (!ok) ++g_fail; else ++g_pass;
+    }
+
+    // Sharded: parallel writers, global order, cross-shard lower_bound
+    {
+        sharded_kntrie<KEY, int, 8> st;
+        std::vector<KEY> ks = make_random<KEY>(6000, 99);
+        auto writer = [&](size_t part) {
+            for (size_t i = part; i < ks.size(); i += 3) st.insert(ks[i], (int)i);
+        };
+        std::thread w1(writer, 0), w2(writer, 1), w3(writer, 2);
+        w1.join(); w2.join(); w3.join();
+
+        std::set<KEY> ref(ks.begin(), ks.end());
+        std::printf("    [sharded] ..."); fflush(stdout);
+        bool ok = (st.size() == ref.size());
+        auto ri = ref.begin();
+        for (auto it = st.begin(); ok && it != st.end(); ++it, ++ri)
+            ok = ri != ref.end() && (*it).first == *ri;
+        ok = ok && ri == ref.end();
+        const auto& cst = st;
+        typename sharded_kntrie<KEY, int, 8>::const_iterator ci = cst.lower_bound(*ref.begin());
+        ok = ok && ci == cst.begin() && std::distance(cst.begin(), cst.end()) == (long)ref.size();
+        for (size_t i = 0; ok && i < ks.size(); i += 97) {
+            KEY probe = static_cast<KEY>(ks[i] + 1);
+            auto want = ref.lower_bound(probe);
+            auto got  = st.lower_bound(probe);
+            ok = (want == ref.end()) ? (got == st.end())
+                                     : (got != st.end() && (*got).first == *want);
+        }
+        size_t visited = 0;
+        st.for_each([&](KEY, int) { ++visited; });
+        ok = ok && visited == ref.size();
+        for (size_t i = 0; ok && i < ks.size(); i += 211) {
+            KEY probe = static_cast<KEY>(ks[i] - 1);
+            auto want = ref.lower_bound(probe);
+            size_t n = st.for_each_from(probe, 100, [&](KEY k, int) {
+                ok = ok && want != ref.end() && k == *want;
+                if (want != ref.end()) ++want;
+            });
+            ok = ok && n == std::min<size_t>(100, std::distance(ref.lower_bound(probe), ref.end()));
+        }
+        std::printf(ok ? " ok\n" : " FAIL\n");
+        if (!ok) ++g_fail; else ++g_pass;
+    }
+
+    // Image: empty trie and bool values round-trip; type mismatch rejected
+    {
+        std::printf("    [image] empty/bool ..."); fflush(stdout);
+        std::string path = image_path("edge");
+        kntrie<KEY, int> e;
+        e.save(path);
+        auto ev = kntrie<KEY, int>::map(path);
+        bool ok = ev.empty() && ev.begin() == ev.end() && !ev.contains(KEY(1))
+               && ev.lower_bound(KEY(0)) == ev.end();
+
+        kntrie<KEY, bool> b;
+        // Top bits split four ways over a long shared middle: skip chains
+        using UK = std::make_unsigned_t<KEY>;
+        constexpr unsigned bits = sizeof(KEY) * CHAR_BIT;
+        for (int i = 0; i < 20000; ++i)
+            b.insert(static_cast<KEY>((UK(i & 3) << (bits - 2)) | UK((i * 7) & 0xFFFF)),
+                     (i % 3) == 0);
+        b.save(path);
+        auto bv = kntrie<KEY, bool>::map(path);
+        auto bi = b.begin();
+        for (auto it = bv.begin(); ok && it != bv.end(); ++it, ++bi)
+            ok = (*it).first == (*bi).first && (*it).second == static_cast<bool>((*bi).second);
+        ok = ok && bi == b.end() && bv.size() == b.size();
+
+        bool threw = false;
+        try { (void)kntrie<KEY, int>::map(path); } catch (const std::runtime_error&) { threw = true; }
+        ok = ok && threw;
+
+        // A root offset past the end or off word alignment is rejected
+        for (std::uint64_t bad : {std::uint64_t(1) << 40, std::uint64_t(12)}) {
+            {
+                std::fstream f(path, std::ios::in | std::ios::out | std::ios::binary);
+                f.seekp(offsetof(gteitelbaum::kntrie_detail::image_header_t, root));
+                f.write(reinterpret_cast<const char*>(&bad), sizeof(bad));
+            }
+            threw = false;
+            try { (void)kntrie<KEY, bool>::map(path); } catch (const std::runtime_error&) { threw = true; }
+            ok = ok && threw;
+        }
+        std::filesystem::remove(path);
+        std::printf(ok ? " ok\n" : " FAIL\n");
+        if (!ok) ++g_fail; else ++g_pass;
+    }
+
+    // Leaf search: dispatching adaptive_search agrees with the scalar kernel
+    {
+        std::printf("    [search] simd/scalar ..."); fflush(stdout);
+        using UK = std::make_unsigned_t<KEY>;
+        using namespace gteitelbaum::kntrie_detail;
+        std::mt19937_64 rng(77);
+        bool ok = true;
+        for (unsigned n = 1; ok && n <= COMPACT_MAX; n += (n < 80 ? 1 : 37)) {
+            std::set<UK> s;
+            while (s.size() < n) s.insert(static_cast<UK>(rng()));
+            std::vector<UK> ks(s.begin(), s.end());
+            std::vector<UK> probes = {UK(0), UK(~UK(0)), ks.front(), ks.back()};
+            for (int i = 0; i < 64; ++i) {
+                UK k = ks[rng() % n];
+                probes.insert(probes.end(), {k, UK(k - 1), UK(k + 1), static_cast<UK>(rng())});
+            }
+            for (UK p : probes) {
+                ok = ok && adaptive_search_last(ks.data(), n, p)
+                           == adaptive_search_scalar(ks.data(), n, p, std::less_equal<UK>{})
+                        && adaptive_search_first(ks.data(), n, p)
+                           == adaptive_search_scalar(ks.data(), n, p, std::less<UK>{});
+            }
+        }
+        std::printf(ok ? " ok\n" : " FAIL\n");
+        if (!ok) ++g_fail; else ++g_pass;
+    }
+
     // Insert + erase all -> empty
     {
         kntrie<KEY, int> t;
@@ -334,6 +1487,10 @@ int main() {
         run_suite(make_random<uint64_t>(n, 3000 + n), "u64", "rnd");
     }
 
+    // ---- Instrumentation ----
+    std::printf("\n--- instrumentation ---\n");
+    test_instrument();
+
     // ---- Summary ----
     std::printf("\n=== Results: %d passed, %d failed ===\n", g_pass, g_fail);
     return g_fail > 0 ? 1 : 0;
@@ -2,19 +2,208 @@
 //
 // Five value types: Int64, Int32, Float, Bool, Object
 // Key type: int64_t for all
+// Int64, Int32, Float and Bool also take NumPy arrays in bulk:
+// get_many, contains_many, set_many, range_array
 //
 // Build: g++ -std=c++23 -O2 -shared -fPIC
 //        $(python3 -m pybind11 --includes) py_kntrie.cpp
 //        -o kntrie$(python3-config --extension-suffix)
 
 #include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
 #include <pybind11/stl.h>
 #include "kntrie.hpp"
+#include <algorithm>
+#include <span>
+#include <vector>
 
 namespace py = pybind11;
 
 using namespace gteitelbaum;
 
+// ============================================================================
+// Array kernels — plain C++ over raw buffers, run with the GIL released
+// ============================================================================
+
+// Keys per find_batch / contains_batch call; the scratch stays on the stack
+static constexpr size_t ARRAY_CHUNK = 256;
+
+// set_many inserts key by key when the batch is under 1/BULK_SET_RATIO
+// of the trie; otherwise it bulk builds the batch and unions it in
+static constexpr size_t BULK_SET_RATIO = 8;
+
+static constexpr size_t WORD_BITS = 64;
+
+template<typename V>
+void get_many_into(const kntrie<int64_t, V>& t, const int64_t* keys, size_t n,
+                   V* vals, bool* found) {
+    using trie_t = kntrie<int64_t, V>;
+    for (size_t base = 0; base < n; base += ARRAY_CHUNK) {
+        size_t m = std::min(ARRAY_CHUNK, n - base);
+        std::span<const int64_t> ks(keys + base, m);
+        if constexpr (std::is_same_v<V, bool>) {
+            typename trie_t::iterator its[ARRAY_CHUNK];
+            t.find_batch(ks, std::span<typename trie_t::iterator>(its, m));
+            auto e = t.end();
+            for (size_t i = 0; i < m; ++i) {
+                found[base + i] = its[i] != e;
+                vals[base + i]  = found[base + i] && bool((*its[i]).second);
+            }
+        } else {
+            const V* ptrs[ARRAY_CHUNK];
+            t.find_batch(ks, std::span<const V*>(ptrs, m));
+            for (size_t i = 0; i < m; ++i) {
+                found[base + i] = ptrs[i] != nullptr;
+                vals[base + i]  = ptrs[i] ? *ptrs[i] : V{};
+            }
+        }
+    }
+}
+
+template<typename V>
+void contains_many_into(const kntrie<int64_t, V>& t, const int64_t* keys, size_t n,
+                        bool* found) {
+    uint64_t words[ARRAY_CHUNK / WORD_BITS];
+    for (size_t base = 0; base < n; base += ARRAY_CHUNK) {
+        size_t m = std::min(ARRAY_CHUNK, n - base);
+        t.contains_batch(std::span<const int64_t>(keys + base, m), words);
+        for (size_t i = 0; i < m; ++i)
+            found[base + i] = (words[i / WORD_BITS] >> (i % WORD_BITS)) & 1;
+    }
+}
+
+// Later duplicates win, as with repeated __setitem__
+template<typename V>
+void set_many_from(kntrie<int64_t, V>& t, const int64_t* keys, const V* vals, size_t n) {
+    using trie_t = kntrie<int64_t, V>;
+    if (n * BULK_SET_RATIO < t.size()) {
+        for (size_t i = 0; i < n; ++i) t.insert_or_assign(keys[i], vals[i]);
+        return;
+    }
+    std::vector<std::pair<int64_t, V>> kv(n);
+    for (size_t i = 0; i < n; ++i) kv[i] = {keys[i], vals[i]};
+    std::stable_sort(kv.begin(), kv.end(),
+                     [](const auto& a, const auto& b) { return a.first < b.first; });
+    size_t w = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (w && kv[w - 1].first == kv[i].first) kv[w - 1].second = kv[i].second;
+        else kv[w++] = kv[i];
+    }
+    kv.resize(w);
+    auto batch = trie_t::from_sorted(kv.begin(), kv.end());
+    t = t.empty() ? std::move(batch) : batch.set_union(t);
+}
+
+// Entries with lo <= key < hi, at most cap of them (keys / vals may be
+// null when cap is 0, which just counts).  Returns the full count.
+template<typename V>
+size_t range_into(kntrie<int64_t, V>& t, int64_t lo, int64_t hi,
+                  int64_t* keys, V* vals, size_t cap) {
+    size_t n = 0;
+    for (auto it = t.lower_bound(lo), e = t.end(); it != e; ++it) {
+        auto kv = *it;
+        if (kv.first >= hi) break;
+        if (n < cap) { keys[n] = kv.first; vals[n] = kv.second; }
+        ++n;
+    }
+    return n;
+}
+
+// Caller-supplied range_array output: exact dtype, contiguous, 1-D and
+// at least n long.  mutable_data() then rejects read-only arrays.
+template<typename A>
+A out_array(py::object o, size_t n, const char* what) {
+    if (!py::isinstance<A>(o))
+        throw py::type_error(std::string("range_array: ") + what +
+                             " must be a contiguous array of the trie's dtype");
+    auto a = py::reinterpret_borrow<A>(o);
+    if (a.ndim() != 1 || static_cast<size_t>(a.size()) < n)
+        throw py::value_error(std::string("range_array: ") + what + " too small");
+    return a;
+}
+
+// ============================================================================
+// bind_kntrie_arrays<V> — NumPy bulk operations (numeric and bool values)
+// ============================================================================
+//
+// Inputs are converted to contiguous int64 keys / V values if needed.
+// Each call borrows the array buffers, then releases the GIL for all
+// trie work.  The trie must not be modified from another thread meanwhile.
+
+template<typename V>
+void bind_kntrie_arrays(py::class_<kntrie<int64_t, V>>& cls) {
+    using trie_t    = kntrie<int64_t, V>;
+    using key_array = py::array_t<int64_t, py::array::c_style | py::array::forcecast>;
+    using val_array = py::array_t<V, py::array::c_style | py::array::forcecast>;
+    using key_out   = py::array_t<int64_t, py::array::c_style>;
+    using val_out   = py::array_t<V, py::array::c_style>;
+
+    cls
+        // get_many(keys) → (values, found); values[i] is 0 / False where
+        // found[i] is False
+        .def("get_many", [](const trie_t& t, key_array keys) {
+            size_t n = static_cast<size_t>(keys.size());
+            val_array vals(static_cast<py::ssize_t>(n));
+            py::array_t<bool> found(static_cast<py::ssize_t>(n));
+            const int64_t* k = keys.data();
+            V* v = vals.mutable_data();
+            bool* f = found.mutable_data();
+            {
+                py::gil_scoped_release release;
+                get_many_into(t, k, n, v, f);
+            }
+            return py::make_tuple(vals, found);
+        }, py::arg("keys"))
+
+        // contains_many(keys) → bool array
+        .def("contains_many", [](const trie_t& t, key_array keys) {
+            size_t n = static_cast<size_t>(keys.size());
+            py::array_t<bool> found(static_cast<py::ssize_t>(n));
+            const int64_t* k = keys.data();
+            bool* f = found.mutable_data();
+            {
+                py::gil_scoped_release release;
+                contains_many_into(t, k, n, f);
+            }
+            return found;
+        }, py::arg("keys"))
+
+        // set_many(keys, values) — same result as assigning in order
+        .def("set_many", [](trie_t& t, key_array keys, val_array vals) {
+            if (keys.size() != vals.size())
+                throw py::value_error("set_many: keys and values differ in length");
+            size_t n = static_cast<size_t>(keys.size());
+            const int64_t* k = keys.data();
+            const V* v = vals.data();
+            py::gil_scoped_release release;
+            set_many_from(t, k, v, n);
+        }, py::arg("keys"), py::arg("values"))
+
+        // range_array(lo, hi, keys=None, values=None) → (keys, values)
+        // for lo <= key < hi in order.  Given output arrays are filled and
+        // returned sliced to the count; otherwise new arrays are returned.
+        .def("range_array", [](trie_t& t, int64_t lo, int64_t hi,
+                               py::object keys, py::object values) {
+            size_t n;
+            {
+                py::gil_scoped_release release;
+                n = range_into<V>(t, lo, hi, nullptr, nullptr, 0);
+            }
+            auto sz = static_cast<py::ssize_t>(n);
+            key_out ko = keys.is_none()   ? key_out(sz) : out_array<key_out>(keys, n, "keys");
+            val_out vo = values.is_none() ? val_out(sz) : out_array<val_out>(values, n, "values");
+            int64_t* kp = ko.mutable_data();
+            V* vp = vo.mutable_data();
+            {
+                py::gil_scoped_release release;
+                n = std::min(n, range_into(t, lo, hi, kp, vp, n));
+            }
+            py::slice first(0, static_cast<py::ssize_t>(n), 1);
+            return py::make_tuple(ko[first], vo[first]);
+        }, py::arg("lo"), py::arg("hi"),
+           py::arg("keys") = py::none(), py::arg("values") = py::none());
+}
+
 // ============================================================================
 // bind_kntrie<V> — register one kntrie<int64_t, V> class
 // ============================================================================
@@ -23,7 +212,8 @@ template<typename V, typename PyV>
 void bind_kntrie(py::module_& m, const char* name) {
     using trie_t = kntrie<int64_t, V>;
 
-    py::class_<trie_t>(m, name)
+    auto cls = py::class_<trie_t>(m, name);
+    cls
 
         .def(py::init<>())
 
@@ -119,6 +309,9 @@ void bind_kntrie(py::module_& m, const char* name) {
             return std::string("kntrie.") + name +
                    "(size=" + std::to_string(t.size()) + ")";
         });
+
+    if constexpr (!std::is_same_v<V, py::object>)
+        bind_kntrie_arrays<V>(cls);
 }
 
 // ============================================================================
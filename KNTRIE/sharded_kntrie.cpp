@@ -0,0 +1 @@
+#include "sharded_kntrie.hpp"
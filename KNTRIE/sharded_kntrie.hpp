@@ -0,0 +1,217 @@
+#ifndef SHARDED_KNTRIE_HPP
+#define SHARDED_KNTRIE_HPP
+
+#include "kntrie.hpp"
+#include <mutex>
+#include <optional>
+
+namespace gteitelbaum {
+
+// ==========================================================================
+// sharded_kntrie<KEY, VALUE, SHARDS, ALLOC>
+//
+// Key space split on the top log2(SHARDS) bits of the stored (sign-
+// flipped) key — the leading bits of the root's consumed prefix.  Each
+// shard is an independent kntrie behind its own mutex, so writers to
+// different shards never contend.
+//
+// Because the split is on the most significant bits, shard i holds a
+// contiguous key range below shard i+1: concatenating shards in index
+// order is the global order.  Point ops (insert/erase/find/contains) are
+// thread-safe.  for_each() locks one shard at a time.  Iterators and
+// lower_bound() are live kntrie iterators and need writers quiescent.
+// ==========================================================================
+
+template<typename KEY, typename VALUE, std::size_t SHARDS = 16,
+         typename ALLOC = std::allocator<std::uint64_t>>
+class sharded_kntrie {
+    static_assert(std::has_single_bit(SHARDS) && SHARDS <= kntrie_detail::BYTE_VALUES,
+                  "SHARDS must be a power of two no larger than 256");
+
+    using KO = kntrie_detail::key_ops<KEY>;
+    using UK = typename KO::UK;
+
+public:
+    using trie_type   = kntrie<KEY, VALUE, ALLOC>;
+    using key_type    = KEY;
+    using mapped_type = VALUE;
+    using size_type   = std::size_t;
+
+private:
+    static constexpr unsigned SHARD_BITS  = std::countr_zero(SHARDS);
+    static constexpr unsigned SHARD_SHIFT = sizeof(UK) * CHAR_BIT - SHARD_BITS;
+
+    struct alignas(kntrie_detail::CACHE_LINE_BYTES) shard_t {
+        mutable std::mutex mu_v;
+        trie_type          trie_v;
+    };
+
+    shard_t shards_v[SHARDS];
+
+    static std::size_t shard_of(const KEY& key) noexcept {
+        if constexpr (SHARD_BITS == 0) return 0;
+        else return static_cast<std::size_t>(KO::to_stored(key) >> SHARD_SHIFT);
+    }
+
+public:
+    // ==================================================================
+    // Iterator — forward, concatenates shards in index order.  Read-only,
+    // like kntrie's, so iterator and const_iterator are one type.
+    // ==================================================================
+
+    class iterator {
+        friend class sharded_kntrie;
+        const sharded_kntrie*       owner_v = nullptr;
+        std::size_t                 shard_v = SHARDS;
+        typename trie_type::iterator it_v{};
+
+        iterator(const sharded_kntrie* o, std::size_t s, typename trie_type::iterator it)
+            : owner_v(o), shard_v(s), it_v(it) { skip_empty(); }
+
+        void skip_empty() {
+            while (shard_v < SHARDS && it_v == owner_v->shards_v[shard_v].trie_v.end()) {
+                if (++shard_v < SHARDS) it_v = owner_v->shards_v[shard_v].trie_v.begin();
+            }
+        }
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = typename trie_type::value_type;
+        using difference_type   = std::ptrdiff_t;
+        using reference         = typename trie_type::iterator::reference;
+
+        iterator() = default;
+
+        reference operator*() const noexcept { return *it_v; }
+
+        iterator& operator++() {
+            ++it_v;
+            skip_empty();
+            return *this;
+        }
+        iterator operator++(int) { auto t = *this; ++*this; return t; }
+
+        bool operator==(const iterator& o) const noexcept {
+            return shard_v == o.shard_v && (shard_v == SHARDS || it_v == o.it_v);
+        }
+        bool operator!=(const iterator& o) const noexcept { return !(*this == o); }
+    };
+    using const_iterator = iterator;
+
+    sharded_kntrie() = default;
+    sharded_kntrie(const sharded_kntrie&) = delete;
+    sharded_kntrie& operator=(const sharded_kntrie&) = delete;
+
+    // ==================================================================
+    // Point operations — lock only the owning shard
+    // ==================================================================
+
+    bool insert(const KEY& key, const VALUE& value) {
+        auto& s = shards_v[shard_of(key)];
+        std::lock_guard<std::mutex> lk(s.mu_v);
+        return s.trie_v.insert(key, value).second;
+    }
+
+    bool insert_or_assign(const KEY& key, const VALUE& value) {
+        auto& s = shards_v[shard_of(key)];
+        std::lock_guard<std::mutex> lk(s.mu_v);
+        return s.trie_v.insert_or_assign(key, value).second;
+    }
+
+    size_type erase(const KEY& key) {
+        auto& s = shards_v[shard_of(key)];
+        std::lock_guard<std::mutex> lk(s.mu_v);
+        return s.trie_v.erase(key);
+    }
+
+    bool contains(const KEY& key) const {
+        const auto& s = shards_v[shard_of(key)];
+        std::lock_guard<std::mutex> lk(s.mu_v);
+        return s.trie_v.contains(key);
+    }
+
+    std::optional<VALUE> find(const KEY& key) const {
+        const auto& s = shards_v[shard_of(key)];
+        std::lock_guard<std::mutex> lk(s.mu_v);
+        auto it = s.trie_v.find(key);
+        if (it == s.trie_v.end()) return std::nullopt;
+        return VALUE((*it).second);
+    }
+
+    size_type size() const {
+        size_type n = 0;
+        for (const auto& s : shards_v) {
+            std::lock_guard<std::mutex> lk(s.mu_v);
+            n += s.trie_v.size();
+        }
+        return n;
+    }
+
+    bool empty() const { return size() == 0; }
+
+    void clear() {
+        for (auto& s : shards_v) {
+            std::lock_guard<std::mutex> lk(s.mu_v);
+            s.trie_v.clear();
+        }
+    }
+
+    // Ordered visit fn(key, value), holding each shard's lock in turn.
+    template<typename Fn>
+    void for_each(Fn&& fn) const {
+        for (const auto& s : shards_v) {
+            std::lock_guard<std::mutex> lk(s.mu_v);
+            for (auto it = s.trie_v.begin(); it != s.trie_v.end(); ++it) {
+                auto [k, v] = *it;
+                fn(k, v);
+            }
+        }
+    }
+
+    // Ordered visit fn(key, value) of at most limit entries with key >= lo,
+    // holding each shard's lock in turn.  Returns the number visited.
+    template<typename Fn>
+    size_type for_each_from(const KEY& lo, size_type limit, Fn&& fn) const {
+        size_type n = 0;
+        std::size_t first = shard_of(lo);
+        for (std::size_t si = first; si < SHARDS && n < limit; ++si) {
+            const auto& s = shards_v[si];
+            std::lock_guard<std::mutex> lk(s.mu_v);
+            auto it = si == first ? s.trie_v.lower_bound(lo) : s.trie_v.begin();
+            for (; it != s.trie_v.end() && n < limit; ++it, ++n) {
+                auto [k, v] = *it;
+                fn(k, v);
+            }
+        }
+        return n;
+    }
+
+    // Direct shard access (e.g. one ingest thread per shard).
+    static constexpr std::size_t shard_count() noexcept { return SHARDS; }
+    static std::size_t shard_index(const KEY& key) noexcept { return shard_of(key); }
+    trie_type&       shard(std::size_t i) noexcept       { return shards_v[i].trie_v; }
+    const trie_type& shard(std::size_t i) const noexcept { return shards_v[i].trie_v; }
+
+    // ==================================================================
+    // Ordered iteration — writers must be quiescent
+    // ==================================================================
+
+    iterator begin() const { return iterator(this, 0, shards_v[0].trie_v.begin()); }
+    iterator end()   const { return iterator(); }
+    iterator cbegin() const { return begin(); }
+    iterator cend()   const { return end(); }
+
+    iterator lower_bound(const KEY& key) const {
+        std::size_t si = shard_of(key);
+        return iterator(this, si, shards_v[si].trie_v.lower_bound(key));
+    }
+
+    iterator upper_bound(const KEY& key) const {
+        std::size_t si = shard_of(key);
+        return iterator(this, si, shards_v[si].trie_v.upper_bound(key));
+    }
+};
+
+} // namespace gteitelbaum
+
+#endif // SHARDED_KNTRIE_HPP
@@ -206,3 +206,56 @@ class TestObject:
         if 1 in m and len(m[1]) == 3:
             del m[1]
         assert 1 not in m
+
+
+# ============================================================================
+# NumPy bulk operations
+# ============================================================================
+
+class TestArrays:
+    @pytest.fixture
+    def np(self):
+        return pytest.importorskip("numpy")
+
+    def test_set_get_many(self, np):
+        m = kntrie.Int64()
+        keys = np.array([5, -3, 9, 5, 1 << 40], dtype=np.int64)
+        m.set_many(keys, np.array([1, 2, 3, 4, 5], dtype=np.int64))
+        assert len(m) == 4
+        assert m[5] == 4                     # later duplicate wins
+        vals, found = m.get_many(np.array([-3, 7, 1 << 40]))
+        assert vals.dtype == np.int64 and found.dtype == np.bool_
+        assert found.tolist() == [True, False, True]
+        assert vals.tolist() == [2, 0, 5]
+        assert m.contains_many([9, 10]).tolist() == [True, False]
+
+    def test_set_many_merges(self, np):
+        m = kntrie.Int32()
+        for i in range(100):
+            m[i] = i
+        keys = np.arange(50, 250, dtype=np.int64)
+        m.set_many(keys, -keys)
+        assert len(m) == 250
+        assert m[10] == 10 and m[60] == -60 and m[249] == -249
+
+    def test_range_array(self, np):
+        m = kntrie.Float()
+        m.set_many(np.arange(0, 100, 3), np.arange(0, 100, 3) * 0.5)
+        keys, vals = m.range_array(10, 20)
+        assert keys.tolist() == [12, 15, 18]
+        assert vals.tolist() == [6.0, 7.5, 9.0]
+        kout = np.empty(8, dtype=np.int64)
+        vout = np.empty(8, dtype=np.float64)
+        keys, vals = m.range_array(10, 20, kout, vout)
+        assert keys.tolist() == [12, 15, 18] and kout[0] == 12
+        with pytest.raises(ValueError):
+            m.range_array(0, 100, kout, vout)
+        with pytest.raises(TypeError):
+            m.range_array(10, 20, np.empty(8, dtype=np.int32), vout)
+
+    def test_bool(self, np):
+        m = kntrie.Bool()
+        m.set_many([1, 2, 3], [True, False, True])
+        vals, found = m.get_many([1, 2, 4])
+        assert vals.tolist() == [True, False, False]
+        assert found.tolist() == [True, True, False]
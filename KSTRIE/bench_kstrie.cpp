@@ -167,6 +167,46 @@ static std::vector<std::string> gen_shared(size_t n, std::mt19937_64& rng) {
     return keys;
 }
 
+// Dense-alphabet keys: genome k-mers, hash digests, ids, tokens.  These
+// are also timed through the matching shipped char map ("kstrie/map"),
+// and the k-mers packed 4 bases per byte ("kstrie/pack").
+static const char DNA_ALPHA[]    = "ACGT";
+static const char HEX_ALPHA[]    = "0123456789abcdef";
+static const char ALNUM_ALPHA[]  = "abcdefghijklmnopqrstuvwxyz0123456789";
+static const char BASE64_ALPHA[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static std::string gen_alpha_key(const char* alpha, int minlen, int maxlen,
+                                 std::mt19937_64& rng) {
+    size_t na = std::strlen(alpha);
+    int len = minlen + static_cast<int>(rng() % (maxlen - minlen + 1));
+    std::string k(len, '\0');
+    for (auto& c : k) c = alpha[rng() % na];
+    return k;
+}
+
+struct AlphaSpec { const char* alpha; int minlen, maxlen; };
+
+static AlphaSpec alpha_spec(const std::string& pattern) {
+    if (pattern == "dna")    return {DNA_ALPHA, 21, 21};    // fixed-k k-mers
+    if (pattern == "hex")    return {HEX_ALPHA, 40, 40};    // SHA-1 digests
+    if (pattern == "alnum")  return {ALNUM_ALPHA, 6, 16};
+    if (pattern == "base64") return {BASE64_ALPHA, 22, 22}; // 128-bit tokens
+    return {nullptr, 0, 0};
+}
+
+static std::vector<std::string> gen_alpha(size_t n, const AlphaSpec& a,
+                                          std::mt19937_64& rng) {
+    std::set<std::string> seen;
+    std::vector<std::string> keys;
+    keys.reserve(n);
+    while (keys.size() < n) {
+        std::string k = gen_alpha_key(a.alpha, a.minlen, a.maxlen, rng);
+        if (seen.insert(k).second) keys.push_back(k);
+    }
+    return keys;
+}
+
 // ==========================================================================
 // Workload
 // ==========================================================================
@@ -194,7 +234,9 @@ static Workload make_workload(size_t n, const std::string& pattern,
     w.pattern = pattern;
     w.find_iters = iters_for(n);
 
-    if      (pattern == "random") w.keys = gen_random(n, rng);
+    AlphaSpec alpha = alpha_spec(pattern);
+    if      (alpha.alpha)         w.keys = gen_alpha(n, alpha, rng);
+    else if (pattern == "random") w.keys = gen_random(n, rng);
     else if (pattern == "url")    w.keys = gen_url(n, rng);
     else if (pattern == "path")   w.keys = gen_path(n, rng);
     else                          w.keys = gen_shared(n, rng);
@@ -214,8 +256,11 @@ static Workload make_workload(size_t n, const std::string& pattern,
     // Append a suffix that makes them unique
     w.find_nf.reserve(w.keys.size());
     std::set<std::string> existing(w.keys.begin(), w.keys.end());
+    // (Alphabet patterns draw misses from the same alphabet and lengths,
+    // so they stay inside the map and packable.)
     for (auto& k : w.keys) {
-        std::string nk = k + "~NOTFOUND~";
+        std::string nk = alpha.alpha ? gen_alpha_key(alpha.alpha, alpha.minlen, alpha.maxlen, rng)
+                                     : k + "~NOTFOUND~";
         if (!existing.count(nk)) {
             w.find_nf.push_back(nk);
             existing.insert(nk);
@@ -229,6 +274,36 @@ static Workload make_workload(size_t n, const std::string& pattern,
     return w;
 }
 
+// The same workload with every key packed by dna_codec.
+static Workload pack_dna(const Workload& w) {
+    using DC = gteitelbaum::kstrie_traits::dna_codec;
+    Workload p;
+    p.pattern = w.pattern;
+    p.find_iters = w.find_iters;
+    auto pack = [](const std::vector<std::string>& in, std::vector<std::string>& out) {
+        out.reserve(in.size());
+        for (auto& k : in) out.push_back(DC::encode(k));
+    };
+    pack(w.keys, p.keys);
+    pack(w.erase_keys, p.erase_keys);
+    pack(w.find_fnd, p.find_fnd);
+    pack(w.find_nf, p.find_nf);
+    return p;
+}
+
+// Calls f(CHARMAP{}) with the shipped char map for an alphabet pattern;
+// false for the general patterns.
+template<typename F>
+static bool with_char_map(const std::string& pattern, F&& f) {
+    namespace kt = gteitelbaum::kstrie_traits;
+    if      (pattern == "dna")    f(kt::dna_char_map{});
+    else if (pattern == "hex")    f(kt::hex_char_map{});
+    else if (pattern == "alnum")  f(kt::lower_alnum_char_map{});
+    else if (pattern == "base64") f(kt::base64_char_map{});
+    else return false;
+    return true;
+}
+
 // ==========================================================================
 // Row
 // ==========================================================================
@@ -247,6 +322,65 @@ struct Row {
 
 constexpr int TRIALS = 3;
 
+// ==========================================================================
+// kstrie timing, shared by the identity, char-map and packed variants
+// ==========================================================================
+
+struct Timings {
+    double fnd = 1e18, nf = 1e18, ins = 1e18, ers = 1e18, iter = 1e18;
+};
+
+template<typename CHARMAP>
+static size_t kstrie_mem(const std::vector<std::string>& keys) {
+    using TrieT = gteitelbaum::kstrie<int32_t, CHARMAP, TrackingAlloc<uint64_t>>;
+    g_alloc_total = 0;
+    TrieT t;
+    for (size_t i = 0; i < keys.size(); ++i) t.insert(keys[i], (int32_t)i);
+    return g_alloc_total;
+}
+
+template<typename TrieT>
+static void time_kstrie(const Workload& w,
+                        const std::vector<size_t>& insert_order,
+                        const std::vector<size_t>& erase_order,
+                        const std::vector<std::vector<size_t>>& fnd_idx,
+                        const std::vector<std::vector<size_t>>& nf_idx,
+                        Timings& k) {
+    TrieT trie;
+    double t0 = now_ms();
+    for (auto i : insert_order) trie.insert(w.keys[i], (int32_t)i);
+    k.ins = std::min(k.ins, now_ms() - t0);
+
+    { uint64_t s = 0; double ti = now_ms();
+      for (auto it = trie.begin(); it != trie.end(); ++it) s += (*it).second;
+      k.iter = std::min(k.iter, now_ms() - ti); do_not_optimize(s); }
+
+    uint64_t cs = 0;
+    double t1 = now_ms();
+    for (int r = 0; r < w.find_iters; ++r)
+        for (auto i : fnd_idx[r]) { auto it = trie.find(w.find_fnd[i]); cs += (it!=trie.end()) ? (*it).second : 0; }
+    k.fnd = std::min(k.fnd, (now_ms() - t1) / w.find_iters);
+    do_not_optimize(cs);
+
+    cs = 0;
+    double t1n = now_ms();
+    for (int r = 0; r < w.find_iters; ++r)
+        for (auto i : nf_idx[r]) { auto it = trie.find(w.find_nf[i]); cs += (it!=trie.end()) ? (*it).second : 0; }
+    k.nf = std::min(k.nf, (now_ms() - t1n) / w.find_iters);
+    do_not_optimize(cs);
+
+    {
+        // Repeated erase+reinsert loop for stable timing at small N.
+        // After each erase pass we reinsert so the next iteration is valid.
+        double t2 = now_ms();
+        for (int r = 0; r < w.find_iters; ++r) {
+            for (auto i : erase_order) trie.erase(w.erase_keys[i]);
+            for (auto i : erase_order) trie.insert(w.erase_keys[i], (int32_t)i);
+        }
+        k.ers = std::min(k.ers, (now_ms() - t2) / (w.find_iters * 2));
+    }
+}
+
 // ==========================================================================
 // bench_one
 // ==========================================================================
@@ -275,16 +409,8 @@ static void bench_one(const Workload& w, std::vector<Row>& rows, bool verbose) {
     }
 
     // ---- Memory measurement ----
-    size_t kstrie_mem, map_mem, umap_mem;
-    {
-        using TrieT = gteitelbaum::kstrie<int32_t,
-                        gteitelbaum::kstrie_traits::identity_char_map,
-                        TrackingAlloc<uint64_t>>;
-        g_alloc_total = 0;
-        TrieT t;
-        for (size_t i = 0; i < n; ++i) t.insert(w.keys[i], (int32_t)i);
-        kstrie_mem = g_alloc_total;
-    }
+    size_t kstrie_mem_bytes, map_mem, umap_mem;
+    kstrie_mem_bytes = kstrie_mem<gteitelbaum::kstrie_traits::identity_char_map>(w.keys);
     {
         using MapT = std::map<std::string, int32_t, std::less<std::string>,
                               TrackingAlloc<std::pair<const std::string, int32_t>>>;
@@ -304,7 +430,7 @@ static void bench_one(const Workload& w, std::vector<Row>& rows, bool verbose) {
         umap_mem = g_alloc_total;
     }
 
-    double k_fnd=1e18, k_nf=1e18, k_ins=1e18, k_ers=1e18, k_iter=1e18;
+    Timings k;
     double m_fnd=1e18, m_nf=1e18, m_ins=1e18, m_ers=1e18, m_iter=1e18;
     double u_fnd=1e18, u_nf=1e18, u_ins=1e18, u_ers=1e18, u_iter=1e18;
 
@@ -318,41 +444,8 @@ static void bench_one(const Workload& w, std::vector<Row>& rows, bool verbose) {
         std::shuffle(erase_order.begin(), erase_order.end(), rng);
 
         // ---- kstrie ----
-        {
-            gteitelbaum::kstrie<int32_t> trie;
-            double t0 = now_ms();
-            for (auto i : insert_order) trie.insert(w.keys[i], (int32_t)i);
-            k_ins = std::min(k_ins, now_ms() - t0);
-
-            { uint64_t s = 0; double ti = now_ms();
-              for (auto it = trie.begin(); it != trie.end(); ++it) s += (*it).second;
-              k_iter = std::min(k_iter, now_ms() - ti); do_not_optimize(s); }
-
-            uint64_t cs = 0;
-            double t1 = now_ms();
-            for (int r = 0; r < w.find_iters; ++r)
-                for (auto i : fnd_idx[r]) { auto it = trie.find(w.find_fnd[i]); cs += (it!=trie.end()) ? (*it).second : 0; }
-            k_fnd = std::min(k_fnd, (now_ms() - t1) / w.find_iters);
-            do_not_optimize(cs);
-
-            cs = 0;
-            double t1n = now_ms();
-            for (int r = 0; r < w.find_iters; ++r)
-                for (auto i : nf_idx[r]) { auto it = trie.find(w.find_nf[i]); cs += (it!=trie.end()) ? (*it).second : 0; }
-            k_nf = std::min(k_nf, (now_ms() - t1n) / w.find_iters);
-            do_not_optimize(cs);
-
-            {
-                // Repeated erase+reinsert loop for stable timing at small N.
-                // After each erase pass we reinsert so the next iteration is valid.
-                double t2 = now_ms();
-                for (int r = 0; r < w.find_iters; ++r) {
-                    for (auto i : erase_order) trie.erase(w.erase_keys[i]);
-                    for (auto i : erase_order) trie.insert(w.erase_keys[i], (int32_t)i);
-                }
-                k_ers = std::min(k_ers, (now_ms() - t2) / (w.find_iters * 2));
-            }
-        }
+        time_kstrie<gteitelbaum::kstrie<int32_t>>(w, insert_order, erase_order,
+                                                  fnd_idx, nf_idx, k);
 
         // ---- map ----
         {
@@ -426,7 +519,29 @@ static void bench_one(const Workload& w, std::vector<Row>& rows, bool verbose) {
         }
     }
 
-    rows.push_back({w.pattern, n, "kstrie", k_fnd, k_nf, k_ins, k_ers, k_iter, kstrie_mem});
+    // ---- kstrie with the pattern's char map / packed k-mers ----
+    std::vector<size_t> erase_order(w.erase_keys.size());
+    std::iota(erase_order.begin(), erase_order.end(), 0);
+    with_char_map(w.pattern, [&](auto cm) {
+        using CM = decltype(cm);
+        size_t mem = kstrie_mem<CM>(w.keys);
+        Timings km;
+        for (int t = 0; t < TRIALS; ++t)
+            time_kstrie<gteitelbaum::kstrie<int32_t, CM>>(w, insert_order, erase_order,
+                                                          fnd_idx, nf_idx, km);
+        rows.push_back({w.pattern, n, "kmap", km.fnd, km.nf, km.ins, km.ers, km.iter, mem});
+    });
+    if (w.pattern == "dna") {
+        Workload pw = pack_dna(w);
+        size_t mem = kstrie_mem<gteitelbaum::kstrie_traits::identity_char_map>(pw.keys);
+        Timings kp;
+        for (int t = 0; t < TRIALS; ++t)
+            time_kstrie<gteitelbaum::kstrie<int32_t>>(pw, insert_order, erase_order,
+                                                      fnd_idx, nf_idx, kp);
+        rows.push_back({w.pattern, n, "kpack", kp.fnd, kp.nf, kp.ins, kp.ers, kp.iter, mem});
+    }
+
+    rows.push_back({w.pattern, n, "kstrie", k.fnd, k.nf, k.ins, k.ers, k.iter, kstrie_mem_bytes});
     rows.push_back({w.pattern, n, "map",    m_fnd, m_nf, m_ins, m_ers, m_iter, map_mem});
     rows.push_back({w.pattern, n, "umap",   u_fnd, u_nf, u_ins, u_ers, u_iter, umap_mem});
 }
@@ -439,14 +554,16 @@ static void emit_html(const std::vector<Row>& rows) {
     struct DataPoint {
         std::string pattern;
         size_t      N;
-        double      vals[3][6];
-        bool        has[3];
+        double      vals[5][6];
+        bool        has[5];
     };
 
     auto cidx = [](const char* c) -> int {
         if (std::strcmp(c, "kstrie") == 0) return 0;
         if (std::strcmp(c, "map")    == 0) return 1;
-        return 2;
+        if (std::strcmp(c, "umap")   == 0) return 2;
+        if (std::strcmp(c, "kmap")   == 0) return 3;
+        return 4;
     };
 
     std::vector<DataPoint> points;
@@ -477,7 +594,7 @@ static void emit_html(const std::vector<Row>& rows) {
         return a.N < b.N;
     });
 
-    const char* names[]    = {"kstrie", "map", "umap"};
+    const char* names[]    = {"kstrie", "map", "umap", "kmap", "kpack"};
     const char* suffixes[] = {"fnd", "nf", "insert", "erase", "iter", "mem"};
 
     std::printf(R"HTML(<!DOCTYPE html>
@@ -505,11 +622,16 @@ static void emit_html(const std::vector<Row>& rows) {
 <div class="wrap">
   <h2>kstrie Benchmark (string &rarr; int32)</h2>
   <p class="sub">Log-log &middot; Per-entry &middot; Lower is better &middot; FND=100%% hit, NF=100%% miss</p>
+  <p class="sub">kstrie/map = shipped char map for the alphabet &middot; kstrie/pack = dna_codec, 4 bases/byte</p>
   <div class="btns">
     <button class="active" onclick="show('random',event)">random</button>
     <button onclick="show('url',event)">url-like</button>
     <button onclick="show('path',event)">path-like</button>
     <button onclick="show('shared',event)">shared prefix</button>
+    <button onclick="show('dna',event)">DNA 21-mer</button>
+    <button onclick="show('hex',event)">hex digest</button>
+    <button onclick="show('alnum',event)">lower+digits</button>
+    <button onclick="show('base64',event)">base64</button>
   </div>
   <div class="chart-box"><h3>Find (ns/entry)</h3><canvas id="c_find"></canvas></div>
   <div class="chart-box"><h3>Insert (ns/entry)</h3><canvas id="c_insert"></canvas></div>
@@ -523,7 +645,7 @@ static void emit_html(const std::vector<Row>& rows) {
     std::printf("const RAW_DATA = [\n");
     for (auto& p : points) {
         std::printf("  {pattern:\"%s\",N:%zu", p.pattern.c_str(), p.N);
-        for (int ci = 0; ci < 3; ++ci) {
+        for (int ci = 0; ci < 5; ++ci) {
             if (!p.has[ci]) continue;
             for (int mi = 0; mi < 6; ++mi) {
                 if (mi == 5)
@@ -544,26 +666,38 @@ const LINES_FIND = [
   { key: "map",    suffix: "nf",  color: "#fca5a5", dash: [6,3], width: 1.5, label: "map NF"     },
   { key: "umap",   suffix: "fnd", color: "#22c55e", dash: [],    width: 2.5, label: "umap FND"   },
   { key: "umap",   suffix: "nf",  color: "#86efac", dash: [6,3], width: 1.5, label: "umap NF"    },
+  { key: "kmap",   suffix: "fnd", color: "#a855f7", dash: [],    width: 2.5, label: "kstrie/map FND"  },
+  { key: "kmap",   suffix: "nf",  color: "#d8b4fe", dash: [6,3], width: 1.5, label: "kstrie/map NF"   },
+  { key: "kpack",  suffix: "fnd", color: "#f59e0b", dash: [],    width: 2.5, label: "kstrie/pack FND" },
+  { key: "kpack",  suffix: "nf",  color: "#fcd34d", dash: [6,3], width: 1.5, label: "kstrie/pack NF"  },
 ];
 const LINES_INSERT = [
   { key: "kstrie", suffix: "insert", color: "#3b82f6", dash: [], width: 2.5, label: "kstrie" },
   { key: "map",    suffix: "insert", color: "#ef4444", dash: [], width: 2.5, label: "map"    },
   { key: "umap",   suffix: "insert", color: "#22c55e", dash: [], width: 2.5, label: "umap"   },
+  { key: "kmap",   suffix: "insert", color: "#a855f7", dash: [], width: 2.5, label: "kstrie/map"  },
+  { key: "kpack",  suffix: "insert", color: "#f59e0b", dash: [], width: 2.5, label: "kstrie/pack" },
 ];
 const LINES_ITER = [
   { key: "kstrie", suffix: "iter", color: "#3b82f6", dash: [], width: 2.5, label: "kstrie" },
   { key: "map",    suffix: "iter", color: "#ef4444", dash: [], width: 2.5, label: "map"    },
   { key: "umap",   suffix: "iter", color: "#22c55e", dash: [], width: 2.5, label: "umap"   },
+  { key: "kmap",   suffix: "iter", color: "#a855f7", dash: [], width: 2.5, label: "kstrie/map"  },
+  { key: "kpack",  suffix: "iter", color: "#f59e0b", dash: [], width: 2.5, label: "kstrie/pack" },
 ];
 const LINES_ERASE = [
   { key: "kstrie", suffix: "erase", color: "#3b82f6", dash: [], width: 2.5, label: "kstrie" },
   { key: "map",    suffix: "erase", color: "#ef4444", dash: [], width: 2.5, label: "map"    },
   { key: "umap",   suffix: "erase", color: "#22c55e", dash: [], width: 2.5, label: "umap"   },
+  { key: "kmap",   suffix: "erase", color: "#a855f7", dash: [], width: 2.5, label: "kstrie/map"  },
+  { key: "kpack",  suffix: "erase", color: "#f59e0b", dash: [], width: 2.5, label: "kstrie/pack" },
 ];
 const LINES_MEM = [
   { key: "kstrie", suffix: "mem", color: "#3b82f6", dash: [],    width: 2.5, label: "kstrie" },
   { key: "map",    suffix: "mem", color: "#ef4444", dash: [],    width: 2.5, label: "map"    },
   { key: "umap",   suffix: "mem", color: "#22c55e", dash: [],    width: 2.5, label: "umap"   },
+  { key: "kmap",   suffix: "mem", color: "#a855f7", dash: [],    width: 2.5, label: "kstrie/map"  },
+  { key: "kpack",  suffix: "mem", color: "#f59e0b", dash: [],    width: 2.5, label: "kstrie/pack" },
 ];
 
 const METRICS = [
@@ -698,7 +832,8 @@ int main(int argc, char* argv[]) {
     if (sizes.empty() || sizes.back() < max_n)
         sizes.push_back(max_n);
 
-    const char* patterns[] = {"random", "url", "path", "shared"};
+    const char* patterns[] = {"random", "url", "path", "shared",
+                              "dna", "hex", "alnum", "base64"};
 
     std::vector<Row> rows;
     std::mt19937_64 rng(42);
@@ -1,9 +1,14 @@
 #ifndef KSTRIE_HPP
 #define KSTRIE_HPP
 
+#include "kstrie_coro.hpp"
 #include "kstrie_impl.hpp"
+#include "kstrie_image.hpp"
+#include <algorithm>
 #include <iterator>
 #include <optional>
+#include <ranges>
+#include <span>
 #include <stdexcept>
 #include <vector>
 
@@ -14,11 +19,26 @@ namespace kstrie_traits {
     using identity_char_map      = kstrie_detail::identity_char_map;
     using upper_char_map         = kstrie_detail::upper_char_map;
     using reverse_lower_char_map = kstrie_detail::reverse_lower_char_map;
+    using dna_char_map           = kstrie_detail::dna_char_map;
+    using hex_char_map           = kstrie_detail::hex_char_map;
+    using lower_alnum_char_map   = kstrie_detail::lower_alnum_char_map;
+    using base64_char_map        = kstrie_detail::base64_char_map;
+    using url_safe_char_map      = kstrie_detail::url_safe_char_map;
+    using dna_codec              = kstrie_detail::dna_codec;
 
     template <std::array<uint8_t, 256> M>
     using char_map = kstrie_detail::char_map<M>;
 } // namespace kstrie_traits
 
+// Process-wide hot-path counters, shared by every kstrie instantiation.
+// All zero unless built with KSTRIE_INSTRUMENT=1.
+using kstrie_instrument_t = kstrie_detail::instrument_t;
+inline kstrie_instrument_t kstrie_instrument() noexcept { return kstrie_detail::instrument_snapshot(); }
+inline void kstrie_instrument_reset() noexcept { kstrie_detail::instrument_reset(); }
+
+template <typename VALUE, typename CHARMAP, typename ALLOC>
+class kstrie_snapshot;
+
 // ============================================================================
 // kstrie -- user-facing trie class
 //
@@ -74,6 +94,7 @@ public:
     using const_mapped_ref = std::conditional_t<IS_BITMAP, bool, const VALUE&>;
 
     kstrie() = default;
+    explicit kstrie(const ALLOC& a) : impl_v(a) {}
     ~kstrie() = default;
 
     kstrie(kstrie&& o) noexcept : impl_v(std::move(o.impl_v)) { fix_end(); }
@@ -125,23 +146,23 @@ public:
         friend class kstrie;
         friend class iterator_impl<!Mutable>;  // for cross-template ==
 
-        uint64_t*  leaf_v   = nullptr;  // compact node (null = end)
+        mutable uint64_t* leaf_v = nullptr;  // compact node (null = end); see operator*
         uint16_t   pos_v    = 0;        // slot index
+        impl_t*    impl_p   = nullptr;  // owning trie: --end(), copy-on-write
         mutable char*   key_buf  = nullptr;  // owned buffer
         mutable size_t  key_len  = 0;
-        mutable size_t  key_cap  = 0;    // also stashes impl_t* for end sentinel via intptr_t
+        mutable size_t  key_cap  = 0;
 
         using value_ref = std::conditional_t<IS_BITMAP,
             std::conditional_t<Mutable, bool_ref, bool>,
             std::conditional_t<Mutable, VALUE&, const VALUE&>>;
 
-        // End sentinel — stash impl* in key_cap for --end()
-        explicit iterator_impl(impl_t* impl)
-            : key_cap(static_cast<size_t>(reinterpret_cast<std::intptr_t>(impl))) {}
+        // End sentinel
+        explicit iterator_impl(impl_t* impl) : impl_p(impl) {}
 
         // Positioned (lazy — no key built)
-        iterator_impl(impl_t* /*impl*/, uint64_t* leaf, uint16_t pos)
-            : leaf_v(leaf), pos_v(pos) {}
+        iterator_impl(impl_t* impl, uint64_t* leaf, uint16_t pos)
+            : leaf_v(leaf), pos_v(pos), impl_p(impl) {}
 
         // Free key buffer. len/cap are stale but never read —
         // ensure_key() overwrites all three when key_buf is set.
@@ -176,10 +197,10 @@ public:
                 fs.prepend(skip, skip_len);
             else if (klen == 1)
                 fs.prepend(skip, skip_len,
-                           CHARMAP::from_index(F[pos_v]));
+                           F[pos_v]);
             else
                 fs.prepend(skip, skip_len,
-                           CHARMAP::from_index(F[pos_v]),
+                           F[pos_v],
                            B + O[pos_v], klen - 1);
 
             // Step 2: walk up from leaf to root
@@ -196,12 +217,18 @@ public:
                     fs.prepend(nsk, nsk_len);
                 else
                     fs.prepend(nsk, nsk_len,
-                               CHARMAP::from_index(static_cast<uint8_t>(nb)));
+                               static_cast<uint8_t>(nb));
 
                 nb = bitmask_type::get_parent_byte(node);
                 node = bitmask_type::get_parent(node);
             }
 
+            // Skip and suffix bytes are stored mapped too: unmap once
+            if constexpr (!CHARMAP::IS_IDENTITY)
+                for (size_t i = 0; i < fs.len_v; ++i)
+                    fs.buf_pv[i] = static_cast<char>(
+                        CHARMAP::from_index(static_cast<uint8_t>(fs.buf_pv[i])));
+
             // Transfer buffer ownership from fast_string to iterator
             key_buf = fs.buf_pv;
             key_len = fs.len_v;
@@ -217,22 +244,22 @@ public:
         struct lazy_key {
             const iterator_impl* it_p;
 
-            operator std::string() const {
+            // Member (not friend) so it may reach iterator_impl's privates.
+            std::string_view view() const {
                 it_p->ensure_key();
-                return std::string(it_p->key_buf, it_p->key_len);
+                return std::string_view(it_p->key_buf, it_p->key_len);
             }
 
+            operator std::string() const { return std::string(view()); }
+
             friend bool operator==(const lazy_key& a, std::string_view b) {
-                a.it_p->ensure_key();
-                return std::string_view(a.it_p->key_buf, a.it_p->key_len) == b;
+                return a.view() == b;
             }
             friend bool operator<(const lazy_key& a, std::string_view b) {
-                a.it_p->ensure_key();
-                return std::string_view(a.it_p->key_buf, a.it_p->key_len) < b;
+                return a.view() < b;
             }
             friend bool operator<(std::string_view a, const lazy_key& b) {
-                b.it_p->ensure_key();
-                return a < std::string_view(b.it_p->key_buf, b.it_p->key_len);
+                return a < b.view();
             }
             friend bool operator>(const lazy_key& a, std::string_view b) { return b < a; }
             friend bool operator>(std::string_view a, const lazy_key& b) { return b < a; }
@@ -260,7 +287,7 @@ public:
 
         // Move — steals buffer pointer
         iterator_impl(iterator_impl&& o) noexcept
-            : leaf_v(o.leaf_v), pos_v(o.pos_v),
+            : leaf_v(o.leaf_v), pos_v(o.pos_v), impl_p(o.impl_p),
               key_buf(o.key_buf), key_len(o.key_len), key_cap(o.key_cap) {
             o.key_buf = nullptr;
             o.leaf_v = nullptr;
@@ -271,6 +298,7 @@ public:
                 delete[] key_buf;
                 leaf_v  = o.leaf_v;
                 pos_v   = o.pos_v;
+                impl_p  = o.impl_p;
                 key_buf = o.key_buf;
                 key_len = o.key_len;
                 key_cap = o.key_cap;
@@ -282,7 +310,7 @@ public:
 
         // Copy — deep-copies buffer only if key was built
         iterator_impl(const iterator_impl& o)
-            : leaf_v(o.leaf_v), pos_v(o.pos_v),
+            : leaf_v(o.leaf_v), pos_v(o.pos_v), impl_p(o.impl_p),
               key_len(o.key_len), key_cap(o.key_cap) {
             if (o.key_buf) {
                 key_buf = new char[o.key_cap];
@@ -295,6 +323,7 @@ public:
                 delete[] key_buf;
                 leaf_v  = o.leaf_v;
                 pos_v   = o.pos_v;
+                impl_p  = o.impl_p;
                 key_len = o.key_len;
                 key_cap = o.key_cap;
                 if (o.key_buf) {
@@ -310,7 +339,7 @@ public:
         // Implicit conversion: iterator → const_iterator
         template<bool M2> requires (!Mutable && M2)
         iterator_impl(const iterator_impl<M2>& o)
-            : leaf_v(o.leaf_v), pos_v(o.pos_v),
+            : leaf_v(o.leaf_v), pos_v(o.pos_v), impl_p(o.impl_p),
               key_len(o.key_len), key_cap(o.key_cap) {
             if (o.key_buf) {
                 key_buf = new char[o.key_cap];
@@ -318,7 +347,11 @@ public:
             }
         }
 
+        // A mutable reference must not reach a node a snapshot shares, so
+        // while one is live the leaf's path is made writable first (the
+        // leaf may move; its slot order does not change).
         reference operator*() const {
+            if constexpr (Mutable) leaf_v = impl_p->own_leaf(leaf_v);
             hdr_type h = hdr_type::from_node(leaf_v);
             if constexpr (Mutable) {
                 auto* vb = h.get_compact_slots(leaf_v);
@@ -375,8 +408,7 @@ public:
 
     private:
         void walk_to_edge(kstrie_detail::dir_t dir) {
-            auto* impl = reinterpret_cast<impl_t*>(static_cast<std::intptr_t>(key_cap));
-            uint64_t* root = impl->get_root_mut();
+            uint64_t* root = impl_p->get_root_mut();
             if (root == compact_type::sentinel()) return;
             edge_entry(root, dir);
         }
@@ -480,8 +512,7 @@ private:
     mutable iterator end_v{const_cast<impl_t*>(&impl_v)};
 
     void fix_end() noexcept {
-        end_v.key_cap = static_cast<size_t>(
-            reinterpret_cast<std::intptr_t>(const_cast<impl_t*>(&impl_v)));
+        end_v.impl_p = &impl_v;
     }
 
 public:
@@ -590,6 +621,68 @@ public:
 
     void clear() noexcept { impl_v.clear(); }
 
+    // ------------------------------------------------------------------
+    // Memory compaction.  Churn leaves nodes at the capacity they once
+    // grew to, scattered over the heap.  compact(budget) moves up to
+    // budget nodes into fresh allocations sized for their contents, in
+    // key order, and returns true once a whole pass has finished (the
+    // next call starts a new one).  Other modifications may run between
+    // calls.  shrink_to_fit() runs one complete pass.  Both invalidate
+    // iterators.
+    // ------------------------------------------------------------------
+
+    bool compact(size_t budget) { return impl_v.compact(budget); }
+
+    void shrink_to_fit() {
+        impl_v.compact_restart();
+        impl_v.compact(SIZE_MAX);
+    }
+
+    // ------------------------------------------------------------------
+    // Snapshots.  snapshot() is O(1): the snapshot shares every node with
+    // this trie.  Each later write first copies the shared nodes on its
+    // own key's path, so it costs that path, and the snapshot keeps the
+    // contents it was taken with.  Take snapshots on the writing thread;
+    // reads of a snapshot may run on other threads while this trie is
+    // written.  Destroying a snapshot frees the nodes only it still owns
+    // through a copy of this trie's allocator, so do that on the writing
+    // thread unless ALLOC is thread-safe (std::allocator is; a shared
+    // kntrie_pool_allocator is not).  Dereferencing a mutable iterator
+    // copies its leaf's path first, so values written through it never
+    // reach a snapshot.
+    // ------------------------------------------------------------------
+
+    kstrie_snapshot<VALUE, CHARMAP, ALLOC> snapshot() {
+        return kstrie_snapshot<VALUE, CHARMAP, ALLOC>(impl_v.snapshot());
+    }
+
+    // ------------------------------------------------------------------
+    // Bulk load from (key, value) pairs in ascending key order (after
+    // CHARMAP mapping, i.e. iteration order).  Skip prefixes come from
+    // adjacent-key common prefixes and every node is built once at final
+    // size instead of inserting key by key.  Repeated keys keep the first
+    // occurrence; unsorted input throws std::invalid_argument.
+    // ------------------------------------------------------------------
+
+    template <typename InputIt>
+    requires (!std::is_integral_v<InputIt>)
+    static kstrie from_sorted(InputIt first, InputIt last) {
+        kstrie t;
+        t.assign_sorted(first, last);
+        return t;
+    }
+
+    template <std::ranges::input_range R>
+    static kstrie from_sorted(R&& r) {
+        return from_sorted(std::ranges::begin(r), std::ranges::end(r));
+    }
+
+    template <typename InputIt>
+    requires (!std::is_integral_v<InputIt>)
+    void assign_sorted(InputIt first, InputIt last) {
+        impl_v.assign_sorted(first, last);
+    }
+
     // ------------------------------------------------------------------
     // Element access
     // ------------------------------------------------------------------
@@ -634,6 +727,70 @@ public:
         return const_iterator(const_cast<impl_t*>(&impl_v), r.leaf, r.pos);
     }
 
+    // ------------------------------------------------------------------
+    // Batched lookup — descents for independent keys run in lockstep with
+    // software prefetch, overlapping their cache misses.  out[i] receives
+    // the result for keys[i]; out must be at least keys.size() long.
+    // ------------------------------------------------------------------
+
+    void find_batch(std::span<const std::string_view> keys,
+                    std::span<const VALUE*> out) const
+    requires (!IS_BITMAP) {
+        if (out.size() < keys.size()) [[unlikely]]
+            throw std::invalid_argument("kstrie::find_batch: output too small");
+        impl_v.find_batch(keys.data(), keys.size(),
+            [&](size_t i, const typename impl_t::iter_find_result& r) {
+                out[i] = r.leaf
+                    ? slots_type::load_value(
+                          hdr_type::from_node(r.leaf).get_compact_slots(r.leaf), r.pos)
+                    : nullptr;
+            });
+    }
+
+    // Bit i of words[i / 64] is set iff keys[i] is present.
+    void contains_batch(std::span<const std::string_view> keys,
+                        std::span<uint64_t> words) const {
+        constexpr size_t WORD_BITS = 64;
+        size_t nw = (keys.size() + WORD_BITS - 1) / WORD_BITS;
+        if (words.size() < nw) [[unlikely]]
+            throw std::invalid_argument("kstrie::contains_batch: output too small");
+        std::fill(words.begin(), words.begin() + nw, uint64_t(0));
+        impl_v.find_batch(keys.data(), keys.size(),
+            [&](size_t i, const typename impl_t::iter_find_result& r) {
+                words[i / WORD_BITS] |= uint64_t(r.leaf != nullptr) << (i % WORD_BITS);
+            });
+    }
+
+    // ------------------------------------------------------------------
+    // Coroutine lookup -- see kstrie_coro.hpp.  Each bitmask dispatch
+    // prefetches the child and co_awaits hop(), letting a scheduler run
+    // other lookups while the miss resolves.  co_lower_bound warms the
+    // key's path the same way, then resolves with lower_bound on hot
+    // lines.  key must stay valid until the lookup completes.
+    // ------------------------------------------------------------------
+
+    template <typename HOP = kstrie_hop>
+    kstrie_lookup<const_iterator, HOP> co_find(std::string_view key, HOP hop = {}) const {
+        uint32_t len = static_cast<uint32_t>(key.size());
+        kstrie_detail::mapped_key<CHARMAP> mk(
+            reinterpret_cast<const uint8_t*>(key.data()), len);
+        auto d = impl_v.descend_start(mk.data, len);
+        while (impl_t::descend_step(d)) co_await hop();
+        auto r = impl_t::descend_finish(d);
+        if (!r.leaf) co_return end();
+        co_return const_iterator(const_cast<impl_t*>(&impl_v), r.leaf, r.pos);
+    }
+
+    template <typename HOP = kstrie_hop>
+    kstrie_lookup<const_iterator, HOP> co_lower_bound(std::string_view key, HOP hop = {}) const {
+        uint32_t len = static_cast<uint32_t>(key.size());
+        kstrie_detail::mapped_key<CHARMAP> mk(
+            reinterpret_cast<const uint8_t*>(key.data()), len);
+        auto d = impl_v.descend_start(mk.data, len);
+        while (impl_t::descend_step(d)) co_await hop();
+        co_return lower_bound(key);
+    }
+
     // ------------------------------------------------------------------
     // Ordered lookup
     // ------------------------------------------------------------------
@@ -789,6 +946,111 @@ public:
         impl_v.prefix_walk_impl(mk.data, len, pfx, std::forward<F>(fn));
     }
 
+    // Allocation-free ordered scans: fn(string_view key, const VALUE&)
+    // where key views one path buffer reused for the whole walk (valid
+    // only during the call).  for_each_range visits [lo, hi); the
+    // one-bound form visits [lo, end).
+    template<typename F>
+    void for_each(F&& fn) const {
+        impl_v.range_walk_impl(nullptr, 0, nullptr, 0, false, fn);
+    }
+
+    template<typename F>
+    void for_each_range(std::string_view lo, std::string_view hi, F&& fn) const {
+        kstrie_detail::mapped_key<CHARMAP> ml(
+            reinterpret_cast<const uint8_t*>(lo.data()), static_cast<uint32_t>(lo.size()));
+        kstrie_detail::mapped_key<CHARMAP> mh(
+            reinterpret_cast<const uint8_t*>(hi.data()), static_cast<uint32_t>(hi.size()));
+        impl_v.range_walk_impl(ml.data, static_cast<uint32_t>(lo.size()),
+                               mh.data, static_cast<uint32_t>(hi.size()), true, fn);
+    }
+
+    template<typename F>
+    void for_each_range(std::string_view lo, F&& fn) const {
+        kstrie_detail::mapped_key<CHARMAP> ml(
+            reinterpret_cast<const uint8_t*>(lo.data()), static_cast<uint32_t>(lo.size()));
+        impl_v.range_walk_impl(ml.data, static_cast<uint32_t>(lo.size()),
+                               nullptr, 0, false, fn);
+    }
+
+    // Typo-tolerant lookup: every key within max_edits Levenshtein edits
+    // (insert / delete / substitute one byte) of query, in key order, in
+    // one pruned traversal.  fn(string_view key, const VALUE&, uint32_t
+    // distance), or fn(key, value).  Distances are measured on CHARMAP
+    // indices, so case-folding maps match case-insensitively.
+    template<typename F>
+    void fuzzy_search(std::string_view query, uint32_t max_edits, F&& fn) const {
+        const uint8_t* raw = reinterpret_cast<const uint8_t*>(query.data());
+        uint32_t len = static_cast<uint32_t>(query.size());
+        kstrie_detail::mapped_key<CHARMAP> mk(raw, len);
+        auto emit = [&](std::string_view k, const VALUE& v, uint32_t dist) {
+            if constexpr (std::is_invocable_v<F&, std::string_view, const VALUE&, uint32_t>)
+                fn(k, v, dist);
+            else
+                fn(k, v);
+        };
+        impl_v.fuzzy_search_impl(mk.data, len, max_edits, emit);
+    }
+
+    // Longest stored key that is a prefix of text, found in one descent
+    // that consumes text byte by byte.  Returns {iterator, length}; the
+    // iterator is end() (length 0) when no key prefixes text.
+    std::pair<const_iterator, size_t> longest_prefix_match(std::string_view text) const {
+        const uint8_t* raw = reinterpret_cast<const uint8_t*>(text.data());
+        uint32_t len = static_cast<uint32_t>(text.size());
+        kstrie_detail::mapped_key<CHARMAP> mk(raw, len);
+        uint64_t* leaf = nullptr;
+        uint16_t  pos  = 0;
+        size_t    mlen = 0;
+        impl_v.prefix_matches_impl(mk.data, len,
+            [&](uint32_t l, uint64_t* lf, uint16_t p) { leaf = lf; pos = p; mlen = l; });
+        if (!leaf) return {end(), 0};
+        return {const_iterator(const_cast<impl_t*>(&impl_v), leaf, pos), mlen};
+    }
+
+    // Dictionary scan: every stored key occurring anywhere in text, in one
+    // pass of single descents (one per start position, shortest match
+    // first).  fn(size_t offset, string_view match, const VALUE&); match
+    // views text.  text is mapped once up front.
+    template<typename F>
+    void scan(std::string_view text, F&& fn) const {
+        const uint8_t* raw = reinterpret_cast<const uint8_t*>(text.data());
+        uint32_t len = static_cast<uint32_t>(text.size());
+        kstrie_detail::mapped_key<CHARMAP> mk(raw, len);
+        for (uint32_t i = 0; i < len; ++i) {
+            impl_v.prefix_matches_impl(mk.data + i, len - i,
+                [&](uint32_t l, uint64_t* lf, uint16_t p) {
+                    if (l == 0) return;  // the empty key matches everywhere
+                    hdr_type h = hdr_type::from_node(lf);
+                    fn(static_cast<size_t>(i), text.substr(i, l),
+                       *slots_type::load_value(h.get_compact_slots(lf), p));
+                });
+        }
+    }
+
+    // Parallel prefix_walk: the prefix's subtree is cut into tasks at its
+    // bitmask nodes and walked on up to `threads` threads (0 = hardware
+    // concurrency).  UNORDERED calls fn concurrently from the workers,
+    // so fn must be thread-safe; ORDERED calls fn on this thread in key
+    // order after the workers finish.  The walk must not race writers.
+    using walk_order = kstrie_detail::walk_order;
+
+    template<typename F>
+    void parallel_prefix_walk(std::string_view pfx, F&& fn, unsigned threads = 0,
+                              walk_order order = walk_order::UNORDERED) const {
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        const uint8_t* raw = reinterpret_cast<const uint8_t*>(pfx.data());
+        uint32_t len = static_cast<uint32_t>(pfx.size());
+        kstrie_detail::mapped_key<CHARMAP> mk(raw, len);
+        impl_v.parallel_prefix_walk_impl(mk.data, len, pfx, fn, threads, order);
+    }
+
+    template<typename F>
+    void parallel_for_each(F&& fn, unsigned threads = 0,
+                           walk_order order = walk_order::UNORDERED) const {
+        parallel_prefix_walk(std::string_view{}, std::forward<F>(fn), threads, order);
+    }
+
     std::vector<std::pair<std::string, VALUE>>
     prefix_vector(std::string_view pfx) const {
         std::vector<std::pair<std::string, VALUE>> result;
@@ -837,6 +1099,47 @@ public:
         return result;
     }
 
+    // ------------------------------------------------------------------
+    // Set algebra — both trees are descended in lockstep: bitmask nodes
+    // dispatch over the AND / OR of their child bitmaps, so subtrees on
+    // one side only are skipped or copied whole, and compact leaves are
+    // merged linearly.  The result is bulk built in one pass.  A key in
+    // both takes this trie's value; merge_with takes
+    // combine(const VALUE& mine, const VALUE& theirs) instead.
+    // ------------------------------------------------------------------
+
+    kstrie intersect(const kstrie& o) const {
+        return join<true, false, false>(o, keep_mine);
+    }
+
+    kstrie set_union(const kstrie& o) const {
+        return join<true, true, true>(o, keep_mine);
+    }
+
+    kstrie set_difference(const kstrie& o) const {
+        return join<false, true, false>(o, keep_mine);
+    }
+
+    template<typename F>
+    kstrie merge_with(const kstrie& o, F&& combine) const {
+        return join<true, true, true>(o, combine);
+    }
+
+    // ------------------------------------------------------------------
+    // On-disk image — frozen, position-independent copy of the tree.
+    // map() opens it read-only (mmap) without rebuilding anything.
+    // Inline values (trivially copyable, <= 8 bytes) and bool only.
+    // ------------------------------------------------------------------
+
+    void save(const std::string& path) const {
+        kstrie_detail::image_ops<VALUE, CHARMAP>::save(
+            path.c_str(), impl_v.get_root(), impl_v.size());
+    }
+
+    static kstrie_view<VALUE, CHARMAP> map(const std::string& path) {
+        return kstrie_view<VALUE, CHARMAP>(path);
+    }
+
     // ------------------------------------------------------------------
     // Comparison
     // ------------------------------------------------------------------
@@ -858,6 +1161,17 @@ public:
 private:
 
 
+    static constexpr auto keep_mine = [](const VALUE& a, const VALUE&) -> const VALUE& {
+        return a;
+    };
+
+    template<bool KEEP_AB, bool KEEP_A, bool KEEP_B, typename F>
+    kstrie join(const kstrie& o, F& combine) const {
+        kstrie r;
+        r.impl_v.template assign_join<KEEP_AB, KEEP_A, KEEP_B>(impl_v, o.impl_v, combine);
+        return r;
+    }
+
     // Construct iterator from insert_result (lazy — no key built).
     iterator make_iter_from_result(
             const kstrie_detail::insert_result& r) {
@@ -1015,6 +1329,93 @@ private:
     }
 };
 
+// ============================================================================
+// kstrie_snapshot -- immutable point-in-time view from kstrie::snapshot().
+//
+// Shares its nodes with the trie (and with other snapshots); whichever
+// lets go of a node last frees it.  Queries are the callback and lookup
+// forms only: a shared node's parent link belongs to the live trie, so
+// there are no parent-walking iterators.  Move-only.  Destruction frees
+// through the trie's allocator; see kstrie::snapshot() for threads.
+// ============================================================================
+
+template <typename VALUE,
+          typename CHARMAP = kstrie_traits::identity_char_map,
+          typename ALLOC   = std::allocator<uint64_t>>
+class kstrie_snapshot {
+    using impl_t = kstrie_detail::kstrie_impl<VALUE, CHARMAP, ALLOC>;
+
+    friend class kstrie<VALUE, CHARMAP, ALLOC>;
+
+    impl_t impl_v;
+
+    explicit kstrie_snapshot(impl_t&& impl) noexcept : impl_v(std::move(impl)) {}
+
+public:
+    using key_type    = typename impl_t::key_type;
+    using mapped_type = typename impl_t::mapped_type;
+    using size_type   = typename impl_t::size_type;
+
+    kstrie_snapshot() = default;
+    kstrie_snapshot(kstrie_snapshot&&) noexcept = default;
+    kstrie_snapshot& operator=(kstrie_snapshot&&) noexcept = default;
+    kstrie_snapshot(const kstrie_snapshot&) = delete;
+    kstrie_snapshot& operator=(const kstrie_snapshot&) = delete;
+
+    [[nodiscard]] bool      empty() const noexcept { return impl_v.empty(); }
+    [[nodiscard]] size_type size()  const noexcept { return impl_v.size(); }
+
+    // Null when absent.
+    const VALUE* find(std::string_view key) const { return impl_v.find(key); }
+    bool contains(std::string_view key) const { return impl_v.contains(key); }
+    size_type count(std::string_view key) const { return impl_v.count(key); }
+
+    const VALUE& at(std::string_view key) const {
+        const VALUE* v = impl_v.find(key);
+        if (!v) throw std::out_of_range("kstrie_snapshot::at");
+        return *v;
+    }
+
+    // Same contracts as kstrie's for_each / for_each_range / prefix_walk.
+    template<typename F>
+    void for_each(F&& fn) const {
+        impl_v.range_walk_impl(nullptr, 0, nullptr, 0, false, fn);
+    }
+
+    template<typename F>
+    void for_each_range(std::string_view lo, std::string_view hi, F&& fn) const {
+        kstrie_detail::mapped_key<CHARMAP> ml(
+            reinterpret_cast<const uint8_t*>(lo.data()), static_cast<uint32_t>(lo.size()));
+        kstrie_detail::mapped_key<CHARMAP> mh(
+            reinterpret_cast<const uint8_t*>(hi.data()), static_cast<uint32_t>(hi.size()));
+        impl_v.range_walk_impl(ml.data, static_cast<uint32_t>(lo.size()),
+                               mh.data, static_cast<uint32_t>(hi.size()), true, fn);
+    }
+
+    template<typename F>
+    void for_each_range(std::string_view lo, F&& fn) const {
+        kstrie_detail::mapped_key<CHARMAP> ml(
+            reinterpret_cast<const uint8_t*>(lo.data()), static_cast<uint32_t>(lo.size()));
+        impl_v.range_walk_impl(ml.data, static_cast<uint32_t>(lo.size()),
+                               nullptr, 0, false, fn);
+    }
+
+    size_t prefix_count(std::string_view pfx) const {
+        const uint8_t* raw = reinterpret_cast<const uint8_t*>(pfx.data());
+        uint32_t len = static_cast<uint32_t>(pfx.size());
+        kstrie_detail::mapped_key<CHARMAP> mk(raw, len);
+        return impl_v.prefix_count_impl(mk.data, len);
+    }
+
+    template<typename F>
+    void prefix_walk(std::string_view pfx, F&& fn) const {
+        const uint8_t* raw = reinterpret_cast<const uint8_t*>(pfx.data());
+        uint32_t len = static_cast<uint32_t>(pfx.size());
+        kstrie_detail::mapped_key<CHARMAP> mk(raw, len);
+        impl_v.prefix_walk_impl(mk.data, len, pfx, std::forward<F>(fn));
+    }
+};
+
 } // namespace gteitelbaum
 
 #endif // KSTRIE_HPP
@@ -244,6 +244,7 @@ struct kstrie_bitmask {
         }
 
         // Realloc
+        stat_add(stat_t::REALLOC);
         uint64_t* nn = mem.alloc_node(new_nu);
         hdr_type& nh = hdr_type::from_node(nn);
         nh.copy_from(h);
@@ -345,6 +346,8 @@ struct kstrie_bitmask {
     // ------------------------------------------------------------------
     // Link helpers: set parent pointers on all children of a bitmask node.
     // Called after create_with_children or after realloc moves a bitmask.
+    // The parent byte is stored only when it changes: a child shared with
+    // a snapshot keeps its byte, and snapshot readers load that header.
     // ------------------------------------------------------------------
 
     static void link_child_to_parent(uint64_t* parent, uint64_t* child,
@@ -353,10 +356,12 @@ struct kstrie_bitmask {
         hdr_type ch = hdr_type::from_node(child);
         if (ch.is_compact()) {
             compact_type::set_parent(child, parent);
-            compact_type::set_parent_byte(child, ch, byte);
+            if (compact_type::get_parent_byte(child, ch) != byte)
+                compact_type::set_parent_byte(child, ch, byte);
         } else {
             set_parent(child, parent);
-            set_parent_byte(child, byte);
+            if (get_parent_byte(child) != byte)
+                set_parent_byte(child, byte);
         }
     }
 
@@ -248,6 +248,46 @@ struct kstrie_compact {
 
     struct find_result { bool found; int pos; };
 
+#if KSTRIE_SIMD_SEARCH_BITS
+    // Entries scanned by the SIMD first-byte filter; larger nodes keep
+    // the binary search (its probe count grows only logarithmically).
+    static constexpr int SIMD_SCAN_MAX = 512;
+
+    // Over F[0..n): lt = #(F[i] < fb), le = #(F[i] <= fb).  F is sorted,
+    // so [lt, le) is exactly the run of entries starting with fb.
+    static void count_firsts(const uint8_t* F, int n, uint8_t fb,
+                             int& lt, int& le) noexcept {
+        lt = le = 0;
+        int i = 0;
+#if KSTRIE_SIMD_SEARCH_BITS == 512
+        __m512i k = _mm512_set1_epi8(static_cast<char>(fb));
+        for (; i < n; i += 64) {
+            int left = n - i;
+            __mmask64 live = left >= 64 ? ~__mmask64(0)
+                                        : (__mmask64(1) << left) - 1;
+            __m512i v = _mm512_maskz_loadu_epi8(live, F + i);  // no read past n
+            lt += std::popcount(_mm512_mask_cmplt_epu8_mask(live, v, k));
+            le += std::popcount(_mm512_mask_cmple_epu8_mask(live, v, k));
+        }
+#else
+        // No unsigned compare: x <= k  <=>  max(x, k) == k;  x < k  <=>  max(x, k) != x.
+        __m256i k = _mm256_set1_epi8(static_cast<char>(fb));
+        for (; i + 32 <= n; i += 32) {
+            __m256i v  = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(F + i));
+            __m256i mx = _mm256_max_epu8(v, k);
+            le += std::popcount(static_cast<uint32_t>(
+                      _mm256_movemask_epi8(_mm256_cmpeq_epi8(mx, k))));
+            lt += 32 - std::popcount(static_cast<uint32_t>(
+                      _mm256_movemask_epi8(_mm256_cmpeq_epi8(mx, v))));
+        }
+        for (; i < n; ++i) {
+            lt += F[i] < fb;
+            le += F[i] <= fb;
+        }
+#endif
+    }
+#endif
+
     static find_result find_pos(const uint64_t* node, const hdr_type& h,
                                 const uint8_t* suffix,
                                 uint32_t suffix_len) noexcept {
@@ -272,6 +312,18 @@ struct kstrie_compact {
 
         int lo = valid_eos;
         int hi = e;
+
+#if KSTRIE_SIMD_SEARCH_BITS
+        // Narrow to the entries sharing suffix[0] with one pass over the
+        // dense F[] array; the search below then only compares their tails.
+        if (hi - lo <= SIMD_SCAN_MAX) {
+            int lt, le;
+            count_firsts(F + lo, hi - lo, static_cast<uint8_t>(fb), lt, le);
+            hi = lo + le;
+            lo = lo + lt;
+        }
+#endif
+
         while (lo < hi) [[likely]] {
             int m  = lo + ((hi - lo) >> 1);
             int lm = static_cast<int>(L[m]);
@@ -302,6 +354,189 @@ struct kstrie_compact {
         return slots::load_value(h.get_compact_slots(node), pos);
     }
 
+    // ------------------------------------------------------------------
+    // prefix_matches -- every entry that is a prefix of suffix, shortest
+    // first: fn(pos, entry_len).  Prefixes of suffix sort at or before
+    // it, so the scan of the suffix[0] run stops at the first entry
+    // that compares greater.
+    // ------------------------------------------------------------------
+
+    template<typename F>
+    static void prefix_matches(const uint64_t* node, const hdr_type& h,
+                               const uint8_t* suffix, uint32_t suffix_len,
+                               F&& fn) {
+        const uint8_t*  L  = lengths(node, h);
+        const uint8_t*  F_ = firsts(node, h);
+        const ks_offset_type* O = offsets(node, h);
+        const uint8_t*  B = keysuffix(node, h);
+        int e = h.count;
+        if (e == 0) return;
+
+        int lo = 0;
+        if (L[0] == 0) { fn(0, 0u); lo = 1; }
+        if (suffix_len == 0) return;
+
+        uint8_t fb = suffix[0];
+        int i = static_cast<int>(std::lower_bound(F_ + lo, F_ + e, fb) - F_);
+        for (; i < e && F_[i] == fb; ++i) {
+            uint32_t lm = L[i];
+            uint32_t min_tail = std::min(lm, suffix_len) - 1;
+            int c = std::memcmp(B + O[i], suffix + 1, min_tail);
+            if (c > 0 || (c == 0 && lm > suffix_len)) break;
+            if (c == 0) fn(i, lm);
+        }
+    }
+
+    // ------------------------------------------------------------------
+    // Front-coded keysuffix -- read-only leaf variant written into images.
+    //
+    // Same L/F/O arrays, skip and value slots; B holds one record per
+    // entry with a tail (L > 1): [shared][rest ...], where shared is how
+    // many leading tail bytes equal the previous entry's tail and rest
+    // is the remaining L - 1 - shared bytes.  O[i] locates entry i's
+    // record.  Every FC_RESTART-th entry (and any entry after one with
+    // no tail) has shared = 0, so a lookup binary-searches the restart
+    // entries and then decodes at most one block.
+    // ------------------------------------------------------------------
+
+    static constexpr int FC_RESTART = 16;
+
+    // Entry tails of a leaf, plain or front-coded.  tail(i) points at
+    // the L[i] - 1 tail bytes of entry i, valid until the next call;
+    // ascending i decodes each front-coded record once.
+    struct tail_reader {
+        const uint8_t*        L;
+        const ks_offset_type* O;
+        const uint8_t*        B;
+        bool                  fc;
+        int                   at = -1;   // entry whose tail is in buf
+        uint8_t               buf[COMPACT_SUFFIX_LEN_MAX];
+
+        tail_reader(const uint64_t* node, const hdr_type& h) noexcept
+            : L(lengths(node, h)), O(offsets(node, h)), B(keysuffix(node, h)),
+              fc(h.is_front_coded()) {}
+
+        const uint8_t* tail(int i) noexcept {
+            if (!fc) return B + O[i];
+            if (at == i) return buf;
+            int j = (at >= 0 && at < i && at / FC_RESTART == i / FC_RESTART)
+                  ? at + 1 : i - i % FC_RESTART;
+            for (; j <= i; ++j) {
+                if (L[j] <= 1) continue;
+                const uint8_t* r = B + O[j];
+                std::memcpy(buf + r[0], r + 1, L[j] - 1u - r[0]);
+            }
+            at = i;
+            return buf;
+        }
+    };
+
+    // Encode node's tails front-coded into B_out / O_out (nullptr: size
+    // only).  Returns the blob size in bytes.
+    static uint32_t fc_encode(const uint64_t* node, const hdr_type& h,
+                              uint8_t* B_out, ks_offset_type* O_out) noexcept {
+        const uint8_t*  L = lengths(node, h);
+        const ks_offset_type* O = offsets(node, h);
+        const uint8_t*  B = keysuffix(node, h);
+        uint32_t cursor = 0;
+        uint32_t prev_tail = 0;
+        const uint8_t* prev = nullptr;
+        for (int i = 0; i < h.count; ++i) {
+            uint32_t t = L[i] > 1 ? L[i] - 1u : 0;
+            if (O_out) O_out[i] = static_cast<ks_offset_type>(cursor);
+            if (t == 0) { prev_tail = 0; continue; }
+            const uint8_t* cur = B + O[i];
+            uint32_t s = 0;
+            if (i % FC_RESTART != 0) {
+                uint32_t mx = std::min(t, prev_tail);
+                while (s < mx && prev[s] == cur[s]) ++s;
+            }
+            if (B_out) {
+                B_out[cursor] = static_cast<uint8_t>(s);
+                std::memcpy(B_out + cursor + 1, cur + s, t - s);
+            }
+            cursor += 1 + t - s;
+            prev = cur;
+            prev_tail = t;
+        }
+        return cursor;
+    }
+
+    // Front-code a leaf only when it saves at least 1/FC_MIN_GAIN of its
+    // words: decoding costs lookups, so marginal gains are not worth it.
+    static constexpr size_t FC_MIN_GAIN = 8;
+
+    // Node size in u64 words once front-coded.
+    static size_t fc_node_u64(const uint64_t* node, const hdr_type& h) noexcept {
+        uint16_t cap = get_prefix(node, h).cap;
+        return compute_slots_off(cap, h.skip, fc_encode(node, h, nullptr, nullptr))
+             + slots::value_u64s(h.count);
+    }
+
+    // Write the front-coded copy of plain node into dst (fc_node_u64
+    // words).  Parent pointer and parent byte are copied unchanged.
+    static void write_front_coded(const uint64_t* node, const hdr_type& h,
+                                  uint64_t* dst) noexcept {
+        const ck_prefix& p = get_prefix(node, h);
+        size_t n = fc_node_u64(node, h);
+        std::memset(dst, 0, n * U64_BYTES);
+        size_t ks_off = p.skip_data_off + h.skip_bytes();
+        std::memcpy(dst, node, ks_off);
+
+        hdr_type& nh = hdr_type::from_node(dst);
+        uint32_t fc = fc_encode(node, h, reinterpret_cast<uint8_t*>(dst) + ks_off,
+                                offsets(dst, nh));
+        nh.slots_off = compute_slots_off(p.cap, h.skip, fc);
+        nh.alloc_u64 = static_cast<uint16_t>(n);
+        nh.flags    |= hdr_type::FLAG_FRONT_CODED;
+        get_prefix(dst, nh).keysuffix_used = static_cast<uint16_t>(fc);
+        std::memcpy(dst + nh.slots_off, node + h.slots_off,
+                    slots::value_u64s(h.count) * U64_BYTES);
+    }
+
+    // find_pos for front-coded leaves: same {found, lower bound} contract.
+    static find_result fc_find_pos(const uint64_t* node, const hdr_type& h,
+                                   const uint8_t* suffix,
+                                   uint32_t suffix_len) noexcept {
+        const uint8_t* L = lengths(node, h);
+        const uint8_t* F = firsts(node, h);
+        int e = h.count;
+        if (suffix_len == 0) [[unlikely]] return {e > 0 && L[0] == 0, 0};
+        if (e == 0) return {false, 0};
+
+        tail_reader tr(node, h);
+        // key vs entry i: < 0, 0, > 0
+        auto cmp = [&](int i) {
+            if (L[i] == 0) return 1;
+            int c = static_cast<int>(suffix[0]) - static_cast<int>(F[i]);
+            if (c != 0) return c;
+            uint32_t min_tail = std::min<uint32_t>(suffix_len, L[i]) - 1;
+            if (min_tail > 0) {
+                c = std::memcmp(suffix + 1, tr.tail(i), min_tail);
+                if (c != 0) return c;
+            }
+            return static_cast<int>(suffix_len) - static_cast<int>(L[i]);
+        };
+
+        // Narrow to the run of entries starting with suffix[0] (F is
+        // dense and plain), then to the last restart in it <= key.
+        int first = (L[0] == 0);
+        int lo = static_cast<int>(std::lower_bound(F + first, F + e, suffix[0]) - F);
+        int hi = static_cast<int>(std::upper_bound(F + lo, F + e, suffix[0]) - F);
+        int rlo = lo / FC_RESTART + 1, rhi = (hi - 1) / FC_RESTART;
+        while (rlo <= rhi) {
+            int m = (rlo + rhi) >> 1;
+            if (cmp(m * FC_RESTART) >= 0) { lo = m * FC_RESTART; rlo = m + 1; }
+            else                          rhi = m - 1;
+        }
+        for (int i = lo; i < hi; ++i) {
+            int c = cmp(i);
+            if (c == 0) return {true, i};
+            if (c < 0) return {false, i};
+        }
+        return {false, hi};
+    }
+
     // ------------------------------------------------------------------
     // collect_entries -- walk parallel arrays into build_entry[].
     // key_buf must be at least N * 256 bytes.
@@ -416,6 +651,7 @@ struct kstrie_compact {
 
     static uint64_t* grow(uint64_t* old_node, hdr_type& h, mem_type& mem,
                           uint16_t blob_delta) {
+        stat_add(stat_t::REALLOC);
         const ck_prefix& op = get_prefix(old_node, h);
         uint16_t e   = h.count;
         uint16_t ksz = op.keysuffix_used;
@@ -845,8 +1081,10 @@ struct kstrie_compact {
             skip_data = hdr_type::get_skip(node, h);
         uint32_t old_skip = h.skip_bytes();
 
+        stat_add(stat_t::SPLIT);
         if (mr.status != match_status::MATCHED) {
             // ---- MISMATCH / KEY_EXHAUSTED: reskip + bitmask ----
+            stat_add(stat_t::SKIP_MISMATCH);
             return promote_mismatch(node, h, key_data, key_len, value,
                                     consumed, mr, skip_data, old_skip, mem);
         }
@@ -1342,6 +1580,7 @@ struct kstrie_compact {
 
     static insert_result split_node(uint64_t* node, hdr_type& h,
                                      mem_type& mem) {
+        stat_add(stat_t::SPLIT);
         uint16_t N = h.count;
 
         // RAII heap buffers for exception safety.
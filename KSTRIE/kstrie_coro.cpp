@@ -0,0 +1 @@
+#include "kstrie_coro.hpp"
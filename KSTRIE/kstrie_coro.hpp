@@ -0,0 +1,142 @@
+#ifndef KSTRIE_CORO_HPP
+#define KSTRIE_CORO_HPP
+
+#include <coroutine>
+#include <exception>
+#include <iterator>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace gteitelbaum {
+
+// ==========================================================================
+// Coroutine lookups (kstrie::co_find / co_lower_bound)
+//
+// A lookup is a lazy coroutine that prefetches the next node at every
+// bitmask dispatch and then co_awaits hop().  While one lookup waits on
+// its prefetch, the scheduler runs others, so many in-flight descents
+// share a core the way find_batch's lockstep groups do, without batching.
+//
+// HOP picks who resumes a suspended lookup:
+//
+//   kstrie_hop (default)  suspend_always.  kstrie_interleave() resumes
+//                         a set of lookups round-robin; co_await on a
+//                         single lookup runs it to completion inline.
+//   runtime yield         any callable returning the runtime's own
+//                         reschedule awaitable (e.g. a task-queue
+//                         yield).  co_await hands the lookup to the
+//                         runtime and resumes the awaiter when done.
+//
+// The trie and the key's bytes must outlive the lookup, and the trie
+// must not be modified while a lookup is in flight.
+// ==========================================================================
+
+struct kstrie_hop {
+    std::suspend_always operator()() const noexcept { return {}; }
+};
+
+template<typename R, typename HOP = kstrie_hop>
+class kstrie_lookup {
+public:
+    struct promise_type {
+        std::optional<R>        value_v;
+        std::exception_ptr      error_v;
+        std::coroutine_handle<> cont_v;
+
+        kstrie_lookup get_return_object() noexcept {
+            return kstrie_lookup(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+
+        struct final_awaiter {
+            bool await_ready() const noexcept { return false; }
+            std::coroutine_handle<> await_suspend(
+                    std::coroutine_handle<promise_type> h) const noexcept {
+                auto c = h.promise().cont_v;
+                return c ? c : std::noop_coroutine();
+            }
+            void await_resume() const noexcept {}
+        };
+        final_awaiter final_suspend() const noexcept { return {}; }
+
+        void return_value(R v) { value_v.emplace(std::move(v)); }
+        void unhandled_exception() noexcept { error_v = std::current_exception(); }
+    };
+
+private:
+    using handle_t = std::coroutine_handle<promise_type>;
+    handle_t h_v;
+
+    explicit kstrie_lookup(handle_t h) noexcept : h_v(h) {}
+
+public:
+    kstrie_lookup(kstrie_lookup&& o) noexcept : h_v(std::exchange(o.h_v, {})) {}
+    kstrie_lookup& operator=(kstrie_lookup&& o) noexcept {
+        if (this != &o) {
+            if (h_v) h_v.destroy();
+            h_v = std::exchange(o.h_v, {});
+        }
+        return *this;
+    }
+    kstrie_lookup(const kstrie_lookup&) = delete;
+    kstrie_lookup& operator=(const kstrie_lookup&) = delete;
+    ~kstrie_lookup() { if (h_v) h_v.destroy(); }
+
+    // Manual driving: resume() advances one hop.
+    [[nodiscard]] bool done() const noexcept { return !h_v || h_v.done(); }
+    void resume() { if (!done()) h_v.resume(); }
+
+    // Result once done(); rethrows anything the hop awaitable threw.
+    R result() {
+        auto& p = h_v.promise();
+        if (p.error_v) std::rethrow_exception(p.error_v);
+        return std::move(*p.value_v);
+    }
+
+    auto operator co_await() && noexcept {
+        struct awaiter {
+            handle_t h;
+            bool await_ready() const noexcept { return h.done(); }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> cont) {
+                if constexpr (std::is_same_v<HOP, kstrie_hop>) {
+                    while (!h.done()) h.resume();
+                    return cont;
+                } else {
+                    h.promise().cont_v = cont;
+                    return h;
+                }
+            }
+            R await_resume() {
+                auto& p = h.promise();
+                if (p.error_v) std::rethrow_exception(p.error_v);
+                return std::move(*p.value_v);
+            }
+        };
+        return awaiter{h_v};
+    }
+};
+
+// Resume every lookup in [first, last) round-robin, one hop each per
+// round, until all are done.  Results are then read with result().
+template<typename It>
+void kstrie_interleave(It first, It last) {
+    bool is_live = true;
+    while (is_live) {
+        is_live = false;
+        for (It it = first; it != last; ++it) {
+            if (it->done()) continue;
+            it->resume();
+            is_live |= !it->done();
+        }
+    }
+}
+
+template<typename Range>
+void kstrie_interleave(Range& lookups) {
+    kstrie_interleave(std::begin(lookups), std::end(lookups));
+}
+
+} // namespace gteitelbaum
+
+#endif // KSTRIE_CORO_HPP
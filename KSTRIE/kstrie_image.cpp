@@ -0,0 +1 @@
+#include "kstrie_image.hpp"
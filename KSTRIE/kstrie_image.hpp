@@ -0,0 +1,793 @@
+#ifndef KSTRIE_IMAGE_HPP
+#define KSTRIE_IMAGE_HPP
+
+#include "kstrie_impl.hpp"
+#include <cstdio>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define KSTRIE_IMAGE_MMAP 1
+#else
+#define KSTRIE_IMAGE_MMAP 0
+#endif
+
+namespace gteitelbaum::kstrie_detail {
+
+// ============================================================================
+// On-disk image
+//
+// [image_header_t (64 bytes)][node words ...]
+//
+// Nodes are copied word-for-word from the live tree (node_size(), not the
+// padded allocation), except that a compact leaf is written front-coded
+// (FLAG_FRONT_CODED, see kstrie_compact) when that saves enough words.
+// Every absolute address is rewritten as a byte offset
+// from the start of the image: bitmask child + EOS slots, and the parent
+// pointer of both node kinds.  Offset 0 falls inside the header, so it
+// stands for "none": the shared sentinel in child slots, null in parent
+// slots.  Parent bytes, bitmaps, skips, L/F/O arrays and keysuffix bytes
+// carry no address and are kept as they are.  Native endian — a
+// byte-swapped image fails the magic check.
+//
+// Keys are stored mapped, so the image records a fingerprint of CHARMAP
+// and refuses to open under a different one.  Only inline values
+// (trivially copyable, <= 8 bytes) and bool can be saved: heap values
+// live outside the node words.
+// ============================================================================
+
+inline constexpr uint64_t IMAGE_MAGIC   = 0x31474D49'5254534Bull;  // "KSTRIMG1"
+// v2: front-coded leaves.  v1 images (all leaves plain) still open.
+inline constexpr uint32_t IMAGE_VERSION = 2;
+
+inline constexpr uint8_t IMAGE_FLAG_BOOL = 1u << 0;
+
+struct image_header_t {
+    uint64_t magic;
+    uint32_t version;
+    uint8_t  value_bytes;
+    uint8_t  flags;
+    uint8_t  bitmap_words;
+    uint8_t  reserved0;
+    uint64_t charmap_hash;
+    uint64_t size;
+    uint64_t root;          // byte offset, 0 when empty
+    uint64_t total_bytes;
+    uint64_t reserved[2];
+};
+
+inline constexpr size_t IMAGE_HEADER_U64 = sizeof(image_header_t) / U64_BYTES;
+static_assert(sizeof(image_header_t) == 64);
+
+// FNV-1a over the char -> index table.
+template <typename CHARMAP>
+constexpr uint64_t charmap_fingerprint() noexcept {
+    uint64_t h = 0xCBF29CE484222325ull;
+    for (uint8_t c : CHARMAP::CHAR_TO_INDEX) {
+        h ^= c;
+        h *= 0x100000001B3ull;
+    }
+    return h;
+}
+
+// ============================================================================
+// image_ops<VALUE, CHARMAP> — writer + offset-based readers.
+//
+// Readers mirror find_inner / find_ge_iter / iterator walk / prefix_walk
+// with base + offset in place of raw child and parent pointers.  The
+// compact-node helpers (find_pos, lengths, firsts, ...) never leave the
+// node, so they run on mapped leaves unchanged; tails are read through
+// tail_reader and searched with leaf_find_pos so front-coded leaves work.
+// ============================================================================
+
+template <typename VALUE, typename CHARMAP>
+struct image_ops {
+    using ALLOC        = std::allocator<uint64_t>;
+    using hdr_type     = node_header<VALUE, CHARMAP, ALLOC>;
+    using slots_type   = kstrie_slots<VALUE>;
+    using skip_type    = kstrie_skip<VALUE, CHARMAP, ALLOC>;
+    using bitmask_type = kstrie_bitmask<VALUE, CHARMAP, ALLOC>;
+    using compact_type = kstrie_compact<VALUE, CHARMAP, ALLOC>;
+    using impl_type    = kstrie_impl<VALUE, CHARMAP, ALLOC>;
+
+    static_assert(slots_type::IS_INLINE || slots_type::IS_BITMAP,
+                  "kstrie image: VALUE must be stored inline or be bool");
+
+    static constexpr size_t CHILD_SLOTS_OFF = bitmask_type::CHILD_SLOTS_OFF;
+    static constexpr size_t SENTINEL_OFF    = bitmask_type::SENTINEL_OFF;
+
+    // Leaf position; leaf == nullptr is end.
+    struct pos_t {
+        const uint64_t* leaf = nullptr;
+        uint16_t        pos  = 0;
+    };
+
+    // ==================================================================
+    // Writer
+    // ==================================================================
+
+    // Append the subtree at node to out; returns its byte offset.
+    // Works on indices: out may reallocate during the recursion.
+    static uint64_t emit(const uint64_t* node, uint64_t parent_off,
+                         std::vector<uint64_t>& out) {
+        hdr_type h = hdr_type::from_node(node);
+        size_t n  = h.node_size() / U64_BYTES;
+        size_t at = out.size();
+        uint64_t off = at * U64_BYTES;
+
+        if (h.is_compact()) {
+            size_t fn = compact_type::fc_node_u64(node, h);
+            if (fn + n / compact_type::FC_MIN_GAIN <= n) {
+                out.resize(at + fn);
+                compact_type::write_front_coded(node, h, out.data() + at);
+            } else {
+                out.insert(out.end(), node, node + n);
+                hdr_type::from_node(out.data() + at).alloc_u64 = static_cast<uint16_t>(n);
+            }
+            out[at + compact_type::COMPACT_PARENT_PTR] = parent_off;
+            return off;
+        }
+
+        out.insert(out.end(), node, node + n);
+        hdr_type::from_node(out.data() + at).alloc_u64 = static_cast<uint16_t>(n);
+
+        out[at + NODE_PARENT_PTR] = parent_off;
+        out[at + SENTINEL_OFF]    = 0;
+        // children then EOS: count + 1 consecutive slots
+        for (uint16_t i = 0; i <= h.count; ++i) {
+            const uint64_t* c = slots_type::load_child(node + CHILD_SLOTS_OFF, i);
+            uint64_t co = (c == compact_type::sentinel()) ? 0 : emit(c, off, out);
+            out[at + CHILD_SLOTS_OFF + i] = co;
+        }
+        return off;
+    }
+
+    static void save(const char* path, const uint64_t* root, size_t size) {
+        std::vector<uint64_t> out(IMAGE_HEADER_U64, 0);
+        uint64_t img_root = (root == compact_type::sentinel()) ? 0 : emit(root, 0, out);
+
+        image_header_t h{};
+        h.magic        = IMAGE_MAGIC;
+        h.version      = IMAGE_VERSION;
+        h.value_bytes  = static_cast<uint8_t>(sizeof(VALUE));
+        h.flags        = slots_type::IS_BITMAP ? IMAGE_FLAG_BOOL : 0;
+        h.bitmap_words = static_cast<uint8_t>(CHARMAP::BITMAP_WORDS);
+        h.charmap_hash = charmap_fingerprint<CHARMAP>();
+        h.size         = size;
+        h.root         = img_root;
+        h.total_bytes  = out.size() * U64_BYTES;
+        std::memcpy(out.data(), &h, sizeof(h));
+
+        std::FILE* f = std::fopen(path, "wb");
+        if (!f) throw std::runtime_error(std::string("kstrie::save: cannot open ") + path);
+        bool ok = std::fwrite(out.data(), U64_BYTES, out.size(), f) == out.size();
+        ok = (std::fclose(f) == 0) && ok;
+        if (!ok) throw std::runtime_error(std::string("kstrie::save: write failed ") + path);
+    }
+
+    // ==================================================================
+    // Offset resolution
+    // ==================================================================
+
+    static const uint64_t* node_at(const uint64_t* base, uint64_t off) noexcept {
+        return off ? base + off / U64_BYTES : compact_type::sentinel();
+    }
+
+    // Same rank trick as bitmask_type::dispatch: miss lands on slot 0 = 0.
+    static const uint64_t* dispatch(const uint64_t* base, const uint64_t* node,
+                                    uint8_t idx) noexcept {
+        int rank = bitmask_type::do_find_pop(node + bitmask_type::CHILD_BITMAP_OFF, idx);
+        return node_at(base, node[SENTINEL_OFF + rank]);
+    }
+
+    static const uint64_t* child_by_slot(const uint64_t* base, const uint64_t* node,
+                                         int slot) noexcept {
+        return node_at(base, node[CHILD_SLOTS_OFF + slot]);
+    }
+
+    static const uint64_t* child_by_bit(const uint64_t* base, const uint64_t* node,
+                                        const hdr_type& h, int bit) noexcept {
+        const auto* bm = bitmask_type::get_bitmap(node, h);
+        return child_by_slot(base, node, bm->count_below(static_cast<uint8_t>(bit)) - 1);
+    }
+
+    static const uint64_t* eos_child(const uint64_t* base, const uint64_t* node,
+                                     const hdr_type& h) noexcept {
+        return node_at(base, node[CHILD_SLOTS_OFF + h.count]);
+    }
+
+    static const uint64_t* parent_of(const uint64_t* base, uint64_t off) noexcept {
+        return off ? base + off / U64_BYTES : nullptr;
+    }
+
+    using tail_reader = typename compact_type::tail_reader;
+    using find_result = typename compact_type::find_result;
+
+    static find_result leaf_find_pos(const uint64_t* node, const hdr_type& h,
+                                     const uint8_t* suffix, uint32_t suffix_len) noexcept {
+        return h.is_front_coded()
+             ? compact_type::fc_find_pos(node, h, suffix, suffix_len)
+             : compact_type::find_pos(node, h, suffix, suffix_len);
+    }
+
+    // ==================================================================
+    // Point lookup — find_inner over offsets
+    // ==================================================================
+
+    static pos_t find(const uint64_t* base, const uint64_t* node,
+                      const uint8_t* mapped, uint32_t key_len) noexcept {
+        uint32_t consumed = 0;
+        hdr_type h;
+        for (;;) {
+            h = hdr_type::from_node(node);
+            if (h.has_skip()) [[unlikely]] {
+                if (!skip_type::match_skip_unchecked(node, h, mapped, key_len, consumed))
+                    [[unlikely]] return {};
+            }
+            if (!h.is_bitmap()) [[unlikely]] break;
+            if (consumed == key_len) [[unlikely]] {
+                node = eos_child(base, node, h);
+                h = hdr_type::from_node(node);
+                break;
+            }
+            node = dispatch(base, node, mapped[consumed++]);
+        }
+        auto [found, pos] = leaf_find_pos(node, h, mapped + consumed,
+                                          key_len - consumed);
+        if (!found) return {};
+        return {node, static_cast<uint16_t>(pos)};
+    }
+
+    // ==================================================================
+    // Ordered navigation — iterator edge_entry / walk(FWD)
+    // ==================================================================
+
+    static pos_t first(const uint64_t* base, const uint64_t* node) noexcept {
+        for (;;) {
+            hdr_type h = hdr_type::from_node(node);
+            if (h.is_compact()) return {node, 0};
+            const uint64_t* eos = eos_child(base, node, h);
+            if (eos != compact_type::sentinel()) { node = eos; continue; }
+            int idx = bitmask_type::get_bitmap(node, h)->find_next_set(0);
+            if (idx < 0) [[unlikely]] return {};
+            node = child_by_bit(base, node, h, idx);
+        }
+    }
+
+    static void advance(const uint64_t* base, pos_t& p) noexcept {
+        hdr_type lh = hdr_type::from_node(p.leaf);
+        if (p.pos + 1 < lh.count) { ++p.pos; return; }
+
+        uint16_t byte = compact_type::get_parent_byte(p.leaf, lh);
+        const uint64_t* parent = parent_of(base, p.leaf[compact_type::COMPACT_PARENT_PTR]);
+        while (byte != ROOT_PARENT_BYTE) {
+            hdr_type ph = hdr_type::from_node(parent);
+            const auto* bm = bitmask_type::get_bitmap(parent, ph);
+            int sib = bm->find_next_set(byte == EOS_PARENT_BYTE ? 0 : byte + 1);
+            if (sib >= 0) {
+                p = first(base, child_by_bit(base, parent, ph, sib));
+                return;
+            }
+            byte   = bitmask_type::get_parent_byte(parent);
+            parent = parent_of(base, parent[NODE_PARENT_PTR]);
+        }
+        p = {};
+    }
+
+    // find_ge_iter over offsets.
+    static pos_t lower_bound(const uint64_t* base, const uint64_t* node,
+                             const uint8_t* mapped, uint32_t key_len,
+                             uint32_t consumed) noexcept {
+        if (node == compact_type::sentinel()) [[unlikely]] return {};
+        hdr_type h = hdr_type::from_node(node);
+
+        if (h.has_skip()) [[unlikely]] {
+            uint32_t sb = h.skip_bytes();
+            const uint8_t* skip = hdr_type::get_skip(node, h);
+            uint32_t remaining = key_len - consumed;
+            uint32_t cmp_len = std::min(sb, remaining);
+            for (uint32_t i = 0; i < cmp_len; ++i) {
+                if (skip[i] < mapped[consumed + i]) return {};
+                if (skip[i] > mapped[consumed + i]) return take_min(base, node, h);
+            }
+            if (remaining < sb) [[unlikely]] return take_min(base, node, h);
+            consumed += sb;
+        }
+
+        if (h.is_compact()) [[unlikely]] {
+            auto [found, pos] = leaf_find_pos(
+                node, h, mapped + consumed, key_len - consumed);
+            if (pos >= h.count) [[unlikely]] return {};
+            return {node, static_cast<uint16_t>(pos)};
+        }
+
+        if (consumed == key_len) [[unlikely]] return take_min(base, node, h);
+
+        uint8_t byte = mapped[consumed++];
+        const uint64_t* child = dispatch(base, node, byte);
+        if (child != compact_type::sentinel()) {
+            pos_t r = lower_bound(base, child, mapped, key_len, consumed);
+            if (r.leaf) [[likely]] return r;
+        }
+        int next_idx = bitmask_type::get_bitmap(node, h)->find_next_set(byte + 1);
+        if (next_idx < 0) [[unlikely]] return {};
+        return first(base, child_by_bit(base, node, h, next_idx));
+    }
+
+    static pos_t take_min(const uint64_t* base, const uint64_t* node,
+                          const hdr_type& h) noexcept {
+        if (h.is_compact() && h.count == 0) [[unlikely]] return {};
+        return first(base, node);
+    }
+
+    // ==================================================================
+    // Key reconstruction — collect mapped bytes leaf -> root, then unmap
+    // ==================================================================
+
+    static void key_at(const uint64_t* base, const pos_t& p, std::string& out) {
+        fast_string fs;
+        hdr_type lh = hdr_type::from_node(p.leaf);
+        const uint8_t* skip = hdr_type::get_skip(p.leaf, lh);
+        size_t skip_len = lh.skip_bytes();
+        uint8_t klen = compact_type::lengths(p.leaf, lh)[p.pos];
+        uint8_t fb   = compact_type::firsts(p.leaf, lh)[p.pos];
+        tail_reader tr(p.leaf, lh);
+        const uint8_t* tail = tr.tail(p.pos);
+
+        if (klen == 0) [[unlikely]] fs.prepend(skip, skip_len);
+        else                        fs.prepend(skip, skip_len, fb, tail, klen - 1u);
+
+        uint16_t nb = compact_type::get_parent_byte(p.leaf, lh);
+        const uint64_t* node = parent_of(base, p.leaf[compact_type::COMPACT_PARENT_PTR]);
+        while (node) {
+            hdr_type h = hdr_type::from_node(node);
+            const uint8_t* nsk = hdr_type::get_skip(node, h);
+            if (nb == EOS_PARENT_BYTE) [[unlikely]]
+                fs.prepend(nsk, h.skip_bytes());
+            else
+                fs.prepend(nsk, h.skip_bytes(), static_cast<uint8_t>(nb));
+            nb   = bitmask_type::get_parent_byte(node);
+            node = parent_of(base, node[NODE_PARENT_PTR]);
+        }
+
+        out.clear();
+        impl_type::append_unmapped(out, reinterpret_cast<const uint8_t*>(fs.buf_pv),
+                                   static_cast<uint32_t>(fs.len_v));
+        delete[] fs.buf_pv;
+    }
+
+    static VALUE value_at(const pos_t& p) noexcept {
+        hdr_type h = hdr_type::from_node(p.leaf);
+        return *slots_type::load_value(h.get_compact_slots(p.leaf), p.pos);
+    }
+
+    // ==================================================================
+    // Prefix count / walk — prefix_count_impl / prefix_walk_impl over offsets
+    // ==================================================================
+
+    static size_t count_subtree(const uint64_t* base, const uint64_t* node) noexcept {
+        if (node == compact_type::sentinel()) return 0;
+        hdr_type h = hdr_type::from_node(node);
+        if (h.is_compact()) return h.count;
+        size_t n = 0;
+        for (uint16_t i = 0; i <= h.count; ++i)   // children + EOS
+            n += count_subtree(base, child_by_slot(base, node, i));
+        return n;
+    }
+
+    // Entry i of a compact node matches the remaining prefix rem[0..rlen).
+    static bool entry_matches(const uint64_t* node, const hdr_type& h, uint16_t i,
+                              tail_reader& tr, const uint8_t* rem, uint32_t rlen) noexcept {
+        const uint8_t* L = compact_type::lengths(node, h);
+        if (L[i] < rlen) return false;
+        if (compact_type::firsts(node, h)[i] != rem[0]) return false;
+        return rlen <= 1 || std::memcmp(tr.tail(i), rem + 1, rlen - 1) == 0;
+    }
+
+    // Descend to the node owning every key with the given mapped prefix.
+    // On success node is that subtree, and rem/rlen is what is left of
+    // the prefix inside a compact leaf (rlen == 0 when the whole subtree
+    // matches).  extra receives skip bytes consumed past the prefix.
+    struct prefix_hit_t {
+        const uint64_t* node = nullptr;
+        const uint8_t*  rem  = nullptr;
+        uint32_t        rlen = 0;
+        const uint8_t*  extra = nullptr;
+        uint32_t        extra_len = 0;
+    };
+
+    static prefix_hit_t find_prefix(const uint64_t* base, const uint64_t* node,
+                                    const uint8_t* mapped, uint32_t len) noexcept {
+        uint32_t consumed = 0;
+        for (;;) {
+            if (node == compact_type::sentinel()) return {};
+            hdr_type h = hdr_type::from_node(node);
+            if (h.has_skip()) [[unlikely]] {
+                uint32_t sb = h.skip_bytes();
+                const uint8_t* skip = hdr_type::get_skip(node, h);
+                uint32_t remaining = len - consumed;
+                if (remaining <= sb) {
+                    if (std::memcmp(skip, mapped + consumed, remaining) != 0) return {};
+                    return {node, nullptr, 0, skip + remaining, sb - remaining};
+                }
+                if (std::memcmp(skip, mapped + consumed, sb) != 0) return {};
+                consumed += sb;
+            }
+            if (consumed >= len) return {node, nullptr, 0, nullptr, 0};
+            if (h.is_compact()) [[unlikely]]
+                return {node, mapped + consumed, len - consumed, nullptr, 0};
+            node = dispatch(base, node, mapped[consumed++]);
+        }
+    }
+
+    static size_t prefix_count(const uint64_t* base, const uint64_t* root,
+                               const uint8_t* mapped, uint32_t len) noexcept {
+        prefix_hit_t r = find_prefix(base, root, mapped, len);
+        if (!r.node) return 0;
+        if (r.rlen == 0) return count_subtree(base, r.node);
+        hdr_type h = hdr_type::from_node(r.node);
+        tail_reader tr(r.node, h);
+        size_t n = 0;
+        for (uint16_t i = 0; i < h.count; ++i)
+            n += entry_matches(r.node, h, i, tr, r.rem, r.rlen);
+        return n;
+    }
+
+    template <typename F>
+    static void walk_post_skip(const uint64_t* base, const uint64_t* node,
+                               const hdr_type& h, std::string& path, F& fn) {
+        if (h.is_compact()) {
+            const uint8_t* L  = compact_type::lengths(node, h);
+            const uint8_t* Fb = compact_type::firsts(node, h);
+            const auto*    sb = h.get_compact_slots(node);
+            tail_reader tr(node, h);
+            for (uint16_t i = 0; i < h.count; ++i) {
+                size_t eb = path.size();
+                if (L[i] > 0) [[likely]] {
+                    impl_type::append_unmapped(path, &Fb[i], 1);
+                    impl_type::append_unmapped(path, tr.tail(i), L[i] - 1u);
+                }
+                fn(std::string_view(path), *slots_type::load_value(sb, i));
+                path.resize(eb);
+            }
+            return;
+        }
+
+        walk_subtree(base, eos_child(base, node, h), path, fn);
+        const auto* bm = bitmask_type::get_bitmap(node, h);
+        int slot = 0;
+        for (int idx = bm->find_next_set(0); idx >= 0; idx = bm->find_next_set(idx + 1)) {
+            path.push_back(static_cast<char>(
+                CHARMAP::from_index(static_cast<uint8_t>(idx))));
+            walk_subtree(base, child_by_slot(base, node, slot++), path, fn);
+            path.pop_back();
+        }
+    }
+
+    template <typename F>
+    static void walk_subtree(const uint64_t* base, const uint64_t* node,
+                             std::string& path, F& fn) {
+        if (node == compact_type::sentinel()) return;
+        hdr_type h = hdr_type::from_node(node);
+        size_t eb = path.size();
+        if (h.has_skip()) [[unlikely]]
+            impl_type::append_unmapped(path, hdr_type::get_skip(node, h), h.skip_bytes());
+        walk_post_skip(base, node, h, path, fn);
+        path.resize(eb);
+    }
+
+    template <typename F>
+    static void prefix_walk(const uint64_t* base, const uint64_t* root,
+                            const uint8_t* mapped, uint32_t len,
+                            std::string_view original_prefix, F& fn) {
+        prefix_hit_t r = find_prefix(base, root, mapped, len);
+        if (!r.node) return;
+        std::string path(original_prefix);
+        hdr_type h = hdr_type::from_node(r.node);
+        if (len == 0) { walk_subtree(base, r.node, path, fn); return; }
+        if (r.rlen == 0) {
+            impl_type::append_unmapped(path, r.extra, r.extra_len);
+            walk_post_skip(base, r.node, h, path, fn);
+            return;
+        }
+        // Compact leaf: suffix[0..rlen) is already in path.
+        const uint8_t* L  = compact_type::lengths(r.node, h);
+        const auto*    sb = h.get_compact_slots(r.node);
+        tail_reader tr(r.node, h);
+        for (uint16_t i = 0; i < h.count; ++i) {
+            if (!entry_matches(r.node, h, i, tr, r.rem, r.rlen)) continue;
+            size_t eb = path.size();
+            uint32_t tail_len = L[i] - 1u;
+            uint32_t tail_skip = r.rlen - 1;
+            if (tail_len > tail_skip)
+                impl_type::append_unmapped(path, tr.tail(i) + tail_skip, tail_len - tail_skip);
+            fn(std::string_view(path), *slots_type::load_value(sb, i));
+            path.resize(eb);
+        }
+    }
+};
+
+// ============================================================================
+// image_file — read-only mapping of a whole file (mmap where available,
+// otherwise an owned heap copy).
+// ============================================================================
+
+class image_file {
+    const uint64_t*             data_v  = nullptr;
+    size_t                      bytes_v = 0;
+    std::unique_ptr<uint64_t[]> owned_v;
+
+    void unmap() noexcept {
+#if KSTRIE_IMAGE_MMAP
+        if (data_v && !owned_v)
+            ::munmap(const_cast<uint64_t*>(data_v), bytes_v);
+#endif
+        owned_v.reset();
+        data_v  = nullptr;
+        bytes_v = 0;
+    }
+
+public:
+    explicit image_file(const char* path) {
+#if KSTRIE_IMAGE_MMAP
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0) throw std::runtime_error(std::string("kstrie::map: cannot open ") + path);
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || st.st_size <= 0) {
+            ::close(fd);
+            throw std::runtime_error(std::string("kstrie::map: cannot stat ") + path);
+        }
+        bytes_v = static_cast<size_t>(st.st_size);
+        void* p = ::mmap(nullptr, bytes_v, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) throw std::runtime_error(std::string("kstrie::map: mmap failed ") + path);
+        data_v = static_cast<const uint64_t*>(p);
+#else
+        std::FILE* f = std::fopen(path, "rb");
+        if (!f) throw std::runtime_error(std::string("kstrie::map: cannot open ") + path);
+        std::fseek(f, 0, SEEK_END);
+        long n = std::ftell(f);
+        std::fseek(f, 0, SEEK_SET);
+        if (n <= 0) { std::fclose(f); throw std::runtime_error(std::string("kstrie::map: empty ") + path); }
+        bytes_v = static_cast<size_t>(n);
+        owned_v.reset(new uint64_t[div_ceil(bytes_v, U64_BYTES)]);
+        bool ok = std::fread(owned_v.get(), 1, bytes_v, f) == bytes_v;
+        std::fclose(f);
+        if (!ok) throw std::runtime_error(std::string("kstrie::map: read failed ") + path);
+        data_v = owned_v.get();
+#endif
+    }
+
+    ~image_file() { unmap(); }
+
+    image_file(const image_file&) = delete;
+    image_file& operator=(const image_file&) = delete;
+
+    image_file(image_file&& o) noexcept
+        : data_v(std::exchange(o.data_v, nullptr)),
+          bytes_v(std::exchange(o.bytes_v, 0)),
+          owned_v(std::move(o.owned_v)) {}
+
+    image_file& operator=(image_file&& o) noexcept {
+        if (this != &o) {
+            unmap();
+            data_v  = std::exchange(o.data_v, nullptr);
+            bytes_v = std::exchange(o.bytes_v, 0);
+            owned_v = std::move(o.owned_v);
+        }
+        return *this;
+    }
+
+    const uint64_t* data()  const noexcept { return data_v; }
+    size_t          bytes() const noexcept { return bytes_v; }
+};
+
+} // namespace gteitelbaum::kstrie_detail
+
+namespace gteitelbaum {
+
+// ============================================================================
+// kstrie_view<VALUE, CHARMAP>
+//
+// Read-only dictionary over an image written by kstrie::save().  find,
+// lower_bound, prefix queries and iteration run directly on the mapped
+// words — nothing is copied or rebuilt, and processes mapping the same
+// file share its page cache.  Move-only; iterators are valid while the
+// view lives.
+// ============================================================================
+
+template <typename VALUE,
+          typename CHARMAP = kstrie_detail::identity_char_map>
+class kstrie_view {
+    using IO    = kstrie_detail::image_ops<VALUE, CHARMAP>;
+    using pos_t = typename IO::pos_t;
+
+    kstrie_detail::image_file file_v;
+    const uint64_t*           base_v = nullptr;
+    const uint64_t*           root_v = nullptr;
+    size_t                    size_v = 0;
+
+    void validate() {
+        using namespace kstrie_detail;
+        if (file_v.bytes() < sizeof(image_header_t))
+            throw std::runtime_error("kstrie::map: file too small");
+        image_header_t h;
+        std::memcpy(&h, file_v.data(), sizeof(h));
+        if (h.magic != IMAGE_MAGIC || h.version == 0 || h.version > IMAGE_VERSION)
+            throw std::runtime_error("kstrie::map: not a kstrie image");
+        uint8_t want_flags = IO::slots_type::IS_BITMAP ? IMAGE_FLAG_BOOL : 0;
+        if (h.value_bytes != sizeof(VALUE) || h.flags != want_flags)
+            throw std::runtime_error("kstrie::map: value type mismatch");
+        if (h.bitmap_words != CHARMAP::BITMAP_WORDS ||
+            h.charmap_hash != charmap_fingerprint<CHARMAP>())
+            throw std::runtime_error("kstrie::map: char map mismatch");
+        if (h.total_bytes != file_v.bytes() || h.root >= h.total_bytes ||
+            h.root % U64_BYTES != 0)
+            throw std::runtime_error("kstrie::map: corrupt header");
+        base_v = file_v.data();
+        root_v = IO::node_at(base_v, h.root);
+        size_v = static_cast<size_t>(h.size);
+    }
+
+    template <typename Fn>
+    static decltype(auto) with_mapped(std::string_view key, Fn&& fn) {
+        kstrie_detail::mapped_key<CHARMAP> mk(
+            reinterpret_cast<const uint8_t*>(key.data()),
+            static_cast<uint32_t>(key.size()));
+        return fn(mk.data, static_cast<uint32_t>(key.size()));
+    }
+
+public:
+    using key_type    = std::string;
+    using mapped_type = VALUE;
+    using value_type  = std::pair<std::string, VALUE>;
+    using size_type   = std::size_t;
+
+    explicit kstrie_view(const std::string& path) : file_v(path.c_str()) { validate(); }
+
+    kstrie_view(kstrie_view&&) noexcept = default;
+    kstrie_view& operator=(kstrie_view&&) noexcept = default;
+
+    // ==================================================================
+    // Iterator — forward, read-only; key rebuilt on demand
+    // ==================================================================
+
+    class iterator {
+        friend class kstrie_view;
+        const uint64_t* base_v = nullptr;
+        pos_t           pos_v{};
+
+        iterator(const uint64_t* base, pos_t p) noexcept : base_v(base), pos_v(p) {}
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = std::pair<std::string, VALUE>;
+        using difference_type   = std::ptrdiff_t;
+        using reference         = std::pair<std::string, VALUE>;
+
+        iterator() = default;
+
+        std::string key() const {
+            std::string k;
+            IO::key_at(base_v, pos_v, k);
+            return k;
+        }
+        VALUE value() const noexcept { return IO::value_at(pos_v); }
+
+        reference operator*() const { return {key(), value()}; }
+
+        iterator& operator++() noexcept {
+            IO::advance(base_v, pos_v);
+            return *this;
+        }
+        iterator operator++(int) noexcept { auto t = *this; ++*this; return t; }
+
+        bool operator==(const iterator& o) const noexcept {
+            return pos_v.leaf == o.pos_v.leaf && (!pos_v.leaf || pos_v.pos == o.pos_v.pos);
+        }
+        bool operator!=(const iterator& o) const noexcept { return !(*this == o); }
+    };
+    using const_iterator = iterator;
+
+    // ==================================================================
+    // Capacity
+    // ==================================================================
+
+    [[nodiscard]] size_type size()  const noexcept { return size_v; }
+    [[nodiscard]] bool      empty() const noexcept { return size_v == 0; }
+    [[nodiscard]] size_type image_bytes() const noexcept { return file_v.bytes(); }
+
+    // ==================================================================
+    // Lookup
+    // ==================================================================
+
+    iterator begin() const noexcept {
+        if (root_v == IO::compact_type::sentinel()) return end();
+        return iterator(base_v, IO::first(base_v, root_v));
+    }
+    iterator end() const noexcept { return iterator(base_v, pos_t{}); }
+
+    iterator find(std::string_view key) const noexcept {
+        return with_mapped(key, [&](const uint8_t* m, uint32_t n) {
+            return iterator(base_v, IO::find(base_v, root_v, m, n));
+        });
+    }
+
+    bool contains(std::string_view key) const noexcept { return find(key) != end(); }
+    size_type count(std::string_view key) const noexcept { return contains(key); }
+
+    std::optional<VALUE> find_value(std::string_view key) const noexcept {
+        iterator it = find(key);
+        if (it == end()) return std::nullopt;
+        return it.value();
+    }
+
+    VALUE at(std::string_view key) const {
+        iterator it = find(key);
+        if (it == end()) throw std::out_of_range("kstrie_view::at");
+        return it.value();
+    }
+
+    // ==================================================================
+    // Ordered lookup
+    // ==================================================================
+
+    iterator lower_bound(std::string_view key) const noexcept {
+        return with_mapped(key, [&](const uint8_t* m, uint32_t n) {
+            return iterator(base_v, IO::lower_bound(base_v, root_v, m, n, 0));
+        });
+    }
+
+    // First key > key: lower_bound of key + one zero byte in mapped space.
+    iterator upper_bound(std::string_view key) const {
+        return with_mapped(key, [&](const uint8_t* m, uint32_t n) {
+            std::string succ(reinterpret_cast<const char*>(m), n);
+            succ.push_back('\0');
+            return iterator(base_v, IO::lower_bound(
+                base_v, root_v, reinterpret_cast<const uint8_t*>(succ.data()), n + 1, 0));
+        });
+    }
+
+    // [first, last) of keys starting with pfx.  last is lower_bound of
+    // the mapped prefix incremented at its last non-0xFF byte.
+    std::pair<iterator, iterator> prefix(std::string_view pfx) const {
+        return with_mapped(pfx, [&](const uint8_t* m, uint32_t n) {
+            iterator first(base_v, IO::lower_bound(base_v, root_v, m, n, 0));
+            std::string succ(reinterpret_cast<const char*>(m), n);
+            while (!succ.empty() && static_cast<uint8_t>(succ.back()) == 0xFF)
+                succ.pop_back();
+            if (succ.empty()) return std::pair{first, end()};
+            succ.back() = static_cast<char>(static_cast<uint8_t>(succ.back()) + 1);
+            iterator last(base_v, IO::lower_bound(
+                base_v, root_v, reinterpret_cast<const uint8_t*>(succ.data()),
+                static_cast<uint32_t>(succ.size()), 0));
+            return std::pair{first, last};
+        });
+    }
+
+    size_type prefix_count(std::string_view pfx) const noexcept {
+        if (pfx.empty()) return size_v;
+        return with_mapped(pfx, [&](const uint8_t* m, uint32_t n) {
+            return IO::prefix_count(base_v, root_v, m, n);
+        });
+    }
+
+    // fn(std::string_view key, const VALUE& value) in key order.
+    template <typename F>
+    void prefix_walk(std::string_view pfx, F&& fn) const {
+        with_mapped(pfx, [&](const uint8_t* m, uint32_t n) {
+            IO::prefix_walk(base_v, root_v, m, n, pfx, fn);
+        });
+    }
+};
+
+} // namespace gteitelbaum
+
+#endif // KSTRIE_IMAGE_HPP
@@ -4,10 +4,18 @@
 #include "kstrie_bitmask.hpp"
 #include "kstrie_compact.hpp"
 #include "kstrie_support.hpp"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <iterator>
 #include <limits>
 #include <memory>
+#include <optional>
+#include <stdexcept>
 #include <string>
 #include <string_view>
+#include <thread>
+#include <vector>
 
 namespace gteitelbaum::kstrie_detail {
 
@@ -44,6 +52,8 @@ private:
     uint64_t* root_v = compact_type::sentinel();
     size_type size_v{};
     mem_type  mem_v{};
+    compact_walk_t compact_v{};     // resume point of an unfinished compact()
+    std::shared_ptr<cow_table> cow_v;  // owners of nodes shared with snapshots
 
     void init_empty_root() {
         root_v = compact_type::sentinel();
@@ -65,6 +75,7 @@ private:
 
     void destroy_tree(uint64_t* node) {
         if (!node || node == compact_type::sentinel()) return;
+        if (cow_live() && cow_v->drop(node)) return;   // a snapshot still owns it
         hdr_type h = hdr_type::from_node(node);
         if (h.is_compact()) {
             auto* vb = h.get_compact_slots(node);
@@ -176,6 +187,33 @@ private:
         return {node, N};
     }
 
+    // ------------------------------------------------------------------
+    // walk_compact — emit compact entries [i0, i1) in order; path holds
+    // the key up to this node's suffixes and is restored after each one.
+    // ------------------------------------------------------------------
+
+    template<typename F>
+    void walk_compact(const uint64_t* node, const hdr_type& h,
+                      int i0, int i1, std::string& path, F&& fn) const {
+        const uint8_t* L  = compact_type::lengths(node, h);
+        const uint8_t* Fb = compact_type::firsts(node, h);
+        const ks_offset_type* O = compact_type::offsets(node, h);
+        const uint8_t* B  = compact_type::keysuffix(node, h);
+        const auto*    sb = h.get_compact_slots(node);
+        for (int i = i0; i < i1; ++i) {
+            size_t eb = path.size();
+            uint8_t klen = L[i];
+            if (klen > 0) [[likely]] {
+                append_unmapped(path, &Fb[i], 1);
+                if (klen > 1) [[likely]]
+                    append_unmapped(path, B + O[i], klen - 1);
+            }
+            fn(std::string_view(path),
+               *slots_type::load_value(sb, i));
+            path.resize(eb);
+        }
+    }
+
     // ------------------------------------------------------------------
     // prefix_walk_subtree — recursive walk, reconstructs keys
     // ------------------------------------------------------------------
@@ -187,23 +225,7 @@ private:
     void walk_node_post_skip(const uint64_t* node, const hdr_type& h,
                              std::string& path, F&& fn) const {
         if (h.is_compact()) {
-            const uint8_t* L  = compact_type::lengths(node, h);
-            const uint8_t* Fb = compact_type::firsts(node, h);
-            const ks_offset_type* O = compact_type::offsets(node, h);
-            const uint8_t* B  = compact_type::keysuffix(node, h);
-            const auto*    sb = h.get_compact_slots(node);
-            for (uint16_t i = 0; i < h.count; ++i) {
-                size_t eb = path.size();
-                uint8_t klen = L[i];
-                if (klen > 0) [[likely]] {
-                    append_unmapped(path, &Fb[i], 1);
-                    if (klen > 1) [[likely]]
-                        append_unmapped(path, B + O[i], klen - 1);
-                }
-                fn(std::string_view(path),
-                   *slots_type::load_value(sb, i));
-                path.resize(eb);
-            }
+            walk_compact(node, h, 0, h.count, path, fn);
             return;
         }
 
@@ -241,6 +263,474 @@ private:
         path.resize(base);
     }
 
+    // ------------------------------------------------------------------
+    // walk_range — emit the entries of node's subtree in [lo, hi), with
+    // d mapped key bytes consumed above node.  lo_tight: the path so far
+    // equals lo[0..d) and lo is longer, so smaller branches are skipped;
+    // hi_tight likewise for hi, where reaching hi ends the walk.  Compact
+    // bounds come from find_pos, bitmask bounds from the child bitmap,
+    // so no per-entry comparison runs and path is only appended/trimmed
+    // at the bytes that differ between consecutive keys.
+    // Returns true once the walk has reached hi.
+    // ------------------------------------------------------------------
+
+    struct range_keys {
+        const uint8_t* lo;
+        uint32_t       lo_len;
+        const uint8_t* hi;
+        uint32_t       hi_len;
+    };
+
+    template<typename F>
+    bool walk_range(const uint64_t* node, uint32_t d, bool lo_tight, bool hi_tight,
+                    const range_keys& rk, std::string& path, F& fn) const {
+        if (node == compact_type::sentinel()) return false;
+        hdr_type h = hdr_type::from_node(node);
+        size_t base = path.size();
+
+        if (h.has_skip()) [[unlikely]] {
+            uint32_t sb = h.skip_bytes();
+            const uint8_t* skip = hdr_type::get_skip(node, h);
+            if (lo_tight) {
+                uint32_t rem = rk.lo_len - d;
+                int c = std::memcmp(skip, rk.lo + d, std::min(sb, rem));
+                if (c < 0) return false;
+                if (c > 0 || rem <= sb) lo_tight = false;
+            }
+            if (hi_tight) {
+                uint32_t rem = rk.hi_len - d;
+                int c = std::memcmp(skip, rk.hi + d, std::min(sb, rem));
+                if (c > 0 || (c == 0 && rem <= sb)) return true;
+                if (c < 0) hi_tight = false;
+            }
+            append_unmapped(path, skip, sb);
+            d += sb;
+        }
+
+        bool is_done = false;
+        if (h.is_compact()) {
+            int i0 = 0, i1 = h.count;
+            if (lo_tight)
+                i0 = compact_type::find_pos(node, h, rk.lo + d, rk.lo_len - d).pos;
+            if (hi_tight) {
+                i1 = compact_type::find_pos(node, h, rk.hi + d, rk.hi_len - d).pos;
+                is_done = i1 < h.count;
+            }
+            walk_compact(node, h, i0, i1, path, fn);
+            path.resize(base);
+            return is_done;
+        }
+
+        // EOS key is the path itself: below lo when lo_tight, below hi
+        // whenever hi_tight (hi is longer).
+        if (!lo_tight)
+            is_done = walk_range(bitmask_type::eos_child(node, h), d,
+                                 false, hi_tight, rk, path, fn);
+
+        const auto* bm = bitmask_type::get_bitmap(node, h);
+        int idx = bm->find_next_set(lo_tight ? rk.lo[d] : 0);
+        int slot = idx >= 0 ? bm->count_below(static_cast<uint8_t>(idx)) - 1 : 0;
+        for (; idx >= 0 && !is_done; idx = bm->find_next_set(idx + 1), ++slot) {
+            uint8_t b = static_cast<uint8_t>(idx);
+            bool child_lo = lo_tight && b == rk.lo[d] && d + 1 < rk.lo_len;
+            bool child_hi = false;
+            if (hi_tight) {
+                if (b > rk.hi[d] || (b == rk.hi[d] && d + 1 == rk.hi_len)) {
+                    is_done = true;
+                    break;
+                }
+                child_hi = (b == rk.hi[d]);
+            }
+            path.push_back(static_cast<char>(CHARMAP::from_index(b)));
+            is_done = walk_range(bitmask_type::child_by_slot(node, h,
+                                     static_cast<uint16_t>(slot)),
+                                 d + 1, child_lo, child_hi, rk, path, fn);
+            path.pop_back();
+        }
+        path.resize(base);
+        return is_done;
+    }
+
+    // ------------------------------------------------------------------
+    // join_walk — lockstep set-algebra join of two subtrees in key order.
+    //
+    // A join_cursor is a subtree whose first `off` skip bytes are already
+    // on the path.  Two bitmask cursors consume their shared skip bytes,
+    // join their EOS children, then dispatch together over the AND of their
+    // child bitmaps (only matched keys kept: KEEP_AB) or the OR / one
+    // side (a side's unmatched keys kept: KEEP_A / KEEP_B), so a subtree
+    // present on one side only is skipped, or walked whole when kept.  A
+    // cursor still inside its skip acts as a bitmask with that single
+    // child byte.
+    // A compact cursor merges linearly with a compact partner, merges
+    // against a walk of a kept partner, or else probes each entry into
+    // the partner.  out(pre, pre_len, suf, suf_len, a, b) receives every
+    // emitted key as pre+suf, ascending, with a null value for the side
+    // that lacks it.
+    // ------------------------------------------------------------------
+
+    struct join_cursor {
+        const uint64_t* node;
+        uint32_t        off;
+    };
+
+    static constexpr uint32_t JOIN_KEY_MAX = hdr_type::SKIP_MAX + COMPACT_SUFFIX_LEN_MAX;
+
+    static uint32_t join_skip_left(const join_cursor& c, const hdr_type& h) noexcept {
+        return h.has_skip() ? h.skip_bytes() - c.off : 0;
+    }
+
+    // Key of compact entry i relative to the cursor: skip rest + suffix.
+    static uint32_t join_entry_key(const join_cursor& c, const hdr_type& h,
+                                   int i, uint8_t* buf) noexcept {
+        uint32_t n = join_skip_left(c, h);
+        if (n) std::memcpy(buf, hdr_type::get_skip(c.node, h) + c.off, n);
+        uint8_t klen = compact_type::lengths(c.node, h)[i];
+        if (klen > 0) {
+            buf[n] = compact_type::firsts(c.node, h)[i];
+            if (klen > 1)
+                std::memcpy(buf + n + 1, compact_type::keysuffix(c.node, h)
+                                       + compact_type::offsets(c.node, h)[i], klen - 1);
+        }
+        return n + klen;
+    }
+
+    static int join_cmp(const uint8_t* a, uint32_t al,
+                        const uint8_t* b, uint32_t bl) noexcept {
+        uint32_t ml = std::min(al, bl);
+        int c = ml ? std::memcmp(a, b, ml) : 0;
+        return c ? c : makecmp(al, bl);
+    }
+
+    // Point lookup of key (relative to the cursor) below c.
+    static const VALUE* join_find(join_cursor c, const uint8_t* key, uint32_t len) noexcept {
+        if (c.node == compact_type::sentinel()) return nullptr;
+        const uint64_t* node = c.node;
+        hdr_type h = hdr_type::from_node(node);
+        uint32_t n = join_skip_left(c, h);
+        for (;;) {
+            if (n) {
+                if (len < n || std::memcmp(hdr_type::get_skip(node, h) + c.off, key, n) != 0)
+                    return nullptr;
+                key += n;
+                len -= n;
+            }
+            if (h.is_compact()) return compact_type::find(node, h, key, len);
+            if (len == 0) {
+                node = bitmask_type::eos_child(node, h);
+            } else {
+                node = bitmask_type::dispatch(node, h, *key++);
+                --len;
+            }
+            if (node == compact_type::sentinel()) return nullptr;
+            h = hdr_type::from_node(node);
+            c.off = 0;
+            n = h.has_skip() ? h.skip_bytes() : 0;
+        }
+    }
+
+    // Every entry below c in order: fn(path, value), path = full key.
+    template<typename F>
+    void join_walk_all(join_cursor c, std::vector<uint8_t>& path, F& fn) const {
+        if (c.node == compact_type::sentinel()) return;
+        hdr_type h = hdr_type::from_node(c.node);
+        size_t base = path.size();
+        if (uint32_t n = join_skip_left(c, h)) {
+            const uint8_t* s = hdr_type::get_skip(c.node, h) + c.off;
+            path.insert(path.end(), s, s + n);
+        }
+        if (h.is_compact()) {
+            const uint8_t* L  = compact_type::lengths(c.node, h);
+            const uint8_t* Fb = compact_type::firsts(c.node, h);
+            const ks_offset_type* O = compact_type::offsets(c.node, h);
+            const uint8_t* B  = compact_type::keysuffix(c.node, h);
+            const auto*    sb = h.get_compact_slots(c.node);
+            size_t top = path.size();
+            for (int i = 0; i < h.count; ++i) {
+                path.resize(top);
+                if (L[i] > 0) {
+                    path.push_back(Fb[i]);
+                    path.insert(path.end(), B + O[i], B + O[i] + L[i] - 1);
+                }
+                fn(path, slots_type::load_value(sb, i));
+            }
+        } else {
+            join_walk_all({bitmask_type::eos_child(c.node, h), 0}, path, fn);
+            const auto* bm = bitmask_type::get_bitmap(c.node, h);
+            uint16_t slot = 0;
+            for (int idx = bm->find_next_set(0); idx >= 0; idx = bm->find_next_set(idx + 1)) {
+                path.push_back(static_cast<uint8_t>(idx));
+                join_walk_all({bitmask_type::child_by_slot(c.node, h, slot++), 0}, path, fn);
+                path.pop_back();
+            }
+        }
+        path.resize(base);
+    }
+
+    template<bool KEEP_AB, bool KEEP_A, bool KEEP_B, typename OUT>
+    void join_walk(join_cursor a, join_cursor b, std::vector<uint8_t>& path, OUT& out) const {
+        const uint64_t* S = compact_type::sentinel();
+        auto a_only = [&](const std::vector<uint8_t>& p, const VALUE* v) {
+            out(p.data(), p.size(), nullptr, 0, v, nullptr);
+        };
+        auto b_only = [&](const std::vector<uint8_t>& p, const VALUE* v) {
+            out(p.data(), p.size(), nullptr, 0, nullptr, v);
+        };
+        if (a.node == S) {
+            if constexpr (KEEP_B) join_walk_all(b, path, b_only);
+            return;
+        }
+        if (b.node == S) {
+            if constexpr (KEEP_A) join_walk_all(a, path, a_only);
+            return;
+        }
+
+        hdr_type ha = hdr_type::from_node(a.node);
+        hdr_type hb = hdr_type::from_node(b.node);
+        if (ha.is_compact()) {
+            join_compact<KEEP_AB, KEEP_A, KEEP_B, true>(a, ha, b, hb, path, out);
+            return;
+        }
+        if (hb.is_compact()) {
+            join_compact<KEEP_AB, KEEP_B, KEEP_A, false>(b, hb, a, ha, path, out);
+            return;
+        }
+
+        // Both bitmask: consume the skip bytes they share.
+        size_t base = path.size();
+        uint32_t ra = join_skip_left(a, ha), rb = join_skip_left(b, hb);
+        const uint8_t* sa = ra ? hdr_type::get_skip(a.node, ha) + a.off : nullptr;
+        const uint8_t* sb = rb ? hdr_type::get_skip(b.node, hb) + b.off : nullptr;
+        uint32_t m = std::min(ra, rb), i = 0;
+        while (i < m && sa[i] == sb[i]) ++i;
+        if (i) {
+            path.insert(path.end(), sa, sa + i);
+            a.off += i; b.off += i;
+            ra -= i;    rb -= i;
+            sa += i;    sb += i;
+        }
+        if (ra && rb) {
+            // Diverged inside both skips: disjoint subtrees, in byte order.
+            if (*sa < *sb) {
+                if constexpr (KEEP_A) join_walk_all(a, path, a_only);
+                if constexpr (KEEP_B) join_walk_all(b, path, b_only);
+            } else {
+                if constexpr (KEEP_B) join_walk_all(b, path, b_only);
+                if constexpr (KEEP_A) join_walk_all(a, path, a_only);
+            }
+            path.resize(base);
+            return;
+        }
+
+        // EOS keys equal the path; a cursor inside its skip has none.
+        join_walk<KEEP_AB, KEEP_A, KEEP_B>({ra ? S : bitmask_type::eos_child(a.node, ha), 0},
+                                  {rb ? S : bitmask_type::eos_child(b.node, hb), 0},
+                                  path, out);
+
+        using bitmap_type = typename bitmask_type::bitmap_type;
+        bitmap_type ma{}, mb{}, mm;
+        if (ra) ma.set_bit(*sa); else ma = *bitmask_type::get_bitmap(a.node, ha);
+        if (rb) mb.set_bit(*sb); else mb = *bitmask_type::get_bitmap(b.node, hb);
+        for (size_t w = 0; w < std::size(mm.words); ++w) {
+            if constexpr (KEEP_A && KEEP_B) mm.words[w] = ma.words[w] | mb.words[w];
+            else if constexpr (KEEP_A)      mm.words[w] = ma.words[w];
+            else if constexpr (KEEP_B)      mm.words[w] = mb.words[w];
+            else                            mm.words[w] = ma.words[w] & mb.words[w];
+        }
+        auto child = [&](const join_cursor& c, const hdr_type& h, uint32_t r,
+                         const bitmap_type& bm, uint8_t byte) -> join_cursor {
+            if (!bm.has_bit(byte)) return {S, 0};
+            if (r) return {c.node, c.off + 1};
+            return {bitmask_type::dispatch(c.node, h, byte), 0};
+        };
+        for (int idx = mm.find_next_set(0); idx >= 0; idx = mm.find_next_set(idx + 1)) {
+            uint8_t byte = static_cast<uint8_t>(idx);
+            path.push_back(byte);
+            join_walk<KEEP_AB, KEEP_A, KEEP_B>(child(a, ha, ra, ma, byte),
+                                      child(b, hb, rb, mb, byte), path, out);
+            path.pop_back();
+        }
+        path.resize(base);
+    }
+
+    // c is compact; x is any cursor.  KEEP_C / KEEP_X and C_IS_A map the
+    // two sides back onto out's (a, b) order.
+    template<bool KEEP_AB, bool KEEP_C, bool KEEP_X, bool C_IS_A, typename OUT>
+    void join_compact(join_cursor c, const hdr_type& hc,
+                      join_cursor x, const hdr_type& hx,
+                      std::vector<uint8_t>& path, OUT& out) const {
+        auto emit = [&](const uint8_t* pre, size_t pl, const uint8_t* suf, uint32_t sl,
+                        const VALUE* vc, const VALUE* vx) {
+            if constexpr (C_IS_A) out(pre, pl, suf, sl, vc, vx);
+            else                  out(pre, pl, suf, sl, vx, vc);
+        };
+        size_t base = path.size();
+        int nc = hc.count;
+        const auto* cs = hc.get_compact_slots(c.node);
+        uint8_t  ck[JOIN_KEY_MAX];
+        uint32_t cl = nc ? join_entry_key(c, hc, 0, ck) : 0;
+        int i = 0;
+        auto next_c = [&] { if (++i < nc) cl = join_entry_key(c, hc, i, ck); };
+
+        if (hx.is_compact()) {
+            int nx = hx.count, j = 0;
+            const auto* xs = hx.get_compact_slots(x.node);
+            uint8_t  xk[JOIN_KEY_MAX];
+            uint32_t xl = nx ? join_entry_key(x, hx, 0, xk) : 0;
+            while ((i < nc && (KEEP_C || j < nx)) || (j < nx && KEEP_X)) {
+                int r = i >= nc ? 1 : j >= nx ? -1 : join_cmp(ck, cl, xk, xl);
+                if (r < 0 ? KEEP_C : r == 0 && KEEP_AB)
+                    emit(path.data(), base, ck, cl, slots_type::load_value(cs, i),
+                         r == 0 ? slots_type::load_value(xs, j) : nullptr);
+                else if (r > 0 && KEEP_X)
+                    emit(path.data(), base, xk, xl, nullptr, slots_type::load_value(xs, j));
+                if (r <= 0) next_c();
+                if (r >= 0 && ++j < nx) xl = join_entry_key(x, hx, j, xk);
+            }
+        } else if constexpr (KEEP_X) {
+            auto fn = [&](const std::vector<uint8_t>& p, const VALUE* vx) {
+                const uint8_t* xk = p.data() + base;
+                uint32_t xl = static_cast<uint32_t>(p.size() - base);
+                int r = 1;
+                while (i < nc && (r = join_cmp(ck, cl, xk, xl)) < 0) {
+                    if constexpr (KEEP_C)
+                        emit(p.data(), base, ck, cl, slots_type::load_value(cs, i), nullptr);
+                    next_c();
+                }
+                if (i < nc && r == 0) {
+                    if constexpr (KEEP_AB)
+                        emit(p.data(), p.size(), nullptr, 0, slots_type::load_value(cs, i), vx);
+                    next_c();
+                } else {
+                    emit(p.data(), p.size(), nullptr, 0, nullptr, vx);
+                }
+            };
+            join_walk_all(x, path, fn);
+            if constexpr (KEEP_C)
+                for (; i < nc; next_c())
+                    emit(path.data(), base, ck, cl, slots_type::load_value(cs, i), nullptr);
+        } else {
+            for (; i < nc; next_c()) {
+                const VALUE* vx = join_find(x, ck, cl);
+                if (vx ? KEEP_AB : KEEP_C)
+                    emit(path.data(), base, ck, cl, slots_type::load_value(cs, i), vx);
+            }
+        }
+    }
+
+    // ------------------------------------------------------------------
+    // fuzzy_walk — Levenshtein traversal.  rows holds one DP row per
+    // mapped key depth (row d = distances of query prefixes to the
+    // first d key bytes); descending one byte computes row d+1 from row
+    // d, and a subtree is pruned as soon as its row minimum exceeds
+    // max_edits.  Bitmask nodes only visit present children; compact
+    // entries are sorted, so each reuses the rows of the bytes it
+    // shares with the previous entry.
+    // ------------------------------------------------------------------
+
+    struct fuzzy_state {
+        const uint8_t*        query;
+        uint32_t              qlen;
+        uint32_t              max_edits;
+        std::vector<uint32_t> rows;
+        std::string           path;
+    };
+
+    // Compute row d+1 for key byte c; returns its minimum.
+    static uint32_t fuzzy_step(fuzzy_state& st, uint32_t d, uint8_t c) {
+        size_t w = st.qlen + 1;
+        if (st.rows.size() < (d + 2) * w) st.rows.resize((d + 2) * w * 2);
+        const uint32_t* p = st.rows.data() + d * w;
+        uint32_t*       r = st.rows.data() + (d + 1) * w;
+        r[0] = p[0] + 1;
+        uint32_t mn = r[0];
+        for (uint32_t j = 1; j <= st.qlen; ++j) {
+            uint32_t v = p[j - 1] + (st.query[j - 1] != c);
+            v = std::min(v, p[j] + 1);
+            v = std::min(v, r[j - 1] + 1);
+            r[j] = v;
+            mn = std::min(mn, v);
+        }
+        return mn;
+    }
+
+    static uint32_t fuzzy_dist(const fuzzy_state& st, uint32_t d) noexcept {
+        return st.rows[d * (st.qlen + 1) + st.qlen];
+    }
+
+    template<typename F>
+    void fuzzy_walk(const uint64_t* node, uint32_t d, fuzzy_state& st, F& fn) const {
+        if (node == compact_type::sentinel()) return;
+        hdr_type h = hdr_type::from_node(node);
+        size_t base = st.path.size();
+
+        if (h.has_skip()) [[unlikely]] {
+            uint32_t sb = h.skip_bytes();
+            const uint8_t* skip = hdr_type::get_skip(node, h);
+            for (uint32_t j = 0; j < sb; ++j)
+                if (fuzzy_step(st, d + j, skip[j]) > st.max_edits) return;
+            append_unmapped(st.path, skip, sb);
+            d += sb;
+        }
+
+        if (h.is_compact()) {
+            const uint8_t* L  = compact_type::lengths(node, h);
+            const uint8_t* Fb = compact_type::firsts(node, h);
+            const ks_offset_type* O = compact_type::offsets(node, h);
+            const uint8_t* B  = compact_type::keysuffix(node, h);
+            const auto*    sv = h.get_compact_slots(node);
+            auto byte_at = [&](int i, uint32_t j) {
+                return j == 0 ? Fb[i] : B[O[i] + j - 1];
+            };
+            int      prev = -1;
+            uint32_t have = 0;          // rows valid for prev's first `have` bytes
+            bool     is_cut = false;    // prev's last valid row exceeded max_edits
+            for (int i = 0; i < h.count; ++i) {
+                uint32_t klen = L[i];
+                uint32_t j = 0;
+                uint32_t lim = std::min(have, klen);
+                while (j < lim && byte_at(i, j) == byte_at(prev, j)) ++j;
+                bool is_pruned = is_cut && j == have;
+                for (; j < klen && !is_pruned; ++j) {
+                    if (fuzzy_step(st, d + j, byte_at(i, j)) > st.max_edits) {
+                        ++j;
+                        is_pruned = true;
+                        break;
+                    }
+                }
+                prev   = i;
+                have   = j;
+                is_cut = is_pruned;
+                if (is_pruned) continue;
+                uint32_t dist = fuzzy_dist(st, d + klen);
+                if (dist > st.max_edits) continue;
+                size_t eb = st.path.size();
+                if (klen > 0) {
+                    append_unmapped(st.path, &Fb[i], 1);
+                    if (klen > 1) append_unmapped(st.path, B + O[i], klen - 1);
+                }
+                fn(std::string_view(st.path), *slots_type::load_value(sv, i), dist);
+                st.path.resize(eb);
+            }
+            st.path.resize(base);
+            return;
+        }
+
+        fuzzy_walk(bitmask_type::eos_child(node, h), d, st, fn);
+        const auto* bm = bitmask_type::get_bitmap(node, h);
+        int slot = 0;
+        for (int idx = bm->find_next_set(0); idx >= 0;
+             idx = bm->find_next_set(idx + 1), ++slot) {
+            uint8_t b = static_cast<uint8_t>(idx);
+            if (fuzzy_step(st, d, b) > st.max_edits) continue;
+            st.path.push_back(static_cast<char>(CHARMAP::from_index(b)));
+            fuzzy_walk(bitmask_type::child_by_slot(node, h, static_cast<uint16_t>(slot)),
+                       d + 1, st, fn);
+            st.path.pop_back();
+        }
+        st.path.resize(base);
+    }
+
     // ------------------------------------------------------------------
     // prefix_walk_filtered — compact entries matching remaining prefix
     // ------------------------------------------------------------------
@@ -628,14 +1118,22 @@ private:
         const uint64_t* node = root_v;
         uint32_t consumed = 0;
         hdr_type h;
+        [[maybe_unused]] unsigned levels = 0;
 
         for (;;) {
             h = hdr_type::from_node(node);
             if (h.has_skip()) [[unlikely]] {
                 if (!skip_type::match_skip_unchecked(node, h, mapped, key_len, consumed))
-                    [[unlikely]] return nullptr;
+                    [[unlikely]] {
+                    if constexpr (INSTRUMENT) {
+                        stat_add(stat_t::SKIP_MISMATCH);
+                        stat_find_depth(levels);
+                    }
+                    return nullptr;
+                }
             }
             if (!h.is_bitmap()) [[unlikely]] break;
+            if constexpr (INSTRUMENT) ++levels;
             if (consumed == key_len) [[unlikely]] {
                 node = bitmask_type::eos_child(node, h);
                 h = hdr_type::from_node(node);
@@ -643,6 +1141,10 @@ private:
             }
             node = bitmask_type::dispatch(node, h, mapped[consumed++]);
         }
+        if constexpr (INSTRUMENT) {
+            stat_find_depth(levels);
+            stat_compact_hit(h.count ? compact_type::get_prefix(node, h).keysuffix_used : 0);
+        }
         // Cold path: compact leaf node
         return compact_type::find(node, h, mapped + consumed, key_len - consumed);
     }
@@ -667,10 +1169,12 @@ public:
     // ------------------------------------------------------------------
 
     kstrie_impl() { init_empty_root(); }
+    explicit kstrie_impl(const ALLOC& a) : mem_v(a) { init_empty_root(); }
     ~kstrie_impl() { if (root_v) destroy_tree(root_v); }
 
     kstrie_impl(kstrie_impl&& o) noexcept
-        : root_v(o.root_v), size_v(o.size_v), mem_v(std::move(o.mem_v)) {
+        : root_v(o.root_v), size_v(o.size_v), mem_v(std::move(o.mem_v)),
+          compact_v(std::move(o.compact_v)), cow_v(std::move(o.cow_v)) {
         o.root_v = compact_type::sentinel();
         o.size_v = 0;
     }
@@ -681,6 +1185,8 @@ public:
             root_v = o.root_v;
             size_v = o.size_v;
             mem_v  = std::move(o.mem_v);
+            compact_v = std::move(o.compact_v);
+            cow_v  = std::move(o.cow_v);
             o.root_v = compact_type::sentinel();
             o.size_v = 0;
         }
@@ -741,7 +1247,235 @@ private:
         return copy;
     }
 
+    // ------------------------------------------------------------------
+    // compact_walk — pre-order relocation for compact().
+    //
+    // Each node due for moving is copied word-for-word into an allocation
+    // sized by node_size() (the size class a fresh build would pick) and
+    // the old block is freed.  A compact node keeps its array cap, so its
+    // value slots are sized for cap entries, not count.  Values move bitwise: inline slots are
+    // trivially copyable, the rest are pointers.  A bitmask relinks its
+    // children before they are visited, so each child's copied parent
+    // pointer is already current.  Returns the (possibly new) node.
+    // ------------------------------------------------------------------
+
+    uint64_t* compact_walk(uint64_t* node, std::string& path, bool eos,
+                           compact_walk_t& w) {
+        if (!node || node == compact_type::sentinel()) return node;
+        if (cow_live() && cow_v->is_shared(node)) return node;   // not ours to move
+
+        bool move = true;
+        if (w.has_lo) {
+            size_t n = std::min(path.size(), w.lo.size());
+            int c = std::memcmp(path.data(), w.lo.data(), n);
+            if (c < 0) return node;                       // wholly before lo
+            if (c == 0 && path.size() < w.lo.size())
+                move = false;                             // ancestor of lo
+            else if (c == 0 && path.size() == w.lo.size() && w.lo_eos && !eos)
+                move = false;                             // owns lo's EOS leaf
+        }
+        if (move) {
+            if (w.budget == 0) {
+                w.stopped = true;
+                w.has_lo  = true;
+                w.lo      = path;
+                w.lo_eos  = eos;
+                return node;
+            }
+            --w.budget;
+            w.has_lo = false;                             // everything after is due
+            hdr_type h = hdr_type::from_node(node);
+            size_t nu = h.is_compact()
+                ? h.slots_off + slots_type::value_u64s(
+                      compact_type::get_prefix(node, h).cap)
+                : h.node_size() / U64_BYTES;
+            uint64_t* nn = mem_v.alloc_node(nu);
+            uint16_t au = hdr_type::from_node(nn).alloc_u64;
+            std::memcpy(nn, node, nu * U64_BYTES);
+            hdr_type::from_node(nn).alloc_u64 = au;
+            if (h.is_bitmap()) bitmask_type::link_all_children(nn);
+            mem_v.free_node(node);
+            node = nn;
+        }
+
+        hdr_type h = hdr_type::from_node(node);
+        if (h.is_compact()) return node;
+
+        size_t base = path.size();
+        if (h.has_skip())
+            path.append(reinterpret_cast<const char*>(
+                bitmask_type::get_bitmask_skip(node, h)), h.skip_bytes());
+
+        uint64_t* old_eos = bitmask_type::eos_child(node, h);
+        uint64_t* new_eos = compact_walk(old_eos, path, true, w);
+        if (new_eos != old_eos) bitmask_type::set_eos_child(node, h, new_eos);
+
+        const auto* bm = bitmask_type::get_bitmap(node, h);
+        uint64_t* cs = bitmask_type::child_slots(node);
+        int bit = -1;
+        for (uint16_t i = 0; i < h.count && !w.stopped; ++i) {
+            bit = bm->find_next_set(bit + 1);
+            path.push_back(static_cast<char>(bit));
+            uint64_t* child = slots_type::load_child(cs, i);
+            uint64_t* nc = compact_walk(child, path, false, w);
+            if (nc != child) slots_type::store_child(cs, i, nc);
+            path.pop_back();
+        }
+        path.resize(base);
+        return node;
+    }
+
+    // ------------------------------------------------------------------
+    // Copy-on-write — see snapshot().  A node is writable when it and
+    // every node above it have one owner.  Writers make their key's path
+    // writable top-down with unshare_path; nodes off the path are never
+    // stored into, except for the parent links of a copied bitmask's
+    // children, which snapshot reads do not follow.
+    // ------------------------------------------------------------------
+
+    [[nodiscard]] bool cow_live() const noexcept { return cow_v && cow_v->any(); }
+
+    // Replace a shared node by a private copy: values are copied, children
+    // gain the copy as an owner.  The original loses this trie as owner.
+    uint64_t* unshare_node(uint64_t* node) {
+        hdr_type h = hdr_type::from_node(node);
+        size_t nu = h.alloc_u64;
+        uint64_t* copy = mem_v.alloc_node(nu);
+        std::memcpy(copy, node, nu * U64_BYTES);
+        if (h.is_compact()) {
+            if constexpr (!slots_type::IS_INLINE && !slots_type::IS_BITMAP) {
+                auto* sb = hdr_type::from_node(copy).get_compact_slots(copy);
+                for (uint16_t i = 0; i < h.count; ++i) {
+                    const VALUE* vp = slots_type::load_value(
+                        h.get_compact_slots(node), i);
+                    sb[i] = {};
+                    slots_type::store_value(sb, i, *vp, mem_v.alloc_v);
+                }
+            }
+        } else {
+            const uint64_t* cs = bitmask_type::child_slots(node);
+            for (uint16_t i = 0; i < h.count; ++i)
+                cow_v->share(slots_type::load_child(cs, i));
+            uint64_t* eos = bitmask_type::eos_child(node, h);
+            if (eos != compact_type::sentinel()) cow_v->share(eos);
+            bitmask_type::link_all_children(copy);
+        }
+        destroy_tree(node);
+        return copy;
+    }
+
+    // Put a copy where its original hung: under parent at pbyte, or root.
+    void relink(uint64_t* parent, uint16_t pbyte, uint64_t* copy) {
+        if (!parent)
+            set_root(copy);
+        else if (pbyte == EOS_PARENT_BYTE)
+            bitmask_type::set_eos_child(parent, hdr_type::from_node(parent), copy);
+        else
+            bitmask_type::replace_child(parent, hdr_type::from_node(parent),
+                                        static_cast<uint8_t>(pbyte), copy);
+    }
+
+    // Same as unshare_path for a live bitmask, found through parent
+    // links instead of a key (live nodes always link to their live parent).
+    uint64_t* unshare_up(uint64_t* node) {
+        uint64_t* parent = bitmask_type::get_parent(node);
+        uint16_t  pbyte  = bitmask_type::get_parent_byte(node);
+        if (parent) parent = unshare_up(parent);
+        if (!cow_v->is_shared(node)) return node;
+        uint64_t* copy = unshare_node(node);
+        relink(parent, pbyte, copy);
+        return copy;
+    }
+
+    // Make every node the mapped key passes through writable, down to the
+    // compact leaf it ends in, or the EOS child of the bitmask it ends at.
+    void unshare_path(const uint8_t* key, uint32_t len) {
+        if (!cow_live()) return;
+        uint64_t* parent = nullptr;
+        uint16_t  pbyte  = 0;
+        uint64_t* node   = root_v;
+        uint32_t  consumed = 0;
+        while (node != compact_type::sentinel()) {
+            if (cow_v->is_shared(node)) {
+                uint64_t* copy = unshare_node(node);
+                relink(parent, pbyte, copy);
+                node = copy;
+            }
+            hdr_type h = hdr_type::from_node(node);
+            if (h.is_compact()) return;
+            auto mr = skip_type::match_prefix(node, h, key, len, consumed);
+            if (mr.status != skip_type::match_status::MATCHED) return;
+            consumed = mr.consumed;
+            parent = node;
+            if (consumed == len) {
+                pbyte = EOS_PARENT_BYTE;
+                node  = bitmask_type::eos_child(node, h);
+            } else {
+                pbyte = key[consumed];
+                node  = bitmask_type::dispatch(node, h, key[consumed++]);
+            }
+        }
+    }
+
+    // Make the whole subtree under a writable node writable: shared
+    // children are replaced by deep copies.  Used before a subtree's
+    // values are moved (collapse) or its nodes handed to another trie.
+    void own_subtree(uint64_t* node) {
+        if (!node || node == compact_type::sentinel()) return;
+        hdr_type h = hdr_type::from_node(node);
+        if (h.is_compact()) return;
+        auto own = [&](uint64_t* child) {
+            if (!cow_v->is_shared(child)) {
+                own_subtree(child);
+                return child;
+            }
+            uint64_t* copy = clone_tree(child);
+            destroy_tree(child);
+            return copy;
+        };
+        uint64_t* cs = bitmask_type::child_slots(node);
+        for (uint16_t i = 0; i < h.count; ++i)
+            slots_type::store_child(cs, i, own(slots_type::load_child(cs, i)));
+        uint64_t* eos = bitmask_type::eos_child(node, h);
+        if (eos != compact_type::sentinel())
+            slots_type::store_child(bitmask_type::eos_child_ptr(node, h), 0, own(eos));
+        bitmask_type::link_all_children(node);
+    }
+
 public:
+    // ------------------------------------------------------------------
+    // Snapshots — snapshot() returns a second owner of the whole tree in
+    // O(1); cow_v, shared by the trie and its snapshots, counts the extra
+    // owners of each shared node.  Each later write copies only the
+    // shared nodes on its own path.  destroy_tree drops a shared node's
+    // owner instead of freeing it, so the last owner frees it.
+    // ------------------------------------------------------------------
+
+    kstrie_impl snapshot() {
+        if (!cow_v) cow_v = std::make_shared<cow_table>();
+        kstrie_impl s(mem_v.alloc_v);
+        s.cow_v  = cow_v;
+        s.root_v = root_v;
+        s.size_v = size_v;
+        if (root_v != compact_type::sentinel()) cow_v->share(root_v);
+        return s;
+    }
+
+    // Make a live compact leaf and its path writable before a mutable
+    // iterator hands out a reference into it.  Returns the leaf's
+    // writable node (itself unless it was shared); slot order is kept.
+    uint64_t* own_leaf(uint64_t* leaf) {
+        if (!cow_live()) [[likely]] return leaf;
+        hdr_type  h      = hdr_type::from_node(leaf);
+        uint64_t* parent = compact_type::get_parent(leaf);
+        uint16_t  pbyte  = compact_type::get_parent_byte(leaf, h);
+        if (parent) parent = unshare_up(parent);
+        if (!cow_v->is_shared(leaf)) return leaf;
+        uint64_t* copy = unshare_node(leaf);
+        relink(parent, pbyte, copy);
+        return copy;
+    }
+
     // ------------------------------------------------------------------
     // Capacity
     // ------------------------------------------------------------------
@@ -807,6 +1541,135 @@ public:
                 static_cast<size_t>(key_len - compact_type::lengths(node, h)[pos])};
     }
 
+    // ------------------------------------------------------------------
+    // Stepwise descent (kstrie::co_find / co_lower_bound).  descend_step
+    // matches one bitmask node's skip, dispatches, and prefetches the
+    // child; false once on a compact leaf or after a miss (node null).
+    // descend_finish resolves the leaf with find_leaf_pos.
+    // ------------------------------------------------------------------
+
+    struct descent_t {
+        const uint64_t* node;
+        const uint8_t*  mapped;
+        uint32_t        len;
+        uint32_t        consumed;
+    };
+
+    descent_t descend_start(const uint8_t* mapped, uint32_t len) const noexcept {
+        return {root_v, mapped, len, 0};
+    }
+
+    static bool descend_step(descent_t& d) noexcept {
+        if (!d.node || d.node == compact_type::sentinel()) return false;
+        hdr_type h = hdr_type::from_node(d.node);
+        if (!h.is_bitmap()) return false;
+        if (!skip_type::match_skip_fast(d.node, h, d.mapped, d.len, d.consumed)) {
+            d.node = nullptr;
+            return false;
+        }
+        d.node = (d.consumed == d.len)
+               ? bitmask_type::eos_child(d.node, h)
+               : bitmask_type::dispatch(d.node, h, d.mapped[d.consumed++]);
+        prefetch_read(d.node);
+        return true;
+    }
+
+    static iter_find_result descend_finish(const descent_t& d) noexcept {
+        if (!d.node) return {};
+        return find_leaf_pos(const_cast<uint64_t*>(d.node), d.mapped, d.len, d.consumed);
+    }
+
+    // ------------------------------------------------------------------
+    // find_batch -- FIND_BATCH_GROUP find_inner descents in lockstep.
+    //
+    // Each round advances every unfinished key past one skip + one
+    // bitmask dispatch and prefetches the child it landed on, so the
+    // misses of independent keys overlap instead of serializing.  Once
+    // all keys sit on compact leaves, their L/F arrays are prefetched
+    // before any find_pos runs.  fn(index, iter_find_result) is called
+    // in input order; leaf == nullptr on miss.
+    // ------------------------------------------------------------------
+
+    static constexpr size_t FIND_BATCH_GROUP = 16;
+
+    template <typename FN>
+    void find_batch(const std::string_view* keys, size_t n, FN&& fn) const {
+        const uint64_t* nodes[FIND_BATCH_GROUP];
+        const uint8_t*  data[FIND_BATCH_GROUP];
+        uint32_t        lens[FIND_BATCH_GROUP];
+        uint32_t        consumed[FIND_BATCH_GROUP];
+        bool            is_done[FIND_BATCH_GROUP];
+        std::optional<mapped_key<CHARMAP>> mks[FIND_BATCH_GROUP];
+
+        for (size_t base = 0; base < n; base += FIND_BATCH_GROUP) {
+            size_t g = std::min(FIND_BATCH_GROUP, n - base);
+            for (size_t i = 0; i < g; ++i) {
+                const std::string_view& k = keys[base + i];
+                lens[i] = static_cast<uint32_t>(k.size());
+                const uint8_t* raw = reinterpret_cast<const uint8_t*>(k.data());
+                if constexpr (CHARMAP::IS_IDENTITY) {
+                    data[i] = raw;
+                } else {
+                    data[i] = mks[i].emplace(raw, lens[i]).data;
+                }
+                nodes[i]    = root_v;
+                consumed[i] = 0;
+                is_done[i]  = false;
+            }
+
+            bool is_live = true;
+            while (is_live) {
+                is_live = false;
+                for (size_t i = 0; i < g; ++i) {
+                    if (is_done[i]) continue;
+                    const uint64_t* node = nodes[i];
+                    hdr_type h = hdr_type::from_node(node);
+                    if (h.has_skip()) [[unlikely]] {
+                        if (!skip_type::match_skip_unchecked(node, h, data[i],
+                                                             lens[i], consumed[i])) {
+                            nodes[i]   = nullptr;
+                            is_done[i] = true;
+                            continue;
+                        }
+                    }
+                    if (!h.is_bitmap()) {
+                        is_done[i] = true;
+                        continue;
+                    }
+                    node = (consumed[i] == lens[i])
+                         ? bitmask_type::eos_child(node, h)
+                         : bitmask_type::dispatch(node, h, data[i][consumed[i]++]);
+                    prefetch_read(node);
+                    nodes[i] = node;
+                    is_live  = true;
+                }
+            }
+
+            for (size_t i = 0; i < g; ++i) {
+                if (!nodes[i]) continue;
+                hdr_type h = hdr_type::from_node(nodes[i]);
+                prefetch_read(compact_type::lengths(nodes[i], h));
+                prefetch_read(compact_type::firsts(nodes[i], h));
+            }
+
+            for (size_t i = 0; i < g; ++i) {
+                const uint64_t* node = nodes[i];
+                iter_find_result r;
+                if (node) {
+                    hdr_type h = hdr_type::from_node(node);
+                    uint32_t rem = lens[i] - consumed[i];
+                    auto [found, pos] = compact_type::find_pos(
+                        node, h, data[i] + consumed[i], rem);
+                    if (found)
+                        r = {const_cast<uint64_t*>(node), static_cast<uint16_t>(pos),
+                             static_cast<size_t>(lens[i] -
+                                                 compact_type::lengths(node, h)[pos])};
+                }
+                fn(base + i, r);
+            }
+        }
+    }
+
     // ------------------------------------------------------------------
     // Lookup
     // ------------------------------------------------------------------
@@ -855,6 +1718,7 @@ public:
     size_type erase_mapped(const uint8_t* mapped, uint32_t len) {
         if (root_v == compact_type::sentinel()) return 0;
 
+        unshare_path(mapped, len);
         erase_info r = erase_node(root_v, mapped, len, 0);
 
         if (r.status == erase_status::MISSING)
@@ -894,6 +1758,7 @@ public:
     erase_iter_result erase_for_iter(const uint8_t* mapped, uint32_t len) {
         if (root_v == compact_type::sentinel()) return {false, nullptr, 0};
 
+        unshare_path(mapped, len);
         erase_info r = erase_node(root_v, mapped, len, 0);
 
         if (r.status == erase_status::MISSING)
@@ -1010,18 +1875,29 @@ public:
     }
 
     // ------------------------------------------------------------------
-    // prefix_walk_impl
+    // prefix_locate -- find where the entries with a mapped prefix live.
+    // node == nullptr: none.  rem != nullptr: compact node whose entries
+    // must still be filtered on rem[0..rlen).  Otherwise the whole
+    // subtree at node, with its skip already in path iff is_post_skip.
     // ------------------------------------------------------------------
 
-    template<typename F>
-    void prefix_walk_impl(const uint8_t* mapped, uint32_t len,
-                          std::string_view original_prefix, F&& fn) const {
-        if (root_v == compact_type::sentinel()) return;
-        std::string path(original_prefix);
+    struct prefix_hit {
+        const uint64_t* node = nullptr;
+        std::string     path;
+        bool            is_post_skip = false;
+        const uint8_t*  rem  = nullptr;
+        uint32_t        rlen = 0;
+    };
+
+    prefix_hit prefix_locate(const uint8_t* mapped, uint32_t len,
+                             std::string_view original_prefix) const {
+        prefix_hit r;
+        if (root_v == compact_type::sentinel()) return r;
+        r.path.assign(original_prefix);
 
         if (len == 0) {
-            prefix_walk_subtree(root_v, path, std::forward<F>(fn));
-            return;
+            r.node = root_v;
+            return r;
         }
 
         const uint64_t* node = root_v;
@@ -1034,33 +1910,252 @@ public:
                 uint32_t remaining = len - consumed;
                 if (remaining <= sb) {
                     if (std::memcmp(skip, mapped + consumed, remaining) != 0)
-                        return;
+                        return r;
                     for (uint32_t j = remaining; j < sb; ++j)
-                        path.push_back(static_cast<char>(
+                        r.path.push_back(static_cast<char>(
                             CHARMAP::from_index(skip[j])));
-                    consumed += sb;
-                    h = hdr_type::from_node(node);
-                    walk_node_post_skip(node, h, path, fn);
-                    return;
+                    r.node = node;
+                    r.is_post_skip = true;
+                    return r;
                 }
-                if (std::memcmp(skip, mapped + consumed, sb) != 0) return;
+                if (std::memcmp(skip, mapped + consumed, sb) != 0) return r;
                 consumed += sb;
             }
-            h = hdr_type::from_node(node);
             if (consumed >= len) {
-                // Skip already consumed — walk post-skip directly
-                walk_node_post_skip(node, h, path, fn);
-                return;
+                r.node = node;
+                r.is_post_skip = true;
+                return r;
             }
             if (h.is_compact()) [[unlikely]] {
-                prefix_walk_filtered(node, h,
-                    mapped + consumed, len - consumed,
-                    path, std::forward<F>(fn));
-                return;
+                r.node = node;
+                r.rem  = mapped + consumed;
+                r.rlen = len - consumed;
+                return r;
             }
             uint8_t byte = mapped[consumed++];
             node = bitmask_type::dispatch(node, h, byte);
+            if (node == compact_type::sentinel()) return r;
+        }
+    }
+
+    // ------------------------------------------------------------------
+    // prefix_walk_impl
+    // ------------------------------------------------------------------
+
+    template<typename F>
+    void prefix_walk_impl(const uint8_t* mapped, uint32_t len,
+                          std::string_view original_prefix, F&& fn) const {
+        prefix_hit r = prefix_locate(mapped, len, original_prefix);
+        if (!r.node) return;
+        hdr_type h = hdr_type::from_node(r.node);
+        if (r.rem)
+            prefix_walk_filtered(r.node, h, r.rem, r.rlen, r.path, fn);
+        else if (r.is_post_skip)
+            walk_node_post_skip(r.node, h, r.path, fn);
+        else
+            prefix_walk_subtree(r.node, r.path, fn);
+    }
+
+    // ------------------------------------------------------------------
+    // range_walk_impl — walk_range from the root with one reused path
+    // buffer.  has_hi == false: no upper bound.
+    // ------------------------------------------------------------------
+
+    static constexpr size_t RANGE_PATH_RESERVE = 256;
+
+    template<typename F>
+    void range_walk_impl(const uint8_t* lo, uint32_t lo_len,
+                         const uint8_t* hi, uint32_t hi_len, bool has_hi,
+                         F&& fn) const {
+        if (root_v == compact_type::sentinel()) return;
+        if (has_hi && hi_len == 0) return;
+        std::string path;
+        path.reserve(RANGE_PATH_RESERVE);
+        range_keys rk{lo, lo_len, hi, hi_len};
+        walk_range(root_v, 0, lo_len > 0, has_hi, rk, path, fn);
+    }
+
+    // ------------------------------------------------------------------
+    // fuzzy_search_impl — fuzzy_walk from the root; row 0 is 0..qlen.
+    // ------------------------------------------------------------------
+
+    template<typename F>
+    void fuzzy_search_impl(const uint8_t* query, uint32_t qlen,
+                           uint32_t max_edits, F&& fn) const {
+        if (root_v == compact_type::sentinel()) return;
+        fuzzy_state st{query, qlen, max_edits, {}, {}};
+        st.rows.resize(static_cast<size_t>(qlen + 1) * (qlen + max_edits + 2));
+        for (uint32_t j = 0; j <= qlen; ++j) st.rows[j] = j;
+        st.path.reserve(RANGE_PATH_RESERVE);
+        fuzzy_walk(root_v, 0, st, fn);
+    }
+
+    // ------------------------------------------------------------------
+    // prefix_matches_impl -- every stored key that is a prefix of
+    // mapped[0..len), shortest first, in a single descent:
+    // fn(match_len, leaf, pos).  Each bitmask node on the path
+    // contributes its EOS entry; the final compact leaf contributes
+    // the entries that prefix the remaining bytes.
+    // ------------------------------------------------------------------
+
+    template<typename F>
+    void prefix_matches_impl(const uint8_t* mapped, uint32_t len, F&& fn) const {
+        const uint64_t* node = root_v;
+        uint32_t consumed = 0;
+        for (;;) {
             if (node == compact_type::sentinel()) return;
+            hdr_type h = hdr_type::from_node(node);
+            if (h.has_skip()) [[unlikely]] {
+                if (!skip_type::match_skip_unchecked(node, h, mapped, len, consumed))
+                    return;
+            }
+            if (!h.is_bitmap()) {
+                compact_type::prefix_matches(node, h, mapped + consumed, len - consumed,
+                    [&](int pos, uint32_t l) {
+                        fn(consumed + l, const_cast<uint64_t*>(node),
+                           static_cast<uint16_t>(pos));
+                    });
+                return;
+            }
+            const uint64_t* eos = bitmask_type::eos_child(node, h);
+            if (eos != compact_type::sentinel()) {
+                hdr_type eh = hdr_type::from_node(eos);
+                if (eh.count > 0 && compact_type::lengths(eos, eh)[0] == 0)
+                    fn(consumed, const_cast<uint64_t*>(eos), uint16_t{0});
+            }
+            if (consumed == len) return;
+            node = bitmask_type::dispatch(node, h, mapped[consumed++]);
+        }
+    }
+
+    // ------------------------------------------------------------------
+    // parallel_prefix_walk_impl -- prefix_walk fanned out over threads.
+    //
+    // The located subtree is split into ordered tasks: any bitmask task
+    // heavier than total / (threads * TASKS_PER_THREAD) by node_tail_total
+    // is replaced by its EOS child and byte children, until there are
+    // enough tasks or nothing is left to split.  Workers claim tasks in
+    // key order through an atomic cursor; with several tasks per thread
+    // the uneven subtree sizes even out.  UNORDERED calls fn concurrently from the
+    // workers; ORDERED buffers each task's keys and replays them in key
+    // order on the calling thread.  The first exception thrown by fn
+    // stops the walk and is rethrown.
+    // ------------------------------------------------------------------
+
+    static constexpr unsigned TASKS_PER_THREAD = 8;
+
+    template<typename F>
+    void parallel_prefix_walk_impl(const uint8_t* mapped, uint32_t len,
+                                   std::string_view original_prefix, F&& fn,
+                                   unsigned threads, walk_order order) const {
+        prefix_hit r = prefix_locate(mapped, len, original_prefix);
+        if (!r.node) return;
+        hdr_type h = hdr_type::from_node(r.node);
+        if (threads <= 1 || r.rem || h.is_compact()) {
+            if (r.rem)
+                prefix_walk_filtered(r.node, h, r.rem, r.rlen, r.path, fn);
+            else if (r.is_post_skip)
+                walk_node_post_skip(r.node, h, r.path, fn);
+            else
+                prefix_walk_subtree(r.node, r.path, fn);
+            return;
+        }
+
+        struct walk_task {
+            const uint64_t* node;
+            std::string     path;
+            bool            is_post_skip;
+        };
+        std::vector<walk_task> tasks;
+        tasks.push_back({r.node, std::move(r.path), r.is_post_skip});
+
+        size_t target = static_cast<size_t>(threads) * TASKS_PER_THREAD;
+        uint64_t limit = node_tail_total(r.node) / target;
+        for (bool is_split = true; is_split && tasks.size() < target; ) {
+            is_split = false;
+            std::vector<walk_task> next;
+            next.reserve(tasks.size() * 2);
+            for (auto& t : tasks) {
+                hdr_type th = hdr_type::from_node(t.node);
+                if (!th.is_bitmap() || node_tail_total(t.node) <= limit) {
+                    next.push_back(std::move(t));
+                    continue;
+                }
+                is_split = true;
+                if (!t.is_post_skip && th.has_skip())
+                    append_unmapped(t.path, hdr_type::get_skip(t.node, th),
+                                    th.skip_bytes());
+                const uint64_t* eos = bitmask_type::eos_child(t.node, th);
+                if (eos != compact_type::sentinel())
+                    next.push_back({eos, t.path, false});
+                const auto* bm = bitmask_type::get_bitmap(t.node, th);
+                int slot = 0;
+                for (int idx = bm->find_next_set(0); idx >= 0;
+                     idx = bm->find_next_set(idx + 1)) {
+                    std::string cp = t.path;
+                    cp.push_back(static_cast<char>(
+                        CHARMAP::from_index(static_cast<uint8_t>(idx))));
+                    next.push_back({bitmask_type::child_by_slot(t.node, th, slot++),
+                                    std::move(cp), false});
+                }
+            }
+            tasks = std::move(next);
+        }
+
+        struct task_out {
+            std::string         keys;
+            std::vector<size_t> ends;
+            std::vector<const VALUE*> vals;
+        };
+        std::vector<task_out> outs(order == walk_order::ORDERED ? tasks.size() : 0);
+
+        std::atomic<size_t> cursor{0};
+        std::atomic<bool>   failed{false};
+        std::exception_ptr  err;
+        auto work = [&] {
+            for (size_t t; (t = cursor.fetch_add(1)) < tasks.size(); ) {
+                if (failed.load(std::memory_order_relaxed)) return;
+                walk_task& wt = tasks[t];
+                try {
+                    auto run = [&](auto&& sink) {
+                        if (wt.is_post_skip)
+                            walk_node_post_skip(wt.node, hdr_type::from_node(wt.node),
+                                                wt.path, sink);
+                        else
+                            prefix_walk_subtree(wt.node, wt.path, sink);
+                    };
+                    if (order == walk_order::ORDERED) {
+                        task_out& o = outs[t];
+                        run([&](std::string_view k, const VALUE& v) {
+                            o.keys.append(k);
+                            o.ends.push_back(o.keys.size());
+                            o.vals.push_back(&v);
+                        });
+                    } else {
+                        run(fn);
+                    }
+                } catch (...) {
+                    if (!failed.exchange(true)) err = std::current_exception();
+                    return;
+                }
+            }
+        };
+
+        unsigned n_workers = static_cast<unsigned>(
+            std::min<size_t>(threads, tasks.size()));
+        std::vector<std::thread> pool;
+        pool.reserve(n_workers - 1);
+        for (unsigned w = 1; w < n_workers; ++w) pool.emplace_back(work);
+        work();
+        for (auto& th : pool) th.join();
+        if (err) std::rethrow_exception(err);
+
+        for (auto& o : outs) {
+            size_t b = 0;
+            for (size_t i = 0; i < o.vals.size(); ++i) {
+                fn(std::string_view(o.keys).substr(b, o.ends[i] - b), *o.vals[i]);
+                b = o.ends[i];
+            }
         }
     }
 
@@ -1070,6 +2165,7 @@ public:
 
     size_t prefix_erase(const uint8_t* mapped, uint32_t len) {
         if (root_v == compact_type::sentinel()) return 0;
+        unshare_path(mapped, len);
         if (len == 0) {
             size_t n = size_v;
             destroy_tree(root_v);
@@ -1108,25 +2204,168 @@ public:
             const uint8_t* mapped, uint32_t len) {
         if (root_v == compact_type::sentinel())
             return {root_v, compact_type::sentinel(), 0, 0};
+        unshare_path(mapped, len);
         if (len == 0) {
             uint64_t* stolen = root_v;
+            if (cow_live()) own_subtree(stolen);
             size_t n = size_v;
             init_empty_root();
             size_v = 0;
             return {root_v, stolen, n, 0};
         }
         auto r = prefix_split_node(root_v, mapped, len, 0);
+        if (cow_live()) own_subtree(r.stolen);   // the stolen nodes change owner
         set_root(r.source);
         size_v -= r.count;
         return r;
     }
 
+    // ------------------------------------------------------------------
+    // compact -- see compact_walk.  Moves up to budget nodes (at least
+    // one) and keeps the resume point in compact_v, so a pass can be
+    // spread over many calls with any mutation in between.  The resume
+    // point is a key path, not a node, so a restructured node is at worst
+    // moved twice or left for the next pass.  Returns true when the pass
+    // is complete.
+    // ------------------------------------------------------------------
+
+    bool compact(size_t budget) {
+        compact_walk_t w = std::move(compact_v);
+        w.budget  = std::max<size_t>(budget, 1);
+        w.stopped = false;
+        compact_v = {};
+        if (size_v == 0) return true;
+
+        std::string path;
+        uint64_t* r = compact_walk(root_v, path, false, w);
+        if (r != root_v) set_root(r);
+        if (!w.stopped) return true;
+        compact_v = std::move(w);
+        return false;
+    }
+
+    void compact_restart() noexcept { compact_v = {}; }
+
     void clear() noexcept {
         if (root_v) destroy_tree(root_v);
         init_empty_root();
         size_v = 0;
     }
 
+    // ------------------------------------------------------------------
+    // assign_sorted -- replace contents from (key, value) pairs in
+    // ascending mapped-key order.  Keys are mapped into one arena; every
+    // node is then built once at final size by build_sorted.  Repeated
+    // keys keep the first occurrence; unsorted input throws.
+    // ------------------------------------------------------------------
+
+    template <typename IT>
+    void assign_sorted(IT first, IT last) {
+        std::vector<uint8_t>  arena;
+        std::vector<size_t>   offs{0};
+        std::vector<uint64_t> raws;
+        if constexpr (std::is_base_of_v<std::forward_iterator_tag,
+                          typename std::iterator_traits<IT>::iterator_category>) {
+            auto n = static_cast<size_t>(std::distance(first, last));
+            offs.reserve(n + 1);
+            raws.reserve(n);
+        }
+
+        try {
+            for (; first != last; ++first) {
+                std::string_view k(first->first);
+                size_t at = arena.size();
+                arena.resize(at + k.size());
+                map_bytes_into<CHARMAP>(reinterpret_cast<const uint8_t*>(k.data()),
+                                        arena.data() + at, static_cast<uint32_t>(k.size()));
+                if (!raws.empty()) {
+                    size_t pa = offs[offs.size() - 2];
+                    size_t pl = at - pa;
+                    size_t ml = std::min(pl, k.size());
+                    int c = ml ? std::memcmp(arena.data() + pa, arena.data() + at, ml) : 0;
+                    if (c == 0) c = makecmp(pl, k.size());
+                    if (c >= 0) [[unlikely]] {
+                        arena.resize(at);
+                        if (c == 0) continue;
+                        throw std::invalid_argument("kstrie::assign_sorted: input not sorted");
+                    }
+                }
+                offs.push_back(arena.size());
+                push_raw(raws, first->second);
+            }
+        } catch (...) {
+            for (uint64_t r : raws) destroy_raw(r);
+            throw;
+        }
+        assign_built(arena, offs, raws);
+    }
+
+    // ------------------------------------------------------------------
+    // assign_join -- replace contents with the join of a and b (either
+    // may be *this): keys in both (KEEP_AB), a's (KEEP_A) and b's
+    // (KEEP_B) unmatched keys.  A matched key takes combine(a, b).
+    // join_walk emits in order, so the result is bulk built like
+    // assign_sorted.
+    // ------------------------------------------------------------------
+
+    template <bool KEEP_AB, bool KEEP_A, bool KEEP_B, typename C>
+    void assign_join(const kstrie_impl& a, const kstrie_impl& b, C& combine) {
+        std::vector<uint8_t>  arena;
+        std::vector<size_t>   offs{0};
+        std::vector<uint64_t> raws;
+        auto out = [&](const uint8_t* pre, size_t pl, const uint8_t* suf, uint32_t sl,
+                       const VALUE* va, const VALUE* vb) {
+            arena.insert(arena.end(), pre, pre + pl);
+            arena.insert(arena.end(), suf, suf + sl);
+            offs.push_back(arena.size());
+            if (va && vb) push_raw(raws, combine(*va, *vb));
+            else          push_raw(raws, va ? *va : *vb);
+        };
+        try {
+            std::vector<uint8_t> path;
+            path.reserve(RANGE_PATH_RESERVE);
+            join_walk<KEEP_AB, KEEP_A, KEEP_B>({a.root_v, 0}, {b.root_v, 0}, path, out);
+        } catch (...) {
+            for (uint64_t r : raws) destroy_raw(r);
+            throw;
+        }
+        assign_built(arena, offs, raws);
+    }
+
+private:
+    // Replace contents with sorted, distinct mapped keys arena[offs[i],
+    // offs[i+1]) carrying raws[i].  Takes ownership of raws; the tree is
+    // built aside and swapped in, so a throw leaves contents unchanged.
+    void assign_built(const std::vector<uint8_t>& arena,
+                      const std::vector<size_t>& offs,
+                      const std::vector<uint64_t>& raws) {
+        size_t n = raws.size();
+        std::unique_ptr<build_entry[]> entries;
+        try {
+            entries = std::make_unique<build_entry[]>(n);
+        } catch (...) {
+            for (uint64_t r : raws) destroy_raw(r);
+            throw;
+        }
+        for (size_t i = 0; i < n; ++i)
+            entries[i] = {arena.data() + offs[i],
+                          static_cast<uint32_t>(offs[i + 1] - offs[i]), raws[i]};
+
+        kstrie_impl t(mem_v.alloc_v);
+        if (n) {
+            try {
+                t.set_root(t.build_sorted(entries.get(), n, 0));
+            } catch (...) {
+                for (uint64_t r : raws) destroy_raw(r);
+                throw;
+            }
+            t.size_v = n;
+        }
+        swap(t);
+    }
+
+public:
+
     // ------------------------------------------------------------------
     // Utilities
     // ------------------------------------------------------------------
@@ -1139,6 +2378,8 @@ public:
         std::swap(root_v, o.root_v);
         std::swap(size_v, o.size_v);
         std::swap(mem_v, o.mem_v);
+        std::swap(compact_v, o.compact_v);
+        std::swap(cow_v, o.cow_v);
     }
 
     [[nodiscard]] size_type max_size() const noexcept {
@@ -1432,6 +2673,8 @@ private:
     }
 
     uint64_t* collapse_to_compact(uint64_t* node) {
+        if (cow_live()) own_subtree(node);   // values move out of the subtree
+
         uint8_t  cL[MAX_COLLAPSE_ENTRIES];
         uint8_t  cF[MAX_COLLAPSE_ENTRIES];
         ks_offset_type cO[MAX_COLLAPSE_ENTRIES];
@@ -1483,6 +2726,7 @@ private:
         nh.count = ei;
         hdr_type::from_node(nn).count = ei;
 
+        stat_add(stat_t::COALESCE);
         free_subtree_nodes(node);
         return nn;
     }
@@ -1716,6 +2960,7 @@ private:
         uint32_t len = static_cast<uint32_t>(key.size());
 
         mapped_key<CHARMAP> mk(raw, len);
+        unshare_path(mk.data, len);
         insert_result r = insert_node(root_v, mk.data, len, value, 0, mode);
         set_root(r.node);
 
@@ -1738,6 +2983,7 @@ public:
         uint32_t len = static_cast<uint32_t>(key.size());
 
         mapped_key<CHARMAP> mk(raw, len);
+        unshare_path(mk.data, len);
         insert_result r = insert_node(root_v, mk.data, len, value, 0, mode);
         set_root(r.node);
 
@@ -1770,6 +3016,8 @@ private:
         if (mr.status == skip_type::match_status::MISMATCH) {
             if (mode == insert_mode::ASSIGN)
                 return {node, insert_outcome::FOUND};
+            stat_add(stat_t::SKIP_MISMATCH);
+            stat_add(stat_t::SPLIT);
 
             const uint8_t* skip_data = hdr_type::get_skip(node, h);
             uint32_t old_skip = h.skip_bytes();
@@ -1811,6 +3059,8 @@ private:
         if (mr.status == skip_type::match_status::KEY_EXHAUSTED) {
             if (mode == insert_mode::ASSIGN)
                 return {node, insert_outcome::FOUND};
+            stat_add(stat_t::SKIP_MISMATCH);
+            stat_add(stat_t::SPLIT);
 
             const uint8_t* skip_data = hdr_type::get_skip(node, h);
             uint32_t old_skip = h.skip_bytes();
@@ -1940,6 +3190,120 @@ private:
             mem_v, 0, nullptr, arr.get(), static_cast<uint16_t>(count));
         return node;
     }
+
+    // Release a raw slot made by make_raw that never reached a node.
+    void destroy_raw(uint64_t raw) {
+        if constexpr (!slots_type::IS_INLINE && !slots_type::IS_BITMAP)
+            slots_type::destroy_value(&raw, 0, mem_v.alloc_v);
+    }
+
+    // Append a raw slot for v, releasing it if the append throws.
+    void push_raw(std::vector<uint64_t>& raws, const VALUE& v) {
+        uint64_t raw = slots_type::make_raw(v, mem_v.alloc_v);
+        try {
+            raws.push_back(raw);
+        } catch (...) {
+            destroy_raw(raw);
+            throw;
+        }
+    }
+
+    // Free the nodes of a subtree made by build_sorted, leaving its
+    // values to the caller's raws.
+    void free_built(uint64_t* node) noexcept {
+        if (!node || node == compact_type::sentinel()) return;
+        hdr_type h = hdr_type::from_node(node);
+        if (h.is_bitmap()) {
+            uint64_t* cs = bitmask_type::child_slots(node);
+            for (uint16_t i = 0; i < h.count; ++i)
+                free_built(slots_type::load_child(cs, i));
+            free_built(bitmask_type::eos_child(node, h));
+        }
+        mem_v.free_node(node);
+    }
+
+    // ------------------------------------------------------------------
+    // build_sorted -- build the subtree for sorted, distinct entries
+    // e[0..n) whose first d bytes are already consumed by ancestors.
+    //
+    // The range's common prefix is lcp(e[0], e[n-1]), taken as this
+    // node's skip.  If the remainder fits a compact node (every suffix
+    // <= 255, tail bytes <= COMPACT_KEYSUFFIX_LIMIT) one is emitted at
+    // final size; otherwise a bitmask node with one child per dispatch
+    // byte and NODE_TOTAL_TAIL summed from the finished children.
+    // Entries are adjusted in place when handed to build_compact.  On a
+    // throw the nodes built so far are freed; the raws stay the caller's.
+    // ------------------------------------------------------------------
+
+    uint64_t* build_sorted(build_entry* e, size_t n, uint32_t d) {
+        const build_entry& lo = e[0];
+        const build_entry& hi = e[n - 1];
+        uint32_t ml  = std::min(lo.key_len, hi.key_len) - d;
+        uint32_t lcp = 0;
+        if (n == 1) lcp = ml;
+        else while (lcp < ml && lo.key[d + lcp] == hi.key[d + lcp]) ++lcp;
+        if (lcp > hdr_type::SKIP_MAX) lcp = hdr_type::SKIP_MAX;
+        uint32_t s = d + lcp;
+        const uint8_t* skip = lcp ? lo.key + d : nullptr;
+
+        bool fits = true;
+        uint32_t tail = 0;
+        for (size_t i = 0; i < n && fits; ++i) {
+            uint32_t kl = e[i].key_len - s;
+            if (kl > 1) tail += kl - 1;
+            fits = kl <= COMPACT_SUFFIX_LEN_MAX && tail <= COMPACT_KEYSUFFIX_LIMIT;
+        }
+        if (fits) {
+            for (size_t i = 0; i < n; ++i) {
+                e[i].key     += s;
+                e[i].key_len -= s;
+            }
+            return compact_type::build_compact(mem_v, static_cast<uint8_t>(lcp), skip,
+                                               e, static_cast<uint16_t>(n));
+        }
+
+        size_t i = 0;
+        bool has_eos = (e[0].key_len == s);
+        uint64_t eos_raw = has_eos ? e[0].raw_slot : 0;
+        i += has_eos;
+
+        uint8_t   bytes[BYTE_VALUES]{};
+        uint64_t* children[BYTE_VALUES]{};
+        uint16_t  nc = 0;
+        uint64_t  desc = 0;
+        uint64_t* node;
+        try {
+            while (i < n) {
+                uint8_t b = e[i].key[s];
+                size_t j = i + 1;
+                while (j < n && e[j].key[s] == b) ++j;
+                bytes[nc]    = b;
+                children[nc] = build_sorted(e + i, j - i, s + 1);
+                desc += node_tail_total(children[nc]);
+                ++nc;
+                i = j;
+            }
+            node = bitmask_type::create_with_children(
+                mem_v, static_cast<uint8_t>(lcp), skip, bytes, children, nc);
+        } catch (...) {
+            for (uint16_t c = 0; c < nc; ++c) free_built(children[c]);
+            throw;
+        }
+        if (has_eos) {
+            build_entry be{nullptr, 0, eos_raw};
+            uint64_t* eos_node;
+            try {
+                eos_node = compact_type::build_compact(mem_v, 0, nullptr, &be, 1);
+            } catch (...) {
+                free_built(node);
+                throw;
+            }
+            bitmask_type::set_eos_child(node, hdr_type::from_node(node), eos_node);
+            desc += node_tail_total(eos_node);
+        }
+        node[NODE_TOTAL_TAIL] = desc + static_cast<uint64_t>(n) * lcp;
+        return node;
+    }
 };
 
 } // namespace gteitelbaum::kstrie_detail
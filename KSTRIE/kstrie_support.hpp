@@ -2,6 +2,7 @@
 #define KSTRIE_SUPPORT_HPP
 
 #include <array>
+#include <atomic>
 #include <bit>
 #include <climits>
 #include <cstddef>
@@ -9,9 +10,34 @@
 #include <cstring>
 #include <limits>
 #include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
 #include <string_view>
 #include <type_traits>
+#include <unordered_map>
 #include <utility>
+#if defined(_MSC_VER)
+#include <xmmintrin.h>   // _mm_prefetch, for prefetch_read
+#endif
+
+// SIMD first-byte filter in compact find_pos: widest vector the target
+// guarantees.  Define KSTRIE_NO_SIMD_SEARCH to force the scalar search.
+#if !defined(KSTRIE_NO_SIMD_SEARCH) && defined(__AVX512BW__)
+#include <immintrin.h>
+#define KSTRIE_SIMD_SEARCH_BITS 512
+#elif !defined(KSTRIE_NO_SIMD_SEARCH) && defined(__AVX2__)
+#include <immintrin.h>
+#define KSTRIE_SIMD_SEARCH_BITS 256
+#else
+#define KSTRIE_SIMD_SEARCH_BITS 0
+#endif
+
+// Hot-path counters and histograms (see instrument_t).  Off by default;
+// build with KSTRIE_INSTRUMENT=1 to compile them in.
+#ifndef KSTRIE_INSTRUMENT
+#define KSTRIE_INSTRUMENT 0
+#endif
 
 namespace gteitelbaum::kstrie_detail {
 
@@ -29,6 +55,15 @@ inline constexpr size_t div_ceil(size_t x, size_t y) noexcept {
     return (x + y - 1) / y;
 }
 
+// Software prefetch (read, keep in all cache levels)
+inline void prefetch_read(const void* p) noexcept {
+#if defined(_MSC_VER)
+    _mm_prefetch(static_cast<const char*>(p), _MM_HINT_T0);
+#else
+    __builtin_prefetch(p, 0, 3);
+#endif
+}
+
 // Fundamental slot width
 #ifndef KTRIE_U64_BYTES_DEFINED
 #define KTRIE_U64_BYTES_DEFINED
@@ -171,6 +206,64 @@ inline constexpr std::array<uint8_t, 256> REVERSE_LOWER_MAP = []() {
     return m;
 }();
 
+// Dense-alphabet maps: every byte outside the alphabet folds onto one
+// catch-all symbol, so the unique count (and the bitmap) stays small.
+
+// DNA bases, case-folded; anything else is 'N'.  5 symbols, 1-word bitmap.
+inline constexpr std::array<uint8_t, 256> DNA_MAP = []() {
+    std::array<uint8_t, 256> m{};
+    for (int i = 0; i < 256; ++i) m[i] = 'N';
+    for (char c : {'A', 'C', 'G', 'T'}) {
+        m[static_cast<uint8_t>(c)] = static_cast<uint8_t>(c);
+        m[static_cast<uint8_t>(c - 'A' + 'a')] = static_cast<uint8_t>(c);
+    }
+    return m;
+}();
+
+// Hex digits, case-folded to lower.  17 symbols, 1-word bitmap.
+inline constexpr std::array<uint8_t, 256> HEX_MAP = []() {
+    std::array<uint8_t, 256> m{};
+    for (int i = 0; i < 256; ++i) m[i] = '*';
+    for (int i = '0'; i <= '9'; ++i) m[i] = static_cast<uint8_t>(i);
+    for (int i = 'a'; i <= 'f'; ++i) m[i] = static_cast<uint8_t>(i);
+    for (int i = 'A'; i <= 'F'; ++i) m[i] = static_cast<uint8_t>('a' + (i - 'A'));
+    return m;
+}();
+
+// Lowercase letters and digits, case-folded.  37 symbols, 1-word bitmap.
+inline constexpr std::array<uint8_t, 256> LOWER_ALNUM_MAP = []() {
+    std::array<uint8_t, 256> m{};
+    for (int i = 0; i < 256; ++i) m[i] = '*';
+    for (int i = '0'; i <= '9'; ++i) m[i] = static_cast<uint8_t>(i);
+    for (int i = 'a'; i <= 'z'; ++i) m[i] = static_cast<uint8_t>(i);
+    for (int i = 'A'; i <= 'Z'; ++i) m[i] = static_cast<uint8_t>('a' + (i - 'A'));
+    return m;
+}();
+
+// RFC 4648 base64 alphabet plus '=' padding, case-sensitive.
+// 66 symbols, 2-word bitmap.
+inline constexpr std::array<uint8_t, 256> BASE64_MAP = []() {
+    std::array<uint8_t, 256> m{};
+    for (int i = 0; i < 256; ++i) m[i] = '*';
+    for (int i = '0'; i <= '9'; ++i) m[i] = static_cast<uint8_t>(i);
+    for (int i = 'A'; i <= 'Z'; ++i) m[i] = static_cast<uint8_t>(i);
+    for (int i = 'a'; i <= 'z'; ++i) m[i] = static_cast<uint8_t>(i);
+    m['+'] = '+'; m['/'] = '/'; m['='] = '=';
+    return m;
+}();
+
+// RFC 3986 unreserved URL characters, case-sensitive.  67 symbols,
+// 2-word bitmap.
+inline constexpr std::array<uint8_t, 256> URL_SAFE_MAP = []() {
+    std::array<uint8_t, 256> m{};
+    for (int i = 0; i < 256; ++i) m[i] = '*';
+    for (int i = '0'; i <= '9'; ++i) m[i] = static_cast<uint8_t>(i);
+    for (int i = 'A'; i <= 'Z'; ++i) m[i] = static_cast<uint8_t>(i);
+    for (int i = 'a'; i <= 'z'; ++i) m[i] = static_cast<uint8_t>(i);
+    m['-'] = '-'; m['.'] = '.'; m['_'] = '_'; m['~'] = '~';
+    return m;
+}();
+
 template <std::array<uint8_t, 256> USER_MAP>
 struct char_map {
 private:
@@ -217,8 +310,10 @@ private:
 public:
     static constexpr bool IS_IDENTITY   = compute_is_identity();
     static constexpr size_t UNIQUE_COUNT = IS_IDENTITY ? 256 : compute_unique_count();
+    // Remapped indices run 1..UNIQUE_COUNT (0 is unused), so the top
+    // index needs UNIQUE_COUNT + 1 bits.
     static constexpr size_t BITMAP_WORDS =
-        IS_IDENTITY ? 4 : (UNIQUE_COUNT <= 64) ? 1 : (UNIQUE_COUNT <= 128) ? 2 : 4;
+        IS_IDENTITY ? 4 : (UNIQUE_COUNT < 64) ? 1 : (UNIQUE_COUNT < 128) ? 2 : 4;
     static constexpr bool NEEDS_REMAP = !IS_IDENTITY && (BITMAP_WORDS < 4);
     static constexpr std::array<uint8_t, 256> CHAR_TO_INDEX =
         NEEDS_REMAP ? compute_char_to_index() : USER_MAP;
@@ -238,6 +333,67 @@ public:
 using identity_char_map       = char_map<IDENTITY_MAP>;
 using upper_char_map          = char_map<UPPER_MAP>;
 using reverse_lower_char_map  = char_map<REVERSE_LOWER_MAP>;
+using dna_char_map            = char_map<DNA_MAP>;
+using hex_char_map            = char_map<HEX_MAP>;
+using lower_alnum_char_map    = char_map<LOWER_ALNUM_MAP>;
+using base64_char_map         = char_map<BASE64_MAP>;
+using url_safe_char_map       = char_map<URL_SAFE_MAP>;
+
+static_assert(dna_char_map::BITMAP_WORDS == 1 && hex_char_map::BITMAP_WORDS == 1 &&
+              lower_alnum_char_map::BITMAP_WORDS == 1);
+static_assert(base64_char_map::BITMAP_WORDS == 2 && url_safe_char_map::BITMAP_WORDS == 2);
+
+// ============================================================================
+// dna_codec -- packs A/C/G/T (either case) 4 bases per byte, 2 bits each,
+// first base in the high bits.  Packed keys of equal base count sort like
+// their bases, so fixed-length k-mers can be stored packed under the
+// identity map: 4x shorter suffixes and a quarter of the trie depth.
+// Unpacking needs the base count (k).
+// ============================================================================
+
+struct dna_codec {
+    static constexpr size_t BASES_PER_BYTE = 4;
+
+    static constexpr size_t packed_size(size_t bases) noexcept {
+        return (bases + BASES_PER_BYTE - 1) / BASES_PER_BYTE;
+    }
+
+    static void encode(std::string_view bases, std::string& out) {
+        out.assign(packed_size(bases.size()), '\0');
+        for (size_t i = 0; i < bases.size(); ++i) {
+            uint8_t code;
+            switch (bases[i]) {
+                case 'A': case 'a': code = 0; break;
+                case 'C': case 'c': code = 1; break;
+                case 'G': case 'g': code = 2; break;
+                case 'T': case 't': code = 3; break;
+                default: throw std::invalid_argument("dna_codec::encode: not ACGT");
+            }
+            out[i >> 2] = static_cast<char>(
+                static_cast<uint8_t>(out[i >> 2]) | (code << (6 - 2 * (i & 3))));
+        }
+    }
+
+    static std::string encode(std::string_view bases) {
+        std::string out;
+        encode(bases, out);
+        return out;
+    }
+
+    static void decode(std::string_view packed, size_t bases, std::string& out) {
+        if (packed.size() < packed_size(bases)) [[unlikely]]
+            throw std::invalid_argument("dna_codec::decode: packed key too short");
+        out.resize(bases);
+        for (size_t i = 0; i < bases; ++i)
+            out[i] = "ACGT"[(static_cast<uint8_t>(packed[i >> 2]) >> (6 - 2 * (i & 3))) & 3];
+    }
+
+    static std::string decode(std::string_view packed, size_t bases) {
+        std::string out;
+        decode(packed, bases, out);
+        return out;
+    }
+};
 
 template <typename VALUE>
 struct kstrie_slots {
@@ -487,17 +643,20 @@ struct node_header {
     uint16_t count;         // compact: entry count, bitmask: child_count
     uint16_t slots_off;     // compact: values offset (u64 units), bitmask: unused
     uint8_t  skip;          // prefix byte count (0 = no prefix)
-    uint8_t  flags;         // bit0: bitmask, bit2: has_skip. All-zeros = compact.
+    uint8_t  flags;         // bit0: bitmask, bit1: front-coded (images only),
+                            // bit2: has_skip. All-zeros = compact.
 
     // Maximum skip prefix that fits in a single node (full u8 range, no sentinel)
     static constexpr uint8_t SKIP_MAX = 255;
 
-    static constexpr uint8_t FLAG_BITMASK    = 1;
-    static constexpr uint8_t FLAG_HAS_SKIP   = 4;
+    static constexpr uint8_t FLAG_BITMASK      = 1;
+    static constexpr uint8_t FLAG_FRONT_CODED  = 2;
+    static constexpr uint8_t FLAG_HAS_SKIP     = 4;
 
     [[nodiscard]] bool is_compact()  const noexcept { return !(flags & FLAG_BITMASK); }
     [[nodiscard]] bool is_bitmap()   const noexcept { return flags & FLAG_BITMASK; }
     [[nodiscard]] bool has_skip()    const noexcept { return flags & FLAG_HAS_SKIP; }
+    [[nodiscard]] bool is_front_coded() const noexcept { return flags & FLAG_FRONT_CODED; }
 
     [[nodiscard]] uint32_t skip_bytes() const noexcept { return skip; }
 
@@ -648,6 +807,9 @@ inline constexpr uint16_t EOS_PARENT_BYTE  = 257;
 enum class insert_mode : uint8_t { INSERT, UPSERT, ASSIGN };
 enum class insert_outcome : uint8_t { INSERTED, UPDATED, FOUND };
 enum class dir_t : int8_t { FWD = +1, BWD = -1 };
+// Callback order for parallel walks: UNORDERED calls fn concurrently,
+// ORDERED replays buffered entries in key order on the calling thread.
+enum class walk_order : uint8_t { UNORDERED, ORDERED };
 
 struct insert_result {
     uint64_t*      node;
@@ -689,6 +851,56 @@ struct prefix_split_result {
     uint32_t  path_len; // mapped bytes consumed before stolen root
 };
 
+// Compaction walk.  A node is named by (path, eos): the mapped bytes
+// consumed before it, and whether it is its parent's EOS child.  Pre-order
+// visits nodes in ascending path, a bitmask before its EOS child, so
+// (lo, lo_eos) marks the first node not yet moved.  has_lo = false: fresh pass.
+struct compact_walk_t {
+    std::string lo;
+    bool        lo_eos  = false;
+    bool        has_lo  = false;
+    size_t      budget  = 0;      // nodes still to move this call
+    bool        stopped = false;
+};
+
+// Snapshot sharing.  refs counts the owners of a shared node beyond the
+// first; a node not in refs has one owner.  One table serves a trie and
+// all its snapshots.  mu guards refs, so a snapshot may be released on
+// another thread while the trie is written (given a thread-safe ALLOC).
+// any() is readable without mu: only the writer adds shares, so a stale
+// nonzero just costs a lookup.
+struct cow_table {
+    std::mutex mu;
+    std::unordered_map<const uint64_t*, uint32_t> refs;
+    std::atomic<size_t> shared_v{0};   // refs.size()
+
+    [[nodiscard]] bool any() const noexcept {
+        return shared_v.load(std::memory_order_acquire) != 0;
+    }
+
+    [[nodiscard]] bool is_shared(const uint64_t* n) {
+        std::lock_guard lk(mu);
+        return refs.contains(n);
+    }
+
+    void share(const uint64_t* n) {
+        std::lock_guard lk(mu);
+        if (++refs[n] == 1) shared_v.fetch_add(1, std::memory_order_release);
+    }
+
+    // Drop one owner.  True when others remain (caller must not free n).
+    bool drop(const uint64_t* n) {
+        std::lock_guard lk(mu);
+        auto it = refs.find(n);
+        if (it == refs.end()) return false;
+        if (--it->second == 0) {
+            refs.erase(it);
+            shared_v.fetch_sub(1, std::memory_order_release);
+        }
+        return true;
+    }
+};
+
 // Collapse: when bitmask total_tail <= COMPACT_KEYSUFFIX_LIMIT, try collapse to compact
 
 // REMOVED VK2_INIT_CAP — cap is now derived from padded allocation in alloc_compact_ks
@@ -702,6 +914,115 @@ static_assert(
         <= std::numeric_limits<uint16_t>::max(),
     "structural maximum node size exceeds uint16_t alloc cap");
 
+// ============================================================================
+// Instrumentation (KSTRIE_INSTRUMENT)
+//
+// Process-wide relaxed counters shared by every kstrie instantiation.
+// With KSTRIE_INSTRUMENT=0 the hooks are empty inline functions.
+// ============================================================================
+
+inline constexpr bool INSTRUMENT = KSTRIE_INSTRUMENT != 0;
+inline constexpr unsigned INSTRUMENT_BUCKETS = 16;
+
+enum class stat_t : unsigned {
+    FIND,           // find descents
+    FIND_NODES,     // bitmask nodes + compact leaf visited by those descents
+    SKIP_MISMATCH,  // a node's skip prefix disagreed with the key
+    COMPACT_HIT,    // find reached a compact leaf
+    SPLIT,          // compact -> bitmask promotion, or skip prefix split
+    COALESCE,       // bitmask subtree collapsed back into a compact leaf
+    REALLOC,        // node outgrew its allocation on insert
+    BYTES_ALLOC,
+    BYTES_FREED,
+    COUNT_
+};
+
+// Snapshot returned by kstrie_instrument().
+struct instrument_t {
+    uint64_t finds           = 0;
+    uint64_t find_nodes      = 0;
+    uint64_t skip_mismatches = 0;
+    uint64_t compact_hits    = 0;
+    uint64_t splits          = 0;
+    uint64_t coalesces       = 0;
+    uint64_t reallocs        = 0;
+    uint64_t bytes_allocated = 0;
+    uint64_t bytes_freed     = 0;
+    // depth[d]: finds that dispatched through d bitmask nodes (last bucket saturates)
+    uint64_t depth[INSTRUMENT_BUCKETS] = {};
+    // compact_fill[b]: compact-leaf find hits whose keysuffix use is in the
+    // b-th sixteenth of COMPACT_KEYSUFFIX_LIMIT
+    uint64_t compact_fill[INSTRUMENT_BUCKETS] = {};
+};
+
+#if KSTRIE_INSTRUMENT
+struct instrument_counters_t {
+    std::atomic<uint64_t> ev[static_cast<unsigned>(stat_t::COUNT_)];
+    std::atomic<uint64_t> depth[INSTRUMENT_BUCKETS];
+    std::atomic<uint64_t> compact_fill[INSTRUMENT_BUCKETS];
+};
+inline instrument_counters_t instrument_counters{};
+#endif
+
+inline void stat_add([[maybe_unused]] stat_t s,
+                     [[maybe_unused]] uint64_t n = 1) noexcept {
+#if KSTRIE_INSTRUMENT
+    instrument_counters.ev[static_cast<unsigned>(s)].fetch_add(n, std::memory_order_relaxed);
+#endif
+}
+
+inline void stat_find_depth([[maybe_unused]] unsigned levels) noexcept {
+#if KSTRIE_INSTRUMENT
+    stat_add(stat_t::FIND);
+    stat_add(stat_t::FIND_NODES, levels);
+    unsigned b = levels < INSTRUMENT_BUCKETS ? levels : INSTRUMENT_BUCKETS - 1;
+    instrument_counters.depth[b].fetch_add(1, std::memory_order_relaxed);
+#endif
+}
+
+inline void stat_compact_hit([[maybe_unused]] uint32_t keysuffix_used) noexcept {
+#if KSTRIE_INSTRUMENT
+    stat_add(stat_t::COMPACT_HIT);
+    stat_add(stat_t::FIND_NODES);
+    unsigned b = static_cast<unsigned>(keysuffix_used * INSTRUMENT_BUCKETS / COMPACT_KEYSUFFIX_LIMIT);
+    if (b >= INSTRUMENT_BUCKETS) b = INSTRUMENT_BUCKETS - 1;
+    instrument_counters.compact_fill[b].fetch_add(1, std::memory_order_relaxed);
+#endif
+}
+
+inline instrument_t instrument_snapshot() noexcept {
+    instrument_t r;
+#if KSTRIE_INSTRUMENT
+    auto ld = [](stat_t s) {
+        return instrument_counters.ev[static_cast<unsigned>(s)].load(std::memory_order_relaxed);
+    };
+    r.finds           = ld(stat_t::FIND);
+    r.find_nodes      = ld(stat_t::FIND_NODES);
+    r.skip_mismatches = ld(stat_t::SKIP_MISMATCH);
+    r.compact_hits    = ld(stat_t::COMPACT_HIT);
+    r.splits          = ld(stat_t::SPLIT);
+    r.coalesces       = ld(stat_t::COALESCE);
+    r.reallocs        = ld(stat_t::REALLOC);
+    r.bytes_allocated = ld(stat_t::BYTES_ALLOC);
+    r.bytes_freed     = ld(stat_t::BYTES_FREED);
+    for (unsigned i = 0; i < INSTRUMENT_BUCKETS; ++i) {
+        r.depth[i]        = instrument_counters.depth[i].load(std::memory_order_relaxed);
+        r.compact_fill[i] = instrument_counters.compact_fill[i].load(std::memory_order_relaxed);
+    }
+#endif
+    return r;
+}
+
+inline void instrument_reset() noexcept {
+#if KSTRIE_INSTRUMENT
+    for (auto& c : instrument_counters.ev) c.store(0, std::memory_order_relaxed);
+    for (unsigned i = 0; i < INSTRUMENT_BUCKETS; ++i) {
+        instrument_counters.depth[i].store(0, std::memory_order_relaxed);
+        instrument_counters.compact_fill[i].store(0, std::memory_order_relaxed);
+    }
+#endif
+}
+
 template <typename ALLOC>
 struct kstrie_memory {
     ALLOC alloc_v{};
@@ -713,6 +1034,7 @@ struct kstrie_memory {
         std::memset(p, 0, au * U64_BYTES);
         uint16_t au16 = static_cast<uint16_t>(au);
         std::memcpy(p, &au16, sizeof(au16));
+        stat_add(stat_t::BYTES_ALLOC, au * U64_BYTES);
         return p;
     }
     void free_node(uint64_t* p) {
@@ -720,6 +1042,7 @@ struct kstrie_memory {
         uint16_t au;
         std::memcpy(&au, p, sizeof(au));
         if (au == 0) [[unlikely]] return;
+        stat_add(stat_t::BYTES_FREED, au * U64_BYTES);
         std::allocator_traits<ALLOC>::deallocate(alloc_v, p, au);
     }
 };
@@ -2,19 +2,240 @@
 //
 // Five value types: Int64, Int32, Float, Bool, Object
 // Key type: str for all
+// Int64, Int32, Float and Bool also take key sequences and NumPy value
+// arrays in bulk: get_many, contains_many, set_many, range_array
 //
 // Build: g++ -std=c++23 -O2 -shared -fPIC
 //        $(python3 -m pybind11 --includes) py_kstrie.cpp
 //        -o kstrie$(python3-config --extension-suffix)
 
 #include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
 #include <pybind11/stl.h>
 #include "kstrie.hpp"
+#include <algorithm>
+#include <span>
+#include <vector>
 
 namespace py = pybind11;
 
 using namespace gteitelbaum;
 
+// ============================================================================
+// key_batch — borrow the UTF-8 bytes of a sequence of str / bytes keys
+// ============================================================================
+
+// str keys use CPython's cached UTF-8 form and bytes keys their own
+// storage, so nothing is copied.  Keys are referenced until this is
+// destroyed, so the views stay valid with the GIL released.  Construct
+// and destroy with the GIL held.
+struct key_batch {
+    std::vector<std::string_view> keys;
+    std::vector<py::object>       keep;
+
+    key_batch(py::sequence seq, const char* fn) {
+        if (py::isinstance<py::str>(seq) || py::isinstance<py::bytes>(seq))
+            throw py::type_error(std::string(fn) + "() takes a sequence of keys, not one key");
+        size_t n = static_cast<size_t>(py::len(seq));
+        keys.reserve(n);
+        keep.reserve(n);
+        for (auto item : seq) {
+            keep.push_back(py::reinterpret_borrow<py::object>(item));
+            if (py::isinstance<py::str>(item)) {
+                Py_ssize_t sz;
+                const char* ptr = PyUnicode_AsUTF8AndSize(item.ptr(), &sz);
+                if (!ptr) throw py::error_already_set();
+                keys.emplace_back(ptr, static_cast<size_t>(sz));
+            } else if (py::isinstance<py::bytes>(item)) {
+                char* ptr; Py_ssize_t sz;
+                PyBytes_AsStringAndSize(item.ptr(), &ptr, &sz);
+                keys.emplace_back(ptr, static_cast<size_t>(sz));
+            } else {
+                throw py::type_error(std::string(fn) + "() keys must be str or bytes");
+            }
+        }
+    }
+};
+
+// ============================================================================
+// Array kernels — plain C++ over raw buffers, run with the GIL released
+// ============================================================================
+
+// Keys per find_batch / contains_batch call; the scratch stays on the stack
+static constexpr size_t ARRAY_CHUNK = 256;
+
+// set_many inserts key by key when the batch is under 1/BULK_SET_RATIO
+// of the trie; otherwise it bulk builds the batch and unions it in
+static constexpr size_t BULK_SET_RATIO = 8;
+
+static constexpr size_t WORD_BITS = 64;
+
+template<typename V>
+void get_many_into(const kstrie<V>& t, const std::string_view* keys, size_t n,
+                   V* vals, bool* found) {
+    if constexpr (kstrie<V>::IS_BITMAP) {
+        // Packed bool values have no address for find_batch to return
+        for (size_t i = 0; i < n; ++i) {
+            auto it = t.find(keys[i]);
+            found[i] = it != t.end();
+            vals[i]  = found[i] && bool((*it).second);
+        }
+    } else {
+        const V* ptrs[ARRAY_CHUNK];
+        for (size_t base = 0; base < n; base += ARRAY_CHUNK) {
+            size_t m = std::min(ARRAY_CHUNK, n - base);
+            t.find_batch(std::span<const std::string_view>(keys + base, m),
+                         std::span<const V*>(ptrs, m));
+            for (size_t i = 0; i < m; ++i) {
+                found[base + i] = ptrs[i] != nullptr;
+                vals[base + i]  = ptrs[i] ? *ptrs[i] : V{};
+            }
+        }
+    }
+}
+
+template<typename V>
+void contains_many_into(const kstrie<V>& t, const std::string_view* keys, size_t n,
+                        bool* found) {
+    uint64_t words[ARRAY_CHUNK / WORD_BITS];
+    for (size_t base = 0; base < n; base += ARRAY_CHUNK) {
+        size_t m = std::min(ARRAY_CHUNK, n - base);
+        t.contains_batch(std::span<const std::string_view>(keys + base, m), words);
+        for (size_t i = 0; i < m; ++i)
+            found[base + i] = (words[i / WORD_BITS] >> (i % WORD_BITS)) & 1;
+    }
+}
+
+// Later duplicates win, as with repeated __setitem__
+template<typename V>
+void set_many_from(kstrie<V>& t, const std::string_view* keys, const V* vals, size_t n) {
+    if (n * BULK_SET_RATIO < t.size()) {
+        for (size_t i = 0; i < n; ++i) t.insert_or_assign(keys[i], vals[i]);
+        return;
+    }
+    std::vector<std::pair<std::string_view, V>> kv(n);
+    for (size_t i = 0; i < n; ++i) kv[i] = {keys[i], vals[i]};
+    std::stable_sort(kv.begin(), kv.end(),
+                     [](const auto& a, const auto& b) { return a.first < b.first; });
+    size_t w = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (w && kv[w - 1].first == kv[i].first) kv[w - 1].second = kv[i].second;
+        else kv[w++] = kv[i];
+    }
+    kv.resize(w);
+    auto batch = kstrie<V>::from_sorted(kv.begin(), kv.end());
+    t = t.empty() ? std::move(batch) : batch.set_union(t);
+}
+
+// Entries with lo <= key < hi, at most cap of them: values into vals,
+// key bytes appended to arena with key i at [offs[i], offs[i+1]).
+// With cap 0 it only counts.  Returns the full count.
+template<typename V>
+size_t range_into(const kstrie<V>& t, std::string_view lo, std::string_view hi,
+                  V* vals, std::vector<char>* arena, std::vector<size_t>* offs, size_t cap) {
+    size_t n = 0;
+    t.for_each_range(lo, hi, [&](std::string_view key, const auto& val) {
+        if (n < cap) {
+            vals[n] = val;
+            arena->insert(arena->end(), key.begin(), key.end());
+            offs->push_back(arena->size());
+        }
+        ++n;
+    });
+    return n;
+}
+
+// ============================================================================
+// bind_kstrie_arrays<V> — bulk operations (numeric and bool values)
+// ============================================================================
+//
+// Keys come in as any sequence of str / bytes, values as NumPy arrays
+// (converted to contiguous V if needed).  Each call borrows its inputs,
+// then releases the GIL for all trie work.  The trie must not be
+// modified from another thread meanwhile.
+
+template<typename V>
+void bind_kstrie_arrays(py::class_<kstrie<V>>& cls) {
+    using trie_t    = kstrie<V>;
+    using val_array = py::array_t<V, py::array::c_style | py::array::forcecast>;
+    using val_out   = py::array_t<V, py::array::c_style>;
+
+    cls
+        // get_many(keys) → (values, found); values[i] is 0 / False where
+        // found[i] is False
+        .def("get_many", [](const trie_t& t, py::sequence keys) {
+            key_batch kb(keys, "get_many");
+            size_t n = kb.keys.size();
+            val_array vals(static_cast<py::ssize_t>(n));
+            py::array_t<bool> found(static_cast<py::ssize_t>(n));
+            V* v = vals.mutable_data();
+            bool* f = found.mutable_data();
+            {
+                py::gil_scoped_release release;
+                get_many_into(t, kb.keys.data(), n, v, f);
+            }
+            return py::make_tuple(vals, found);
+        }, py::arg("keys"))
+
+        // contains_many(keys) → bool array
+        .def("contains_many", [](const trie_t& t, py::sequence keys) {
+            key_batch kb(keys, "contains_many");
+            size_t n = kb.keys.size();
+            py::array_t<bool> found(static_cast<py::ssize_t>(n));
+            bool* f = found.mutable_data();
+            {
+                py::gil_scoped_release release;
+                contains_many_into(t, kb.keys.data(), n, f);
+            }
+            return found;
+        }, py::arg("keys"))
+
+        // set_many(keys, values) — same result as assigning in order
+        .def("set_many", [](trie_t& t, py::sequence keys, val_array vals) {
+            key_batch kb(keys, "set_many");
+            if (kb.keys.size() != static_cast<size_t>(vals.size()))
+                throw py::value_error("set_many: keys and values differ in length");
+            const V* v = vals.data();
+            py::gil_scoped_release release;
+            set_many_from(t, kb.keys.data(), v, kb.keys.size());
+        }, py::arg("keys"), py::arg("values"))
+
+        // range_array(lo, hi, values=None) → (list[str], values) for
+        // lo <= key < hi in order.  A given values array (exact dtype,
+        // contiguous, long enough) is filled and returned sliced to the
+        // count; otherwise a new array is returned.
+        .def("range_array", [](const trie_t& t, std::string lo, std::string hi,
+                               py::object values) {
+            size_t n;
+            {
+                py::gil_scoped_release release;
+                n = range_into<V>(t, lo, hi, nullptr, nullptr, nullptr, 0);
+            }
+            val_out vo;
+            if (values.is_none()) {
+                vo = val_out(static_cast<py::ssize_t>(n));
+            } else {
+                if (!py::isinstance<val_out>(values))
+                    throw py::type_error("range_array: values must be a contiguous array of the trie's dtype");
+                vo = py::reinterpret_borrow<val_out>(values);
+                if (vo.ndim() != 1 || static_cast<size_t>(vo.size()) < n)
+                    throw py::value_error("range_array: values too small");
+            }
+            V* vp = vo.mutable_data();
+            std::vector<char>   arena;
+            std::vector<size_t> offs{0};
+            {
+                py::gil_scoped_release release;
+                offs.reserve(n + 1);
+                n = std::min(n, range_into(t, lo, hi, vp, &arena, &offs, n));
+            }
+            py::list keys(n);
+            for (size_t i = 0; i < n; ++i)
+                keys[i] = py::str(arena.data() + offs[i], offs[i + 1] - offs[i]);
+            return py::make_tuple(keys, vo[py::slice(0, static_cast<py::ssize_t>(n), 1)]);
+        }, py::arg("lo"), py::arg("hi"), py::arg("values") = py::none());
+}
+
 // ============================================================================
 // bind_kstrie<V> — register one kstrie<V> class
 // ============================================================================
@@ -210,6 +431,9 @@ void bind_kstrie(py::module_& m, const char* name) {
             return std::string("kstrie.") + name +
                    "(size=" + std::to_string(t.size()) + ")";
         });
+
+    if constexpr (!std::is_same_v<V, py::object>)
+        bind_kstrie_arrays<V>(cls);
 }
 
 // ============================================================================
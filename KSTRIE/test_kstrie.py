@@ -109,6 +109,54 @@ class TestInt64:
         assert m["item_02500"] == 2500
 
 
+# ============================================================================
+# Bulk operations (NumPy values)
+# ============================================================================
+
+class TestArrays:
+    @pytest.fixture
+    def np(self):
+        return pytest.importorskip("numpy")
+
+    def test_set_get_many(self, np):
+        m = kstrie.Int64()
+        m.set_many(["b", "a", "caf\u00e9", "a"], np.array([1, 2, 3, 4]))
+        assert len(m) == 3
+        assert m["a"] == 4                   # later duplicate wins
+        vals, found = m.get_many(["caf\u00e9", "zz", b"b"])
+        assert found.tolist() == [True, False, True]
+        assert vals.tolist() == [3, 0, 1]
+        assert m.contains_many(np.array(["a", "c"])).tolist() == [True, False]
+        with pytest.raises(TypeError):
+            m.get_many("abc")
+
+    def test_set_many_merges(self, np):
+        m = kstrie.Int32()
+        for i in range(100):
+            m[f"k{i:03d}"] = i
+        keys = [f"k{i:03d}" for i in range(50, 250)]
+        m.set_many(keys, -np.arange(50, 250))
+        assert len(m) == 250
+        assert m["k010"] == 10 and m["k060"] == -60
+
+    def test_range_array(self, np):
+        m = kstrie.Float()
+        m.set_many(["apple", "banana", "cherry", "date"], [1.0, 2.0, 3.0, 4.0])
+        keys, vals = m.range_array("b", "d")
+        assert keys == ["banana", "cherry"]
+        assert vals.tolist() == [2.0, 3.0]
+        out = np.zeros(4)
+        keys, vals = m.range_array("a", "z", out)
+        assert len(keys) == 4 and out.tolist() == [1.0, 2.0, 3.0, 4.0]
+
+    def test_bool(self, np):
+        m = kstrie.Bool()
+        m.set_many(["x", "y"], [True, False])
+        vals, found = m.get_many(["x", "y", "z"])
+        assert vals.tolist() == [True, False, False]
+        assert found.tolist() == [True, True, False]
+
+
 # ============================================================================
 # Prefix operations
 # ============================================================================
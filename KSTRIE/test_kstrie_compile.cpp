@@ -1,10 +1,93 @@
 #include "kstrie.hpp"
+#include "../KNTRIE/kntrie_pool_allocator.hpp"
 #include <cstdio>
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cctype>
+#include <coroutine>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
 
 using namespace gteitelbaum;
 
+// Minimal coroutine runtime for the co_find checks: a FIFO of ready
+// handles, a yield that requeues, and a fire-and-forget task.
+struct test_runtime {
+    std::deque<std::coroutine_handle<>> ready;
+    void run() {
+        while (!ready.empty()) {
+            auto h = ready.front();
+            ready.pop_front();
+            h.resume();
+        }
+    }
+};
+
+struct test_yield {
+    test_runtime* rt;
+    auto operator()() const noexcept {
+        struct awaiter {
+            test_runtime* rt;
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> h) const { rt->ready.push_back(h); }
+            void await_resume() const noexcept {}
+        };
+        return awaiter{rt};
+    }
+};
+
+struct test_detached {
+    struct promise_type {
+        test_detached get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() const noexcept { return {}; }
+        std::suspend_never final_suspend() const noexcept { return {}; }
+        void return_void() const noexcept {}
+        void unhandled_exception() const noexcept { std::terminate(); }
+    };
+};
+
+// Throws std::bad_alloc once g_alloc_left allocations have been made
+// (negative = never) and counts live blocks, for failure-path leak checks.
+static std::atomic<long> g_alloc_left{-1};
+static std::atomic<long> g_alloc_live{0};
+
+template <typename T>
+struct fail_alloc {
+    using value_type = T;
+    fail_alloc() = default;
+    template <typename U> fail_alloc(const fail_alloc<U>&) noexcept {}
+    T* allocate(std::size_t n) {
+        for (long left = g_alloc_left.load(); left >= 0; )
+            if (left == 0) throw std::bad_alloc();
+            else if (g_alloc_left.compare_exchange_weak(left, left - 1)) break;
+        ++g_alloc_live;
+        return std::allocator<T>{}.allocate(n);
+    }
+    void deallocate(T* p, std::size_t n) noexcept {
+        --g_alloc_live;
+        std::allocator<T>{}.deallocate(p, n);
+    }
+    friend bool operator==(const fail_alloc&, const fail_alloc&) noexcept { return true; }
+};
+
+template <typename T>
+test_detached co_probe(const T& t, const std::string& k, test_runtime& rt,
+                       std::string& hit, std::string& lb) {
+    auto a = co_await t.co_find(k, test_yield{&rt});
+    hit = a == t.end() ? "<none>" : std::string((*a).first);
+    auto b = co_await t.co_lower_bound(k, test_yield{&rt});
+    lb = b == t.end() ? "<none>" : std::string((*b).first);
+    auto c = co_await t.co_find(k);
+    assert((c == t.end()) == (a == t.end()));
+}
+
 int main() {
     // Basic CRUD
     kstrie<int64_t> t;
@@ -47,5 +130,776 @@ int main() {
     assert(te.size() == 3);
     assert(te.contains(""));
     
+    // Pool allocator through kstrie_memory (nodes + heap values)
+    {
+        using PA = kntrie_pool_allocator<uint64_t>;
+        kstrie<std::string, kstrie_traits::identity_char_map, PA> tp;
+        for (int i = 0; i < 5000; ++i)
+            tp.insert("key" + std::to_string(i), std::string(24, 'v'));
+        for (int i = 0; i < 5000; i += 2)
+            tp.erase("key" + std::to_string(i));
+        assert(tp.size() == 2500);
+        assert(tp.contains("key1") && !tp.contains("key0"));
+        assert(tp.get_allocator().stats().live_bytes > 0);
+        auto tc = tp;
+        tp.clear();
+        assert(tc.size() == 2500 && tc.contains("key4999"));
+
+        // Page-policy pool: huge-page slabs bound to the first NUMA node
+        kntrie_page_policy pol;
+        pol.numa  = kntrie_numa::BIND;
+        pol.nodes = uint64_t(1) << kntrie_numa_nodes().front();
+        kstrie<std::string, kstrie_traits::identity_char_map, PA> th{PA(pol)};
+        for (int i = 0; i < 5000; ++i) th.insert("key" + std::to_string(i), std::to_string(i));
+        assert(th.size() == 5000 && th.at("key4321") == "4321");
+        auto hs = th.get_allocator().stats();
+        assert(hs.reserved_bytes % (size_t(1) << 21) == 0 && hs.live_bytes > 0);
+        kstrie<int, kstrie_traits::identity_char_map, kntrie_hugepage_allocator<uint64_t>> tx;
+        for (int i = 0; i < 5000; ++i) tx.insert("k" + std::to_string(i), i);
+        assert(tx.size() == 5000 && tx.at("k77") == 77);
+    }
+
+    // Compact search (SIMD first-byte filter when built for AVX2/AVX-512)
+    // against std::map: dense runs of shared first bytes, hits and misses
+    {
+        kstrie<int64_t> tc;
+        std::map<std::string, int64_t> ref;
+        uint64_t x = 88172645463325252ull;
+        auto rnd = [&] { x ^= x << 13; x ^= x >> 7; x ^= x << 17; return x; };
+        auto make = [&] {
+            std::string k(1 + rnd() % 12, '\0');
+            for (auto& c : k) c = "/aab09.-~\xff"[rnd() % 10];
+            return k;
+        };
+        for (int i = 0; i < 30000; ++i) {
+            std::string k = make();
+            tc.insert(k, i);
+            ref.emplace(k, i);
+        }
+        assert(tc.size() == ref.size());
+        for (int i = 0; i < 30000; ++i) {
+            std::string k = make();
+            auto r = ref.find(k);
+            const int64_t* v = tc.contains(k) ? &tc.at(k) : nullptr;
+            assert((r == ref.end()) == (v == nullptr));
+            if (v) assert(*v == r->second);
+            auto lb = tc.lower_bound(k);
+            auto rl = ref.lower_bound(k);
+            assert((lb == tc.end()) == (rl == ref.end()));
+            if (rl != ref.end()) assert((*lb).first == rl->first);
+        }
+
+        // Batched lookup agrees with find() for every key
+        std::vector<std::string> qs;
+        for (int i = 0; i < 1000; ++i) qs.push_back(make());
+        qs.push_back("");
+        qs.push_back(ref.begin()->first);
+        std::vector<std::string_view> qv(qs.begin(), qs.end());
+        std::vector<const int64_t*> out(qv.size());
+        std::vector<uint64_t> bits((qv.size() + 63) / 64);
+        tc.find_batch(qv, out);
+        tc.contains_batch(qv, bits);
+        for (size_t i = 0; i < qv.size(); ++i) {
+            auto r = ref.find(qs[i]);
+            assert((out[i] != nullptr) == (r != ref.end()));
+            if (out[i]) assert(*out[i] == r->second);
+            assert(((bits[i / 64] >> (i % 64)) & 1) == (r != ref.end()));
+        }
+
+        // Coroutine lookups: interleaved round-robin and awaited under a
+        // queue runtime agree with std::map
+        {
+            using CI = kstrie<int64_t>::const_iterator;
+            const auto& ct = tc;
+            std::vector<kstrie_lookup<CI>> fs, ls;
+            for (const auto& q : qs) { fs.push_back(ct.co_find(q)); ls.push_back(ct.co_lower_bound(q)); }
+            kstrie_interleave(fs);
+            kstrie_interleave(ls.begin(), ls.end());
+            test_runtime rt;
+            std::vector<std::string> hit(qs.size()), lb(qs.size());
+            for (size_t i = 0; i < qs.size(); ++i) co_probe(ct, qs[i], rt, hit[i], lb[i]);
+            rt.run();
+            for (size_t i = 0; i < qs.size(); ++i) {
+                auto r = ref.find(qs[i]);
+                auto l = ref.lower_bound(qs[i]);
+                CI f = fs[i].result(), g = ls[i].result();
+                assert((f == ct.end()) == (r == ref.end()));
+                if (r != ref.end()) assert((*f).first == r->first && (*f).second == r->second);
+                assert((g == ct.end()) == (l == ref.end()));
+                if (l != ref.end()) assert((*g).first == l->first);
+                assert(hit[i] == (r == ref.end() ? "<none>" : r->first));
+                assert(lb[i] == (l == ref.end() ? "<none>" : l->first));
+            }
+        }
+
+        // Range scans agree with std::map over random [lo, hi)
+        auto ai = ref.begin();
+        tc.for_each([&](std::string_view k, const int64_t& v) {
+            assert(ai != ref.end() && k == ai->first && v == ai->second);
+            ++ai;
+        });
+        assert(ai == ref.end());
+        for (int i = 0; i < 300; ++i) {
+            std::string lo = make(), hi = make();
+            if (i % 7 == 0) hi = lo + "a";
+            if (i % 11 == 0) lo = ref.lower_bound(lo) == ref.end() ? lo : ref.lower_bound(lo)->first;
+            auto a = ref.lower_bound(lo);
+            auto b = ref.lower_bound(hi);
+            size_t want = (a == ref.end() || (b != ref.end() && b->first <= a->first))
+                        ? 0 : static_cast<size_t>(std::distance(a, b));
+            size_t n = 0;
+            tc.for_each_range(lo, hi, [&](std::string_view k, const int64_t& v) {
+                assert(a != ref.end() && k == a->first && v == a->second);
+                ++a;
+                ++n;
+            });
+            assert(n == want);
+            n = 0;
+            tc.for_each_range(lo, [&](std::string_view, const int64_t&) { ++n; });
+            assert(n == static_cast<size_t>(std::distance(ref.lower_bound(lo), ref.end())));
+        }
+
+        // Fuzzy search agrees with brute-force Levenshtein over ref
+        auto lev = [](const std::string& a, const std::string& b) {
+            std::vector<uint32_t> row(b.size() + 1);
+            for (size_t j = 0; j <= b.size(); ++j) row[j] = static_cast<uint32_t>(j);
+            for (size_t i = 1; i <= a.size(); ++i) {
+                uint32_t diag = row[0];
+                row[0] = static_cast<uint32_t>(i);
+                for (size_t j = 1; j <= b.size(); ++j) {
+                    uint32_t up = row[j];
+                    row[j] = std::min({up + 1, row[j - 1] + 1, diag + (a[i - 1] != b[j - 1])});
+                    diag = up;
+                }
+            }
+            return row[b.size()];
+        };
+        for (int i = 0; i < 40; ++i) {
+            std::string q = i % 2 ? make() : std::next(ref.begin(), i * 97)->first;
+            uint32_t k = 1 + i % 3;
+            std::vector<std::pair<std::string, uint32_t>> want, got;
+            for (auto& [key, v] : ref)
+                if (uint32_t d = lev(key, q); d <= k) want.emplace_back(key, d);
+            tc.fuzzy_search(q, k, [&](std::string_view key, const int64_t& v, uint32_t d) {
+                assert(ref.at(std::string(key)) == v);
+                got.emplace_back(key, d);
+            });
+            assert(got == want);
+        }
+
+        // Dictionary scan / longest_prefix_match against per-substring probes
+        std::string text;
+        while (text.size() < 3000) text += make();
+        size_t nscan = 0;
+        std::vector<std::pair<size_t, size_t>> hits;
+        tc.scan(text, [&](size_t off, std::string_view m, const int64_t& v) {
+            assert(m.data() == text.data() + off && ref.at(std::string(m)) == v);
+            hits.emplace_back(off, m.size());
+        });
+        for (size_t i = 0; i < text.size(); ++i) {
+            size_t best = 0;
+            for (size_t l = 1; l <= 12 && i + l <= text.size(); ++l) {
+                if (!ref.count(text.substr(i, l))) continue;
+                assert(hits[nscan++] == std::make_pair(i, l));
+                best = l;
+            }
+            auto [it, ml] = tc.longest_prefix_match(std::string_view(text).substr(i));
+            assert(ml == best && (best == 0) == (it == tc.end()));
+            if (best) assert((*it).first == text.substr(i, best));
+        }
+        assert(nscan == hits.size() && nscan > 1000);
+
+        kstrie<uint32_t, kstrie_traits::upper_char_map> tu;
+        for (uint32_t i = 0; i < 3000; ++i) tu.insert("Tok" + std::to_string(i), i);
+        size_t nfz = 0, wfz = 0;
+        tu.fuzzy_search("tok12", 1, [&](std::string_view key, const uint32_t&) {
+            assert(lev(std::string(key), "TOK12") <= 1);
+            ++nfz;
+        });
+        for (uint32_t i = 0; i < 3000; ++i) wfz += lev("TOK" + std::to_string(i), "TOK12") <= 1;
+        assert(nfz == wfz && nfz > 30);
+        std::vector<std::string> found;
+        tu.scan("xtok299!", [&](size_t, std::string_view m, const uint32_t& v) {
+            assert(tu.at(m) == v);
+            found.emplace_back(m);
+        });
+        assert((found == std::vector<std::string>{"tok2", "tok29", "tok299"}));
+        tu.insert("", 7);
+        auto [ue, ul] = tu.longest_prefix_match("zz");
+        assert(ue != tu.end() && ul == 0 && (*ue).second == 7);
+        assert(tu.longest_prefix_match("TOK12345").second == 7);
+        tu.erase("");
+        size_t nu = 0;
+        tu.for_each_range("tok10", "TOK11", [&](std::string_view k, const uint32_t&) {
+            assert(k.starts_with("TOK10"));
+            ++nu;
+        });
+        assert(nu == 111);
+        std::vector<std::string> us = {"tok7", "TOK2999", "tok3000", "", "Tok12"};
+        std::vector<std::string_view> uv(us.begin(), us.end());
+        std::vector<const uint32_t*> uo(uv.size());
+        tu.find_batch(uv, uo);
+        assert(*uo[0] == 7 && *uo[1] == 2999 && !uo[2] && !uo[3] && *uo[4] == 12);
+        bool threw = false;
+        try { tu.find_batch(uv, std::span<const uint32_t*>(uo.data(), 2)); }
+        catch (const std::invalid_argument&) { threw = true; }
+        assert(threw);
+    }
+
+    // Sorted bulk build: same contents as key-by-key insert, still mutable
+    {
+        std::map<std::string, int64_t> ref;
+        for (int i = 0; i < 40000; ++i)
+            ref.emplace("word" + std::to_string(i * 7919 % 65537), i);
+        std::string deep(600, 'p');
+        ref.emplace("", -1);
+        ref.emplace(deep, 1);
+        ref.emplace(deep + "q", 2);
+        ref.emplace(deep.substr(0, 300) + "z", 3);
+        for (int i = 0; i < 300; ++i)
+            ref.emplace(std::string(1, static_cast<char>(i & 0xFF)) + "x", i);
+
+        std::vector<std::pair<std::string, int64_t>> in(ref.begin(), ref.end());
+        in.insert(in.begin() + 5, in[4]);  // repeated key keeps first
+        auto tb = kstrie<int64_t>::from_sorted(in);
+        assert(tb.size() == ref.size());
+        auto it = tb.begin();
+        for (auto& [k, v] : ref) {
+            assert(it != tb.end() && (*it).first == k && (*it).second == v);
+            ++it;
+        }
+        assert(it == tb.end());
+        assert(tb.at(deep + "q") == 2 && !tb.contains(deep.substr(0, 300)));
+
+        for (int i = 0; i < 40000; i += 3) {
+            std::string k = "word" + std::to_string(i * 7919 % 65537);
+            assert(tb.erase(k) == 1);
+            ref.erase(k);
+        }
+        tb.insert("wordx", 9);
+        ref.emplace("wordx", 9);
+        assert(tb.size() == ref.size());
+        for (auto& [k, v] : ref) assert(tb.at(k) == v);
+
+        std::vector<std::pair<std::string, int64_t>> bad = {{"b", 1}, {"a", 2}};
+        bool threw = false;
+        try { (void)kstrie<int64_t>::from_sorted(bad); }
+        catch (const std::invalid_argument&) { threw = true; }
+        assert(threw);
+
+        using UM = kstrie_traits::upper_char_map;
+        std::vector<std::pair<std::string, std::string>> us = {
+            {"Ab", "1"}, {"aB", "dup"}, {"AC", "2"}, {"b", "3"}};
+        auto tu = kstrie<std::string, UM>::from_sorted(us.begin(), us.end());
+        assert(tu.size() == 3 && tu.at("ab") == "1" && tu.at("ac") == "2");
+
+        kstrie<int64_t> te2;
+        te2.assign_sorted(in.end(), in.end());
+        assert(te2.empty());
+
+        // A bulk load that fails part way leaves the old contents and
+        // leaks nothing
+        {
+            using FT = kstrie<std::string, kstrie_traits::identity_char_map,
+                              fail_alloc<uint64_t>>;
+            std::vector<std::pair<std::string, std::string>> src;
+            for (int i = 0; i < 3000; ++i) {
+                std::string k = "k" + std::to_string(100000 + i * 7);
+                src.emplace_back(k, k + std::string(40, 'v'));
+            }
+            std::vector<std::pair<std::string, std::string>> old(src.begin(), src.begin() + 50);
+            for (long budget = 0; ; budget += 7) {
+                FT ft = FT::from_sorted(old);
+                g_alloc_left = budget;
+                bool ok = true;
+                try { ft.assign_sorted(src.begin(), src.end()); }
+                catch (const std::bad_alloc&) { ok = false; }
+                g_alloc_left = -1;
+                if (ok) { assert(ft.size() == src.size()); break; }
+                assert(ft.size() == old.size());
+                for (auto& [k, v] : old) assert(ft.at(k) == v);
+            }
+            assert(g_alloc_live == 0);
+        }
+
+        // Range scans across long skips
+        for (auto [lo, hi] : {std::pair{deep.substr(0, 299), deep + "q"},
+                              std::pair{deep, deep + "q"}, std::pair{deep + "a", deep + "r"},
+                              std::pair{std::string("word2"), std::string("word3")},
+                              std::pair{std::string(""), std::string("\x01")}}) {
+            size_t n = 0;
+            tb.for_each_range(lo, hi, [&](std::string_view k, const int64_t& v) {
+                assert(k >= lo && k < hi && ref.at(std::string(k)) == v);
+                ++n;
+            });
+            assert(n == static_cast<size_t>(
+                std::distance(ref.lower_bound(lo), ref.lower_bound(hi))));
+        }
+
+        // Parallel walks match the serial walk (ORDERED: exactly)
+        using WO = kstrie<int64_t>::walk_order;
+        for (const char* q : {"", "word1", "word", "pppp", "zz"}) {
+            auto want = tb.prefix_vector(q);
+            std::vector<std::pair<std::string, int64_t>> got;
+            tb.parallel_prefix_walk(q, [&](std::string_view k, const int64_t& v) {
+                got.emplace_back(k, v);
+            }, 4, WO::ORDERED);
+            assert(got == want);
+
+            std::mutex mu;
+            std::vector<std::pair<std::string, int64_t>> un;
+            tb.parallel_prefix_walk(q, [&](std::string_view k, const int64_t& v) {
+                std::lock_guard lk(mu);
+                un.emplace_back(k, v);
+            }, 8);
+            std::sort(un.begin(), un.end());
+            assert(un == want);
+        }
+        std::atomic<size_t> seen{0};
+        tb.parallel_for_each([&](std::string_view, const int64_t&) { ++seen; });
+        assert(seen == tb.size());
+        threw = false;
+        try {
+            tb.parallel_for_each([](std::string_view k, const int64_t&) {
+                if (k == "wordx") throw std::runtime_error("stop");
+            }, 4);
+        } catch (const std::runtime_error&) { threw = true; }
+        assert(threw);
+    }
+
+    // Image round-trip: save() then map(), every read path over the file
+    {
+        kstrie<uint32_t> ti;
+        ti.insert("", 7);
+        for (uint32_t i = 0; i < 20000; ++i) {
+            ti.insert("w" + std::to_string(i * 7919u % 100003u), i);
+            if (i % 97 == 0)
+                ti.insert("/api/v1/some/long/shared/path/" + std::to_string(i), i + 1);
+        }
+        const char* path = "kstrie_image_test.bin";
+        ti.save(path);
+        auto v = kstrie<uint32_t>::map(path);
+        assert(v.size() == ti.size());
+
+        auto vi = v.begin();
+        for (auto it = ti.begin(); it != ti.end(); ++it, ++vi) {
+            assert(vi != v.end());
+            auto [k, val] = *vi;
+            assert(k == std::string((*it).first) && val == (*it).second);
+        }
+        assert(vi == v.end());
+
+        assert(v.at("") == 7 && v.find_value("w0") == 0u);
+        assert(!v.contains("w") && !v.contains("zzz") && !v.find_value("/api"));
+        for (const char* q : {"", "w", "w5", "w99", "/api/v1/some/long/shared/path/9",
+                              "/api/v2", "x", "\xff"}) {
+            auto a = ti.lower_bound(q);
+            auto b = v.lower_bound(q);
+            assert((a == ti.end()) == (b == v.end()));
+            if (b != v.end()) assert(b.key() == std::string((*a).first));
+
+            auto [pf, pl] = v.prefix(q);
+            size_t n = 0;
+            for (auto it = pf; it != pl; ++it, ++n)
+                assert(it.key().starts_with(q));
+            assert(n == ti.prefix_count(q) && n == v.prefix_count(q));
+
+            std::vector<std::string> got;
+            v.prefix_walk(q, [&](std::string_view k, const uint32_t& x) {
+                assert(v.at(k) == x);
+                got.emplace_back(k);
+            });
+            assert(got.size() == n);
+        }
+        auto ub = v.upper_bound("w5");
+        assert(ub.key() > std::string("w5"));
+
+        kstrie<bool> tb2;
+        for (int i = 0; i < 3000; ++i) tb2.insert("b" + std::to_string(i), i % 3 == 0);
+        tb2.save(path);
+        auto vb = kstrie<bool>::map(path);
+        assert(vb.size() == 3000 && vb.at("b0") && !vb.at("b1") && !vb.at("b2999") && vb.at("b2997"));
+        bool threw = false;
+        try { (void)kstrie<uint32_t>::map(path); } catch (const std::runtime_error&) { threw = true; }
+        assert(threw);
+
+        using UM = kstrie_traits::upper_char_map;
+        kstrie<uint32_t, UM> tu;
+        for (uint32_t i = 0; i < 5000; ++i) tu.insert("Key" + std::to_string(i), i);
+        tu.save(path);
+        auto vu = kstrie<uint32_t, UM>::map(path);
+        assert(vu.size() == 5000 && vu.at("KEY42") == 42 && vu.at("key4999") == 4999);
+        assert(vu.prefix_count("key1") == tu.prefix_count("KEY1"));
+        assert(vu.begin().key() == "KEY0");
+        threw = false;
+        try { (void)kstrie<uint32_t>::map(path); } catch (const std::runtime_error&) { threw = true; }
+        assert(threw);
+
+        kstrie<uint32_t> te2;
+        te2.save(path);
+        auto ve = kstrie<uint32_t>::map(path);
+        assert(ve.empty() && ve.begin() == ve.end() && !ve.contains(""));
+
+        // Path keys: long shared runs inside leaves, written front-coded
+        kstrie<uint32_t> tpk;
+        std::map<std::string, uint32_t> pref;
+        const char* seg[] = {"src", "include", "lib", "share", "doc", "x"};
+        for (uint32_t i = 0; i < 30000; ++i) {
+            std::string k = "/usr";
+            for (uint32_t d = 0, z = i * 2654435761u; d < 1 + i % 5; ++d, z /= 7)
+                k += std::string("/") + seg[z % 6];
+            k += "/f" + std::to_string(i % 977);
+            tpk.insert(k, i);
+            pref.emplace(k, i);
+        }
+        tpk.save(path);
+        auto vp = kstrie<uint32_t>::map(path);
+        assert(vp.size() == pref.size());
+        auto pi = pref.begin();
+        for (auto it = vp.begin(); it != vp.end(); ++it, ++pi)
+            assert(it.key() == pi->first && it.value() == pi->second);
+        assert(pi == pref.end());
+        for (auto& [k, x] : pref) {
+            assert(vp.at(k) == x);
+            std::string miss = k;
+            miss.back() = static_cast<char>(miss.back() + 1);
+            auto lb = vp.lower_bound(k.substr(0, k.size() - 1) + "~");
+            auto rl = pref.lower_bound(k.substr(0, k.size() - 1) + "~");
+            assert((lb == vp.end()) == (rl == pref.end()));
+            if (lb != vp.end()) assert(lb.key() == rl->first);
+            assert(vp.contains(miss) == (pref.count(miss) == 1));
+        }
+        for (const char* q : {"/usr/src", "/usr/lib/doc/", "/usr/x/x/x", "/usr/share/f9"})
+            assert(vp.prefix_count(q) == tpk.prefix_count(q));
+        std::remove(path);
+    }
+
+    // Shipped dense-alphabet maps: folded keys collide, order follows the
+    // mapped symbols; the 2-word maps reach their top index
+    {
+        auto check = [](auto tag, const char* alpha, auto fold) {
+            using M = decltype(tag);
+            kstrie<uint32_t, M> tm;
+            std::map<std::string, uint32_t> ref;
+            uint64_t x = 0x9E3779B97F4A7C15ull;
+            size_t na = std::strlen(alpha);
+            for (uint32_t i = 0; i < 20000; ++i) {
+                std::string k(1 + (x = x * 6364136223846793005ull + 1442695040888963407ull) % 9, '\0');
+                for (auto& c : k) c = alpha[((x = x * 6364136223846793005ull + 1) >> 33) % na];
+                tm.insert(k, i);
+                std::string f = k;
+                for (auto& c : f) c = fold(c);
+                ref.emplace(f, i);
+            }
+            assert(tm.size() == ref.size());
+            auto it = ref.begin();
+            tm.for_each([&](std::string_view k, const uint32_t& v) {
+                assert(it != ref.end() && k == it->first && v == it->second);
+                ++it;
+            });
+            assert(it == ref.end());
+        };
+        auto same = [](char c) { return c; };
+        auto lower = [](char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); };
+        auto upper = [](char c) { return static_cast<char>(std::toupper(static_cast<unsigned char>(c))); };
+        check(kstrie_traits::dna_char_map{}, "ACGTacgt", upper);
+        check(kstrie_traits::hex_char_map{}, "0123456789abcdefABCDEF", lower);
+        check(kstrie_traits::lower_alnum_char_map{}, "abcdefghijklmnopqrstuvwxyz0123456789XYZ", lower);
+        check(kstrie_traits::base64_char_map{},
+              "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/=", same);
+        check(kstrie_traits::url_safe_char_map{},
+              "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-._~", same);
+
+        kstrie<uint8_t, kstrie_traits::dna_char_map> td;
+        td.insert("ACGTX", 1);
+        assert(td.contains("acgtn") && (*td.begin()).first == "ACGTN");
+
+        // Packed k-mers: round trip and order preserved at fixed length
+        using DC = kstrie_traits::dna_codec;
+        assert(DC::encode("ACGT") == std::string(1, '\x1b'));
+        assert(DC::decode(DC::encode("gattaca"), 7) == "GATTACA");
+        kstrie<uint32_t> tk;
+        std::vector<std::string> kmers;
+        for (uint32_t i = 0; i < 4096; ++i) {
+            std::string k(11, 'A');
+            for (int j = 0; j < 11; ++j) k[j] = "ACGT"[(i * 2654435761u >> (2 * j)) & 3];
+            kmers.push_back(k);
+            tk.insert(DC::encode(k), i);
+        }
+        std::sort(kmers.begin(), kmers.end());
+        kmers.erase(std::unique(kmers.begin(), kmers.end()), kmers.end());
+        assert(tk.size() == kmers.size());
+        size_t ki = 0;
+        tk.for_each([&](std::string_view k, const uint32_t&) {
+            assert(k.size() == DC::packed_size(11) && DC::decode(k, 11) == kmers[ki++]);
+        });
+        bool threw = false;
+        try { (void)DC::encode("ACGN"); } catch (const std::invalid_argument&) { threw = true; }
+        assert(threw);
+    }
+
+    // Set algebra: intersect / set_union / set_difference / merge_with
+    {
+        uint64_t x = 0x243F6A8885A308D3ull;
+        auto rnd = [&] { return (x = x * 6364136223846793005ull + 1442695040888963407ull) >> 33; };
+        auto gen = [&](size_t n, const char* heads) {
+            std::map<std::string, std::string> m;
+            for (size_t i = 0; i < n; ++i) {
+                std::string k = std::string("/srv/") + heads[rnd() % std::strlen(heads)];
+                size_t len = rnd() % 40;
+                for (size_t j = 0; j < len; ++j) k += "ab/cdXY"[rnd() % 7];
+                if (rnd() % 5 == 0) k.resize(rnd() % (k.size() + 1));
+                m.emplace(k, std::to_string(rnd() % 1000));
+            }
+            return m;
+        };
+        using M = std::map<std::string, std::string>;
+        auto build = [](const M& m) { return kstrie<std::string>::from_sorted(m); };
+        auto check = [](const kstrie<std::string>& t, const M& want) {
+            assert(t.size() == want.size());
+            auto it = want.begin();
+            t.for_each([&](std::string_view k, const std::string& v) {
+                assert(it != want.end() && k == it->first && v == it->second);
+                ++it;
+            });
+            assert(it == want.end());
+            for (const auto& [k, v] : want) assert(t.at(k) == v);
+        };
+        for (auto [na, nb, ha, hb] : {std::tuple{4000, 3000, "abc", "bcd"},
+                                      std::tuple{30, 5000, "ab", "abcdef"},
+                                      std::tuple{2000, 0, "a", "a"},
+                                      std::tuple{500, 600, "pq", "rs"}}) {
+            M ma = gen(na, ha), mb = gen(nb, hb);
+            for (size_t i = 0; i < ma.size() / 3; ++i) {  // guaranteed overlap
+                auto it = std::next(ma.begin(), static_cast<long>(rnd() % ma.size()));
+                mb.emplace(it->first, "b" + it->second);
+            }
+            auto ta = build(ma), tb = build(mb);
+            M mi, mu = mb, md, mm = mb;
+            for (const auto& [k, v] : ma) {
+                mu[k] = v;
+                if (mb.count(k)) { mi.emplace(k, v); mm[k] = v + "+" + mb[k]; }
+                else             { md.emplace(k, v); mm[k] = v; }
+            }
+            check(ta.intersect(tb), mi);
+            check(ta.set_union(tb), mu);
+            check(ta.set_difference(tb), md);
+            check(ta.merge_with(tb, [](const std::string& a, const std::string& b) {
+                      return a + "+" + b; }), mm);
+            M mdb;
+            for (const auto& [k, v] : mb) if (!ma.count(k)) mdb.emplace(k, v);
+            check(tb.set_difference(ta), mdb);
+            check(ta.intersect(ta), ma);
+            check(ta.set_difference(ta), M{});
+        }
+
+        // Inline and bool values, folded keys
+        kstrie<uint32_t, kstrie_traits::upper_char_map> la, lb;
+        for (uint32_t i = 0; i < 3000; ++i) la.insert("Key" + std::to_string(i * 3), i);
+        for (uint32_t i = 0; i < 3000; ++i) lb.insert("KEY" + std::to_string(i * 5), i);
+        auto li = la.intersect(lb);
+        assert(li.size() == 600);
+        li.for_each([](std::string_view k, const uint32_t& v) {
+            assert(std::stoul(std::string(k.substr(3))) % 15 == 0 && v * 3 == std::stoul(std::string(k.substr(3))));
+        });
+        assert(la.merge_with(lb, [](uint32_t a, uint32_t b) { return a + b; }).size() == 5400);
+        kstrie<bool> ba, bb;
+        for (int i = 0; i < 1000; ++i) { ba.insert(std::to_string(i), i & 1); bb.insert(std::to_string(i * 2), true); }
+        auto bi = ba.intersect(bb);
+        assert(bi.size() == 500 && !bi.at("10") && !bi.contains("11"));
+        assert(ba.merge_with(bb, [](bool a, bool b) { return a || b; }).at("10"));
+    }
+
+    // Compaction: full pass shrinks churned nodes; sliced passes survive
+    // interleaved mutation
+    {
+        using M = std::map<std::string, std::string>;
+        kstrie<std::string> t;
+        M m;
+        uint64_t s = 99;
+        auto rnd = [&] { s = s * 6364136223846793005ULL + 1442695040888963407ULL; return s >> 33; };
+        auto key = [&] { return "c/" + std::to_string(rnd() % 40000) + (rnd() & 1 ? "/x" : ""); };
+        auto check = [&] {
+            assert(t.size() == m.size());
+            auto it = t.begin();
+            for (const auto& [k, v] : m) { assert((*it).first == k && (*it).second == v); ++it; }
+            assert(it == t.end());
+        };
+        for (int i = 0; i < 30000; ++i) { auto k = key(); t.insert(k, k); m.emplace(k, k); }
+        for (int i = 0; i < 20000; ++i) { auto k = key(); t.erase(k); m.erase(k); }
+        size_t before = t.memory_usage();
+        t.shrink_to_fit();
+        check();
+        assert(t.memory_usage() <= before);
+
+        int calls = 0;
+        for (int pass = 0; pass < 2; ++pass) {
+            while (!t.compact(5)) {
+                auto k = key();
+                if (rnd() & 1) { t.insert(k, k); m.emplace(k, k); }
+                else           { t.erase(k); m.erase(k); }
+                assert(++calls < 1000000);
+            }
+            check();
+        }
+
+        kstrie<bool> b;
+        for (int i = 0; i < 5000; ++i) b.insert(std::to_string(i * 7), i & 1);
+        for (int i = 0; i < 5000; i += 2) b.erase(std::to_string(i * 7));
+        while (!b.compact(1)) {}
+        assert(b.size() == 2500);
+        for (int i = 1; i < 5000; i += 2) assert(b.at(std::to_string(i * 7)));
+
+        // a compact leaf with erase holes keeps its cap when moved
+        kstrie<std::string> h;
+        std::string v(40, 'v');
+        for (int i = 0; i < 5; ++i) h.insert("h" + std::to_string(i), v);
+        h.erase("h1"); h.erase("h3");
+        while (!h.compact(1000)) {}
+        for (int i = 5; i < 9; ++i) h.insert("h" + std::to_string(i), v);
+        assert(h.size() == 7 && !h.contains("h1") && h.at("h8") == v);
+    }
+
+    // Snapshots: frozen contents under every kind of write; any release
+    // order; concurrent reader
+    {
+        using M = std::map<std::string, std::string>;
+        auto check = [](const auto& snap, const M& m) {
+            assert(snap.size() == m.size());
+            auto it = m.begin();
+            snap.for_each([&](std::string_view k, const std::string& v) {
+                assert(it != m.end() && it->first == k && it->second == v);
+                ++it;
+            });
+            assert(it == m.end());
+        };
+        kstrie<std::string> t;
+        M m;
+        for (int i = 0; i < 20000; ++i) {
+            auto k = "s/" + std::to_string(i * 13 % 20000) + (i & 1 ? "/y" : "");
+            t.insert(k, k + "!");
+            m.emplace(k, k + "!");
+        }
+        auto s0 = t.snapshot();
+        M m0 = m;
+        check(s0, m0);
+        assert(s0.at("s/13/y") == "s/13/y!" && !s0.find("nope"));
+
+        for (int i = 0; i < 20000; i += 3) { auto k = "s/" + std::to_string(i); t.erase(k); m.erase(k); }
+        for (int i = 0; i < 5000; ++i) { auto k = "n/" + std::to_string(i); t.insert(k, k); m.emplace(k, k); }
+        t["s/13/y"] = "changed";
+        m["s/13/y"] = "changed";
+        (*t.find("s/26")).second = "found";
+        m["s/26"] = "found";
+        check(s0, m0);
+
+        auto s1 = t.snapshot();
+        M m1 = m;
+        assert(t.prefix_erase("s/1") > 0);
+        std::erase_if(m, [](const auto& kv) { return kv.first.starts_with("s/1"); });
+        auto split = t.prefix_split("n/");
+        std::erase_if(m, [](const auto& kv) { return kv.first.starts_with("n/"); });
+        assert(split.size() == 5000 && split.at("n/42") == "n/42");
+        t.shrink_to_fit();
+        check(s0, m0);
+        check(s1, m1);
+        assert(s1.prefix_count("n/") == 5000 && s0.prefix_count("n/") == 0);
+        assert(s1.at("s/13/y") == "changed" && s0.at("s/13/y") == "s/13/y!");
+        size_t seen = 0;
+        s1.for_each_range("s/2", "s/3", [&](std::string_view k, const std::string&) {
+            assert(k >= "s/2" && k < "s/3");
+            ++seen;
+        });
+        assert(seen == static_cast<size_t>(std::count_if(m1.begin(), m1.end(), [](const auto& kv) {
+            return kv.first >= "s/2" && kv.first < "s/3"; })));
+
+        {
+            auto s2 = t.snapshot();
+            t.clear();
+            assert(t.empty() && s2.size() == m.size());
+            check(s2, m);
+        }
+        s0 = {};
+        check(s1, m1);
+        split.insert("n/new", "x");
+        s1 = {};
+
+        // Writes through any mutable iterator copy the path first
+        kstrie<int> w;
+        for (int i = 0; i < 3000; ++i) w.insert("k" + std::to_string(i), i);
+        auto ws = w.snapshot();
+        (*w.try_emplace("k42", 7).first).second = -1;
+        for (auto&& [k, v] : w) v += 10000;
+        auto wr = w.end();
+        --wr;
+        (*wr).second = -2;
+        auto ws2 = w.snapshot();
+        (*w.find("k7")).second = -3;
+        for (int i = 0; i < 3000; ++i) assert(ws.at("k" + std::to_string(i)) == i);
+        assert(ws2.at("k42") == 9999 && ws2.at("k7") == 10007);
+        assert(w.at("k42") == 9999 && w.at("k7") == -3 && w.at("k999") == -2);
+        kstrie<bool> wb;
+        for (int i = 0; i < 3000; ++i) wb.insert(std::to_string(i), false);
+        auto wbs = wb.snapshot();
+        for (auto it = wb.begin(); it != wb.end(); ++it) (*it).second = true;
+        wbs.for_each([](std::string_view, const bool& v) { assert(!v); });
+        assert(wb.at("1234") && wbs.size() == 3000);
+
+        kstrie<uint32_t> c;
+        for (uint32_t i = 0; i < 50000; ++i) c.insert("k" + std::to_string(i), i);
+        auto cs = c.snapshot();
+        std::atomic<bool> ok{true};
+        std::thread reader([&] {
+            for (int pass = 0; pass < 3; ++pass) {
+                uint64_t sum = 0;
+                size_t n = 0;
+                cs.for_each([&](std::string_view, const uint32_t& v) { sum += v; ++n; });
+                if (n != 50000 || sum != 50000ULL * 49999 / 2) ok = false;
+                for (uint32_t i = 0; i < 50000; i += 97)
+                    if (cs.at("k" + std::to_string(i)) != i) ok = false;
+            }
+        });
+        for (uint32_t i = 0; i < 50000; ++i) {
+            if (i & 1) c.erase("k" + std::to_string(i));
+            else       c["k" + std::to_string(i)] = i + 1;
+        }
+        reader.join();
+        assert(ok && c.size() == 25000 && c.at("k10") == 11);
+    }
+
+    // Instrumentation: zero when compiled out; consistent when compiled in
+    {
+        kstrie_instrument_reset();
+        kstrie_instrument_t built, found;
+        uint64_t depth_sum = 0, fill_sum = 0;
+        {
+            kstrie<int> it;
+            for (int i = 0; i < 20000; ++i) it.insert("inst/" + std::to_string(i * 7), i);
+            built = kstrie_instrument();
+            kstrie_instrument_reset();
+            for (int i = 0; i < 20000; ++i) assert(it.contains("inst/" + std::to_string(i * 7)));
+            assert(!it.contains("zzz"));
+            found = kstrie_instrument();
+            for (unsigned b = 0; b < kstrie_detail::INSTRUMENT_BUCKETS; ++b) {
+                depth_sum += found.depth[b];
+                fill_sum  += found.compact_fill[b];
+            }
+            kstrie_instrument_reset();
+            for (int i = 0; i < 20000; ++i) it.erase("inst/" + std::to_string(i * 7));
+        }
+        auto after = kstrie_instrument();
+        if constexpr (kstrie_detail::INSTRUMENT) {
+            assert(built.splits > 0 && built.reallocs > 0 && built.bytes_allocated > 0);
+            assert(found.finds == 20001 && depth_sum == found.finds);
+            assert(found.compact_hits >= 20000 && fill_sum == found.compact_hits);
+            assert(found.skip_mismatches + found.compact_hits == found.finds);
+            assert(found.find_nodes > found.compact_hits);
+            assert(after.coalesces > 0 && after.bytes_freed > 0);
+        } else {
+            assert(built.bytes_allocated == 0 && found.finds == 0 &&
+                   depth_sum == 0 && fill_sum == 0 && after.bytes_freed == 0);
+        }
+    }
+
     std::printf("ALL OK\n");
 }
@@ -4,7 +4,23 @@
 // Usage:
 //   ktoken::tokenizer<> t("UnicodeData.txt", "cl100k_base.tiktoken");  // defaults: cl100k + tiktoken
 //   auto ids = t.encode(text, len);
+//   size_t n = t.encode_into(text, len, out, cap);     // no allocation
 //   auto bytes = t.decode(ids.data(), ids.size());
+//   size_t m = t.decode_into(ids.data(), ids.size(), buf, cap);  // no allocation
+//
+//   // Parallel encode (threads = 0 → hardware concurrency):
+//   auto batch = t.encode_batch(docs);                 // span<const span<const uint8_t>>
+//   auto big   = t.encode_parallel(text, len);
+//
+//   // Streaming: tokens reach the sink as soon as their chunk is final
+//   auto se = t.stream();
+//   se.feed(bytes, n, [&](const uint32_t* ids, size_t k) { ... });
+//   se.finish(sink);
+//
+//   // Streaming decode: bytes reach the sink in whole UTF-8 chars
+//   auto sd = t.decode_stream();
+//   sd.feed(id, [&](const uint8_t* b, size_t k) { ... });
+//   sd.finish(sink);
 //
 //   // Other models/formats:
 //   ktoken::tokenizer<ktoken::o200k> t2("UnicodeData.txt", "o200k_base.tiktoken");
@@ -18,19 +34,40 @@
 #include "kstrie.hpp"
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <bit>
 #include <cstdint>
 #include <cstring>
+#include <exception>
 #include <fstream>
+#include <functional>
+#include <optional>
 #include <queue>
+#include <span>
+#include <stdexcept>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <vector>
 
+// SIMD ASCII run scan: widest vector the target guarantees.  Define
+// KTOKEN_NO_SIMD_CLASSIFY to force scalar.
+#if !defined(KTOKEN_NO_SIMD_CLASSIFY) && defined(__AVX512BW__)
+#include <immintrin.h>
+#define KTOKEN_SIMD_CLASSIFY_BITS 512
+#elif !defined(KTOKEN_NO_SIMD_CLASSIFY) && defined(__AVX2__)
+#include <immintrin.h>
+#define KTOKEN_SIMD_CLASSIFY_BITS 256
+#else
+#define KTOKEN_SIMD_CLASSIFY_BITS 0
+#endif
+
 namespace ktoken {
 
 // SSO byte string: 15 bytes inline (covers 99% of tokens), no heap alloc.
-// Replaces vector<uint8_t> in decode table — eliminates ~100K heap allocations.
+// Loaders collect token bytes in these before packing the decode table.
 using byte_string = std::basic_string<uint8_t>;
+using byte_view   = std::basic_string_view<uint8_t>;
 
 // ===========================================================================
 // Constants
@@ -39,11 +76,12 @@ using byte_string = std::basic_string<uint8_t>;
 static constexpr uint32_t BASE_TOKENS       = 256;
 static constexpr uint32_t NO_RANK           = UINT32_MAX;
 static constexpr size_t   PAIR_SHIFT        = 32;
-static constexpr int      MAX_PARTS         = 256;
+static constexpr int      MAX_PARTS         = 256;   // array-engine capacity; longer chunks use the heap engine
 static constexpr size_t   ASCII_COUNT       = 128;
 static constexpr int      MAX_DIGIT_RUN     = 3;
 static constexpr uint32_t SURROGATE_LO      = 0xD800;
 static constexpr uint32_t SURROGATE_HI      = 0xDFFF;
+static constexpr uint32_t MAX_CODEPOINT     = 0x10FFFF;
 
 inline constexpr uint64_t pack_pair(uint32_t l, uint32_t r) {
     return (uint64_t(l) << PAIR_SHIFT) | r;
@@ -60,6 +98,7 @@ enum char_class : uint8_t {
     CL_DIGIT = 4, CL_WHITESPACE = 5, CL_NEWLINE = 6, CL_APOSTROPHE = 7,
     CL_OTHER = 8,
 };
+static constexpr size_t CLASS_COUNT = 9;
 
 inline constexpr bool is_letter_or_mark(uint8_t c) { return c <= CL_MARK; }
 inline constexpr bool is_ws(uint8_t c) { return c == CL_WHITESPACE || c == CL_NEWLINE; }
@@ -94,6 +133,10 @@ inline int encode_utf8(uint32_t cp, char* buf) {
 using cat_trie_t = gteitelbaum::kntrie<uint32_t, uint8_t>;
 
 inline uint8_t g_ascii_class[ASCII_COUNT];
+// Same table as nibble bitmaps for the SIMD scan, one per class set:
+// bit (b >> 4) of g_class_set_bits[set][b & 15] is set iff g_ascii_class[b]
+// is in set.  512 x 16 bytes; each split loop touches a handful of rows.
+alignas(16) inline uint8_t g_class_set_bits[1u << CLASS_COUNT][16];
 
 struct classify_result { uint8_t cls; uint8_t len; };
 
@@ -107,6 +150,8 @@ inline classify_result classify(const cat_trie_t& trie, const uint8_t* data, siz
     return {static_cast<uint8_t>(it != trie.end() ? (*it).second : CL_OTHER), static_cast<uint8_t>(clen)};
 }
 
+inline void init_ascii_tables(const cat_trie_t& trie);
+
 inline cat_trie_t build_category_trie(const char* path) {
     cat_trie_t trie;
     std::ifstream f(path); std::string line;
@@ -139,12 +184,88 @@ inline cat_trie_t build_category_trie(const char* path) {
     trie.insert_or_assign(0x0A, CL_NEWLINE); trie.insert_or_assign(0x0D, CL_NEWLINE);
     trie.insert_or_assign(0x09, CL_WHITESPACE); trie.insert_or_assign(0x0B, CL_WHITESPACE);
     trie.insert_or_assign(0x0C, CL_WHITESPACE);
+    init_ascii_tables(trie);
+    return trie;
+}
+
+// Fill the ASCII fast-path tables from a category trie
+inline void init_ascii_tables(const cat_trie_t& trie) {
     std::memset(g_ascii_class, CL_OTHER, sizeof(g_ascii_class));
     for (uint32_t cp = 0; cp < ASCII_COUNT; ++cp) {
         auto it = trie.find(cp);
         if (it != trie.end()) g_ascii_class[cp] = (*it).second;
     }
-    return trie;
+    std::memset(g_class_set_bits, 0, sizeof(g_class_set_bits));
+    for (uint32_t set = 0; set < (1u << CLASS_COUNT); ++set)
+        for (uint32_t cp = 0; cp < ASCII_COUNT; ++cp)
+            if (set >> g_ascii_class[cp] & 1) g_class_set_bits[set][cp & 0x0F] |= uint8_t(1u << (cp >> 4));
+}
+
+// ===========================================================================
+// Class runs — SIMD over pure-ASCII spans, classify() for the rest
+// ===========================================================================
+
+// Bitmask of the classes a predicate accepts: class_set<is_letter_or_mark>.
+template<auto PRED>
+inline constexpr uint16_t class_set = [] {
+    uint16_t m = 0;
+    for (uint8_t c = 0; c < CLASS_COUNT; ++c) if (PRED(c)) m |= uint16_t(1u << c);
+    return m;
+}();
+
+// First position >= pos that is not an ASCII byte whose class is in SET.
+// Each vector block is two pshufb lookups: the low nibble selects a byte of
+// the set's bitmap, the high nibble selects the bit (0 for >= 0x80).
+template<uint16_t SET>
+inline size_t ascii_run_end(const uint8_t* data, size_t pos, size_t len) {
+#if KTOKEN_SIMD_CLASSIFY_BITS
+    const __m128i bits = _mm_load_si128(reinterpret_cast<const __m128i*>(g_class_set_bits[SET]));
+    const __m128i hi_bit = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, (char)128, 0, 0, 0, 0, 0, 0, 0, 0);
+#if KTOKEN_SIMD_CLASSIFY_BITS == 512
+    // Zero-masked with every lane selected: the unmasked broadcast (and
+    // shuffle) pass an undefined operand that GCC flags maybe-uninitialized.
+    const __m512i lo_tbl = _mm512_maskz_broadcast_i32x4(0xFFFF, bits);
+    const __m512i hi_tbl = _mm512_maskz_broadcast_i32x4(0xFFFF, hi_bit);
+    const __m512i nib = _mm512_set1_epi8(0x0F);
+    for (; pos + 64 <= len; pos += 64) {
+        __m512i v  = _mm512_loadu_si512(data + pos);
+        __m512i lo = _mm512_shuffle_epi8(lo_tbl, _mm512_and_si512(v, nib));
+        __m512i hi = _mm512_shuffle_epi8(hi_tbl, _mm512_and_si512(_mm512_srli_epi16(v, 4), nib));
+        uint64_t miss = _mm512_testn_epi8_mask(lo, hi);
+        if (miss) return pos + std::countr_zero(miss);
+    }
+#else
+    const __m256i lo_tbl = _mm256_broadcastsi128_si256(bits), hi_tbl = _mm256_broadcastsi128_si256(hi_bit);
+    const __m256i nib = _mm256_set1_epi8(0x0F);
+    for (; pos + 32 <= len; pos += 32) {
+        __m256i v  = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+        __m256i lo = _mm256_shuffle_epi8(lo_tbl, _mm256_and_si256(v, nib));
+        __m256i hi = _mm256_shuffle_epi8(hi_tbl, _mm256_and_si256(_mm256_srli_epi16(v, 4), nib));
+        uint32_t miss = (uint32_t)_mm256_movemask_epi8(
+            _mm256_cmpeq_epi8(_mm256_and_si256(lo, hi), _mm256_setzero_si256()));
+        if (miss) return pos + std::countr_zero(miss);
+    }
+#endif
+#endif
+    while (pos < len && data[pos] < ASCII_COUNT && (SET >> g_ascii_class[data[pos]] & 1)) ++pos;
+    return pos;
+}
+
+// End of the run of characters whose class is in SET, starting at pos.
+// Multi-byte characters go through classify() without re-entering the
+// vector scan, so non-Latin text pays nothing for it.
+template<uint16_t SET>
+inline size_t scan_run(const cat_trie_t& trie, const uint8_t* data, size_t len, size_t pos) {
+    for (;;) {
+        if (pos >= len) return pos;
+        if (data[pos] < ASCII_COUNT) {
+            pos = ascii_run_end<SET>(data, pos, len);
+            if (pos >= len || data[pos] < ASCII_COUNT) return pos;
+        }
+        auto [c, l] = classify(trie, data + pos, len - pos);
+        if (!(SET >> c & 1)) return pos;
+        pos += l;
+    }
 }
 
 // ===========================================================================
@@ -174,6 +295,16 @@ inline int check_contraction(const cat_trie_t& trie, const uint8_t* data, size_t
 
 struct chunk_range { uint32_t off; uint32_t len; };
 
+// Each model's split_each(trie, data, len, emit) calls emit(chunk_range)
+// in order, allocating nothing; split() collects the same into a vector.
+template<typename Model>
+inline std::vector<chunk_range> collect_chunks(const cat_trie_t& trie, const uint8_t* data, size_t len) {
+    std::vector<chunk_range> chunks;
+    chunks.reserve(len / 3);
+    Model::split_each(trie, data, len, [&](chunk_range c) { chunks.push_back(c); });
+    return chunks;
+}
+
 // ===========================================================================
 // Whitespace handler (shared by cl100k and o200k)
 // Implements: \s*[\r\n]+ | \s+(?!\S) | \s+
@@ -207,8 +338,11 @@ struct cl100k {
     }
 
     static std::vector<chunk_range> split(const cat_trie_t& trie, const uint8_t* data, size_t len) {
-        std::vector<chunk_range> chunks;
-        chunks.reserve(len / 3);
+        return collect_chunks<cl100k>(trie, data, len);
+    }
+
+    template<typename F>
+    static void split_each(const cat_trie_t& trie, const uint8_t* data, size_t len, F&& emit) {
         size_t pos = 0;
         while (pos < len) {
             size_t start = pos;
@@ -216,44 +350,42 @@ struct cl100k {
 
             if (cls == CL_APOSTROPHE) {
                 int cm = check_contraction(trie, data+pos, len-pos);
-                if (cm > 0) { chunks.push_back({(uint32_t)start,(uint32_t)cm}); pos += cm; continue; }
+                if (cm > 0) { emit(chunk_range{(uint32_t)start,(uint32_t)cm}); pos += cm; continue; }
             }
             if (is_prefix(cls)) {
                 size_t probe = pos + clen;
                 if (probe < len) {
                     auto [nc, nl] = classify(trie, data+probe, len-probe);
                     if (is_letter_or_mark(nc)) {
-                        pos = probe;
-                        while (pos < len) { auto [c2,l2] = classify(trie,data+pos,len-pos); if (!is_letter_or_mark(c2)) break; pos+=l2; }
-                        chunks.push_back({(uint32_t)start,(uint32_t)(pos-start)}); continue;
+                        pos = scan_run<class_set<is_letter_or_mark>>(trie, data, len, probe);
+                        emit(chunk_range{(uint32_t)start,(uint32_t)(pos-start)}); continue;
                     }
                 }
             }
             if (is_letter_or_mark(cls)) {
-                while (pos < len) { auto [c2,l2] = classify(trie,data+pos,len-pos); if (!is_letter_or_mark(c2)) break; pos+=l2; }
-                chunks.push_back({(uint32_t)start,(uint32_t)(pos-start)}); continue;
+                pos = scan_run<class_set<is_letter_or_mark>>(trie, data, len, pos);
+                emit(chunk_range{(uint32_t)start,(uint32_t)(pos-start)}); continue;
             }
             if (cls == CL_DIGIT) {
                 int count = 0;
                 while (pos < len && count < MAX_DIGIT_RUN) { auto [c2,l2] = classify(trie,data+pos,len-pos); if (c2!=CL_DIGIT) break; pos+=l2; count++; }
-                chunks.push_back({(uint32_t)start,(uint32_t)(pos-start)}); continue;
+                emit(chunk_range{(uint32_t)start,(uint32_t)(pos-start)}); continue;
             }
             if (cls == CL_WHITESPACE) {
                 size_t probe = pos + clen;
                 if (probe < len) { auto [nc,nl] = classify(trie,data+probe,len-probe); if (is_punct(nc)) { pos = probe; goto punct; } }
             }
             if (is_punct(cls)) { punct:
-                while (pos < len) { auto [c2,l2] = classify(trie,data+pos,len-pos); if (!is_punct(c2)) break; pos+=l2; }
+                pos = scan_run<class_set<is_punct>>(trie, data, len, pos);
                 while (pos < len) { auto [c2,l2] = classify(trie,data+pos,len-pos); if (c2!=CL_NEWLINE) break; pos+=l2; }
-                chunks.push_back({(uint32_t)start,(uint32_t)(pos-start)}); continue;
+                emit(chunk_range{(uint32_t)start,(uint32_t)(pos-start)}); continue;
             }
             if (is_ws(cls)) {
                 pos = handle_whitespace(trie, data, len, pos, start);
-                chunks.push_back({(uint32_t)start,(uint32_t)(pos-start)}); continue;
+                emit(chunk_range{(uint32_t)start,(uint32_t)(pos-start)}); continue;
             }
-            pos += clen; chunks.push_back({(uint32_t)start,(uint32_t)(pos-start)});
+            pos += clen; emit(chunk_range{(uint32_t)start,(uint32_t)(pos-start)});
         }
-        return chunks;
     }
 };
 
@@ -268,22 +400,25 @@ struct o200k {
     static constexpr bool is_prefix(uint8_t c) { return c == CL_MARK || c == CL_WHITESPACE || c == CL_APOSTROPHE || c == CL_OTHER; }
 
     static size_t scan_lower(const cat_trie_t& t, const uint8_t* d, size_t len, size_t pos) {
-        while (pos < len) { auto [c,l] = classify(t,d+pos,len-pos); if (!in_lower_set(c)) break; pos+=l; } return pos;
+        return scan_run<class_set<in_lower_set>>(t, d, len, pos);
     }
     static size_t try_contraction(const cat_trie_t& t, const uint8_t* d, size_t len, size_t pos) {
         if (pos < len) { int cm = check_contraction(t, d+pos, len-pos); if (cm > 0) pos += cm; } return pos;
     }
     static size_t scan_punct_run(const cat_trie_t& t, const uint8_t* d, size_t len, size_t pos) {
-        while (pos < len) { auto [c,l] = classify(t,d+pos,len-pos); if (!is_punct(c)) break; pos+=l; }
+        pos = scan_run<class_set<is_punct>>(t, d, len, pos);
         while (pos < len) { auto [c,l] = classify(t,d+pos,len-pos); if (c==CL_NEWLINE){pos+=l;continue;} if(d[pos]=='/'){pos+=1;continue;} break; }
         return pos;
     }
 
     static std::vector<chunk_range> split(const cat_trie_t& trie, const uint8_t* data, size_t len) {
-        std::vector<chunk_range> out;
-        out.reserve(len / 3);
+        return collect_chunks<o200k>(trie, data, len);
+    }
+
+    template<typename F>
+    static void split_each(const cat_trie_t& trie, const uint8_t* data, size_t len, F&& out) {
         size_t pos = 0;
-        auto emit = [&](size_t s, size_t e) { if (e > s) out.push_back({(uint32_t)s,(uint32_t)(e-s)}); };
+        auto emit = [&](size_t s, size_t e) { if (e > s) out(chunk_range{(uint32_t)s,(uint32_t)(e-s)}); };
 
         while (pos < len) {
             size_t start = pos;
@@ -301,8 +436,7 @@ struct o200k {
 
             // Upper run with backtracking
             if (in_upper_set(cls)) {
-                size_t upper_end = letter_start + clen;
-                while (upper_end < len) { auto [c2,l2] = classify(trie,data+upper_end,len-upper_end); if (!in_upper_set(c2)) break; upper_end+=l2; }
+                size_t upper_end = scan_run<class_set<in_upper_set>>(trie, data, len, letter_start + clen);
 
                 if (upper_end < len) { auto [c2,l2] = classify(trie,data+upper_end,len-upper_end);
                     if (in_lower_set(c2)) { pos = try_contraction(trie,data,len,scan_lower(trie,data,len,upper_end)); emit(start,pos); continue; }
@@ -310,10 +444,10 @@ struct o200k {
 
                 // Backtrack: find last non-CL_UPPER
                 size_t split_pos = letter_start; bool found = false;
-                { struct ci { size_t p; uint8_t c; uint8_t l; }; std::vector<ci> chars;
-                  size_t scan = letter_start;
-                  while (scan < upper_end) { auto [c2,l2] = classify(trie,data+scan,len-scan); chars.push_back({scan,c2,l2}); scan+=l2; }
-                  for (int i = (int)chars.size()-1; i >= 0; --i) { if (chars[i].c != CL_UPPER) { split_pos = chars[i].p; found = true; break; } }
+                for (size_t scan = letter_start; scan < upper_end; ) {
+                    auto [c2,l2] = classify(trie,data+scan,len-scan);
+                    if (c2 != CL_UPPER) { split_pos = scan; found = true; }
+                    scan += l2;
                 }
                 if (found) { pos = try_contraction(trie,data,len,scan_lower(trie,data,len,split_pos)); emit(start,pos); continue; }
 
@@ -330,7 +464,6 @@ struct o200k {
             if (is_ws(cls)) { pos = handle_whitespace(trie,data,len,pos,start); emit(start,pos); continue; }
             pos += clen; emit(start,pos);
         }
-        return out;
     }
 };
 
@@ -354,6 +487,7 @@ struct p50k {
     static constexpr bool is_letter(uint8_t c) {
         return c <= CL_OTHER_LETTER;  // LOWER, UPPER, OTHER_LETTER only
     }
+    static constexpr bool is_digit(uint8_t c) { return c == CL_DIGIT; }
 
     // Case-sensitive contraction: 's 't 'd 'm 'll 've 're (lowercase only)
     // Lookahead uses is_letter (no marks) — p50k's \p{L} excludes \p{M}
@@ -381,8 +515,11 @@ struct p50k {
     }
 
     static std::vector<chunk_range> split(const cat_trie_t& trie, const uint8_t* data, size_t len) {
-        std::vector<chunk_range> chunks;
-        chunks.reserve(len / 3);
+        return collect_chunks<p50k>(trie, data, len);
+    }
+
+    template<typename F>
+    static void split_each(const cat_trie_t& trie, const uint8_t* data, size_t len, F&& emit) {
         size_t pos = 0;
         while (pos < len) {
             size_t start = pos;
@@ -391,7 +528,7 @@ struct p50k {
             // Contractions: '(?:[sdmt]|ll|ve|re) — standalone, case-sensitive
             if (cls == CL_APOSTROPHE) {
                 int cm = check_contraction_cs(trie, data + pos, len - pos);
-                if (cm > 0) { chunks.push_back({(uint32_t)start, (uint32_t)cm}); pos += cm; continue; }
+                if (cm > 0) { emit(chunk_range{(uint32_t)start, (uint32_t)cm}); pos += cm; continue; }
             }
 
             // Optional space prefix + letters: " ?\p{L}+"
@@ -400,76 +537,181 @@ struct p50k {
                 if (probe < len) {
                     auto [nc, nl] = classify(trie, data + probe, len - probe);
                     if (is_letter(nc)) {
-                        pos = probe;
-                        while (pos < len) { auto [c2,l2] = classify(trie,data+pos,len-pos); if (!is_letter(c2)) break; pos+=l2; }
-                        chunks.push_back({(uint32_t)start, (uint32_t)(pos - start)}); continue;
+                        pos = scan_run<class_set<is_letter>>(trie, data, len, probe);
+                        emit(chunk_range{(uint32_t)start, (uint32_t)(pos - start)}); continue;
                     }
                     // " ?[^\s\p{L}\p{N}]+"
                     if (is_punct(nc)) {
-                        pos = probe;
-                        while (pos < len) { auto [c2,l2] = classify(trie,data+pos,len-pos); if (!is_punct(c2)) break; pos+=l2; }
-                        chunks.push_back({(uint32_t)start, (uint32_t)(pos - start)}); continue;
+                        pos = scan_run<class_set<is_punct>>(trie, data, len, probe);
+                        emit(chunk_range{(uint32_t)start, (uint32_t)(pos - start)}); continue;
                     }
                     // " ?\p{N}+"
                     if (nc == CL_DIGIT) {
-                        pos = probe;
-                        while (pos < len) { auto [c2,l2] = classify(trie,data+pos,len-pos); if (c2!=CL_DIGIT) break; pos+=l2; }
-                        chunks.push_back({(uint32_t)start, (uint32_t)(pos - start)}); continue;
+                        pos = scan_run<class_set<is_digit>>(trie, data, len, probe);
+                        emit(chunk_range{(uint32_t)start, (uint32_t)(pos - start)}); continue;
                     }
                 }
             }
 
             // Letters: \p{L}+ (no marks)
             if (is_letter(cls)) {
-                while (pos < len) { auto [c2,l2] = classify(trie,data+pos,len-pos); if (!is_letter(c2)) break; pos+=l2; }
-                chunks.push_back({(uint32_t)start, (uint32_t)(pos - start)}); continue;
+                pos = scan_run<class_set<is_letter>>(trie, data, len, pos);
+                emit(chunk_range{(uint32_t)start, (uint32_t)(pos - start)}); continue;
             }
 
             // Digits: \p{N}+ (no limit)
             if (cls == CL_DIGIT) {
-                while (pos < len) { auto [c2,l2] = classify(trie,data+pos,len-pos); if (c2!=CL_DIGIT) break; pos+=l2; }
-                chunks.push_back({(uint32_t)start, (uint32_t)(pos - start)}); continue;
+                pos = scan_run<class_set<is_digit>>(trie, data, len, pos);
+                emit(chunk_range{(uint32_t)start, (uint32_t)(pos - start)}); continue;
             }
 
             // Punctuation: [^\s\p{L}\p{N}]+
             if (is_punct(cls)) {
-                while (pos < len) { auto [c2,l2] = classify(trie,data+pos,len-pos); if (!is_punct(c2)) break; pos+=l2; }
-                chunks.push_back({(uint32_t)start, (uint32_t)(pos - start)}); continue;
+                pos = scan_run<class_set<is_punct>>(trie, data, len, pos);
+                emit(chunk_range{(uint32_t)start, (uint32_t)(pos - start)}); continue;
             }
 
             // Whitespace: \s+$|\s+(?!\S)|\s+
             if (is_ws(cls)) {
-                size_t run_end = pos;
-                while (run_end < len) { auto [c2,l2] = classify(trie,data+run_end,len-run_end); if (!is_ws(c2)) break; run_end+=l2; }
+                size_t run_end = scan_run<class_set<is_ws>>(trie, data, len, pos);
                 // \s+$ — at end of string, consume all
-                if (run_end == len) { pos = run_end; chunks.push_back({(uint32_t)start, (uint32_t)(pos-start)}); continue; }
+                if (run_end == len) { pos = run_end; emit(chunk_range{(uint32_t)start, (uint32_t)(pos-start)}); continue; }
                 // \s+(?!\S) — leave last char if followed by non-ws
                 size_t last_char_start = pos;
                 { size_t scan = pos; while (scan < run_end) { last_char_start = scan; auto [c2,l2] = classify(trie,data+scan,len-scan); scan+=l2; } }
                 if (last_char_start > start) { pos = last_char_start; }
                 else { pos = run_end; }
-                chunks.push_back({(uint32_t)start, (uint32_t)(pos - start)}); continue;
+                emit(chunk_range{(uint32_t)start, (uint32_t)(pos - start)}); continue;
             }
 
             // Fallback
             pos += clen;
-            chunks.push_back({(uint32_t)start, (uint32_t)(pos - start)});
+            emit(chunk_range{(uint32_t)start, (uint32_t)(pos - start)});
         }
-        return chunks;
     }
 };
 
+// ===========================================================================
+// Pair-rank hash — optional flat alternative to pair_trie for merge lookups
+// ===========================================================================
+
+enum class pair_backend : uint8_t { TRIE, HASH };
+
+// Open addressing, linear probing, load <= 1/2. One 8-byte slot per pair
+// packs left(20) | right(20) | rank(24): 2MB for cl100k's 100K merges
+// versus 1.5MB of trie, in exchange for ~1 cache line per lookup.
+struct pair_rank_table {
+    static constexpr uint32_t ID_BITS   = 20;
+    static constexpr uint32_t RANK_BITS = 24;
+    static constexpr uint64_t EMPTY     = UINT64_MAX;
+
+    std::vector<uint64_t> slots;
+    int shift = 64;
+
+    static constexpr uint64_t key(uint32_t l, uint32_t r) { return (uint64_t(l) << ID_BITS) | r; }
+    size_t home(uint64_t k) const { return (size_t)((k * 0x9E3779B97F4A7C15ull) >> shift); }
+
+    // False (table left empty) if the vocabulary has ids that do not fit
+    // a slot; all-ones ids are reserved so no key can collide with EMPTY.
+    bool build(const gteitelbaum::kntrie<uint64_t, uint32_t>& pairs, size_t vocab_size) {
+        slots.clear();
+        if (vocab_size >= (size_t(1) << ID_BITS) - 1) return false;
+        size_t cap = std::bit_ceil(std::max<size_t>(pairs.size() * 2, 16));
+        slots.assign(cap, EMPTY);
+        shift = 64 - std::countr_zero(cap);
+        for (auto [p, rank] : pairs) {
+            uint64_t k = key(pair_left(p), pair_right(p));
+            size_t i = home(k);
+            while (slots[i] != EMPTY) i = (i + 1) & (cap - 1);
+            slots[i] = (k << RANK_BITS) | rank;
+        }
+        return true;
+    }
+
+    uint32_t find(uint32_t l, uint32_t r) const {
+        uint64_t k = key(l, r);
+        for (size_t i = home(k);; i = (i + 1) & (slots.size() - 1)) {
+            uint64_t e = slots[i];
+            if ((e >> RANK_BITS) == k) return (uint32_t)(e & ((uint64_t(1) << RANK_BITS) - 1));
+            if (e == EMPTY) return NO_RANK;
+        }
+    }
+
+    size_t memory_usage() const { return slots.size() * sizeof(uint64_t); }
+};
+
+// ===========================================================================
+// Decode table — all token bytes packed in one arena
+// ===========================================================================
+
+// Token r is bytes[off[r] .. off[r+1]). Two allocations for the whole
+// vocab, and a decode is one offset load plus one memcpy per token.
+struct decode_table {
+    std::vector<uint32_t> off{0};
+    std::vector<uint8_t>  bytes;
+
+    decode_table() = default;
+
+    // Pack a rank-indexed list (loaders see ranks out of order)
+    explicit decode_table(const std::vector<byte_string>& by_rank) {
+        off.reserve(by_rank.size() + 1);
+        size_t total = 0;
+        for (auto& b : by_rank) total += b.size();
+        bytes.reserve(total);
+        for (auto& b : by_rank) push_back(b);
+    }
+
+    size_t size() const { return off.size() - 1; }
+    uint32_t length(uint32_t r) const { return off[r + 1] - off[r]; }
+    const uint8_t* data(uint32_t r) const { return bytes.data() + off[r]; }
+    byte_view operator[](uint32_t r) const { return {data(r), length(r)}; }
+
+    void push_back(byte_view b) {
+        bytes.insert(bytes.end(), b.begin(), b.end());
+        off.push_back((uint32_t)bytes.size());
+    }
+
+    // Append the concatenation of two existing tokens (a trained merge)
+    void push_concat(uint32_t l, uint32_t r) {
+        size_t at = bytes.size(), ll = length(l), rl = length(r);
+        bytes.resize(at + ll + rl);
+        std::memcpy(bytes.data() + at, bytes.data() + off[l], ll);
+        std::memcpy(bytes.data() + at + ll, bytes.data() + off[r], rl);
+        off.push_back((uint32_t)bytes.size());
+    }
+
+    size_t memory_usage() const { return off.size() * sizeof(uint32_t) + bytes.size(); }
+};
+
 // ===========================================================================
 // Vocab data — the core encoder state
 // ===========================================================================
 
 struct vocab_data {
-    std::vector<byte_string> decode;
+    decode_table decode;
     uint32_t byte_rank[BASE_TOKENS];
     gteitelbaum::kntrie<uint64_t, uint32_t> pair_trie;
     // Flat lookup for byte-byte pairs: eliminates kntrie traversal on init.
     // 256 * 256 * 4 = 256KB, fits in L2 cache.
     uint32_t byte_pair_rank[BASE_TOKENS][BASE_TOKENS];
+    // Merge lookups go to pair_trie unless HASH is selected; the table is
+    // built on first selection and pair_trie stays authoritative.
+    pair_backend backend = pair_backend::TRIE;
+    pair_rank_table pair_table;
+
+    uint32_t pair_rank(uint32_t l, uint32_t r) const {
+        if (backend == pair_backend::HASH) return pair_table.find(l, r);
+        auto it = pair_trie.find(pack_pair(l, r));
+        return it != pair_trie.end() ? (*it).second : NO_RANK;
+    }
+
+    // Returns the backend in effect: TRIE if the table cannot be built.
+    pair_backend set_pair_backend(pair_backend b) {
+        if (b == pair_backend::HASH && pair_table.slots.empty() &&
+            !pair_table.build(pair_trie, decode.size()))
+            b = pair_backend::TRIE;
+        return backend = b;
+    }
 
     void build_byte_pair_table() {
         for (uint32_t a = 0; a < BASE_TOKENS; ++a)
@@ -484,11 +726,34 @@ struct vocab_data {
 // BPE encode/decode engine
 // ===========================================================================
 
+// Chunks longer than this go to the heap engine (see bpe_encode_long).
+// Measured crossover on cl100k letter runs is ~192 bytes: below it the
+// array engine's contiguous scans beat the heap's bookkeeping.
+static constexpr uint32_t LONG_CHUNK_MIN = 192;
+static_assert(LONG_CHUNK_MIN <= (uint32_t)MAX_PARTS);
+
+// Long-chunk engine node: one live part, linked to its neighbours
+struct bpe_node {
+    uint32_t tok;
+    uint32_t rank;   // rank of pair (this, next); NO_RANK if none or merged away
+    uint32_t prev;
+    uint32_t next;
+};
+
 struct bpe_scratch {
     uint32_t parts[MAX_PARTS];
     uint32_t pair_ranks[MAX_PARTS];
     uint32_t result[MAX_PARTS];
     uint32_t result_count;
+    // Long-chunk engine state: grown on demand, reused across chunks
+    bool long_out = false;           // tokens are in long_result, not result
+    std::vector<bpe_node> nodes;
+    std::vector<uint64_t> heap;      // (rank << 32) | node, min-heap
+    std::vector<uint32_t> long_result;
+    // encode_batch stages each document here before copying it out once
+    std::vector<uint32_t> doc_tokens;
+
+    const uint32_t* tokens() const { return long_out ? long_result.data() : result; }
 };
 
 // Min-scan: [[unlikely]] tells the compiler the update is rare —
@@ -508,13 +773,16 @@ inline uint32_t find_min_pair(const uint32_t* pair_ranks, uint32_t n, uint32_t&
     return mi;
 }
 
-inline void bpe_encode_chunk(const vocab_data& vd, const uint8_t* data, uint32_t len,
+// Array engine: O(n) min-scan + memmove per merge. Fastest for the short
+// chunks natural text is made of; requires len <= MAX_PARTS.
+inline void bpe_encode_short(const vocab_data& vd, const uint8_t* data, uint32_t len,
                               bpe_scratch& s) {
+    s.long_out = false;
     s.result_count = 0;
     if (len == 0) return;
     if (len == 1) { s.result[0] = vd.byte_rank[data[0]]; s.result_count = 1; return; }
 
-    uint32_t n = (len > MAX_PARTS) ? MAX_PARTS : len;
+    uint32_t n = len;
     for (uint32_t i = 0; i < n; ++i) s.parts[i] = vd.byte_rank[data[i]];
     // First pass is always byte-byte pairs: use flat table, no kntrie
     for (uint32_t i = 0; i+1 < n; ++i)
@@ -534,21 +802,215 @@ inline void bpe_encode_chunk(const vocab_data& vd, const uint8_t* data, uint32_t
         n--;
 
         // Left neighbor
-        if (mi > 0) [[likely]] {
-            auto it = vd.pair_trie.find(pack_pair(s.parts[mi-1], s.parts[mi]));
-            s.pair_ranks[mi-1] = it != vd.pair_trie.end() ? (*it).second : NO_RANK;
-        }
+        if (mi > 0) [[likely]]
+            s.pair_ranks[mi-1] = vd.pair_rank(s.parts[mi-1], s.parts[mi]);
 
         // Right neighbor
-        if (mi + 1 < n) [[likely]] {
-            auto it = vd.pair_trie.find(pack_pair(s.parts[mi], s.parts[mi+1]));
-            s.pair_ranks[mi] = it != vd.pair_trie.end() ? (*it).second : NO_RANK;
-        }
+        if (mi + 1 < n) [[likely]]
+            s.pair_ranks[mi] = vd.pair_rank(s.parts[mi], s.parts[mi+1]);
     }
     std::memcpy(s.result, s.parts, n * sizeof(uint32_t));
     s.result_count = n;
 }
 
+// Heap engine: parts in a doubly linked list, pair ranks in a min-heap
+// keyed (rank, node). O(n log n) in chunk length, no length cap. Ties go
+// to the leftmost pair, as in the array engine's min-scan, so both
+// produce identical tokens. Stale heap entries (pair changed or merged
+// away) are dropped on pop by checking the node's current rank.
+inline void bpe_encode_long(const vocab_data& vd, const uint8_t* data, uint32_t len,
+                             bpe_scratch& s) {
+    static constexpr uint32_t NIL = UINT32_MAX;
+    auto pack = [](uint32_t rank, uint32_t i) { return (uint64_t(rank) << PAIR_SHIFT) | i; };
+    auto& nodes = s.nodes;
+    auto& heap = s.heap;
+    nodes.resize(len);
+    heap.clear();
+    for (uint32_t i = 0; i < len; ++i) {
+        uint32_t r = (i + 1 < len) ? vd.byte_pair_rank[data[i]][data[i+1]] : NO_RANK;
+        nodes[i] = {vd.byte_rank[data[i]], r, i ? i - 1 : NIL, (i + 1 < len) ? i + 1 : NIL};
+        if (r != NO_RANK) heap.push_back(pack(r, i));
+    }
+    std::make_heap(heap.begin(), heap.end(), std::greater<>{});
+
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<>{});
+        uint64_t e = heap.back();
+        heap.pop_back();
+        uint32_t r = (uint32_t)(e >> PAIR_SHIFT), i = (uint32_t)e;
+        bpe_node& L = nodes[i];
+        if (L.rank != r) continue;
+
+        // Merge next into i and unlink it
+        bpe_node& R = nodes[L.next];
+        L.tok = r;
+        L.next = R.next;
+        R.rank = NO_RANK;
+        if (L.next != NIL) nodes[L.next].prev = i;
+
+        L.rank = (L.next != NIL) ? vd.pair_rank(L.tok, nodes[L.next].tok) : NO_RANK;
+        if (L.rank != NO_RANK) {
+            heap.push_back(pack(L.rank, i));
+            std::push_heap(heap.begin(), heap.end(), std::greater<>{});
+        }
+        if (L.prev != NIL) {
+            bpe_node& P = nodes[L.prev];
+            P.rank = vd.pair_rank(P.tok, L.tok);
+            if (P.rank != NO_RANK) {
+                heap.push_back(pack(P.rank, L.prev));
+                std::push_heap(heap.begin(), heap.end(), std::greater<>{});
+            }
+        }
+    }
+
+    s.long_result.clear();
+    for (uint32_t i = 0; i != NIL; i = nodes[i].next) s.long_result.push_back(nodes[i].tok);
+    s.result_count = (uint32_t)s.long_result.size();
+    s.long_out = true;
+}
+
+// Encode one chunk; result is s.tokens()[0 .. s.result_count)
+inline void bpe_encode_chunk(const vocab_data& vd, const uint8_t* data, uint32_t len,
+                              bpe_scratch& s) {
+    if (len > LONG_CHUNK_MIN) bpe_encode_long(vd, data, len, s);
+    else                      bpe_encode_short(vd, data, len, s);
+}
+
+// ===========================================================================
+// Chunk cache — memoizes bpe_encode_chunk for short recurring chunks
+// (" the", " and", ...). Optional, bounded, one per thread.
+// ===========================================================================
+
+enum class cache_evict : uint8_t {
+    LRU,   // a full set replaces its least recently used way
+    NONE,  // fill-only: once a set is full, new chunks are not stored
+};
+
+struct bpe_cache_stats {
+    uint64_t hits      = 0;
+    uint64_t misses    = 0;
+    uint64_t evictions = 0;
+};
+
+// CACHE_WAYS-way set-associative table keyed by the chunk bytes. Only
+// chunks of 2..CACHE_KEY_MAX bytes encoding to at most CACHE_MAX_TOKENS
+// tokens are stored; everything else bypasses it. Not thread-safe.
+class bpe_cache {
+public:
+    static constexpr uint32_t CACHE_KEY_MAX    = 16;
+    static constexpr uint32_t CACHE_MAX_TOKENS = 4;
+    static constexpr uint32_t CACHE_WAYS       = 4;
+    static constexpr size_t   DEFAULT_CAPACITY = size_t(1) << 14;
+
+    // capacity is in entries, rounded up to a power-of-two number of sets
+    explicit bpe_cache(size_t capacity = DEFAULT_CAPACITY,
+                       cache_evict policy = cache_evict::LRU)
+        : policy_(policy) {
+        size_t sets = 1;
+        while (sets * CACHE_WAYS < capacity) sets <<= 1;
+        set_mask_ = sets - 1;
+        entries_.resize(sets * CACHE_WAYS);
+    }
+
+    size_t capacity() const { return entries_.size(); }
+    cache_evict policy() const { return policy_; }
+    const bpe_cache_stats& stats() const { return stats_; }
+    void reset_stats() { stats_ = {}; }
+
+    void clear() {
+        std::fill(entries_.begin(), entries_.end(), entry{});
+        stats_ = {};
+        clock_ = 0;
+    }
+
+    static constexpr bool cacheable(uint32_t len) { return len >= 2 && len <= CACHE_KEY_MAX; }
+
+    // On a hit, copy the cached tokens into s.tokens() and return true
+    bool lookup(const uint8_t* data, uint32_t len, bpe_scratch& s) {
+        key_t k = make_key(data, len);
+        entry* set = set_of(k, len);
+        for (uint32_t w = 0; w < CACHE_WAYS; ++w) {
+            entry& e = set[w];
+            if (e.len == len && e.key == k) {
+                ++stats_.hits;
+                e.stamp = ++clock_;
+                std::memcpy(s.result, e.tok, e.n_tok * sizeof(uint32_t));
+                s.result_count = e.n_tok;
+                s.long_out = false;
+                return true;
+            }
+        }
+        ++stats_.misses;
+        return false;
+    }
+
+    // Record the result of a missed lookup (s as left by bpe_encode_chunk)
+    void store(const uint8_t* data, uint32_t len, const bpe_scratch& s) {
+        if (s.result_count > CACHE_MAX_TOKENS) return;
+        key_t k = make_key(data, len);
+        entry* set = set_of(k, len);
+        entry* victim = nullptr;
+        for (uint32_t w = 0; w < CACHE_WAYS; ++w)
+            if (set[w].len == 0) { victim = &set[w]; break; }
+        if (!victim) {
+            if (policy_ == cache_evict::NONE) return;
+            victim = set;
+            for (uint32_t w = 1; w < CACHE_WAYS; ++w)
+                if (set[w].stamp < victim->stamp) victim = &set[w];
+            ++stats_.evictions;
+        }
+        victim->key   = k;
+        victim->len   = static_cast<uint8_t>(len);
+        victim->n_tok = static_cast<uint8_t>(s.result_count);
+        victim->stamp = ++clock_;
+        std::memcpy(victim->tok, s.tokens(), s.result_count * sizeof(uint32_t));
+    }
+
+private:
+    // Chunk bytes, zero-padded to CACHE_KEY_MAX
+    struct key_t {
+        uint64_t lo = 0, hi = 0;
+        bool operator==(const key_t&) const = default;
+    };
+
+    struct entry {
+        key_t    key;
+        uint64_t stamp = 0;
+        uint32_t tok[CACHE_MAX_TOKENS] = {};
+        uint8_t  len   = 0;   // 0 = empty
+        uint8_t  n_tok = 0;
+    };
+
+    static key_t make_key(const uint8_t* data, uint32_t len) {
+        key_t k;
+        uint32_t n_lo = std::min<uint32_t>(len, sizeof(uint64_t));
+        std::memcpy(&k.lo, data, n_lo);
+        if (len > n_lo) std::memcpy(&k.hi, data + n_lo, len - n_lo);
+        return k;
+    }
+
+    entry* set_of(const key_t& k, uint32_t len) {
+        static constexpr uint64_t MIX = 0x9E3779B97F4A7C15ull;
+        uint64_t h = (k.lo ^ std::rotl(k.hi, 29) ^ len) * MIX;
+        return entries_.data() + ((h >> 32) & set_mask_) * CACHE_WAYS;
+    }
+
+    std::vector<entry> entries_;
+    size_t             set_mask_ = 0;
+    uint64_t           clock_    = 0;
+    bpe_cache_stats    stats_;
+    cache_evict        policy_;
+};
+
+// bpe_encode_chunk through a cache
+inline void bpe_encode_chunk(const vocab_data& vd, const uint8_t* data, uint32_t len,
+                              bpe_scratch& s, bpe_cache& cache) {
+    if (!bpe_cache::cacheable(len)) { bpe_encode_chunk(vd, data, len, s); return; }
+    if (cache.lookup(data, len, s)) return;
+    bpe_encode_chunk(vd, data, len, s);
+    cache.store(data, len, s);
+}
+
 // ===========================================================================
 // BPE simulation merge recovery (for tiktoken format)
 // ===========================================================================
@@ -625,8 +1087,9 @@ struct tiktoken_format {
             if (rank > max_rank) max_rank = rank;
             entries.push_back({std::move(bytes), rank});
         }
-        vd.decode.resize(max_rank + 1);
-        for (auto& [bytes, rank] : entries) vd.decode[rank] = std::move(bytes);
+        std::vector<byte_string> by_rank(max_rank + 1);
+        for (auto& [bytes, rank] : entries) by_rank[rank] = std::move(bytes);
+        vd.decode = decode_table(by_rank);
         std::memset(vd.byte_rank, 0xFF, sizeof(vd.byte_rank));
         for (uint32_t r = 0; r < BASE_TOKENS && r <= max_rank; ++r)
             if (vd.decode[r].size() == 1) vd.byte_rank[static_cast<uint8_t>(vd.decode[r][0])] = r;
@@ -687,16 +1150,17 @@ struct huggingface_format {
         auto& model = j["model"];
         auto& vocab = model["vocab"];
 
-        vd.decode.resize((uint32_t)vocab.size());
+        std::vector<byte_string> by_rank((uint32_t)vocab.size());
         std::memset(vd.byte_rank, 0xFF, sizeof(vd.byte_rank));
         gteitelbaum::kstrie<uint32_t> str_to_rank;
         for (auto& [key, val] : vocab.items()) {
             uint32_t rank = val.get<uint32_t>();
-            if (rank >= vd.decode.size()) vd.decode.resize(rank + 1);
-            vd.decode[rank] = bmap.decode_str(key);
-            if (vd.decode[rank].size() == 1) vd.byte_rank[static_cast<uint8_t>(vd.decode[rank][0])] = rank;
+            if (rank >= by_rank.size()) by_rank.resize(rank + 1);
+            by_rank[rank] = bmap.decode_str(key);
+            if (by_rank[rank].size() == 1) vd.byte_rank[static_cast<uint8_t>(by_rank[rank][0])] = rank;
             str_to_rank.insert_or_assign(key, rank);
         }
+        vd.decode = decode_table(by_rank);
 
         auto& merges = model["merges"];
         for (size_t mi = 0; mi < merges.size(); ++mi) {
@@ -715,6 +1179,335 @@ struct huggingface_format {
 };
 #endif
 
+// ===========================================================================
+// Compiled image — everything the loaders compute, in one file
+//
+// [compiled_header (64 bytes)]
+// [u32 decode_off[n_tokens + 1]][decode bytes]
+// [u32 byte_rank[256]][u32 byte_pair_rank[256][256]]
+// [u64 pair_key[n_pairs]][u32 pair_rank[n_pairs]]
+// [class_range[n_ranges]]                 category trie as codepoint runs
+//
+// Sections start on 8-byte boundaries.  Native endian, like kntrie images.
+// Loading maps the file, copies the flat tables and decode bytes, and
+// bulk-builds both tries with from_sorted: no base64 or JSON parsing, no
+// merge re-simulation, no UnicodeData.txt.
+// ===========================================================================
+
+inline constexpr uint64_t COMPILED_MAGIC   = 0x314E4942'4B4F544Bull;  // "KTOKBIN1"
+inline constexpr uint32_t COMPILED_VERSION = 1;
+
+struct compiled_header {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t n_tokens;
+    uint64_t decode_bytes;
+    uint32_t n_pairs;
+    uint32_t n_ranges;
+    uint64_t total_bytes;
+    uint64_t reserved[3];
+};
+static_assert(sizeof(compiled_header) == 64);
+
+struct class_range { uint32_t lo, hi, cls; };
+
+namespace detail {
+    inline size_t pad8(size_t n) { return (n + 7) & ~size_t(7); }
+
+    struct compiled_layout {
+        size_t decode_off, decode_bytes, byte_rank, byte_pair_rank, pair_key, pair_rank, ranges, total;
+        explicit compiled_layout(const compiled_header& h) {
+            decode_off     = sizeof(compiled_header);
+            decode_bytes   = decode_off + (size_t(h.n_tokens) + 1) * sizeof(uint32_t);
+            byte_rank      = pad8(decode_bytes + h.decode_bytes);
+            byte_pair_rank = byte_rank + BASE_TOKENS * sizeof(uint32_t);
+            pair_key       = byte_pair_rank + BASE_TOKENS * BASE_TOKENS * sizeof(uint32_t);
+            pair_rank      = pair_key + size_t(h.n_pairs) * sizeof(uint64_t);
+            ranges         = pad8(pair_rank + size_t(h.n_pairs) * sizeof(uint32_t));
+            total          = ranges + size_t(h.n_ranges) * sizeof(class_range);
+        }
+    };
+}
+
+inline void write_compiled(const char* path, const cat_trie_t& trie, const vocab_data& vd) {
+    std::vector<class_range> ranges;
+    for (auto [cp, cls] : trie) {
+        if (!ranges.empty() && ranges.back().hi + 1 == cp && ranges.back().cls == cls) ranges.back().hi = cp;
+        else ranges.push_back({cp, cp, cls});
+    }
+    const auto& offs = vd.decode.off;
+
+    compiled_header h{};
+    h.magic        = COMPILED_MAGIC;
+    h.version      = COMPILED_VERSION;
+    h.n_tokens     = (uint32_t)vd.decode.size();
+    h.decode_bytes = offs.back();
+    h.n_pairs      = (uint32_t)vd.pair_trie.size();
+    h.n_ranges     = (uint32_t)ranges.size();
+    detail::compiled_layout L(h);
+    h.total_bytes  = L.total;
+
+    std::vector<uint8_t> out(L.total, 0);
+    auto put = [&](size_t at, const void* src, size_t n) { if (n) std::memcpy(out.data() + at, src, n); };
+    put(0, &h, sizeof(h));
+    put(L.decode_off, offs.data(), offs.size() * sizeof(uint32_t));
+    put(L.decode_bytes, vd.decode.bytes.data(), vd.decode.bytes.size());
+    put(L.byte_rank, vd.byte_rank, sizeof(vd.byte_rank));
+    put(L.byte_pair_rank, vd.byte_pair_rank, sizeof(vd.byte_pair_rank));
+    size_t i = 0;
+    for (auto [key, rank] : vd.pair_trie) {
+        put(L.pair_key  + i * sizeof(uint64_t), &key, sizeof(uint64_t));
+        put(L.pair_rank + i * sizeof(uint32_t), &rank, sizeof(uint32_t));
+        ++i;
+    }
+    put(L.ranges, ranges.data(), ranges.size() * sizeof(class_range));
+
+    std::FILE* f = std::fopen(path, "wb");
+    if (!f) throw std::runtime_error(std::string("ktoken::save_compiled: cannot open ") + path);
+    bool ok = std::fwrite(out.data(), 1, out.size(), f) == out.size();
+    ok = (std::fclose(f) == 0) && ok;
+    if (!ok) throw std::runtime_error(std::string("ktoken::save_compiled: write failed ") + path);
+}
+
+// Rebuilds the category trie and vocab; also fills the ASCII tables.
+// Every table is range-checked first, so a corrupt image throws
+// std::runtime_error rather than reaching the bulk builders.
+inline std::pair<cat_trie_t, vocab_data> read_compiled(const char* path) {
+    gteitelbaum::kntrie_detail::image_file img(path);
+    const uint8_t* base = reinterpret_cast<const uint8_t*>(img.data());
+    compiled_header h;
+    if (img.bytes() < sizeof(h)) throw std::runtime_error(std::string("ktoken::load_compiled: file too small ") + path);
+    std::memcpy(&h, base, sizeof(h));
+    if (h.magic != COMPILED_MAGIC || h.version != COMPILED_VERSION)
+        throw std::runtime_error(std::string("ktoken::load_compiled: not a compiled ktoken image ") + path);
+    detail::compiled_layout L(h);
+    if (h.total_bytes != L.total || L.total != img.bytes())
+        throw std::runtime_error(std::string("ktoken::load_compiled: corrupt header ") + path);
+    auto at = [&](size_t off) { return base + off; };
+
+    std::pair<cat_trie_t, vocab_data> res;
+    auto& [trie, vd] = res;
+    const uint32_t* offs = reinterpret_cast<const uint32_t*>(at(L.decode_off));
+    if (offs[h.n_tokens] != h.decode_bytes)
+        throw std::runtime_error(std::string("ktoken::load_compiled: corrupt decode table ") + path);
+    for (uint32_t r = 0; r < h.n_tokens; ++r)
+        if (offs[r] > offs[r + 1])
+            throw std::runtime_error(std::string("ktoken::load_compiled: corrupt decode table ") + path);
+    vd.decode.off.assign(offs, offs + h.n_tokens + 1);
+    vd.decode.bytes.assign(at(L.decode_bytes), at(L.decode_bytes) + h.decode_bytes);
+    std::memcpy(vd.byte_rank, at(L.byte_rank), sizeof(vd.byte_rank));
+    std::memcpy(vd.byte_pair_rank, at(L.byte_pair_rank), sizeof(vd.byte_pair_rank));
+    auto is_rank = [&](uint32_t r) { return r < h.n_tokens || r == NO_RANK; };
+    bool ranks_ok = std::all_of(std::begin(vd.byte_rank), std::end(vd.byte_rank), is_rank);
+    for (const auto& row : vd.byte_pair_rank)
+        ranks_ok = ranks_ok && std::all_of(std::begin(row), std::end(row), is_rank);
+    if (!ranks_ok)
+        throw std::runtime_error(std::string("ktoken::load_compiled: corrupt rank tables ") + path);
+
+    const uint64_t* keys  = reinterpret_cast<const uint64_t*>(at(L.pair_key));
+    const uint32_t* ranks = reinterpret_cast<const uint32_t*>(at(L.pair_rank));
+    std::vector<std::pair<uint64_t, uint32_t>> pairs(h.n_pairs);
+    for (uint32_t i = 0; i < h.n_pairs; ++i) {
+        if ((i && keys[i] <= keys[i - 1]) || ranks[i] >= h.n_tokens ||
+            pair_left(keys[i]) >= h.n_tokens || pair_right(keys[i]) >= h.n_tokens)
+            throw std::runtime_error(std::string("ktoken::load_compiled: corrupt pair table ") + path);
+        pairs[i] = {keys[i], ranks[i]};
+    }
+    vd.pair_trie.assign_sorted(pairs.begin(), pairs.end());
+
+    const class_range* rg = reinterpret_cast<const class_range*>(at(L.ranges));
+    for (uint32_t i = 0; i < h.n_ranges; ++i)
+        if (rg[i].lo > rg[i].hi || rg[i].hi > MAX_CODEPOINT || rg[i].cls >= CLASS_COUNT ||
+            (i && rg[i].lo <= rg[i - 1].hi))
+            throw std::runtime_error(std::string("ktoken::load_compiled: corrupt category ranges ") + path);
+    std::vector<std::pair<uint32_t, uint8_t>> cps;
+    for (uint32_t i = 0; i < h.n_ranges; ++i)
+        for (uint64_t cp = rg[i].lo; cp <= rg[i].hi; ++cp) cps.push_back({(uint32_t)cp, (uint8_t)rg[i].cls});
+    trie.assign_sorted(cps.begin(), cps.end());
+    init_ascii_tables(trie);
+    return res;
+}
+
+// ===========================================================================
+// Streaming encoder — tokenizes as bytes arrive
+//
+// Input is buffered back only to the last safe cut. A safe cut is a
+// position q where cl100k, o200k and p50k all end a chunk, whatever bytes
+// follow, and where no earlier chunk looked past the char at q. Chunks
+// before the cut are final, so they are encoded and handed to the sink
+// immediately; the tail carries over to the next feed. Cuts, with prev
+// the byte before q and cur the char at q:
+//   prev ASCII letter   cur ASCII, not a letter, not '\'' (contractions)
+//   prev ASCII digit    cur ASCII, not a digit
+//   prev '\n'           cur complete, not whitespace, not '/' (o200k
+//                       folds "\n/" into the punctuation before it)
+// Input with no cut (one huge word, a base64 blob) is held until a cut
+// appears or finish(). Output equals tokenizer::encode on the whole
+// stream. Sinks are called as sink(const uint32_t* tokens, size_t n).
+// ===========================================================================
+
+template<typename Model>
+class stream_encoder {
+public:
+    // Largest piece of one feed() split at a time; bounds the buffer
+    static constexpr size_t STREAM_SLICE = size_t(1) << 16;
+
+    // trie, vd and cache must outlive the encoder
+    stream_encoder(const cat_trie_t& trie, const vocab_data& vd, bpe_cache* cache = nullptr)
+        : trie_(&trie), vocab_(&vd), cache_(cache) {}
+
+    template<typename Sink>
+    void feed(const uint8_t* data, size_t len, Sink&& sink) {
+        while (len) {
+            size_t n = std::min(len, STREAM_SLICE);
+            pending_.insert(pending_.end(), data, data + n);
+            data += n; len -= n;
+            size_t q = find_cut();
+            if (q == 0) continue;
+            emit(q + utf8_len(pending_[q]), q, sink);
+            pending_.erase(pending_.begin(), pending_.begin() + q);
+            mark_checked();
+        }
+    }
+
+    // End of stream: encode everything still held
+    template<typename Sink>
+    void finish(Sink&& sink) {
+        emit(pending_.size(), pending_.size(), sink);
+        reset();
+    }
+
+    void reset() { pending_.clear(); checked_ = 0; }
+    size_t pending() const { return pending_.size(); }
+
+private:
+    // Encode the chunks of pending_[0..view) that end at or before limit
+    template<typename Sink>
+    void emit(size_t view, size_t limit, Sink& sink) {
+        const uint8_t* d = pending_.data();
+        Model::split_each(*trie_, d, view, [&](chunk_range c) {
+            if (c.off + c.len > limit) return;
+            if (cache_) bpe_encode_chunk(*vocab_, d + c.off, c.len, s_, *cache_);
+            else        bpe_encode_chunk(*vocab_, d + c.off, c.len, s_);
+            if (s_.result_count) sink(s_.tokens(), static_cast<size_t>(s_.result_count));
+        });
+    }
+
+    static constexpr bool is_alpha(uint8_t c) { return (uint8_t)((c | 0x20) - 'a') < 26; }
+    static constexpr bool is_digit(uint8_t c) { return (uint8_t)(c - '0') < 10; }
+
+    bool is_cut(const uint8_t* d, size_t n, size_t q) const {
+        uint8_t prev = d[q-1], cur = d[q];
+        if (is_alpha(prev)) return cur < ASCII_COUNT && !is_alpha(cur) && cur != '\'';
+        if (is_digit(prev)) return cur < ASCII_COUNT && !is_digit(cur);
+        if (prev != '\n' || cur == '/') return false;
+        if ((size_t)utf8_len(cur) > n - q) return false;
+        return !is_ws(classify(*trie_, d + q, n - q).cls);
+    }
+
+    // Last safe cut in pending_, or 0. Positions below checked_ are
+    // known not to be cuts, so a long cut-free run is scanned once.
+    size_t find_cut() {
+        const uint8_t* d = pending_.data();
+        size_t n = pending_.size();
+        for (size_t q = n; q-- > std::max<size_t>(checked_, 1); )
+            if (is_cut(d, n, q)) return q;
+        mark_checked();
+        return 0;
+    }
+
+    // The last few positions may hold a char not yet complete
+    void mark_checked() {
+        static constexpr size_t UTF8_MAX = 4;
+        checked_ = pending_.size() > UTF8_MAX ? pending_.size() - UTF8_MAX : 0;
+    }
+
+    const cat_trie_t*    trie_;
+    const vocab_data*    vocab_;
+    bpe_cache*           cache_;
+    std::vector<uint8_t> pending_;
+    size_t               checked_ = 0;
+    bpe_scratch          s_;
+};
+
+// ===========================================================================
+// Streaming decoder — token IDs to bytes as they are generated
+//
+// Byte-level BPE tokens can end partway through a UTF-8 char. A trailing
+// incomplete char (at most 3 bytes) is held until the token that
+// completes it arrives; every other byte goes to the sink straight out of
+// the decode table, with no copy. Bytes that can never complete a char (a
+// stray continuation, a lead followed by a non-continuation) pass through
+// as they are, so the concatenated output always equals tokenizer::decode
+// on the whole stream. Sinks are called as sink(const uint8_t* bytes, size_t n).
+// ===========================================================================
+
+class stream_decoder {
+public:
+    // dt must outlive the decoder
+    explicit stream_decoder(const decode_table& dt) : decode_(&dt) {}
+
+    template<typename Sink>
+    void feed(const uint32_t* tokens, size_t count, Sink&& sink) {
+        for (size_t i = 0; i < count; ++i) {
+            if (tokens[i] >= decode_->size()) continue;
+            const uint8_t* p = decode_->data(tokens[i]);
+            size_t n = decode_->length(tokens[i]);
+            // Finish the held char first
+            while (held_n_ && n) {
+                if (!is_cont(*p)) { flush(sink); break; }
+                held_[held_n_++] = *p++; --n;
+                if (held_n_ == held_need_) flush(sink);
+            }
+            if (n == 0) continue;
+            size_t keep = incomplete_tail(p, n);
+            if (n > keep) sink(p, n - keep);
+            if (keep) {
+                std::memcpy(held_, p + n - keep, keep);
+                held_n_ = keep;
+                held_need_ = (size_t)utf8_len(held_[0]);
+            }
+        }
+    }
+
+    template<typename Sink>
+    void feed(uint32_t token, Sink&& sink) { feed(&token, 1, sink); }
+
+    // End of stream: emit a held partial char as is
+    template<typename Sink>
+    void finish(Sink&& sink) { flush(sink); }
+
+    void reset() { held_n_ = 0; }
+    size_t pending() const { return held_n_; }
+
+private:
+    static constexpr size_t UTF8_MAX = 4;
+
+    static constexpr bool is_cont(uint8_t b) { return (b & 0xC0) == 0x80; }
+
+    // Length of an incomplete char ending p[0..n), or 0
+    static size_t incomplete_tail(const uint8_t* p, size_t n) {
+        size_t lim = std::min(n, UTF8_MAX - 1);
+        for (size_t k = 1; k <= lim; ++k) {
+            uint8_t b = p[n - k];
+            if (is_cont(b)) continue;
+            return (b >= 0xC0 && (size_t)utf8_len(b) > k) ? k : 0;
+        }
+        return 0;
+    }
+
+    template<typename Sink>
+    void flush(Sink& sink) {
+        if (held_n_) sink(static_cast<const uint8_t*>(held_), held_n_);
+        held_n_ = 0;
+    }
+
+    const decode_table* decode_;
+    uint8_t             held_[UTF8_MAX];
+    size_t              held_n_    = 0;
+    size_t              held_need_ = 0;
+};
+
 // ===========================================================================
 // Tokenizer — the public API
 // ===========================================================================
@@ -744,36 +1537,151 @@ public:
     const vocab_data& vocab() const { return vocab_; }
     const cat_trie_t& trie() const { return cat_trie_; }
 
+    // Merge-lookup backend (see pair_rank_table). Not safe while other
+    // threads are encoding with this tokenizer. Returns the backend in effect.
+    pair_backend set_pair_backend(pair_backend b) { return vocab_.set_pair_backend(b); }
+
+    // One-file startup image (see write_compiled): load_compiled needs
+    // neither the vocab file nor UnicodeData.txt. Throws std::runtime_error.
+    void save_compiled(const char* path) const { write_compiled(path, cat_trie_, vocab_); }
+    static tokenizer load_compiled(const char* path) {
+        auto [trie, vd] = read_compiled(path);
+        return tokenizer(std::move(trie), std::move(vd));
+    }
+
+    // Incremental encoder over this tokenizer (which must outlive it)
+    stream_encoder<Model> stream(bpe_cache* cache = nullptr) const {
+        return stream_encoder<Model>(cat_trie_, vocab_, cache);
+    }
+
+    // Chunks per work item in encode_parallel
+    static constexpr size_t PARALLEL_BLOCK_CHUNKS = 4096;
+
     // Encode bytes → token IDs
     std::vector<uint32_t> encode(const uint8_t* data, size_t len) const {
-        auto chunks = Model::split(cat_trie_, data, len);
         std::vector<uint32_t> tokens;
-        tokens.reserve(len / 3);
         bpe_scratch s;
-        for (auto& c : chunks) {
-            bpe_encode_chunk(vocab_, data + c.off, c.len, s);
-            tokens.insert(tokens.end(), s.result, s.result + s.result_count);
+        encode_append(data, len, s, nullptr, tokens);
+        return tokens;
+    }
+
+    // Encode through a caller-owned chunk cache (reused across calls)
+    std::vector<uint32_t> encode(const uint8_t* data, size_t len, bpe_cache& cache) const {
+        std::vector<uint32_t> tokens;
+        bpe_scratch s;
+        encode_append(data, len, s, &cache, tokens);
+        return tokens;
+    }
+
+    // Encode into out[0..cap) with the split fused into BPE: no chunk
+    // vector, no token vector. Returns the token count; if that exceeds
+    // cap, only the first cap tokens were written (cap >= len always
+    // suffices). With a reused scratch nothing is allocated once its
+    // long-chunk buffers have grown.
+    size_t encode_into(const uint8_t* data, size_t len, uint32_t* out, size_t cap,
+                       bpe_scratch& s, bpe_cache* cache = nullptr) const {
+        size_t n = 0;
+        Model::split_each(cat_trie_, data, len, [&](chunk_range c) {
+            encode_one(data, c, s, cache);
+            if (n < cap)
+                std::memcpy(out + n, s.tokens(),
+                            std::min<size_t>(s.result_count, cap - n) * sizeof(uint32_t));
+            n += s.result_count;
+        });
+        return n;
+    }
+
+    size_t encode_into(const uint8_t* data, size_t len, uint32_t* out, size_t cap) const {
+        bpe_scratch s;
+        return encode_into(data, len, out, cap, s);
+    }
+
+    // Encode many documents on up to `threads` threads (0 = hardware
+    // concurrency). Workers pull documents off a shared cursor, each with
+    // its own bpe_scratch; result[i] is exactly encode(docs[i]).
+    // Tokens are staged in the worker's scratch (grown once, reused), so
+    // each result is allocated once at its exact size and never regrown.
+    // cache_capacity > 0 gives each worker a bpe_cache of that many entries.
+    std::vector<std::vector<uint32_t>>
+    encode_batch(std::span<const std::span<const uint8_t>> docs, unsigned threads = 0,
+                 size_t cache_capacity = 0) const {
+        std::vector<std::vector<uint32_t>> out(docs.size());
+        parallel_for(docs.size(), threads, cache_capacity,
+                     [&](size_t i, bpe_scratch& s, bpe_cache* cache) {
+            s.doc_tokens.clear();
+            encode_append(docs[i].data(), docs[i].size(), s, cache, s.doc_tokens);
+            out[i].assign(s.doc_tokens.begin(), s.doc_tokens.end());
+        });
+        return out;
+    }
+
+    // Encode one large input with BPE spread over `threads` threads.
+    // The split stays serial (the patterns are not restartable mid-text);
+    // chunks are then encoded in blocks of PARALLEL_BLOCK_CHUNKS and
+    // stitched into an output sized once. Same tokens as encode().
+    std::vector<uint32_t> encode_parallel(const uint8_t* data, size_t len,
+                                          unsigned threads = 0,
+                                          size_t cache_capacity = 0) const {
+        auto chunks = Model::split(cat_trie_, data, len);
+        size_t n_blocks = (chunks.size() + PARALLEL_BLOCK_CHUNKS - 1) / PARALLEL_BLOCK_CHUNKS;
+        std::vector<std::vector<uint32_t>> parts(n_blocks);
+        parallel_for(n_blocks, threads, cache_capacity,
+                     [&](size_t b, bpe_scratch& s, bpe_cache* cache) {
+            size_t lo = b * PARALLEL_BLOCK_CHUNKS;
+            size_t n = std::min(PARALLEL_BLOCK_CHUNKS, chunks.size() - lo);
+            encode_chunks(data, chunks.data() + lo, n, s, cache, parts[b]);
+        });
+        size_t total = 0;
+        for (auto& p : parts) total += p.size();
+        std::vector<uint32_t> tokens(total);
+        uint32_t* dst = tokens.data();
+        for (auto& p : parts) {
+            std::memcpy(dst, p.data(), p.size() * sizeof(uint32_t));
+            dst += p.size();
         }
         return tokens;
     }
 
-    // Decode token IDs → bytes
+    // Decode token IDs → bytes. Unknown IDs decode to nothing.
     std::vector<uint8_t> decode(const uint32_t* tokens, size_t count) const {
-        std::vector<uint8_t> out;
+        std::vector<uint8_t> out(decoded_size(tokens, count));
+        decode_into(tokens, count, out.data(), out.size());
+        return out;
+    }
+
+    // Exact byte length decode() would produce
+    size_t decoded_size(const uint32_t* tokens, size_t count) const {
+        const auto& dt = vocab_.decode;
+        size_t n = 0;
+        for (size_t i = 0; i < count; ++i)
+            if (tokens[i] < dt.size()) n += dt.length(tokens[i]);
+        return n;
+    }
+
+    // Decode into out[0..cap). Returns the byte count; if that exceeds
+    // cap, nothing was written (size the buffer and call again).
+    size_t decode_into(const uint32_t* tokens, size_t count, uint8_t* out, size_t cap) const {
+        size_t n = decoded_size(tokens, count);
+        if (n > cap) return n;
+        const auto& dt = vocab_.decode;
         for (size_t i = 0; i < count; ++i) {
-            if (tokens[i] < vocab_.decode.size()) {
-                auto& bytes = vocab_.decode[tokens[i]];
-                out.insert(out.end(), bytes.begin(), bytes.end());
-            }
+            if (tokens[i] >= dt.size()) continue;
+            uint32_t len = dt.length(tokens[i]);
+            std::memcpy(out, dt.data(tokens[i]), len);
+            out += len;
         }
-        return out;
+        return n;
     }
 
+    // Incremental decoder over this tokenizer (which must outlive it)
+    stream_decoder decode_stream() const { return stream_decoder(vocab_.decode); }
+
     // Train a new vocabulary from corpus
     static tokenizer train(const char* unicode_db_path,
                            const uint8_t* corpus, size_t len,
-                           uint32_t target_vocab_size) {
+                           uint32_t target_vocab_size, unsigned threads = 0) {
         uint32_t num_merges = (target_vocab_size > BASE_TOKENS) ? target_vocab_size - BASE_TOKENS : 0;
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
         cat_trie_t trie = build_category_trie(unicode_db_path);
         auto ranges = Model::split(trie, corpus, len);
 
@@ -781,6 +1689,8 @@ public:
         static constexpr uint16_t NOT_HOT        = 0;
         static constexpr uint32_t HOT_DIVISOR    = 2;
         static constexpr uint32_t HOT_MAX_SLOTS  = UINT16_MAX;
+        // Chunks per worker below which a pass stays on the calling thread
+        static constexpr size_t   TRAIN_BLOCK_CHUNKS = 1 << 13;
 
         auto pack_hot = [](uint16_t hl, uint16_t hr) -> uint32_t {
             return (uint32_t(hl) << HOT_INDEX_BITS) | hr;
@@ -802,6 +1712,9 @@ public:
               }
           }
         }
+        auto workers_for = [&](size_t n) {
+            return (unsigned)std::clamp<size_t>(n / TRAIN_BLOCK_CHUNKS, 1, threads);
+        };
 
         // Hot index — fill in merge order, no eviction
         uint32_t max_hot = std::min(num_merges / HOT_DIVISOR, HOT_MAX_SLOTS);
@@ -827,30 +1740,47 @@ public:
         rank_to_hot.resize(BASE_TOKENS, NOT_HOT);
         for (uint32_t b = 0; b < BASE_TOKENS; ++b) make_hot(b);
 
-        // Full pair counts + hot cache + hot inverted index
+        // Full pair counts + hot inverted index (hot pair -> chunk ids).
+        // Each worker counts a contiguous block of chunks into its own
+        // tries; blocks are merged in order, so inverted lists come out
+        // sorted and unique.
         gteitelbaum::kntrie<uint64_t, int64_t> pair_counts;
-        gteitelbaum::kntrie<uint32_t, int64_t> hot_cache;
         gteitelbaum::kntrie<uint32_t, std::vector<uint32_t>> hot_inv;
-
-        for (uint32_t ci = 0; ci < (uint32_t)chunks.size(); ++ci) {
-            auto& c = chunks[ci];
-            int64_t w = (int64_t)c.freq;
-            for (size_t i = 0; i + 1 < c.tokens.size(); ++i) {
-                uint32_t L = c.tokens[i], R = c.tokens[i + 1];
-                pair_counts[pack_pair(L, R)] += w;
-                uint16_t hL = get_hot(L), hR = get_hot(R);
-                if (hL != NOT_HOT && hR != NOT_HOT) {
-                    uint32_t hkey = pack_hot(hL, hR);
-                    hot_cache[hkey] += w;
-                    hot_inv[hkey].push_back(ci);
+        {
+            struct count_shard {
+                gteitelbaum::kntrie<uint64_t, int64_t> pairs;
+                gteitelbaum::kntrie<uint32_t, std::vector<uint32_t>> inv;
+            };
+            unsigned n_workers = workers_for(chunks.size());
+            std::vector<count_shard> shards(n_workers);
+            parallel_blocks(chunks.size(), n_workers, [&](size_t b, size_t e, unsigned w) {
+                auto& sh = shards[w];
+                for (uint32_t ci = (uint32_t)b; ci < (uint32_t)e; ++ci) {
+                    auto& c = chunks[ci];
+                    int64_t wt = (int64_t)c.freq;
+                    for (size_t i = 0; i + 1 < c.tokens.size(); ++i) {
+                        uint32_t L = c.tokens[i], R = c.tokens[i + 1];
+                        sh.pairs[pack_pair(L, R)] += wt;
+                        uint16_t hL = get_hot(L), hR = get_hot(R);
+                        if (hL != NOT_HOT && hR != NOT_HOT) {
+                            auto& v = sh.inv[pack_hot(hL, hR)];
+                            if (v.empty() || v.back() != ci) v.push_back(ci);
+                        }
+                    }
+                }
+            });
+            pair_counts = std::move(shards[0].pairs);
+            hot_inv = std::move(shards[0].inv);
+            for (unsigned w = 1; w < n_workers; ++w) {
+                pair_counts = pair_counts.merge_with(shards[w].pairs,
+                    [](int64_t a, int64_t b) { return a + b; });
+                for (auto it = shards[w].inv.begin(); it != shards[w].inv.end(); ++it) {
+                    auto& src = (*it).second;
+                    auto& dst = hot_inv[(*it).first];
+                    dst.insert(dst.end(), src.begin(), src.end());
                 }
             }
         }
-        for (auto it = hot_inv.begin(); it != hot_inv.end(); ++it) {
-            auto& v = (*it).second;
-            std::sort(v.begin(), v.end());
-            v.erase(std::unique(v.begin(), v.end()), v.end());
-        }
 
         using heap_entry = std::pair<int64_t, uint64_t>;
         std::priority_queue<heap_entry> heap;
@@ -859,69 +1789,100 @@ public:
 
         // Decode table + byte ranks
         vocab_data vd;
-        vd.decode.resize(BASE_TOKENS);
-        for (uint32_t b = 0; b < BASE_TOKENS; ++b) vd.decode[b] = byte_string(1, static_cast<uint8_t>(b));
+        for (uint32_t b = 0; b < BASE_TOKENS; ++b) {
+            uint8_t byte = static_cast<uint8_t>(b);
+            vd.decode.push_back(byte_view(&byte, 1));
+        }
         std::memset(vd.byte_rank, 0xFF, sizeof(vd.byte_rank));
         for (uint32_t b = 0; b < BASE_TOKENS; ++b) vd.byte_rank[b] = b;
         uint32_t next_rank = BASE_TOKENS;
 
-        // Adjust pair count in both full and hot cache
-        auto adjust_pair = [&](uint32_t L, uint32_t R, int64_t delta, uint32_t chunk_id) {
-            uint64_t key64 = pack_pair(L, R);
-            auto& pc = pair_counts[key64];
-            pc += delta;
-            int64_t nc = pc;
-            if (delta > 0 && nc > 0) heap.push({nc, key64});
-            uint16_t hL = get_hot(L), hR = get_hot(R);
-            if (hL != NOT_HOT && hR != NOT_HOT) {
-                uint32_t hkey = pack_hot(hL, hR);
-                hot_cache[hkey] += delta;
-                if (delta > 0) hot_inv[hkey].push_back(chunk_id);
+        // Per-worker output of one merge pass: pair count deltas, and
+        // (hot pair, chunk) entries for pairs the merge created
+        struct merge_shard {
+            std::vector<std::pair<uint64_t, int64_t>>  deltas;
+            std::vector<std::pair<uint32_t, uint32_t>> inv_add;
+        };
+        std::vector<merge_shard> mshards(threads);
+        std::vector<std::pair<uint64_t, int64_t>> all_deltas;
+
+        auto rewrite_chunk = [&](uint32_t ci, uint32_t left, uint32_t right, uint32_t new_rank,
+                                 merge_shard& out) {
+            auto& c = chunks[ci];
+            auto& tok = c.tokens;
+            int64_t w = (int64_t)c.freq;
+            auto adjust = [&](uint32_t L, uint32_t R, int64_t delta) {
+                out.deltas.push_back({pack_pair(L, R), delta});
+                uint16_t hL = get_hot(L), hR = get_hot(R);
+                if (delta > 0 && hL != NOT_HOT && hR != NOT_HOT) out.inv_add.push_back({pack_hot(hL, hR), ci});
+            };
+            size_t i = 0;
+            while (i + 1 < tok.size()) {
+                if (tok[i] != left || tok[i + 1] != right) { ++i; continue; }
+                if (i > 0) adjust(tok[i - 1], left, -w);
+                if (i + 2 < tok.size()) adjust(right, tok[i + 2], -w);
+                tok[i] = new_rank;
+                tok.erase(tok.begin() + i + 1);
+                if (i > 0) adjust(tok[i - 1], new_rank, w);
+                if (i + 1 < tok.size()) adjust(new_rank, tok[i + 1], w);
             }
         };
 
-        // Merge a pair in a set of chunks
-        auto merge_chunks = [&](const std::vector<uint32_t>& chunk_ids,
+        // Merge a pair in a set of chunks: rewrite in parallel, then apply
+        // the summed deltas once per pair. Only increases are pushed to the
+        // heap; decreases are requeued lazily when their stale entry pops.
+        auto merge_chunks = [&](std::span<const uint32_t> chunk_ids,
                                 uint32_t left, uint32_t right, uint32_t new_rank) {
-            for (uint32_t ci : chunk_ids) {
-                auto& c = chunks[ci];
-                auto& tok = c.tokens;
-                int64_t w = (int64_t)c.freq;
-                size_t i = 0;
-                while (i + 1 < tok.size()) {
-                    if (tok[i] != left || tok[i + 1] != right) { ++i; continue; }
-                    if (i > 0) adjust_pair(tok[i - 1], left, -w, ci);
-                    if (i + 2 < tok.size()) adjust_pair(right, tok[i + 2], -w, ci);
-                    tok[i] = new_rank;
-                    tok.erase(tok.begin() + i + 1);
-                    if (i > 0) adjust_pair(tok[i - 1], new_rank, w, ci);
-                    if (i + 1 < tok.size()) adjust_pair(new_rank, tok[i + 1], w, ci);
-                }
+            unsigned n_workers = workers_for(chunk_ids.size());
+            parallel_blocks(chunk_ids.size(), n_workers, [&](size_t b, size_t e, unsigned w) {
+                auto& out = mshards[w];
+                out.deltas.clear();
+                out.inv_add.clear();
+                for (size_t k = b; k < e; ++k) rewrite_chunk(chunk_ids[k], left, right, new_rank, out);
+            });
+            all_deltas.clear();
+            for (unsigned w = 0; w < n_workers; ++w)
+                all_deltas.insert(all_deltas.end(), mshards[w].deltas.begin(), mshards[w].deltas.end());
+            std::sort(all_deltas.begin(), all_deltas.end(),
+                      [](const auto& a, const auto& b) { return a.first < b.first; });
+            for (size_t i = 0; i < all_deltas.size(); ) {
+                uint64_t key64 = all_deltas[i].first;
+                int64_t net = 0;
+                for (; i < all_deltas.size() && all_deltas[i].first == key64; ++i) net += all_deltas[i].second;
+                if (net == 0) continue;
+                auto& pc = pair_counts[key64];
+                pc += net;
+                if (net > 0 && pc > 0) heap.push({pc, key64});
             }
+            for (unsigned w = 0; w < n_workers; ++w)
+                for (auto [hkey, ci] : mshards[w].inv_add) hot_inv[hkey].push_back(ci);
         };
 
+        std::vector<uint32_t> all_ids(chunks.size());
+        for (uint32_t i = 0; i < (uint32_t)chunks.size(); ++i) all_ids[i] = i;
+
         // Train
         for (uint32_t m = 0; m < num_merges; ++m) {
-            // Find best pair
+            // Find best pair; a stale entry whose pair has since lost count
+            // is requeued at its current count, so the pick is the exact max
             int64_t best_count = 0; uint64_t best_key = 0;
             while (!heap.empty()) {
                 auto [c, k] = heap.top(); heap.pop();
                 auto cur = pair_counts.find(k);
-                if (cur != pair_counts.end() && (*cur).second == c && c > 0) { best_count = c; best_key = k; break; }
+                int64_t now = cur != pair_counts.end() ? (*cur).second : 0;
+                if (now == c && c > 0) { best_count = c; best_key = k; break; }
+                if (now > 0 && now < c) heap.push({now, k});
             }
             if (best_count <= 0) break;
 
             uint32_t left = pair_left(best_key), right = pair_right(best_key);
             uint32_t nr = next_rank++;
-            vd.decode.resize(nr + 1);
-            vd.decode[nr] = vd.decode[left] + vd.decode[right];
+            vd.decode.push_concat(left, right);
             vd.pair_trie.insert(pack_pair(left, right), nr);
 
             // Zero out merged pair
             pair_counts.insert_or_assign(best_key, int64_t(0));
             uint16_t hL = get_hot(left), hR = get_hot(right);
-            if (hL != NOT_HOT && hR != NOT_HOT)
-                hot_cache.insert_or_assign(pack_hot(hL, hR), int64_t(0));
 
             // Capture hot chunk list before promotion
             std::vector<uint32_t> hot_chunk_ids;
@@ -930,7 +1891,7 @@ public:
                 uint32_t hkey = pack_hot(hL, hR);
                 auto inv_it = hot_inv.find(hkey);
                 if (inv_it != hot_inv.end()) {
-                    hot_chunk_ids = (*inv_it).second;
+                    hot_chunk_ids = std::move((*inv_it).second);
                     hot_inv.erase(hkey);
                     std::sort(hot_chunk_ids.begin(), hot_chunk_ids.end());
                     hot_chunk_ids.erase(std::unique(hot_chunk_ids.begin(), hot_chunk_ids.end()),
@@ -946,8 +1907,6 @@ public:
                 if (!hot_chunk_ids.empty())
                     merge_chunks(hot_chunk_ids, left, right, nr);
             } else {
-                std::vector<uint32_t> all_ids(chunks.size());
-                for (uint32_t i = 0; i < (uint32_t)chunks.size(); ++i) all_ids[i] = i;
                 merge_chunks(all_ids, left, right, nr);
             }
         }
@@ -955,6 +1914,90 @@ public:
         vd.build_byte_pair_table();
         return tokenizer(std::move(trie), std::move(vd));
     }
+
+private:
+    void encode_one(const uint8_t* data, chunk_range c, bpe_scratch& s, bpe_cache* cache) const {
+        if (cache) bpe_encode_chunk(vocab_, data + c.off, c.len, s, *cache);
+        else       bpe_encode_chunk(vocab_, data + c.off, c.len, s);
+    }
+
+    // Split and BPE-encode data in one pass, appending to tokens
+    void encode_append(const uint8_t* data, size_t len, bpe_scratch& s, bpe_cache* cache,
+                       std::vector<uint32_t>& tokens) const {
+        tokens.reserve(tokens.size() + len / 3);
+        Model::split_each(cat_trie_, data, len, [&](chunk_range c) {
+            encode_one(data, c, s, cache);
+            tokens.insert(tokens.end(), s.tokens(), s.tokens() + s.result_count);
+        });
+    }
+
+    // BPE-encode chunks[0..n) of data, appending to tokens
+    void encode_chunks(const uint8_t* data, const chunk_range* chunks, size_t n,
+                       bpe_scratch& s, bpe_cache* cache,
+                       std::vector<uint32_t>& tokens) const {
+        if (n == 0) return;
+        tokens.reserve(tokens.size() + (chunks[n-1].off + chunks[n-1].len - chunks[0].off) / 3);
+        for (size_t i = 0; i < n; ++i) {
+            encode_one(data, chunks[i], s, cache);
+            tokens.insert(tokens.end(), s.tokens(), s.tokens() + s.result_count);
+        }
+    }
+
+    // Static split of [0, n) into one contiguous block per worker, in
+    // order: fn(begin, end, worker). The calling thread runs block 0.
+    template<typename F>
+    static void parallel_blocks(size_t n, unsigned workers, F&& fn) {
+        std::atomic<bool>  failed{false};
+        std::exception_ptr err;
+        auto work = [&](unsigned w) {
+            try {
+                fn(n * w / workers, n * (w + 1) / workers, w);
+            } catch (...) {
+                if (!failed.exchange(true)) err = std::current_exception();
+            }
+        };
+        std::vector<std::thread> pool;
+        if (workers > 1) pool.reserve(workers - 1);
+        for (unsigned w = 1; w < workers; ++w) pool.emplace_back(work, w);
+        work(0);
+        for (auto& th : pool) th.join();
+        if (err) std::rethrow_exception(err);
+    }
+
+    // Run fn(i, scratch, cache) for i in [0, n) on up to `threads` threads;
+    // cache is a per-worker bpe_cache, or null when cache_capacity is 0.
+    // Items are claimed through a shared cursor so uneven work balances;
+    // vocab_data and the category trie are read-only, so workers share
+    // them unlocked. The first exception is rethrown after the join.
+    template<typename F>
+    static void parallel_for(size_t n, unsigned threads, size_t cache_capacity, F&& fn) {
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        std::atomic<size_t> cursor{0};
+        std::atomic<bool>   failed{false};
+        std::exception_ptr  err;
+        auto work = [&] {
+            bpe_scratch s;
+            std::optional<bpe_cache> cache;
+            for (size_t i; (i = cursor.fetch_add(1)) < n; ) {
+                if (failed.load(std::memory_order_relaxed)) return;
+                try {
+                    if (cache_capacity && !cache) cache.emplace(cache_capacity);
+                    fn(i, s, cache ? &*cache : nullptr);
+                } catch (...) {
+                    if (!failed.exchange(true)) err = std::current_exception();
+                    return;
+                }
+            }
+        };
+
+        unsigned n_workers = static_cast<unsigned>(std::min<size_t>(threads, n));
+        std::vector<std::thread> pool;
+        if (n_workers > 1) pool.reserve(n_workers - 1);
+        for (unsigned w = 1; w < n_workers; ++w) pool.emplace_back(work);
+        work();
+        for (auto& th : pool) th.join();
+        if (err) std::rethrow_exception(err);
+    }
 };
 
 } // namespace ktoken
@@ -1,8 +1,11 @@
 // cl100k encoder benchmark — validates token-for-token match with tiktoken
 #include "ktoken.hpp"
+#include <algorithm>
 #include <chrono>
 #include <cstdio>
 #include <fstream>
+#include <span>
+#include <thread>
 
 using tok_t = ktoken::tokenizer<ktoken::cl100k, ktoken::tiktoken_format>;
 using hrclock = std::chrono::high_resolution_clock;
@@ -30,6 +33,16 @@ int main() {
     double ms = std::chrono::duration<double,std::milli>(t2-t1).count();
     printf("Encode: %zu tokens in %.1f ms (%.1f MB/s)\n", ids.size(), ms, len/(ms*1e3));
 
+    // Pre-tokenizer alone (SIMD ASCII runs when KTOKEN_SIMD_CLASSIFY_BITS > 0)
+    {
+        size_t n_chunks = 0;
+        auto ta = hrclock::now();
+        ktoken::cl100k::split_each(tok.trie(), corpus.data(), len, [&](ktoken::chunk_range) { ++n_chunks; });
+        double m = std::chrono::duration<double,std::milli>(hrclock::now()-ta).count();
+        printf("Split:  %zu chunks in %.1f ms (%.1f MB/s, simd %d)\n",
+               n_chunks, m, len/(m*1e3), KTOKEN_SIMD_CLASSIFY_BITS);
+    }
+
     // Decode round-trip
     auto dec = tok.decode(ids.data(), ids.size());
     bool ok = (dec.size() == len) && memcmp(dec.data(), corpus.data(), len) == 0;
@@ -45,6 +58,107 @@ int main() {
         printf("  run %d: %zu tokens, %.1f ms (%.1f MB/s)\n", i, r.size(), m, len/(m*1e3));
     }
 
+    // Pair lookup backend A/B: kntrie vs flat hash, best of 5
+    printf("\nPair lookup (%zu merge pairs):\n", tok.vocab().pair_trie.size());
+    for (auto want : {ktoken::pair_backend::TRIE, ktoken::pair_backend::HASH}) {
+        auto got = tok.set_pair_backend(want);
+        double best = 1e30;
+        bool same = true;
+        for (int i = 0; i < 5; ++i) {
+            auto ta = hrclock::now();
+            auto r = tok.encode(corpus.data(), len);
+            best = std::min(best, std::chrono::duration<double,std::milli>(hrclock::now()-ta).count());
+            same &= r == ids;
+        }
+        ok &= same && got == want;
+        size_t mem = got == ktoken::pair_backend::HASH ? tok.vocab().pair_table.memory_usage()
+                                                       : tok.vocab().pair_trie.memory_usage();
+        printf("  %s %.1f ms (%.1f MB/s) %.2f MB %s\n",
+               got == ktoken::pair_backend::HASH ? "hash " : "trie ", best, len/(best*1e3),
+               mem / 1048576.0, same ? "MATCH" : "MISMATCH");
+    }
+    tok.set_pair_backend(ktoken::pair_backend::TRIE);
+
+    // Chunk cache: capacity and eviction sweep, warm cache reused across runs
+    printf("\nChunk cache:\n");
+    for (auto policy : {ktoken::cache_evict::LRU, ktoken::cache_evict::NONE}) {
+        for (size_t cap : {size_t(1) << 10, ktoken::bpe_cache::DEFAULT_CAPACITY, size_t(1) << 16}) {
+            ktoken::bpe_cache cache(cap, policy);
+            tok.encode(corpus.data(), len, cache);
+            cache.reset_stats();
+            auto ta = hrclock::now();
+            auto r = tok.encode(corpus.data(), len, cache);
+            double m = std::chrono::duration<double,std::milli>(hrclock::now()-ta).count();
+            bool same = r == ids;
+            ok &= same;
+            const auto& st = cache.stats();
+            printf("  %s cap=%zu: %.1f ms (%.1f MB/s) hit %.1f%% evict %llu %s\n",
+                   policy == ktoken::cache_evict::LRU ? "LRU " : "NONE", cache.capacity(),
+                   m, len/(m*1e3), 100.0 * st.hits / std::max<uint64_t>(1, st.hits + st.misses),
+                   (unsigned long long)st.evictions, same ? "MATCH" : "MISMATCH");
+        }
+    }
+
+    // Small messages (~200 bytes): vector encode vs allocation-free encode_into
+    {
+        std::vector<std::pair<size_t, size_t>> msgs;
+        for (size_t s = 0; s + 200 <= len; s += 200) msgs.push_back({s, 200});
+        std::vector<uint32_t> out(200);
+        ktoken::bpe_scratch scratch;
+        size_t n_vec = 0, n_into = 0;
+        bool same = true;
+        auto ta = hrclock::now();
+        for (auto [s, n] : msgs) n_vec += tok.encode(corpus.data() + s, n).size();
+        auto tb = hrclock::now();
+        for (auto [s, n] : msgs) n_into += tok.encode_into(corpus.data() + s, n, out.data(), out.size(), scratch);
+        auto tc = hrclock::now();
+        for (size_t i = 0; i < msgs.size(); i += 97) {
+            auto [s, n] = msgs[i];
+            auto v = tok.encode(corpus.data() + s, n);
+            size_t k = tok.encode_into(corpus.data() + s, n, out.data(), out.size(), scratch);
+            same &= k == v.size() && std::equal(v.begin(), v.end(), out.begin());
+        }
+        same &= n_vec == n_into;
+        ok &= same;
+        double mv = std::chrono::duration<double,std::milli>(tb-ta).count();
+        double mi = std::chrono::duration<double,std::milli>(tc-tb).count();
+        printf("\nSmall messages (%zu x 200 B):\n", msgs.size());
+        printf("  encode      %.1f ms (%.2f us/msg)\n", mv, mv * 1e3 / msgs.size());
+        printf("  encode_into %.1f ms (%.2f us/msg) %s\n", mi, mi * 1e3 / msgs.size(),
+               same ? "MATCH" : "MISMATCH");
+    }
+
+    // Parallel: one large input, then the corpus cut into ~4KB documents at newlines
+    printf("\nParallel (%u hw threads):\n", std::thread::hardware_concurrency());
+    for (unsigned th : {1u, 2u, 4u, 0u}) {
+        auto ta = hrclock::now();
+        auto r = tok.encode_parallel(corpus.data(), len, th);
+        double m = std::chrono::duration<double,std::milli>(hrclock::now()-ta).count();
+        bool same = r == ids;
+        ok &= same;
+        printf("  encode_parallel threads=%u: %.1f ms (%.1f MB/s) %s\n",
+               th, m, len/(m*1e3), same ? "MATCH" : "MISMATCH");
+    }
+
+    std::vector<std::span<const uint8_t>> docs;
+    for (size_t s = 0; s < len; ) {
+        size_t e = std::min(s + 4096, len);
+        while (e < len && corpus[e-1] != '\n') ++e;
+        docs.emplace_back(corpus.data() + s, e - s);
+        s = e;
+    }
+    std::vector<std::vector<uint32_t>> expect;
+    for (auto d : docs) expect.push_back(tok.encode(d.data(), d.size()));
+    for (unsigned th : {1u, 2u, 4u, 0u}) {
+        auto ta = hrclock::now();
+        auto r = tok.encode_batch(docs, th, ktoken::bpe_cache::DEFAULT_CAPACITY);
+        double m = std::chrono::duration<double,std::milli>(hrclock::now()-ta).count();
+        bool same = r == expect;
+        ok &= same;
+        printf("  encode_batch %zu docs threads=%u: %.1f ms (%.1f MB/s) %s\n",
+               docs.size(), th, m, len/(m*1e3), same ? "MATCH" : "MISMATCH");
+    }
+
     printf("\nTokens: %zu\n", ids.size());
     return ok ? 0 : 1;
 }
@@ -1,5 +1,6 @@
 // Round-trip verification: both loaded vocab and trained vocab
 #include "ktoken.hpp"
+#include <chrono>
 #include <cstdio>
 #include <fstream>
 
@@ -34,6 +35,15 @@ int main() {
     all_ok &= verify(loaded, multi.data(), mlen, "Multilingual (2.6MB)");
     all_ok &= verify(loaded, (const uint8_t*)"", 0, "Empty");
     all_ok &= verify(loaded, (const uint8_t*)"A", 1, "Single byte");
+    {
+        auto e_trie = loaded.encode(multi.data(), mlen);
+        bool ok = loaded.set_pair_backend(ktoken::pair_backend::HASH) == ktoken::pair_backend::HASH;
+        ok &= loaded.encode(multi.data(), mlen) == e_trie;
+        ok &= verify(loaded, corpus.data(), len, "English, hash pairs");
+        loaded.set_pair_backend(ktoken::pair_backend::TRIE);
+        printf("  %-20s same tokens as trie: %s\n", "Multilingual, hash", ok ? "PASS" : "FAIL");
+        all_ok &= ok;
+    }
 
     // Test 2: trained vocab
     printf("\n=== Trained (1000 merges) ===\n");
@@ -68,6 +78,105 @@ int main() {
         all_ok &= ok;
     }
 
+    // Test 5: long chunks — heap engine vs array engine, no MAX_PARTS truncation
+    printf("\n=== Long chunks ===\n");
+    {
+        uint64_t rng = 0x9E3779B97F4A7C15ull;
+        auto next = [&] { rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17; return rng; };
+        static const char ALPHA[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+        ktoken::bpe_scratch sa, sb;
+        size_t mismatches = 0;
+        for (uint32_t n = 2; n <= (uint32_t)ktoken::MAX_PARTS; ++n) {
+            std::vector<uint8_t> run(n);
+            for (auto& c : run) c = (uint8_t)ALPHA[next() % 52];
+            ktoken::bpe_encode_short(loaded.vocab(), run.data(), n, sa);
+            ktoken::bpe_encode_long(loaded.vocab(), run.data(), n, sb);
+            if (sa.result_count != sb.result_count ||
+                memcmp(sa.tokens(), sb.tokens(), sa.result_count * sizeof(uint32_t)) != 0)
+                ++mismatches;
+        }
+        printf("  %-20s lengths 2..%d: %zu mismatches: %s\n", "engines agree",
+               ktoken::MAX_PARTS, mismatches, mismatches ? "FAIL" : "PASS");
+        all_ok &= mismatches == 0;
+
+        for (uint32_t n : {300u, 4096u, 100000u}) {
+            std::vector<uint8_t> run(n);
+            for (auto& c : run) c = (uint8_t)ALPHA[next() % 52];
+            char label[32];
+            snprintf(label, sizeof(label), "Letter run %u", n);
+            all_ok &= verify(loaded, run.data(), n, label);
+        }
+    }
+
+    // Test 6: compiled image — same tokens, no source files needed
+    printf("\n=== Compiled image ===\n");
+    {
+        using hrclock = std::chrono::high_resolution_clock;
+        auto ms_since = [](auto t) { return std::chrono::duration<double,std::milli>(hrclock::now()-t).count(); };
+        const char* path = "poc_roundtrip.ktok";
+        auto t0 = hrclock::now();
+        tok_t fresh("UnicodeData.txt", "cl100k_base.tiktoken");
+        double ms_src = ms_since(t0);
+        fresh.save_compiled(path);
+        t0 = hrclock::now();
+        auto img = tok_t::load_compiled(path);
+        double ms_img = ms_since(t0);
+        printf("  load from sources %.1f ms, load_compiled %.1f ms\n", ms_src, ms_img);
+        bool ok = img.vocab_size() == fresh.vocab_size();
+        ok &= img.encode(corpus.data(), len) == fresh.encode(corpus.data(), len);
+        ok &= img.encode(multi.data(), mlen) == fresh.encode(multi.data(), mlen);
+        printf("  %-20s same tokens as source load: %s\n", "cl100k image", ok ? "PASS" : "FAIL");
+        all_ok &= ok;
+
+        trained.save_compiled(path);
+        auto timg = tok_t::load_compiled(path);
+        all_ok &= verify(timg, corpus.data(), len, "Trained image");
+
+        bool threw = false;
+        try { tok_t::load_compiled("corpus.txt"); } catch (const std::runtime_error&) { threw = true; }
+        printf("  %-20s %s\n", "rejects non-image", threw ? "PASS" : "FAIL");
+        all_ok &= threw;
+
+        // Corrupt tables throw runtime_error before reaching the builders
+        fresh.save_compiled(path);
+        std::vector<char> good;
+        {
+            std::ifstream gf(path, std::ios::binary);
+            good.assign(std::istreambuf_iterator<char>(gf), {});
+        }
+        ktoken::compiled_header h;
+        memcpy(&h, good.data(), sizeof(h));
+        ktoken::detail::compiled_layout L(h);
+        auto rejects = [&](auto patch) {
+            std::vector<char> bad = good;
+            patch(bad.data());
+            std::ofstream(path, std::ios::binary).write(bad.data(), (std::streamsize)bad.size());
+            try { tok_t::load_compiled(path); }
+            catch (const std::runtime_error&) { return true; }
+            catch (...) {}
+            return false;
+        };
+        auto put32 = [](char* at, uint32_t v) { memcpy(at, &v, sizeof(v)); };
+        bool rej = rejects([&](char* b) {   // pair keys out of order
+            uint64_t k0, k1;
+            memcpy(&k0, b + L.pair_key, 8);
+            memcpy(&k1, b + L.pair_key + 8, 8);
+            memcpy(b + L.pair_key, &k1, 8);
+            memcpy(b + L.pair_key + 8, &k0, 8);
+        });
+        rej &= rejects([&](char* b) { put32(b + L.pair_rank, h.n_tokens); });
+        rej &= rejects([&](char* b) { put32(b + L.byte_rank, h.n_tokens + 7); });
+        rej &= rejects([&](char* b) {       // lo = 0, hi = 0xFFFFFFFF
+            put32(b + L.ranges, 0);
+            put32(b + L.ranges + 4, 0xFFFFFFFFu);
+        });
+        rej &= rejects([&](char* b) { put32(b + L.ranges, 0x30); put32(b + L.ranges + 4, 0x20); });
+        rej &= rejects([&](char* b) { put32(b + L.ranges + 8, ktoken::CLASS_COUNT); });
+        printf("  %-20s %s\n", "rejects corrupt", rej ? "PASS" : "FAIL");
+        all_ok &= rej;
+        std::remove(path);
+    }
+
     printf("\nOverall: %s\n", all_ok ? "ALL PASS" : "SOME FAILURES");
     return all_ok ? 0 : 1;
 }
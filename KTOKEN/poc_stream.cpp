@@ -0,0 +1,121 @@
+// Streaming encoder: feed() in pieces must match encode() on the whole input.
+// Streaming decoder: per-token feed() must rebuild the input in whole chars.
+#include "ktoken.hpp"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+
+using hrclock = std::chrono::high_resolution_clock;
+
+static std::vector<uint8_t> read_file(const char* path) {
+    std::ifstream f(path, std::ios::binary|std::ios::ate);
+    size_t len = f.tellg(); f.seekg(0);
+    std::vector<uint8_t> v(len);
+    f.read(reinterpret_cast<char*>(v.data()), len);
+    return v;
+}
+
+// Feed sizes: fixed piece, or 0 for pseudo-random pieces of 1..4096 bytes
+template<typename Tok>
+static bool verify(const Tok& tok, const std::vector<uint8_t>& in,
+                   const std::vector<uint32_t>& expect, size_t piece, const char* label) {
+    uint64_t rng = 0x2545F4914F6CDD1Dull;
+    auto next = [&] { rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17; return rng; };
+    std::vector<uint32_t> got;
+    size_t max_pending = 0, first_token_at = 0;
+    auto sink = [&](const uint32_t* ids, size_t n) { got.insert(got.end(), ids, ids + n); };
+
+    auto se = tok.stream();
+    auto t0 = hrclock::now();
+    for (size_t off = 0; off < in.size(); ) {
+        size_t n = std::min(piece ? piece : 1 + next() % 4096, in.size() - off);
+        se.feed(in.data() + off, n, sink);
+        off += n;
+        max_pending = std::max(max_pending, se.pending());
+        if (!first_token_at && !got.empty()) first_token_at = off;
+    }
+    se.finish(sink);
+    if (!first_token_at) first_token_at = in.size();
+    double ms = std::chrono::duration<double,std::milli>(hrclock::now()-t0).count();
+
+    bool ok = got == expect;
+    char pl[16];
+    if (piece) snprintf(pl, sizeof(pl), "%zu", piece); else snprintf(pl, sizeof(pl), "1..4096");
+    printf("  %-14s feed %-8s %.1f ms, max pending %zu B, first token after %zu B: %s\n",
+           label, pl, ms, max_pending, first_token_at, ok ? "PASS" : "FAIL");
+    return ok;
+}
+
+// Decode one token at a time; every sink call must start and end on a
+// char boundary (the inputs are valid UTF-8), and the pieces must
+// concatenate to the input. decode_into must agree with decode.
+template<typename Tok>
+static bool verify_decode(const Tok& tok, const std::vector<uint8_t>& in,
+                          const std::vector<uint32_t>& ids, const char* label) {
+    std::vector<uint8_t> got;
+    got.reserve(in.size());
+    size_t split_chars = 0, max_pending = 0;
+    auto sink = [&](const uint8_t* b, size_t n) {
+        if ((b[0] & 0xC0) == 0x80) ++split_chars;
+        size_t k = n;
+        while (k > 0 && n - k < 3 && (b[k - 1] & 0xC0) == 0x80) --k;
+        if (k > 0 && b[k - 1] >= 0xC0 && (size_t)ktoken::utf8_len(b[k - 1]) > n - k + 1) ++split_chars;
+        got.insert(got.end(), b, b + n);
+    };
+    auto sd = tok.decode_stream();
+    auto t0 = hrclock::now();
+    for (uint32_t id : ids) {
+        sd.feed(id, sink);
+        max_pending = std::max(max_pending, sd.pending());
+    }
+    sd.finish(sink);
+    double ms = std::chrono::duration<double,std::milli>(hrclock::now()-t0).count();
+
+    std::vector<uint8_t> buf(tok.decoded_size(ids.data(), ids.size()));
+    bool fits = tok.decode_into(ids.data(), ids.size(), buf.data(), buf.size()) == buf.size();
+    bool small = buf.empty() || tok.decode_into(ids.data(), ids.size(), buf.data(), buf.size() - 1) == buf.size();
+
+    bool ok = got == in && split_chars == 0 && fits && small && buf == in;
+    printf("  %-14s decode per token %.1f ms, max held %zu B, split chars %zu: %s\n",
+           label, ms, max_pending, split_chars, ok ? "PASS" : "FAIL");
+    return ok;
+}
+
+template<typename Tok>
+static bool run_model(const char* name, const std::vector<uint8_t>& en,
+                      const std::vector<uint8_t>& multi) {
+    printf("=== %s ===\n", name);
+    Tok tok("UnicodeData.txt", "cl100k_base.tiktoken");
+    bool ok = true;
+    auto e_en = tok.encode(en.data(), en.size());
+    auto e_mu = tok.encode(multi.data(), multi.size());
+    for (size_t piece : {size_t(1), size_t(7), size_t(0), en.size()})
+        ok &= verify(tok, en, e_en, piece, "English");
+    for (size_t piece : {size_t(1), size_t(0)})
+        ok &= verify(tok, multi, e_mu, piece, "Multilingual");
+    ok &= verify_decode(tok, en, e_en, "English");
+    ok &= verify_decode(tok, multi, e_mu, "Multilingual");
+
+    // Boundary-sensitive snippets fed byte by byte
+    const char* edge[] = {
+        "x  \n  \n  y", "ABCあDEf, ghi", "it's  '\n/path", "1234567890abc",
+        "trailing space   ", "\r\n\r\n\t x", "don'T'LL've",
+    };
+    for (const char* e : edge) {
+        std::vector<uint8_t> v(e, e + strlen(e));
+        ok &= verify(tok, v, tok.encode(v.data(), v.size()), 1, "edge");
+    }
+    printf("\n");
+    return ok;
+}
+
+int main() {
+    auto en = read_file("corpus.txt");
+    auto multi = read_file("corpus_multi.txt");
+    bool ok = true;
+    ok &= run_model<ktoken::tokenizer<ktoken::cl100k>>("cl100k", en, multi);
+    ok &= run_model<ktoken::tokenizer<ktoken::o200k>>("o200k splitter", en, multi);
+    ok &= run_model<ktoken::tokenizer<ktoken::p50k>>("p50k splitter", en, multi);
+    printf("Overall: %s\n", ok ? "ALL PASS" : "SOME FAILURES");
+    return ok ? 0 : 1;
+}
@@ -9,6 +9,7 @@ using tok_t = ktoken::tokenizer<ktoken::cl100k, ktoken::tiktoken_format>;
 
 int main(int argc, char** argv) {
     uint32_t target_vocab = (argc > 1) ? (uint32_t)atoi(argv[1]) + ktoken::BASE_TOKENS : 756;
+    unsigned threads      = (argc > 2) ? (unsigned)atoi(argv[2]) : 0;
 
     std::ifstream cf("corpus.txt", std::ios::binary|std::ios::ate);
     size_t len = cf.tellg(); cf.seekg(0);
@@ -19,7 +20,7 @@ int main(int argc, char** argv) {
 
     using clock = std::chrono::high_resolution_clock;
     auto t0 = clock::now();
-    auto trained = tok_t::train("UnicodeData.txt", corpus.data(), len, target_vocab);
+    auto trained = tok_t::train("UnicodeData.txt", corpus.data(), len, target_vocab, threads);
     auto t1 = clock::now();
     double ms = std::chrono::duration<double,std::milli>(t1-t0).count();
     printf("Trained: vocab=%zu in %.0f ms (%.0f merges/sec)\n",
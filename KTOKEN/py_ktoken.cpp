@@ -8,12 +8,55 @@
 //        -o ktoken$(python3-config --extension-suffix)
 
 #include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
 #include <pybind11/stl.h>
 #include "nlohmann_json.hpp"
 #include "ktoken.hpp"
 
 namespace py = pybind11;
 
+// ============================================================================
+// batch_input — borrow the bytes of every text in a batch up front
+// ============================================================================
+
+// str items use CPython's cached UTF-8 form, bytes their own storage and
+// other buffer objects (bytearray, memoryview, uint8 arrays) a held
+// buffer request, so nothing is copied. Items are referenced until this
+// is destroyed, so the views stay valid with the GIL released even if
+// the caller's list changes. Construct and destroy with the GIL held.
+struct batch_input {
+    std::vector<std::span<const uint8_t>> docs;
+    std::vector<py::object>               keep;
+    std::vector<py::buffer_info>          views;
+
+    batch_input(py::list texts, const char* fn) {
+        docs.reserve(texts.size());
+        keep.reserve(texts.size());
+        for (auto item : texts) {
+            keep.push_back(py::reinterpret_borrow<py::object>(item));
+            if (py::isinstance<py::str>(item)) {
+                Py_ssize_t sz;
+                const char* ptr = PyUnicode_AsUTF8AndSize(item.ptr(), &sz);
+                if (!ptr) throw py::error_already_set();
+                docs.push_back({reinterpret_cast<const uint8_t*>(ptr), static_cast<size_t>(sz)});
+            } else if (py::isinstance<py::bytes>(item)) {
+                char* ptr; Py_ssize_t sz;
+                PyBytes_AsStringAndSize(item.ptr(), &ptr, &sz);
+                docs.push_back({reinterpret_cast<const uint8_t*>(ptr), static_cast<size_t>(sz)});
+            } else if (PyObject_CheckBuffer(item.ptr())) {
+                views.push_back(py::reinterpret_borrow<py::buffer>(item).request());
+                auto& b = views.back();
+                if (b.ndim > 1 || (b.ndim == 1 && b.strides[0] != b.itemsize))
+                    throw py::type_error(std::string(fn) + "() buffers must be contiguous");
+                docs.push_back({static_cast<const uint8_t*>(b.ptr),
+                                static_cast<size_t>(b.size * b.itemsize)});
+            } else {
+                throw py::type_error(std::string(fn) + "() items must be str, bytes or a buffer");
+            }
+        }
+    }
+};
+
 // ============================================================================
 // bind_tokenizer<T> — register one tokenizer class
 // ============================================================================
@@ -59,41 +102,50 @@ void bind_tokenizer(py::module_& m, const char* name) {
             return result;
         }, py::arg("text"))
 
-        // encode_batch(texts) → list[list[int]]
-        .def("encode_batch", [](const T& tok, py::list texts) {
-            py::list result;
-            for (auto& item : texts) {
-                std::string s;
-                const uint8_t* data;
-                size_t len;
-
-                if (py::isinstance<py::str>(item)) {
-                    s = item.cast<std::string>();
-                    data = reinterpret_cast<const uint8_t*>(s.data());
-                    len = s.size();
-                } else if (py::isinstance<py::bytes>(item)) {
-                    char* ptr; Py_ssize_t sz;
-                    PyBytes_AsStringAndSize(item.ptr(), &ptr, &sz);
-                    data = reinterpret_cast<const uint8_t*>(ptr);
-                    len = static_cast<size_t>(sz);
-                } else {
-                    throw py::type_error(
-                        "encode_batch() items must be str or bytes");
-                }
-
-                std::vector<uint32_t> tokens;
-                {
-                    py::gil_scoped_release release;
-                    tokens = tok.encode(data, len);
-                }
-
-                py::list toks(tokens.size());
-                for (size_t i = 0; i < tokens.size(); ++i)
-                    toks[i] = py::cast(static_cast<int>(tokens[i]));
-                result.append(toks);
+        // encode_batch(texts, threads=0) → list[list[int]]
+        // Borrows every input, then releases the GIL once for the whole
+        // batch, encoded on up to `threads` threads (0 = all cores).
+        .def("encode_batch", [](const T& tok, py::list texts, unsigned threads) {
+            batch_input in(texts, "encode_batch");
+            std::vector<std::vector<uint32_t>> batch;
+            {
+                py::gil_scoped_release release;
+                batch = tok.encode_batch(in.docs, threads);
+            }
+
+            py::list result(batch.size());
+            for (size_t d = 0; d < batch.size(); ++d) {
+                py::list toks(batch[d].size());
+                for (size_t i = 0; i < batch[d].size(); ++i)
+                    toks[i] = py::cast(static_cast<int>(batch[d][i]));
+                result[d] = toks;
             }
             return result;
-        }, py::arg("texts"))
+        }, py::arg("texts"), py::arg("threads") = 0)
+
+        // encode_batch_np(texts, threads=0) → (tokens, offsets)
+        // Same encoding as encode_batch, returned unboxed: tokens is one
+        // flat uint32 array and document d is tokens[offsets[d]:offsets[d+1]]
+        // (offsets is uint64, len(texts) + 1 entries).
+        .def("encode_batch_np", [](const T& tok, py::list texts, unsigned threads) {
+            batch_input in(texts, "encode_batch_np");
+            std::vector<std::vector<uint32_t>> batch;
+            {
+                py::gil_scoped_release release;
+                batch = tok.encode_batch(in.docs, threads);
+            }
+
+            py::array_t<uint64_t> offsets(static_cast<py::ssize_t>(batch.size() + 1));
+            uint64_t* off = offsets.mutable_data();
+            off[0] = 0;
+            for (size_t d = 0; d < batch.size(); ++d) off[d + 1] = off[d] + batch[d].size();
+
+            py::array_t<uint32_t> tokens(static_cast<py::ssize_t>(off[batch.size()]));
+            uint32_t* dst = tokens.mutable_data();
+            for (size_t d = 0; d < batch.size(); ++d)
+                std::memcpy(dst + off[d], batch[d].data(), batch[d].size() * sizeof(uint32_t));
+            return py::make_tuple(tokens, offsets);
+        }, py::arg("texts"), py::arg("threads") = 0)
 
         // decode(tokens) → bytes
         .def("decode", [](const T& tok, py::list tokens) {
@@ -59,6 +59,22 @@ class TestCl100kTiktoken:
         for i, text in enumerate(texts):
             assert tok.decode_str(batch[i]) == text
 
+    def test_encode_batch_np(self, tok):
+        np = pytest.importorskip("numpy")
+        texts = ["Hello", b"World", bytearray(b"Test"), "", "caf\u00e9 \U0001F389"]
+        flat, offsets = tok.encode_batch_np(texts, threads=2)
+        assert flat.dtype == np.uint32 and offsets.dtype == np.uint64
+        assert len(offsets) == len(texts) + 1 and offsets[0] == 0
+        assert offsets[-1] == len(flat)
+        for i, text in enumerate(texts):
+            ids = flat[offsets[i]:offsets[i + 1]].tolist()
+            assert ids == tok.encode(text)
+            assert tok.decode(ids) == (text.encode() if isinstance(text, str) else bytes(text))
+
+    def test_encode_batch_np_rejects(self, tok):
+        with pytest.raises(TypeError):
+            tok.encode_batch_np(["ok", 42])
+
     def test_vocab_size(self, tok):
         assert tok.vocab_size == 100256
 